@@ -33,6 +33,7 @@
 
 #include "aom/aom_codec.h"
 #include "aom/aom_image.h"
+#include "aom/aom_thread_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,6 +61,9 @@ enum aom_com_control_id {
       192, /**< get a pointer to the new frame, aom_image_t* parameter */
   AV1_COPY_NEW_FRAME_IMAGE = 193, /**< copy the new frame to an external buffer,
                                      aom_image_t* parameter */
+  AV1_SET_THREAD_POOL = 194, /**< run the worker threads of the codec on a
+                                shared pool, aom_thread_pool_t* parameter.
+                                Must be set before the first frame. */
 
   AOM_DECODER_CTRL_ID_START = 256
 };
@@ -99,6 +103,9 @@ AOM_CTRL_USE_TYPE(AV1_GET_NEW_FRAME_IMAGE, aom_image_t *)
 AOM_CTRL_USE_TYPE(AV1_COPY_NEW_FRAME_IMAGE, aom_image_t *)
 #define AOM_CTRL_AV1_COPY_NEW_FRAME_IMAGE
 
+AOM_CTRL_USE_TYPE(AV1_SET_THREAD_POOL, aom_thread_pool_t *)
+#define AOM_CTRL_AV1_SET_THREAD_POOL
+
 /*!\endcond */
 /*! @} - end defgroup aom */
 
@@ -243,6 +243,12 @@ aom_image_t *aom_codec_get_frame(aom_codec_ctx_t *ctx, aom_codec_iter_t *iter);
  * \note
  * When decoding AV1, the application may be required to pass in at least
  * #AOM_MAXIMUM_WORK_BUFFERS external frame buffers.
+ *
+ * \note
+ * When film grain is applied, the output image is also allocated with
+ * \p cb_get, so the grain is written directly into the application's buffer.
+ * Up to one such buffer per spatial layer is held until the next call to
+ * aom_codec_decode().
  */
 aom_codec_err_t aom_codec_set_frame_buffer_functions(
     aom_codec_ctx_t *ctx, aom_get_frame_buffer_cb_fn_t cb_get,
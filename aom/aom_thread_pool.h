@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+/*!\file
+ * \brief Describes the thread pool which may be shared by several codec
+ *        instances.
+ *
+ * By default each encoder or decoder instance creates its own worker threads,
+ * up to the configured number of threads. When many instances run in the same
+ * process, this can create many more threads than there are CPU cores. A
+ * thread pool created once with aom_thread_pool_create() can instead be
+ * attached to any number of instances with the AV1_SET_THREAD_POOL control.
+ * The instances then run their multi-threaded stages on the threads of the
+ * pool, and do not create worker threads of their own.
+ *
+ * The number of threads an instance uses for a given stage is still set by
+ * its configuration (e.g. g_threads), the pool only provides the threads.
+ */
+#ifndef AOM_AOM_AOM_THREAD_POOL_H_
+#define AOM_AOM_AOM_THREAD_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!\brief Thread pool
+ *
+ * Opaque handle of a thread pool. The pool is thread-safe: it may be used by
+ * codec instances running on different threads at the same time.
+ */
+typedef struct aom_thread_pool aom_thread_pool_t;
+
+/*!\brief Creates a thread pool
+ *
+ * \param[in] num_threads  Number of threads of the pool, at least 1.
+ *
+ * \return The new pool, or NULL if num_threads is less than 1 or the pool
+ *         could not be created. If the library is built without
+ *         multi-threading support, the pool has no threads and the codec
+ *         instances attached to it run all their work on the calling thread.
+ */
+aom_thread_pool_t *aom_thread_pool_create(int num_threads);
+
+/*!\brief Destroys a thread pool
+ *
+ * Waits for the threads of the pool to exit and frees the pool. All the codec
+ * instances attached to the pool must be destroyed with aom_codec_destroy()
+ * first.
+ *
+ * \param[in] pool  The pool to destroy. May be NULL.
+ */
+void aom_thread_pool_destroy(aom_thread_pool_t *pool);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_AOM_AOM_THREAD_POOL_H_
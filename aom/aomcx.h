@@ -1206,7 +1206,25 @@ enum aome_enc_control_id {
    */
   AV1E_SET_MIN_CR = 144,
 
-  /* NOTE: enums 145-149 unused */
+  /*!\brief Control to encode the frames on a thread of the encoder, unsigned
+   * int parameter
+   *
+   * - 0 = aom_codec_encode() encodes the frame before it returns (default)
+   * - 1 = aom_codec_encode() copies the frame into a queue and returns, and
+   *       aom_codec_get_cx_data() returns the packets of the frames encoded
+   *       so far without waiting for the others. aom_codec_encode() only
+   *       blocks if the queue is full, or to flush: with a NULL image it
+   *       waits for all the queued frames to be encoded. An error of the
+   *       encoder thread is returned by the next aom_codec_encode() call,
+   *       which also sets the detail returned by aom_codec_error_detail().
+   *
+   * The other controls and aom_codec_enc_config_set() wait for the queued
+   * frames to be encoded before they apply. Setting this control to 0 waits
+   * for them too.
+   */
+  AV1E_SET_ASYNC_ENCODE = 145,
+
+  /* NOTE: enums 146-149 unused */
 
   /*!\brief Codec control function to set the layer id, aom_svc_layer_id_t*
    * parameter
@@ -1753,6 +1771,9 @@ AOM_CTRL_USE_TYPE(AV1E_SET_TIER_MASK, unsigned int)
 AOM_CTRL_USE_TYPE(AV1E_SET_MIN_CR, unsigned int)
 #define AOM_CTRL_AV1E_SET_MIN_CR
 
+AOM_CTRL_USE_TYPE(AV1E_SET_ASYNC_ENCODE, unsigned int)
+#define AOM_CTRL_AV1E_SET_ASYNC_ENCODE
+
 AOM_CTRL_USE_TYPE(AV1E_SET_SVC_LAYER_ID, aom_svc_layer_id_t *)
 #define AOME_CTRL_AV1E_SET_SVC_LAYER_ID
 
@@ -160,6 +160,12 @@ if(CONFIG_AV1_DECODER)
               "${AOM_ROOT}/aom_dsp/entdec.h"
               "${AOM_ROOT}/aom_dsp/grain_synthesis.c"
               "${AOM_ROOT}/aom_dsp/grain_synthesis.h")
+
+  list(APPEND AOM_DSP_COMMON_INTRIN_SSE4_1
+              "${AOM_ROOT}/aom_dsp/x86/grain_synthesis_sse4.c")
+
+  list(APPEND AOM_DSP_COMMON_INTRIN_AVX2
+              "${AOM_ROOT}/aom_dsp/x86/grain_synthesis_avx2.c")
 endif()
 
 if(CONFIG_AV1_ENCODER)
@@ -230,6 +236,7 @@ if(CONFIG_AV1_ENCODER)
 
   list(APPEND AOM_DSP_ENCODER_INTRIN_AVX2
               "${AOM_ROOT}/aom_dsp/x86/masked_sad_intrin_avx2.c"
+              "${AOM_ROOT}/aom_dsp/x86/noise_model_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/subtract_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/highbd_quantize_intrin_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/adaptive_quantize_avx2.c"
@@ -247,6 +254,10 @@ if(CONFIG_AV1_ENCODER)
               "${AOM_ROOT}/aom_dsp/x86/blk_sse_sum_avx2.c"
               "${AOM_ROOT}/aom_dsp/x86/sum_squares_avx2.c")
 
+  list(APPEND AOM_DSP_ENCODER_INTRIN_AVX512
+              "${AOM_ROOT}/aom_dsp/x86/sad4d_avx512.c"
+              "${AOM_ROOT}/aom_dsp/x86/variance_avx512.c")
+
   list(APPEND AOM_DSP_ENCODER_AVX_ASM_X86_64
               "${AOM_ROOT}/aom_dsp/x86/quantize_avx_x86_64.asm")
 
@@ -289,6 +300,11 @@ if(CONFIG_AV1_ENCODER)
     list(APPEND AOM_DSP_ENCODER_SOURCES "${AOM_ROOT}/aom_dsp/fastssim.c"
                 "${AOM_ROOT}/aom_dsp/psnrhvs.c" "${AOM_ROOT}/aom_dsp/ssim.c"
                 "${AOM_ROOT}/aom_dsp/ssim.h")
+
+    list(APPEND AOM_DSP_ENCODER_INTRIN_AVX2
+                "${AOM_ROOT}/aom_dsp/x86/fastssim_avx2.c"
+                "${AOM_ROOT}/aom_dsp/x86/psnrhvs_avx2.c"
+                "${AOM_ROOT}/aom_dsp/x86/ssim_avx2.c")
   endif()
 
   if(CONFIG_TUNE_VMAF)
@@ -387,6 +403,14 @@ function(setup_aom_dsp_targets)
     endif()
   endif()
 
+  if(HAVE_AVX512)
+    if(CONFIG_AV1_ENCODER)
+      add_intrinsics_object_library("${AOM_AVX512_FLAGS}" "avx512"
+                                    "aom_dsp_encoder"
+                                    "AOM_DSP_ENCODER_INTRIN_AVX512")
+    endif()
+  endif()
+
   if(HAVE_NEON)
     add_intrinsics_object_library("${AOM_NEON_INTRIN_FLAG}" "neon"
                                   "aom_dsp_common" "AOM_DSP_COMMON_INTRIN_NEON")
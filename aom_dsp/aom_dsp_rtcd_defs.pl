@@ -473,6 +473,23 @@ if (aom_config("CONFIG_AV1_HIGHBITDEPTH") eq "yes") {
   specialize qw/aom_highbd_lpf_horizontal_4_dual sse2 avx2/;
 }
 
+#
+# Film grain synthesis
+#
+if (aom_config("CONFIG_AV1_DECODER") eq "yes") {
+  add_proto qw/void aom_film_grain_add_noise_luma/, "uint8_t *luma, int luma_stride, const int *grain, int grain_stride, const int *scaling_lut, int width, int height, int scaling_shift, int min_val, int max_val";
+  specialize qw/aom_film_grain_add_noise_luma sse4_1 avx2/;
+
+  add_proto qw/void aom_film_grain_add_noise_chroma/, "uint8_t *chroma, int chroma_stride, const uint8_t *luma, int luma_stride, const int *grain, int grain_stride, const int *scaling_lut, int width, int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult, int offset, int scaling_shift, int min_val, int max_val";
+  specialize qw/aom_film_grain_add_noise_chroma sse4_1 avx2/;
+
+  add_proto qw/void aom_highbd_film_grain_add_noise_luma/, "uint16_t *luma, int luma_stride, const int *grain, int grain_stride, const int *scaling_lut, int width, int height, int scaling_shift, int min_val, int max_val, int bd";
+  specialize qw/aom_highbd_film_grain_add_noise_luma avx2/;
+
+  add_proto qw/void aom_highbd_film_grain_add_noise_chroma/, "uint16_t *chroma, int chroma_stride, const uint16_t *luma, int luma_stride, const int *grain, int grain_stride, const int *scaling_lut, int width, int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult, int offset, int scaling_shift, int min_val, int max_val, int bd";
+  specialize qw/aom_highbd_film_grain_add_noise_chroma avx2/;
+}
+
 #
 # Encoder functions.
 #
@@ -522,6 +539,16 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes"){
 
     add_proto qw/void aom_ifft32x32_float/, "const float *input, float *temp, float *output";
     specialize qw/aom_ifft32x32_float avx2          sse2/;
+
+    # Denoising and noise modeling
+    add_proto qw/void aom_noise_tx_filter_coeffs/, "float *coeffs, const float *psd, int n";
+    specialize qw/aom_noise_tx_filter_coeffs avx2/;
+
+    add_proto qw/void aom_noise_overlap_add/, "float *dst, int dst_stride, const float *block, const float *plane, const float *window, int w, int h";
+    specialize qw/aom_noise_overlap_add avx2/;
+
+    add_proto qw/void aom_flat_block_gradient_stats/, "const double *block, int block_size, double *sum_gxx, double *sum_gxy, double *sum_gyy, double *sum, double *sum_sq";
+    specialize qw/aom_flat_block_gradient_stats avx2/;
 }  # CONFIG_AV1_ENCODER
 
 #
@@ -827,27 +854,27 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
     add_proto qw/void/, "aom_masked_sad${w}x${h}x4d", "const uint8_t *src, int src_stride, const uint8_t *ref[], int ref_stride, const uint8_t *second_pred, const uint8_t *msk, int msk_stride, int invert_mask, unsigned sads[]";
   }
 
-  specialize qw/aom_sad128x128x4d avx2          sse2/;
-  specialize qw/aom_sad128x64x4d  avx2          sse2/;
-  specialize qw/aom_sad64x128x4d  avx2          sse2/;
-  specialize qw/aom_sad64x64x4d   avx2 neon msa sse2/;
-  specialize qw/aom_sad64x32x4d   avx2      msa sse2/;
-  specialize qw/aom_sad64x16x4d   avx2          sse2/;
-  specialize qw/aom_sad32x64x4d   avx2      msa sse2/;
-  specialize qw/aom_sad32x32x4d   avx2 neon msa sse2/;
-  specialize qw/aom_sad32x16x4d   avx2      msa sse2/;
-  specialize qw/aom_sad32x8x4d    avx2          sse2/;
-  specialize qw/aom_sad16x64x4d                 sse2/;
-  specialize qw/aom_sad16x32x4d             msa sse2/;
-  specialize qw/aom_sad16x16x4d         neon msa sse2/;
-  specialize qw/aom_sad16x8x4d               msa sse2/;
-
-  specialize qw/aom_sad8x16x4d              msa sse2/;
-  specialize qw/aom_sad8x8x4d               msa sse2/;
-  specialize qw/aom_sad8x4x4d               msa sse2/;
-  specialize qw/aom_sad4x16x4d              msa sse2/;
-  specialize qw/aom_sad4x8x4d               msa sse2/;
-  specialize qw/aom_sad4x4x4d               msa sse2/;
+  specialize qw/aom_sad128x128x4d avx2 avx512          sse2/;
+  specialize qw/aom_sad128x64x4d  avx2 avx512          sse2/;
+  specialize qw/aom_sad64x128x4d  avx2 avx512          sse2/;
+  specialize qw/aom_sad64x64x4d   avx2 avx512 neon msa sse2/;
+  specialize qw/aom_sad64x32x4d   avx2 avx512      msa sse2/;
+  specialize qw/aom_sad64x16x4d   avx2 avx512          sse2/;
+  specialize qw/aom_sad32x64x4d   avx2 avx512      msa sse2/;
+  specialize qw/aom_sad32x32x4d   avx2 avx512 neon msa sse2/;
+  specialize qw/aom_sad32x16x4d   avx2 avx512      msa sse2/;
+  specialize qw/aom_sad32x8x4d    avx2 avx512          sse2/;
+  specialize qw/aom_sad16x64x4d                        sse2/;
+  specialize qw/aom_sad16x32x4d                    msa sse2/;
+  specialize qw/aom_sad16x16x4d                neon msa sse2/;
+  specialize qw/aom_sad16x8x4d                      msa sse2/;
+
+  specialize qw/aom_sad8x16x4d                     msa sse2/;
+  specialize qw/aom_sad8x8x4d                      msa sse2/;
+  specialize qw/aom_sad8x4x4d                      msa sse2/;
+  specialize qw/aom_sad4x16x4d                     msa sse2/;
+  specialize qw/aom_sad4x8x4d                      msa sse2/;
+  specialize qw/aom_sad4x4x4d                      msa sse2/;
 
   specialize qw/aom_sad4x32x4d  sse2/;
   specialize qw/aom_sad4x16x4d  sse2/;
@@ -1017,13 +1044,38 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
   #
   if (aom_config("CONFIG_INTERNAL_STATS") eq "yes") {
     add_proto qw/void aom_ssim_parms_8x8/, "const uint8_t *s, int sp, const uint8_t *r, int rp, uint32_t *sum_s, uint32_t *sum_r, uint32_t *sum_sq_s, uint32_t *sum_sq_r, uint32_t *sum_sxr";
-    specialize qw/aom_ssim_parms_8x8/, "$sse2_x86_64";
+    specialize qw/aom_ssim_parms_8x8 avx2/, "$sse2_x86_64";
 
     add_proto qw/void aom_ssim_parms_16x16/, "const uint8_t *s, int sp, const uint8_t *r, int rp, uint32_t *sum_s, uint32_t *sum_r, uint32_t *sum_sq_s, uint32_t *sum_sq_r, uint32_t *sum_sxr";
     specialize qw/aom_ssim_parms_16x16/, "$sse2_x86_64";
 
+    #
+    # FastSSIM
+    #
+    add_proto qw/void aom_fastssim_downsample/, "const uint8_t *src, int stride, uint32_t *dst, int w, int h";
+    specialize qw/aom_fastssim_downsample avx2/;
+
+    add_proto qw/void aom_fastssim_downsample_level/, "const uint32_t *src, int src_w, uint32_t *dst, int w, int h";
+    specialize qw/aom_fastssim_downsample_level avx2/;
+
+    add_proto qw/void aom_fastssim_gradient/, "const uint32_t *im, int w, uint32_t *g";
+    specialize qw/aom_fastssim_gradient avx2/;
+
+    #
+    # PSNR-HVS
+    #
+    add_proto qw/double aom_psnrhvs_8x8/, "const int16_t *src, const int16_t *dst, const double *csf, const double *mask, int pix_max";
+    specialize qw/aom_psnrhvs_8x8 avx2/;
+
     if (aom_config("CONFIG_AV1_HIGHBITDEPTH") eq "yes") {
       add_proto qw/void aom_highbd_ssim_parms_8x8/, "const uint16_t *s, int sp, const uint16_t *r, int rp, uint32_t *sum_s, uint32_t *sum_r, uint32_t *sum_sq_s, uint32_t *sum_sq_r, uint32_t *sum_sxr";
+      specialize qw/aom_highbd_ssim_parms_8x8 avx2/;
+
+      add_proto qw/void aom_highbd_fastssim_downsample/, "const uint16_t *src, int stride, uint32_t *dst, int w, int h, int shift";
+      specialize qw/aom_highbd_fastssim_downsample avx2/;
+
+      add_proto qw/double aom_highbd_psnrhvs_8x8/, "const int16_t *src, const int16_t *dst, const double *csf, const double *mask, int pix_max";
+      specialize qw/aom_highbd_psnrhvs_8x8 avx2/;
     }
   }
 }  # CONFIG_AV1_ENCODER
@@ -1051,6 +1103,14 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
   specialize qw/aom_mse8x16           sse2           msa/;
   specialize qw/aom_mse8x8            sse2           msa/;
 
+  add_proto qw/uint64_t aom_mse_wxh_16bit/, "uint8_t *dst, int dstride, uint16_t *src, int sstride, int w, int h";
+  specialize qw/aom_mse_wxh_16bit  sse2 avx2/;
+
+  if (aom_config("CONFIG_AV1_HIGHBITDEPTH") eq "yes") {
+    add_proto qw/uint64_t aom_mse_wxh_16bit_highbd/, "uint16_t *dst, int dstride, uint16_t *src, int sstride, int w, int h";
+    specialize qw/aom_mse_wxh_16bit_highbd  sse2 avx2/;
+  }
+
   if (aom_config("CONFIG_AV1_HIGHBITDEPTH") eq "yes") {
     foreach $bd (8, 10, 12) {
       add_proto qw/void/, "aom_highbd_${bd}_get16x16var", "const uint8_t *src_ptr, int source_stride, const uint8_t *ref_ptr, int ref_stride, unsigned int *sse, int *sum";
@@ -1136,22 +1196,22 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
     add_proto qw/uint32_t/, "aom_sub_pixel_avg_variance${w}x${h}", "const uint8_t *src_ptr, int source_stride, int xoffset, int  yoffset, const uint8_t *ref_ptr, int ref_stride, uint32_t *sse, const uint8_t *second_pred";
     add_proto qw/uint32_t/, "aom_dist_wtd_sub_pixel_avg_variance${w}x${h}", "const uint8_t *src_ptr, int source_stride, int xoffset, int  yoffset, const uint8_t *ref_ptr, int ref_stride, uint32_t *sse, const uint8_t *second_pred, const DIST_WTD_COMP_PARAMS *jcp_param";
   }
-  specialize qw/aom_variance128x128   sse2 avx2 neon    /;
-  specialize qw/aom_variance128x64    sse2 avx2         /;
-  specialize qw/aom_variance64x128    sse2 avx2         /;
-  specialize qw/aom_variance64x64     sse2 avx2 neon msa/;
-  specialize qw/aom_variance64x32     sse2 avx2 neon msa/;
-  specialize qw/aom_variance32x64     sse2 avx2 neon msa/;
-  specialize qw/aom_variance32x32     sse2 avx2 neon msa/;
-  specialize qw/aom_variance32x16     sse2 avx2      msa/;
-  specialize qw/aom_variance16x32     sse2 avx2      msa/;
-  specialize qw/aom_variance16x16     sse2 avx2 neon msa/;
-  specialize qw/aom_variance16x8      sse2 avx2 neon msa/;
-  specialize qw/aom_variance8x16      sse2      neon msa/;
-  specialize qw/aom_variance8x8       sse2      neon msa/;
-  specialize qw/aom_variance8x4       sse2           msa/;
-  specialize qw/aom_variance4x8       sse2           msa/;
-  specialize qw/aom_variance4x4       sse2           msa/;
+  specialize qw/aom_variance128x128   sse2 avx2 avx512 neon    /;
+  specialize qw/aom_variance128x64    sse2 avx2 avx512         /;
+  specialize qw/aom_variance64x128    sse2 avx2 avx512         /;
+  specialize qw/aom_variance64x64     sse2 avx2 avx512 neon msa/;
+  specialize qw/aom_variance64x32     sse2 avx2 avx512 neon msa/;
+  specialize qw/aom_variance32x64     sse2 avx2 avx512 neon msa/;
+  specialize qw/aom_variance32x32     sse2 avx2 avx512 neon msa/;
+  specialize qw/aom_variance32x16     sse2 avx2 avx512      msa/;
+  specialize qw/aom_variance16x32     sse2 avx2             msa/;
+  specialize qw/aom_variance16x16     sse2 avx2        neon msa/;
+  specialize qw/aom_variance16x8      sse2 avx2        neon msa/;
+  specialize qw/aom_variance8x16      sse2             neon msa/;
+  specialize qw/aom_variance8x8       sse2             neon msa/;
+  specialize qw/aom_variance8x4       sse2                  msa/;
+  specialize qw/aom_variance4x8       sse2                  msa/;
+  specialize qw/aom_variance4x4       sse2                  msa/;
 
   specialize qw/aom_sub_pixel_variance128x128   avx2          sse2 ssse3/;
   specialize qw/aom_sub_pixel_variance128x64    avx2          sse2 ssse3/;
@@ -1190,9 +1250,9 @@ if (aom_config("CONFIG_AV1_ENCODER") eq "yes") {
   specialize qw/aom_variance4x16 sse2/;
   specialize qw/aom_variance16x4 sse2 avx2/;
   specialize qw/aom_variance8x32 sse2/;
-  specialize qw/aom_variance32x8 sse2 avx2/;
+  specialize qw/aom_variance32x8 sse2 avx2 avx512/;
   specialize qw/aom_variance16x64 sse2 avx2/;
-  specialize qw/aom_variance64x16 sse2 avx2/;
+  specialize qw/aom_variance64x16 sse2 avx2 avx512/;
 
   specialize qw/aom_sub_pixel_variance4x16 sse2 ssse3/;
   specialize qw/aom_sub_pixel_variance16x4 avx2 sse2 ssse3/;
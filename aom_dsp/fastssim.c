@@ -101,87 +101,82 @@ static void fs_ctx_init(fs_ctx *_ctx, int _w, int _h, int _nlevels) {
 
 static void fs_ctx_clear(fs_ctx *_ctx) { free(_ctx->level); }
 
-static void fs_downsample_level(fs_ctx *_ctx, int _l) {
-  const uint32_t *src1;
-  const uint32_t *src2;
-  uint32_t *dst1;
-  uint32_t *dst2;
-  int w2;
-  int h2;
-  int w;
-  int h;
-  int i;
-  int j;
-  w = _ctx->level[_l].w;
-  h = _ctx->level[_l].h;
-  dst1 = _ctx->level[_l].im1;
-  dst2 = _ctx->level[_l].im2;
-  w2 = _ctx->level[_l - 1].w;
-  h2 = _ctx->level[_l - 1].h;
-  src1 = _ctx->level[_l - 1].im1;
-  src2 = _ctx->level[_l - 1].im2;
-  for (j = 0; j < h; j++) {
-    int j0offs;
-    int j1offs;
-    j0offs = 2 * j * w2;
-    j1offs = FS_MINI(2 * j + 1, h2) * w2;
-    for (i = 0; i < w; i++) {
-      int i0;
-      int i1;
-      i0 = 2 * i;
-      i1 = FS_MINI(i0 + 1, w2);
-      dst1[j * w + i] = src1[j0offs + i0] + src1[j0offs + i1] +
-                        src1[j1offs + i0] + src1[j1offs + i1];
-      dst2[j * w + i] = src2[j0offs + i0] + src2[j0offs + i1] +
-                        src2[j1offs + i0] + src2[j1offs + i1];
+// Each sample of the level is the sum of a 2x2 block of the level above it.
+// The levels have (w + 1) / 2 columns and rows, so the last ones read a column
+// and a row past an odd width and height, as the level buffers are followed by
+// other data and the frames have borders.
+void aom_fastssim_downsample_level_c(const uint32_t *src, int src_w,
+                                     uint32_t *dst, int w, int h) {
+  for (int j = 0; j < h; j++) {
+    const uint32_t *const src0 = src + 2 * j * src_w;
+    const uint32_t *const src1 = src0 + src_w;
+    for (int i = 0; i < w; i++) {
+      dst[j * w + i] =
+          src0[2 * i] + src0[2 * i + 1] + src1[2 * i] + src1[2 * i + 1];
+    }
+  }
+}
+
+void aom_fastssim_downsample_c(const uint8_t *src, int stride, uint32_t *dst,
+                               int w, int h) {
+  for (int j = 0; j < h; j++) {
+    const uint8_t *const src0 = src + 2 * j * stride;
+    const uint8_t *const src1 = src0 + stride;
+    for (int i = 0; i < w; i++) {
+      dst[j * w + i] =
+          src0[2 * i] + src0[2 * i + 1] + src1[2 * i] + src1[2 * i + 1];
+    }
+  }
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+void aom_highbd_fastssim_downsample_c(const uint16_t *src, int stride,
+                                      uint32_t *dst, int w, int h, int shift) {
+  for (int j = 0; j < h; j++) {
+    const uint16_t *const src0 = src + 2 * j * stride;
+    const uint16_t *const src1 = src0 + stride;
+    for (int i = 0; i < w; i++) {
+      dst[j * w + i] = (src0[2 * i] >> shift) + (src0[2 * i + 1] >> shift) +
+                       (src1[2 * i] >> shift) + (src1[2 * i + 1] >> shift);
     }
   }
 }
+#endif  // CONFIG_AV1_HIGHBITDEPTH
+
+// Computes the w - 1 gradient magnitudes between the rows im and im + w.
+void aom_fastssim_gradient_c(const uint32_t *im, int w, uint32_t *g) {
+  for (int i = 0; i < w - 1; i++) {
+    const unsigned g1 = abs((int)im[w + i + 1] - (int)im[i]);
+    const unsigned g2 = abs((int)im[w + i] - (int)im[i + 1]);
+    g[i] = 4 * FS_MAXI(g1, g2) + FS_MINI(g1, g2);
+  }
+}
+
+static void fs_downsample_level(fs_ctx *_ctx, int _l) {
+  const fs_level *const src = &_ctx->level[_l - 1];
+  fs_level *const dst = &_ctx->level[_l];
+  aom_fastssim_downsample_level(src->im1, src->w, dst->im1, dst->w, dst->h);
+  aom_fastssim_downsample_level(src->im2, src->w, dst->im2, dst->w, dst->h);
+}
 
 static void fs_downsample_level0(fs_ctx *_ctx, const uint8_t *_src1,
                                  int _s1ystride, const uint8_t *_src2,
-                                 int _s2ystride, int _w, int _h, uint32_t shift,
+                                 int _s2ystride, uint32_t shift,
                                  int buf_is_hbd) {
-  uint32_t *dst1;
-  uint32_t *dst2;
-  int w;
-  int h;
-  int i;
-  int j;
-  w = _ctx->level[0].w;
-  h = _ctx->level[0].h;
-  dst1 = _ctx->level[0].im1;
-  dst2 = _ctx->level[0].im2;
-  for (j = 0; j < h; j++) {
-    int j0;
-    int j1;
-    j0 = 2 * j;
-    j1 = FS_MINI(j0 + 1, _h);
-    for (i = 0; i < w; i++) {
-      int i0;
-      int i1;
-      i0 = 2 * i;
-      i1 = FS_MINI(i0 + 1, _w);
-      if (!buf_is_hbd) {
-        dst1[j * w + i] =
-            _src1[j0 * _s1ystride + i0] + _src1[j0 * _s1ystride + i1] +
-            _src1[j1 * _s1ystride + i0] + _src1[j1 * _s1ystride + i1];
-        dst2[j * w + i] =
-            _src2[j0 * _s2ystride + i0] + _src2[j0 * _s2ystride + i1] +
-            _src2[j1 * _s2ystride + i0] + _src2[j1 * _s2ystride + i1];
-      } else {
-        uint16_t *src1s = CONVERT_TO_SHORTPTR(_src1);
-        uint16_t *src2s = CONVERT_TO_SHORTPTR(_src2);
-        dst1[j * w + i] = (src1s[j0 * _s1ystride + i0] >> shift) +
-                          (src1s[j0 * _s1ystride + i1] >> shift) +
-                          (src1s[j1 * _s1ystride + i0] >> shift) +
-                          (src1s[j1 * _s1ystride + i1] >> shift);
-        dst2[j * w + i] = (src2s[j0 * _s2ystride + i0] >> shift) +
-                          (src2s[j0 * _s2ystride + i1] >> shift) +
-                          (src2s[j1 * _s2ystride + i0] >> shift) +
-                          (src2s[j1 * _s2ystride + i1] >> shift);
-      }
-    }
+  fs_level *const dst = &_ctx->level[0];
+  if (!buf_is_hbd) {
+    aom_fastssim_downsample(_src1, _s1ystride, dst->im1, dst->w, dst->h);
+    aom_fastssim_downsample(_src2, _s2ystride, dst->im2, dst->w, dst->h);
+  } else {
+#if CONFIG_AV1_HIGHBITDEPTH
+    aom_highbd_fastssim_downsample(CONVERT_TO_SHORTPTR(_src1), _s1ystride,
+                                   dst->im1, dst->w, dst->h, shift);
+    aom_highbd_fastssim_downsample(CONVERT_TO_SHORTPTR(_src2), _s2ystride,
+                                   dst->im2, dst->w, dst->h, shift);
+#else
+    (void)shift;
+    assert(0);
+#endif  // CONFIG_AV1_HIGHBITDEPTH
   }
 }
 
@@ -336,20 +331,8 @@ static void fs_calc_structure(fs_ctx *_ctx, int _l, int bit_depth) {
   c2 = ssim_c2 * (1 << 4 * _l) * 16 * 104;
   for (j = 0; j < h + 4; j++) {
     if (j < h - 1) {
-      for (i = 0; i < w - 1; i++) {
-        unsigned g1;
-        unsigned g2;
-        unsigned gx;
-        unsigned gy;
-        g1 = abs((int)im1[(j + 1) * w + i + 1] - (int)im1[j * w + i]);
-        g2 = abs((int)im1[(j + 1) * w + i] - (int)im1[j * w + i + 1]);
-        gx = 4 * FS_MAXI(g1, g2) + FS_MINI(g1, g2);
-        g1 = abs((int)im2[(j + 1) * w + i + 1] - (int)im2[j * w + i]);
-        g2 = abs((int)im2[(j + 1) * w + i] - (int)im2[j * w + i + 1]);
-        gy = 4 * FS_MAXI(g1, g2) + FS_MINI(g1, g2);
-        gx_buf[(j & 7) * stride + i + 4] = gx;
-        gy_buf[(j & 7) * stride + i + 4] = gy;
-      }
+      aom_fastssim_gradient(im1 + j * w, w, gx_buf + (j & 7) * stride + 4);
+      aom_fastssim_gradient(im2 + j * w, w, gy_buf + (j & 7) * stride + 4);
     } else {
       memset(gx_buf + (j & 7) * stride, 0, stride * sizeof(*gx_buf));
       memset(gy_buf + (j & 7) * stride, 0, stride * sizeof(*gy_buf));
@@ -447,7 +430,7 @@ static double calc_ssim(const uint8_t *_src, int _systride, const uint8_t *_dst,
   int l;
   ret = 1;
   fs_ctx_init(&ctx, _w, _h, FS_NLEVELS);
-  fs_downsample_level0(&ctx, _src, _systride, _dst, _dystride, _w, _h, _shift,
+  fs_downsample_level0(&ctx, _src, _systride, _dst, _dystride, _shift,
                        buf_is_hbd);
   for (l = 0; l < FS_NLEVELS - 1; l++) {
     fs_calc_structure(&ctx, l, _bd);
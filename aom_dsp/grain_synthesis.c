@@ -18,6 +18,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+
+#include "config/aom_dsp_rtcd.h"
+
 #include "aom_dsp/grain_synthesis.h"
 #include "aom_mem/aom_mem.h"
 
@@ -216,11 +219,8 @@ static const int gaussian_sequence[2048] = {
 
 static const int gauss_bits = 11;
 
-static int luma_subblock_size_y = 32;
-static int luma_subblock_size_x = 32;
-
-static int chroma_subblock_size_y = 16;
-static int chroma_subblock_size_x = 16;
+static const int luma_subblock_size_y = 32;
+static const int luma_subblock_size_x = 32;
 
 static const int min_luma_legal_range = 16;
 static const int max_luma_legal_range = 235;
@@ -228,27 +228,53 @@ static const int max_luma_legal_range = 235;
 static const int min_chroma_legal_range = 16;
 static const int max_chroma_legal_range = 240;
 
-static int scaling_lut_y[256];
-static int scaling_lut_cb[256];
-static int scaling_lut_cr[256];
-
-static int grain_min;
-static int grain_max;
-
-static uint16_t random_register = 0;  // random number generator register
-
-static void init_arrays(const aom_film_grain_t *params, int luma_stride,
-                        int chroma_stride, int ***pred_pos_luma_p,
-                        int ***pred_pos_chroma_p, int **luma_grain_block,
-                        int **cb_grain_block, int **cr_grain_block,
-                        int **y_line_buf, int **cb_line_buf, int **cr_line_buf,
-                        int **y_col_buf, int **cb_col_buf, int **cr_col_buf,
-                        int luma_grain_samples, int chroma_grain_samples,
-                        int chroma_subsamp_y, int chroma_subsamp_x) {
-  memset(scaling_lut_y, 0, sizeof(*scaling_lut_y) * 256);
-  memset(scaling_lut_cb, 0, sizeof(*scaling_lut_cb) * 256);
-  memset(scaling_lut_cr, 0, sizeof(*scaling_lut_cr) * 256);
-
+// Frame level state of the grain synthesis, including the scaling functions
+// and the grain range. It is set up by init_grain_frame() and only read while
+// the grain is added, so that horizontal stripes of the frame can be processed
+// by several threads, and several frames at the same time.
+typedef struct {
+  const aom_film_grain_t *params;
+  // If 'src' is set, each stripe first copies its rows of 'src' to 'dst'.
+  const aom_image_t *src;
+  aom_image_t *dst;
+  uint8_t *luma;
+  uint8_t *cb;
+  uint8_t *cr;
+  int height;
+  int width;
+  // luma and chroma strides in samples
+  int luma_stride;
+  int chroma_stride;
+  int use_high_bit_depth;
+  int chroma_subsamp_y;
+  int chroma_subsamp_x;
+  int mc_identity;
+  int **pred_pos_luma;
+  int **pred_pos_chroma;
+  int *luma_grain_block;
+  int *cb_grain_block;
+  int *cr_grain_block;
+  int luma_grain_stride;
+  int chroma_grain_stride;
+  int left_pad;
+  int top_pad;
+  int ar_padding;
+  int chroma_subblock_size_y;
+  int chroma_subblock_size_x;
+  int scaling_lut_y[256];
+  int scaling_lut_cb[256];
+  int scaling_lut_cr[256];
+  int grain_min;
+  int grain_max;
+  // Number of rows of luma_subblock_size_y luma lines in the frame
+  int num_block_rows;
+} FilmGrainFrame;
+
+static void init_arrays(const aom_film_grain_t *params,
+                        int ***pred_pos_luma_p, int ***pred_pos_chroma_p,
+                        int **luma_grain_block, int **cb_grain_block,
+                        int **cr_grain_block, int luma_grain_samples,
+                        int chroma_grain_samples) {
   int num_pos_luma = 2 * params->ar_coeff_lag * (params->ar_coeff_lag + 1);
   int num_pos_chroma = num_pos_luma;
   if (params->num_y_points > 0) ++num_pos_chroma;
@@ -306,23 +332,6 @@ static void init_arrays(const aom_film_grain_t *params, int luma_stride,
   *pred_pos_luma_p = pred_pos_luma;
   *pred_pos_chroma_p = pred_pos_chroma;
 
-  *y_line_buf = (int *)aom_malloc(sizeof(**y_line_buf) * luma_stride * 2);
-  *cb_line_buf = (int *)aom_malloc(sizeof(**cb_line_buf) * chroma_stride *
-                                   (2 >> chroma_subsamp_y));
-  *cr_line_buf = (int *)aom_malloc(sizeof(**cr_line_buf) * chroma_stride *
-                                   (2 >> chroma_subsamp_y));
-
-  *y_col_buf =
-      (int *)aom_malloc(sizeof(**y_col_buf) * (luma_subblock_size_y + 2) * 2);
-  *cb_col_buf =
-      (int *)aom_malloc(sizeof(**cb_col_buf) *
-                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
-                        (2 >> chroma_subsamp_x));
-  *cr_col_buf =
-      (int *)aom_malloc(sizeof(**cr_col_buf) *
-                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
-                        (2 >> chroma_subsamp_x));
-
   *luma_grain_block =
       (int *)aom_malloc(sizeof(**luma_grain_block) * luma_grain_samples);
   *cb_grain_block =
@@ -333,10 +342,7 @@ static void init_arrays(const aom_film_grain_t *params, int luma_stride,
 
 static void dealloc_arrays(const aom_film_grain_t *params, int ***pred_pos_luma,
                            int ***pred_pos_chroma, int **luma_grain_block,
-                           int **cb_grain_block, int **cr_grain_block,
-                           int **y_line_buf, int **cb_line_buf,
-                           int **cr_line_buf, int **y_col_buf, int **cb_col_buf,
-                           int **cr_col_buf) {
+                           int **cb_grain_block, int **cr_grain_block) {
   int num_pos_luma = 2 * params->ar_coeff_lag * (params->ar_coeff_lag + 1);
   int num_pos_chroma = num_pos_luma;
   if (params->num_y_points > 0) ++num_pos_chroma;
@@ -351,18 +357,6 @@ static void dealloc_arrays(const aom_film_grain_t *params, int ***pred_pos_luma,
   }
   aom_free((*pred_pos_chroma));
 
-  aom_free(*y_line_buf);
-
-  aom_free(*cb_line_buf);
-
-  aom_free(*cr_line_buf);
-
-  aom_free(*y_col_buf);
-
-  aom_free(*cb_col_buf);
-
-  aom_free(*cr_col_buf);
-
   aom_free(*luma_grain_block);
 
   aom_free(*cb_grain_block);
@@ -371,35 +365,38 @@ static void dealloc_arrays(const aom_film_grain_t *params, int ***pred_pos_luma,
 }
 
 // get a number between 0 and 2^bits - 1
-static INLINE int get_random_number(int bits) {
+static INLINE int get_random_number(uint16_t *random_register, int bits) {
   uint16_t bit;
-  bit = ((random_register >> 0) ^ (random_register >> 1) ^
-         (random_register >> 3) ^ (random_register >> 12)) &
+  bit = ((*random_register >> 0) ^ (*random_register >> 1) ^
+         (*random_register >> 3) ^ (*random_register >> 12)) &
         1;
-  random_register = (random_register >> 1) | (bit << 15);
-  return (random_register >> (16 - bits)) & ((1 << bits) - 1);
+  *random_register = (*random_register >> 1) | (bit << 15);
+  return (*random_register >> (16 - bits)) & ((1 << bits) - 1);
 }
 
-static void init_random_generator(int luma_line, uint16_t seed) {
+// Returns the initial value of the random number generator register
+static uint16_t init_random_generator(int luma_line, uint16_t seed) {
   // same for the picture
 
   uint16_t msb = (seed >> 8) & 255;
   uint16_t lsb = seed & 255;
 
-  random_register = (msb << 8) + lsb;
+  uint16_t random_register = (msb << 8) + lsb;
 
   //  changes for each row
   int luma_num = luma_line >> 5;
 
   random_register ^= ((luma_num * 37 + 178) & 255) << 8;
   random_register ^= ((luma_num * 173 + 105) & 255);
+  return random_register;
 }
 
 // Return 0 for success, -1 for failure
 static int generate_luma_grain_block(
     const aom_film_grain_t *params, int **pred_pos_luma, int *luma_grain_block,
     int luma_block_size_y, int luma_block_size_x, int luma_grain_stride,
-    int left_pad, int top_pad, int right_pad, int bottom_pad) {
+    int left_pad, int top_pad, int right_pad, int bottom_pad, int grain_min,
+    int grain_max) {
   if (params->num_y_points == 0) {
     memset(luma_grain_block, 0,
            sizeof(*luma_grain_block) * luma_block_size_y * luma_grain_stride);
@@ -412,10 +409,12 @@ static int generate_luma_grain_block(
   int num_pos_luma = 2 * params->ar_coeff_lag * (params->ar_coeff_lag + 1);
   int rounding_offset = (1 << (params->ar_coeff_shift - 1));
 
+  uint16_t random_register = params->random_seed;
+
   for (int i = 0; i < luma_block_size_y; i++)
     for (int j = 0; j < luma_block_size_x; j++)
       luma_grain_block[i * luma_grain_stride + j] =
-          (gaussian_sequence[get_random_number(gauss_bits)] +
+          (gaussian_sequence[get_random_number(&random_register, gauss_bits)] +
            ((1 << gauss_sec_shift) >> 1)) >>
           gauss_sec_shift;
 
@@ -443,7 +442,8 @@ static int generate_chroma_grain_blocks(
     int **pred_pos_chroma, int *luma_grain_block, int *cb_grain_block,
     int *cr_grain_block, int luma_grain_stride, int chroma_block_size_y,
     int chroma_block_size_x, int chroma_grain_stride, int left_pad, int top_pad,
-    int right_pad, int bottom_pad, int chroma_subsamp_y, int chroma_subsamp_x) {
+    int right_pad, int bottom_pad, int chroma_subsamp_y, int chroma_subsamp_x,
+    int grain_min, int grain_max) {
   int bit_depth = params->bit_depth;
   int gauss_sec_shift = 12 - bit_depth + params->grain_scale_shift;
 
@@ -453,12 +453,14 @@ static int generate_chroma_grain_blocks(
   int chroma_grain_block_size = chroma_block_size_y * chroma_grain_stride;
 
   if (params->num_cb_points || params->chroma_scaling_from_luma) {
-    init_random_generator(7 << 5, params->random_seed);
+    uint16_t random_register =
+        init_random_generator(7 << 5, params->random_seed);
 
     for (int i = 0; i < chroma_block_size_y; i++)
       for (int j = 0; j < chroma_block_size_x; j++)
         cb_grain_block[i * chroma_grain_stride + j] =
-            (gaussian_sequence[get_random_number(gauss_bits)] +
+            (gaussian_sequence[get_random_number(&random_register,
+                                                 gauss_bits)] +
              ((1 << gauss_sec_shift) >> 1)) >>
             gauss_sec_shift;
   } else {
@@ -467,12 +469,14 @@ static int generate_chroma_grain_blocks(
   }
 
   if (params->num_cr_points || params->chroma_scaling_from_luma) {
-    init_random_generator(11 << 5, params->random_seed);
+    uint16_t random_register =
+        init_random_generator(11 << 5, params->random_seed);
 
     for (int i = 0; i < chroma_block_size_y; i++)
       for (int j = 0; j < chroma_block_size_x; j++)
         cr_grain_block[i * chroma_grain_stride + j] =
-            (gaussian_sequence[get_random_number(gauss_bits)] +
+            (gaussian_sequence[get_random_number(&random_register,
+                                                 gauss_bits)] +
              ((1 << gauss_sec_shift) >> 1)) >>
             gauss_sec_shift;
   } else {
@@ -558,7 +562,7 @@ static void init_scaling_function(const int scaling_points[][2], int num_points,
 
 // function that extracts samples from a LUT (and interpolates intemediate
 // frames for 10- and 12-bit video)
-static int scale_LUT(int *scaling_lut, int index, int bit_depth) {
+static int scale_LUT(const int *scaling_lut, int index, int bit_depth) {
   int x = index >> (bit_depth - 8);
 
   if (!(bit_depth - 8) || x == 255)
@@ -570,7 +574,117 @@ static int scale_LUT(int *scaling_lut, int index, int bit_depth) {
                              (bit_depth - 8));
 }
 
-static void add_noise_to_block(const aom_film_grain_t *params, uint8_t *luma,
+void aom_film_grain_add_noise_luma_c(uint8_t *luma, int luma_stride,
+                                     const int *grain, int grain_stride,
+                                     const int *scaling_lut, int width,
+                                     int height, int scaling_shift,
+                                     int min_val, int max_val) {
+  const int rounding_offset = (1 << (scaling_shift - 1));
+  for (int i = 0; i < height; i++) {
+    for (int j = 0; j < width; j++) {
+      luma[i * luma_stride + j] =
+          clamp(luma[i * luma_stride + j] +
+                    ((scale_LUT(scaling_lut, luma[i * luma_stride + j], 8) *
+                          grain[i * grain_stride + j] +
+                      rounding_offset) >>
+                     scaling_shift),
+                min_val, max_val);
+    }
+  }
+}
+
+void aom_film_grain_add_noise_chroma_c(
+    uint8_t *chroma, int chroma_stride, const uint8_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val) {
+  const int rounding_offset = (1 << (scaling_shift - 1));
+  for (int i = 0; i < height; i++) {
+    for (int j = 0; j < width; j++) {
+      int average_luma = 0;
+      if (subsamp_x) {
+        average_luma = (luma[(i << subsamp_y) * luma_stride + (j << subsamp_x)] +
+                        luma[(i << subsamp_y) * luma_stride +
+                             (j << subsamp_x) + 1] +
+                        1) >>
+                       1;
+      } else {
+        average_luma = luma[(i << subsamp_y) * luma_stride + j];
+      }
+
+      chroma[i * chroma_stride + j] = clamp(
+          chroma[i * chroma_stride + j] +
+              ((scale_LUT(scaling_lut,
+                          clamp(((average_luma * luma_mult +
+                                  chroma_mult * chroma[i * chroma_stride + j]) >>
+                                 6) +
+                                    offset,
+                                0, 255),
+                          8) *
+                    grain[i * grain_stride + j] +
+                rounding_offset) >>
+               scaling_shift),
+          min_val, max_val);
+    }
+  }
+}
+
+void aom_highbd_film_grain_add_noise_luma_c(uint16_t *luma, int luma_stride,
+                                            const int *grain, int grain_stride,
+                                            const int *scaling_lut, int width,
+                                            int height, int scaling_shift,
+                                            int min_val, int max_val, int bd) {
+  const int rounding_offset = (1 << (scaling_shift - 1));
+  for (int i = 0; i < height; i++) {
+    for (int j = 0; j < width; j++) {
+      luma[i * luma_stride + j] =
+          clamp(luma[i * luma_stride + j] +
+                    ((scale_LUT(scaling_lut, luma[i * luma_stride + j], bd) *
+                          grain[i * grain_stride + j] +
+                      rounding_offset) >>
+                     scaling_shift),
+                min_val, max_val);
+    }
+  }
+}
+
+void aom_highbd_film_grain_add_noise_chroma_c(
+    uint16_t *chroma, int chroma_stride, const uint16_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val, int bd) {
+  const int rounding_offset = (1 << (scaling_shift - 1));
+  for (int i = 0; i < height; i++) {
+    for (int j = 0; j < width; j++) {
+      int average_luma = 0;
+      if (subsamp_x) {
+        average_luma = (luma[(i << subsamp_y) * luma_stride + (j << subsamp_x)] +
+                        luma[(i << subsamp_y) * luma_stride +
+                             (j << subsamp_x) + 1] +
+                        1) >>
+                       1;
+      } else {
+        average_luma = luma[(i << subsamp_y) * luma_stride + j];
+      }
+
+      chroma[i * chroma_stride + j] = clamp(
+          chroma[i * chroma_stride + j] +
+              ((scale_LUT(scaling_lut,
+                          clamp(((average_luma * luma_mult +
+                                  chroma_mult * chroma[i * chroma_stride + j]) >>
+                                 6) +
+                                    offset,
+                                0, (256 << (bd - 8)) - 1),
+                          bd) *
+                    grain[i * grain_stride + j] +
+                rounding_offset) >>
+               scaling_shift),
+          min_val, max_val);
+    }
+  }
+}
+
+static void add_noise_to_block(const FilmGrainFrame *fg, uint8_t *luma,
                                uint8_t *cb, uint8_t *cr, int luma_stride,
                                int chroma_stride, int *luma_grain,
                                int *cb_grain, int *cr_grain,
@@ -578,6 +692,8 @@ static void add_noise_to_block(const aom_film_grain_t *params, uint8_t *luma,
                                int half_luma_height, int half_luma_width,
                                int bit_depth, int chroma_subsamp_y,
                                int chroma_subsamp_x, int mc_identity) {
+  (void)bit_depth;
+  const aom_film_grain_t *params = fg->params;
   int cb_mult = params->cb_mult - 128;            // fixed scale
   int cb_luma_mult = params->cb_luma_mult - 128;  // fixed scale
   int cb_offset = params->cb_offset - 256;
@@ -586,8 +702,6 @@ static void add_noise_to_block(const aom_film_grain_t *params, uint8_t *luma,
   int cr_luma_mult = params->cr_luma_mult - 128;  // fixed scale
   int cr_offset = params->cr_offset - 256;
 
-  int rounding_offset = (1 << (params->scaling_shift - 1));
-
   int apply_y = params->num_y_points > 0 ? 1 : 0;
   int apply_cb =
       (params->num_cb_points > 0 || params->chroma_scaling_from_luma) ? 1 : 0;
@@ -622,75 +736,41 @@ static void add_noise_to_block(const aom_film_grain_t *params, uint8_t *luma,
     max_luma = max_chroma = 255;
   }
 
-  for (int i = 0; i < (half_luma_height << (1 - chroma_subsamp_y)); i++) {
-    for (int j = 0; j < (half_luma_width << (1 - chroma_subsamp_x)); j++) {
-      int average_luma = 0;
-      if (chroma_subsamp_x) {
-        average_luma = (luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x)] +
-                        luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x) + 1] +
-                        1) >>
-                       1;
-      } else {
-        average_luma = luma[(i << chroma_subsamp_y) * luma_stride + j];
-      }
+  const int chroma_height = half_luma_height << (1 - chroma_subsamp_y);
+  const int chroma_width = half_luma_width << (1 - chroma_subsamp_x);
 
-      if (apply_cb) {
-        cb[i * chroma_stride + j] = clamp(
-            cb[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cb,
-                            clamp(((average_luma * cb_luma_mult +
-                                    cb_mult * cb[i * chroma_stride + j]) >>
-                                   6) +
-                                      cb_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            8) *
-                      cb_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
+  // The chroma noise depends on the luma samples without grain.
+  if (apply_cb) {
+    aom_film_grain_add_noise_chroma(
+        cb, chroma_stride, luma, luma_stride, cb_grain, chroma_grain_stride,
+        fg->scaling_lut_cb, chroma_width, chroma_height, chroma_subsamp_x,
+        chroma_subsamp_y, cb_luma_mult, cb_mult, cb_offset,
+        params->scaling_shift, min_chroma, max_chroma);
+  }
 
-      if (apply_cr) {
-        cr[i * chroma_stride + j] = clamp(
-            cr[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cr,
-                            clamp(((average_luma * cr_luma_mult +
-                                    cr_mult * cr[i * chroma_stride + j]) >>
-                                   6) +
-                                      cr_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            8) *
-                      cr_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
-    }
+  if (apply_cr) {
+    aom_film_grain_add_noise_chroma(
+        cr, chroma_stride, luma, luma_stride, cr_grain, chroma_grain_stride,
+        fg->scaling_lut_cr, chroma_width, chroma_height, chroma_subsamp_x,
+        chroma_subsamp_y, cr_luma_mult, cr_mult, cr_offset,
+        params->scaling_shift, min_chroma, max_chroma);
   }
 
   if (apply_y) {
-    for (int i = 0; i < (half_luma_height << 1); i++) {
-      for (int j = 0; j < (half_luma_width << 1); j++) {
-        luma[i * luma_stride + j] =
-            clamp(luma[i * luma_stride + j] +
-                      ((scale_LUT(scaling_lut_y, luma[i * luma_stride + j], 8) *
-                            luma_grain[i * luma_grain_stride + j] +
-                        rounding_offset) >>
-                       params->scaling_shift),
-                  min_luma, max_luma);
-      }
-    }
+    aom_film_grain_add_noise_luma(luma, luma_stride, luma_grain,
+                                  luma_grain_stride, fg->scaling_lut_y,
+                                  half_luma_width << 1, half_luma_height << 1,
+                                  params->scaling_shift, min_luma, max_luma);
   }
 }
 
 static void add_noise_to_block_hbd(
-    const aom_film_grain_t *params, uint16_t *luma, uint16_t *cb, uint16_t *cr,
+    const FilmGrainFrame *fg, uint16_t *luma, uint16_t *cb, uint16_t *cr,
     int luma_stride, int chroma_stride, int *luma_grain, int *cb_grain,
     int *cr_grain, int luma_grain_stride, int chroma_grain_stride,
     int half_luma_height, int half_luma_width, int bit_depth,
     int chroma_subsamp_y, int chroma_subsamp_x, int mc_identity) {
+  const aom_film_grain_t *params = fg->params;
   int cb_mult = params->cb_mult - 128;            // fixed scale
   int cb_luma_mult = params->cb_luma_mult - 128;  // fixed scale
   // offset value depends on the bit depth
@@ -701,8 +781,6 @@ static void add_noise_to_block_hbd(
   // offset value depends on the bit depth
   int cr_offset = (params->cr_offset << (bit_depth - 8)) - (1 << bit_depth);
 
-  int rounding_offset = (1 << (params->scaling_shift - 1));
-
   int apply_y = params->num_y_points > 0 ? 1 : 0;
   int apply_cb =
       (params->num_cb_points > 0 || params->chroma_scaling_from_luma) > 0 ? 1
@@ -739,66 +817,31 @@ static void add_noise_to_block_hbd(
     max_luma = max_chroma = (256 << (bit_depth - 8)) - 1;
   }
 
-  for (int i = 0; i < (half_luma_height << (1 - chroma_subsamp_y)); i++) {
-    for (int j = 0; j < (half_luma_width << (1 - chroma_subsamp_x)); j++) {
-      int average_luma = 0;
-      if (chroma_subsamp_x) {
-        average_luma = (luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x)] +
-                        luma[(i << chroma_subsamp_y) * luma_stride +
-                             (j << chroma_subsamp_x) + 1] +
-                        1) >>
-                       1;
-      } else {
-        average_luma = luma[(i << chroma_subsamp_y) * luma_stride + j];
-      }
+  const int chroma_height = half_luma_height << (1 - chroma_subsamp_y);
+  const int chroma_width = half_luma_width << (1 - chroma_subsamp_x);
 
-      if (apply_cb) {
-        cb[i * chroma_stride + j] = clamp(
-            cb[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cb,
-                            clamp(((average_luma * cb_luma_mult +
-                                    cb_mult * cb[i * chroma_stride + j]) >>
-                                   6) +
-                                      cb_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            bit_depth) *
-                      cb_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
-      if (apply_cr) {
-        cr[i * chroma_stride + j] = clamp(
-            cr[i * chroma_stride + j] +
-                ((scale_LUT(scaling_lut_cr,
-                            clamp(((average_luma * cr_luma_mult +
-                                    cr_mult * cr[i * chroma_stride + j]) >>
-                                   6) +
-                                      cr_offset,
-                                  0, (256 << (bit_depth - 8)) - 1),
-                            bit_depth) *
-                      cr_grain[i * chroma_grain_stride + j] +
-                  rounding_offset) >>
-                 params->scaling_shift),
-            min_chroma, max_chroma);
-      }
-    }
+  // The chroma noise depends on the luma samples without grain.
+  if (apply_cb) {
+    aom_highbd_film_grain_add_noise_chroma(
+        cb, chroma_stride, luma, luma_stride, cb_grain, chroma_grain_stride,
+        fg->scaling_lut_cb, chroma_width, chroma_height, chroma_subsamp_x,
+        chroma_subsamp_y, cb_luma_mult, cb_mult, cb_offset,
+        params->scaling_shift, min_chroma, max_chroma, bit_depth);
+  }
+
+  if (apply_cr) {
+    aom_highbd_film_grain_add_noise_chroma(
+        cr, chroma_stride, luma, luma_stride, cr_grain, chroma_grain_stride,
+        fg->scaling_lut_cr, chroma_width, chroma_height, chroma_subsamp_x,
+        chroma_subsamp_y, cr_luma_mult, cr_mult, cr_offset,
+        params->scaling_shift, min_chroma, max_chroma, bit_depth);
   }
 
   if (apply_y) {
-    for (int i = 0; i < (half_luma_height << 1); i++) {
-      for (int j = 0; j < (half_luma_width << 1); j++) {
-        luma[i * luma_stride + j] =
-            clamp(luma[i * luma_stride + j] +
-                      ((scale_LUT(scaling_lut_y, luma[i * luma_stride + j],
-                                  bit_depth) *
-                            luma_grain[i * luma_grain_stride + j] +
-                        rounding_offset) >>
-                       params->scaling_shift),
-                  min_luma, max_luma);
-      }
-    }
+    aom_highbd_film_grain_add_noise_luma(
+        luma, luma_stride, luma_grain, luma_grain_stride, fg->scaling_lut_y,
+        half_luma_width << 1, half_luma_height << 1, params->scaling_shift,
+        min_luma, max_luma, bit_depth);
   }
 }
 
@@ -857,7 +900,7 @@ static void extend_even(uint8_t *dst, int dst_stride, int width, int height,
 static void ver_boundary_overlap(int *left_block, int left_stride,
                                  int *right_block, int right_stride,
                                  int *dst_block, int dst_stride, int width,
-                                 int height) {
+                                 int height, int grain_min, int grain_max) {
   if (width == 1) {
     while (height) {
       *dst_block = clamp((*left_block * 23 + *right_block * 22 + 16) >> 5,
@@ -886,7 +929,7 @@ static void ver_boundary_overlap(int *left_block, int left_stride,
 static void hor_boundary_overlap(int *top_block, int top_stride,
                                  int *bottom_block, int bottom_stride,
                                  int *dst_block, int dst_stride, int width,
-                                 int height) {
+                                 int height, int grain_min, int grain_max) {
   if (height == 1) {
     while (width) {
       *dst_block = clamp((*top_block * 23 + *bottom_block * 22 + 16) >> 5,
@@ -914,132 +957,269 @@ static void hor_boundary_overlap(int *top_block, int top_stride,
   }
 }
 
-int av1_add_film_grain(const aom_film_grain_t *params, const aom_image_t *src,
-                       aom_image_t *dst) {
-  uint8_t *luma, *cb, *cr;
-  int height, width, luma_stride, chroma_stride;
-  int use_high_bit_depth = 0;
-  int chroma_subsamp_x = 0;
-  int chroma_subsamp_y = 0;
-  int mc_identity = src->mc == AOM_CICP_MC_IDENTITY ? 1 : 0;
+// Grain of the blocks processed last, for the overlap with the block row below
+// (line buffers) and with the block to the right (column buffers).
+typedef struct {
+  int *y_line_buf;
+  int *cb_line_buf;
+  int *cr_line_buf;
+  int *y_col_buf;
+  int *cb_col_buf;
+  int *cr_col_buf;
+} FilmGrainOverlapBufs;
+
+typedef struct {
+  const FilmGrainFrame *fg;
+  int row_start;
+  int row_end;
+} FilmGrainStripe;
+
+static void free_overlap_bufs(FilmGrainOverlapBufs *bufs) {
+  aom_free(bufs->y_line_buf);
+  aom_free(bufs->cb_line_buf);
+  aom_free(bufs->cr_line_buf);
+  aom_free(bufs->y_col_buf);
+  aom_free(bufs->cb_col_buf);
+  aom_free(bufs->cr_col_buf);
+}
 
-  switch (src->fmt) {
-    case AOM_IMG_FMT_AOMI420:
-    case AOM_IMG_FMT_I420:
-      use_high_bit_depth = 0;
-      chroma_subsamp_x = 1;
-      chroma_subsamp_y = 1;
-      break;
-    case AOM_IMG_FMT_I42016:
-      use_high_bit_depth = 1;
-      chroma_subsamp_x = 1;
-      chroma_subsamp_y = 1;
-      break;
-      //    case AOM_IMG_FMT_444A:
-    case AOM_IMG_FMT_I444:
-      use_high_bit_depth = 0;
-      chroma_subsamp_x = 0;
-      chroma_subsamp_y = 0;
-      break;
-    case AOM_IMG_FMT_I44416:
-      use_high_bit_depth = 1;
-      chroma_subsamp_x = 0;
-      chroma_subsamp_y = 0;
-      break;
-    case AOM_IMG_FMT_I422:
-      use_high_bit_depth = 0;
-      chroma_subsamp_x = 1;
-      chroma_subsamp_y = 0;
-      break;
-    case AOM_IMG_FMT_I42216:
-      use_high_bit_depth = 1;
-      chroma_subsamp_x = 1;
-      chroma_subsamp_y = 0;
-      break;
-    default:  // unknown input format
-      fprintf(stderr, "Film grain error: input format is not supported!");
-      return -1;
-  }
+// Return 0 for success, -1 for failure
+static int alloc_overlap_bufs(const FilmGrainFrame *fg,
+                              FilmGrainOverlapBufs *bufs) {
+  const int chroma_subsamp_y = fg->chroma_subsamp_y;
+  const int chroma_subsamp_x = fg->chroma_subsamp_x;
+  const int chroma_subblock_size_y = fg->chroma_subblock_size_y;
+
+  bufs->y_line_buf =
+      (int *)aom_malloc(sizeof(*bufs->y_line_buf) * fg->luma_stride * 2);
+  bufs->cb_line_buf = (int *)aom_malloc(
+      sizeof(*bufs->cb_line_buf) * fg->chroma_stride * (2 >> chroma_subsamp_y));
+  bufs->cr_line_buf = (int *)aom_malloc(
+      sizeof(*bufs->cr_line_buf) * fg->chroma_stride * (2 >> chroma_subsamp_y));
+
+  bufs->y_col_buf = (int *)aom_malloc(sizeof(*bufs->y_col_buf) *
+                                      (luma_subblock_size_y + 2) * 2);
+  bufs->cb_col_buf =
+      (int *)aom_malloc(sizeof(*bufs->cb_col_buf) *
+                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
+                        (2 >> chroma_subsamp_x));
+  bufs->cr_col_buf =
+      (int *)aom_malloc(sizeof(*bufs->cr_col_buf) *
+                        (chroma_subblock_size_y + (2 >> chroma_subsamp_y)) *
+                        (2 >> chroma_subsamp_x));
 
-  assert(params->bit_depth == src->bit_depth);
+  if (!bufs->y_line_buf || !bufs->cb_line_buf || !bufs->cr_line_buf ||
+      !bufs->y_col_buf || !bufs->cb_col_buf || !bufs->cr_col_buf) {
+    free_overlap_bufs(bufs);
+    return -1;
+  }
+  return 0;
+}
 
-  dst->fmt = src->fmt;
-  dst->bit_depth = src->bit_depth;
+// Copies the rows of the block rows [row_start, row_end) of the source image
+// to the output image. Note that dst is already assumed to be aligned to even.
+static void copy_src_rows(const FilmGrainFrame *fg, int row_start,
+                          int row_end) {
+  const aom_image_t *src = fg->src;
+  aom_image_t *dst = fg->dst;
+  const int use_high_bit_depth = fg->use_high_bit_depth;
+  const int y_start = row_start * luma_subblock_size_y;
+  const int y_end = AOMMIN(row_end * luma_subblock_size_y, fg->height);
+  const int src_rows = AOMMIN(y_end, (int)src->d_h) - y_start;
+
+  uint8_t *dst_luma =
+      dst->planes[AOM_PLANE_Y] + y_start * dst->stride[AOM_PLANE_Y];
+  copy_rect(src->planes[AOM_PLANE_Y] + y_start * src->stride[AOM_PLANE_Y],
+            src->stride[AOM_PLANE_Y], dst_luma, dst->stride[AOM_PLANE_Y],
+            src->d_w, src_rows, use_high_bit_depth);
+  // Only the last stripe may have an odd number of rows.
+  extend_even(dst_luma, dst->stride[AOM_PLANE_Y], src->d_w, src_rows,
+              use_high_bit_depth);
 
-  dst->r_w = src->r_w;
-  dst->r_h = src->r_h;
-  dst->d_w = src->d_w;
-  dst->d_h = src->d_h;
+  if (!src->monochrome) {
+    const int uv_start = y_start >> fg->chroma_subsamp_y;
+    const int uv_rows = (y_end >> fg->chroma_subsamp_y) - uv_start;
+    for (int plane = AOM_PLANE_U; plane <= AOM_PLANE_V; plane++) {
+      copy_rect(src->planes[plane] + uv_start * src->stride[plane],
+                src->stride[plane],
+                dst->planes[plane] + uv_start * dst->stride[plane],
+                dst->stride[plane], fg->width >> fg->chroma_subsamp_x,
+                uv_rows, use_high_bit_depth);
+    }
+  }
+}
 
-  dst->cp = src->cp;
-  dst->tc = src->tc;
-  dst->mc = src->mc;
+static void get_block_offsets(const FilmGrainFrame *fg,
+                              uint16_t *random_register, int *luma_offset_y,
+                              int *luma_offset_x, int *chroma_offset_y,
+                              int *chroma_offset_x) {
+  const int chroma_subsamp_y = fg->chroma_subsamp_y;
+  const int chroma_subsamp_x = fg->chroma_subsamp_x;
+  int offset_y = get_random_number(random_register, 8);
+  int offset_x = (offset_y >> 4) & 15;
+  offset_y &= 15;
+
+  *luma_offset_y = fg->left_pad + 2 * fg->ar_padding + (offset_y << 1);
+  *luma_offset_x = fg->top_pad + 2 * fg->ar_padding + (offset_x << 1);
+
+  *chroma_offset_y = fg->top_pad + (2 >> chroma_subsamp_y) * fg->ar_padding +
+                     offset_y * (2 >> chroma_subsamp_y);
+  *chroma_offset_x = fg->left_pad + (2 >> chroma_subsamp_x) * fg->ar_padding +
+                     offset_x * (2 >> chroma_subsamp_x);
+}
 
-  dst->monochrome = src->monochrome;
-  dst->csp = src->csp;
-  dst->range = src->range;
+// Blends the grain of the block with the column buffers, which hold the grain
+// of the block to the left
+static void blend_col_bufs(const FilmGrainFrame *fg,
+                           const FilmGrainOverlapBufs *bufs, int y,
+                           int luma_offset_y, int luma_offset_x,
+                           int chroma_offset_y, int chroma_offset_x) {
+  const int chroma_subsamp_y = fg->chroma_subsamp_y;
+  const int chroma_subsamp_x = fg->chroma_subsamp_x;
+  const int chroma_subblock_size_y = fg->chroma_subblock_size_y;
+  const int height = fg->height;
+  const int grain_min = fg->grain_min;
+  const int grain_max = fg->grain_max;
+
+  ver_boundary_overlap(
+      bufs->y_col_buf, 2,
+      fg->luma_grain_block + luma_offset_y * fg->luma_grain_stride +
+          luma_offset_x,
+      fg->luma_grain_stride, bufs->y_col_buf, 2, 2,
+      AOMMIN(luma_subblock_size_y + 2, height - (y << 1)), grain_min,
+      grain_max);
+
+  ver_boundary_overlap(
+      bufs->cb_col_buf, 2 >> chroma_subsamp_x,
+      fg->cb_grain_block + chroma_offset_y * fg->chroma_grain_stride +
+          chroma_offset_x,
+      fg->chroma_grain_stride, bufs->cb_col_buf, 2 >> chroma_subsamp_x,
+      2 >> chroma_subsamp_x,
+      AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+             (height - (y << 1)) >> chroma_subsamp_y),
+      grain_min, grain_max);
+
+  ver_boundary_overlap(
+      bufs->cr_col_buf, 2 >> chroma_subsamp_x,
+      fg->cr_grain_block + chroma_offset_y * fg->chroma_grain_stride +
+          chroma_offset_x,
+      fg->chroma_grain_stride, bufs->cr_col_buf, 2 >> chroma_subsamp_x,
+      2 >> chroma_subsamp_x,
+      AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+             (height - (y << 1)) >> chroma_subsamp_y),
+      grain_min, grain_max);
+}
 
-  dst->x_chroma_shift = src->x_chroma_shift;
-  dst->y_chroma_shift = src->y_chroma_shift;
+// Saves the grain of the block for the overlap with the block row below and
+// the block to the right
+static void save_overlap_bufs(const FilmGrainFrame *fg,
+                              const FilmGrainOverlapBufs *bufs, int x, int y,
+                              int luma_offset_y, int luma_offset_x,
+                              int chroma_offset_y, int chroma_offset_x) {
+  const int chroma_subsamp_y = fg->chroma_subsamp_y;
+  const int chroma_subsamp_x = fg->chroma_subsamp_x;
+  const int chroma_subblock_size_y = fg->chroma_subblock_size_y;
+  const int chroma_subblock_size_x = fg->chroma_subblock_size_x;
+  const int height = fg->height;
+  const int width = fg->width;
+  const int luma_stride = fg->luma_stride;
+  const int chroma_stride = fg->chroma_stride;
+  const int luma_grain_stride = fg->luma_grain_stride;
+  const int chroma_grain_stride = fg->chroma_grain_stride;
+
+  if (x) {
+    // Copy overlapped column bufer to line buffer
+    copy_area(bufs->y_col_buf + (luma_subblock_size_y << 1), 2,
+              bufs->y_line_buf + (x << 1), luma_stride, 2, 2);
+
+    copy_area(
+        bufs->cb_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
+        2 >> chroma_subsamp_x,
+        bufs->cb_line_buf + (x << (1 - chroma_subsamp_x)), chroma_stride,
+        2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
+
+    copy_area(
+        bufs->cr_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
+        2 >> chroma_subsamp_x,
+        bufs->cr_line_buf + (x << (1 - chroma_subsamp_x)), chroma_stride,
+        2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
+  }
 
-  dst->temporal_id = src->temporal_id;
-  dst->spatial_id = src->spatial_id;
+  // Copy grain to the line buffer for overlap with a bottom block
+  copy_area(fg->luma_grain_block +
+                (luma_offset_y + luma_subblock_size_y) * luma_grain_stride +
+                luma_offset_x + ((x ? 2 : 0)),
+            luma_grain_stride, bufs->y_line_buf + ((x ? x + 1 : 0) << 1),
+            luma_stride,
+            AOMMIN(luma_subblock_size_x, width - (x << 1)) - (x ? 2 : 0), 2);
 
-  width = src->d_w % 2 ? src->d_w + 1 : src->d_w;
-  height = src->d_h % 2 ? src->d_h + 1 : src->d_h;
+  copy_area(fg->cb_grain_block +
+                (chroma_offset_y + chroma_subblock_size_y) *
+                    chroma_grain_stride +
+                chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
+            chroma_grain_stride,
+            bufs->cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+            chroma_stride,
+            AOMMIN(chroma_subblock_size_x,
+                   ((width - (x << 1)) >> chroma_subsamp_x)) -
+                (x ? 2 >> chroma_subsamp_x : 0),
+            2 >> chroma_subsamp_y);
 
-  copy_rect(src->planes[AOM_PLANE_Y], src->stride[AOM_PLANE_Y],
-            dst->planes[AOM_PLANE_Y], dst->stride[AOM_PLANE_Y], src->d_w,
-            src->d_h, use_high_bit_depth);
-  // Note that dst is already assumed to be aligned to even.
-  extend_even(dst->planes[AOM_PLANE_Y], dst->stride[AOM_PLANE_Y], src->d_w,
-              src->d_h, use_high_bit_depth);
+  copy_area(fg->cr_grain_block +
+                (chroma_offset_y + chroma_subblock_size_y) *
+                    chroma_grain_stride +
+                chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
+            chroma_grain_stride,
+            bufs->cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
+            chroma_stride,
+            AOMMIN(chroma_subblock_size_x,
+                   ((width - (x << 1)) >> chroma_subsamp_x)) -
+                (x ? 2 >> chroma_subsamp_x : 0),
+            2 >> chroma_subsamp_y);
 
-  if (!src->monochrome) {
-    copy_rect(src->planes[AOM_PLANE_U], src->stride[AOM_PLANE_U],
-              dst->planes[AOM_PLANE_U], dst->stride[AOM_PLANE_U],
-              width >> chroma_subsamp_x, height >> chroma_subsamp_y,
-              use_high_bit_depth);
+  // Copy grain to the column buffer for overlap with the next block to
+  // the right
 
-    copy_rect(src->planes[AOM_PLANE_V], src->stride[AOM_PLANE_V],
-              dst->planes[AOM_PLANE_V], dst->stride[AOM_PLANE_V],
-              width >> chroma_subsamp_x, height >> chroma_subsamp_y,
-              use_high_bit_depth);
-  }
-
-  luma = dst->planes[AOM_PLANE_Y];
-  cb = dst->planes[AOM_PLANE_U];
-  cr = dst->planes[AOM_PLANE_V];
+  copy_area(fg->luma_grain_block + luma_offset_y * luma_grain_stride +
+                luma_offset_x + luma_subblock_size_x,
+            luma_grain_stride, bufs->y_col_buf, 2, 2,
+            AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
 
-  // luma and chroma strides in samples
-  luma_stride = dst->stride[AOM_PLANE_Y] >> use_high_bit_depth;
-  chroma_stride = dst->stride[AOM_PLANE_U] >> use_high_bit_depth;
+  copy_area(fg->cb_grain_block + chroma_offset_y * chroma_grain_stride +
+                chroma_offset_x + chroma_subblock_size_x,
+            chroma_grain_stride, bufs->cb_col_buf, 2 >> chroma_subsamp_x,
+            2 >> chroma_subsamp_x,
+            AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+                   (height - (y << 1)) >> chroma_subsamp_y));
 
-  return av1_add_film_grain_run(
-      params, luma, cb, cr, height, width, luma_stride, chroma_stride,
-      use_high_bit_depth, chroma_subsamp_y, chroma_subsamp_x, mc_identity);
+  copy_area(fg->cr_grain_block + chroma_offset_y * chroma_grain_stride +
+                chroma_offset_x + chroma_subblock_size_x,
+            chroma_grain_stride, bufs->cr_col_buf, 2 >> chroma_subsamp_x,
+            2 >> chroma_subsamp_x,
+            AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
+                   (height - (y << 1)) >> chroma_subsamp_y));
 }
 
-int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
-                           uint8_t *cb, uint8_t *cr, int height, int width,
-                           int luma_stride, int chroma_stride,
-                           int use_high_bit_depth, int chroma_subsamp_y,
-                           int chroma_subsamp_x, int mc_identity) {
-  int **pred_pos_luma;
-  int **pred_pos_chroma;
-  int *luma_grain_block;
-  int *cb_grain_block;
-  int *cr_grain_block;
-
-  int *y_line_buf;
-  int *cb_line_buf;
-  int *cr_line_buf;
-
-  int *y_col_buf;
-  int *cb_col_buf;
-  int *cr_col_buf;
-
-  random_register = params->random_seed;
+// Return 0 for success, -1 for failure
+static int init_grain_frame(FilmGrainFrame *fg,
+                            const aom_film_grain_t *params, uint8_t *luma,
+                            uint8_t *cb, uint8_t *cr, int height, int width,
+                            int luma_stride, int chroma_stride,
+                            int use_high_bit_depth, int chroma_subsamp_y,
+                            int chroma_subsamp_x, int mc_identity) {
+  memset(fg, 0, sizeof(*fg));
+  fg->params = params;
+  fg->luma = luma;
+  fg->cb = cb;
+  fg->cr = cr;
+  fg->height = height;
+  fg->width = width;
+  fg->luma_stride = luma_stride;
+  fg->chroma_stride = chroma_stride;
+  fg->use_high_bit_depth = use_high_bit_depth;
+  fg->chroma_subsamp_y = chroma_subsamp_y;
+  fg->chroma_subsamp_x = chroma_subsamp_x;
+  fg->mc_identity = mc_identity;
 
   int left_pad = 3;
   int right_pad = 3;  // padding to offset for AR coefficients
@@ -1048,11 +1228,10 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
 
   int ar_padding = 3;  // maximum lag used for stabilization of AR coefficients
 
-  luma_subblock_size_y = 32;
-  luma_subblock_size_x = 32;
-
-  chroma_subblock_size_y = luma_subblock_size_y >> chroma_subsamp_y;
-  chroma_subblock_size_x = luma_subblock_size_x >> chroma_subsamp_x;
+  const int chroma_subblock_size_y = luma_subblock_size_y >> chroma_subsamp_y;
+  const int chroma_subblock_size_x = luma_subblock_size_x >> chroma_subsamp_x;
+  fg->chroma_subblock_size_y = chroma_subblock_size_y;
+  fg->chroma_subblock_size_x = chroma_subblock_size_x;
 
   // Initial padding is only needed for generation of
   // film grain templates (to stabilize the AR process)
@@ -1070,98 +1249,149 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
                             chroma_subblock_size_x * 2 +
                             (2 >> chroma_subsamp_x) * ar_padding + right_pad;
 
-  int luma_grain_stride = luma_block_size_x;
-  int chroma_grain_stride = chroma_block_size_x;
+  fg->luma_grain_stride = luma_block_size_x;
+  fg->chroma_grain_stride = chroma_block_size_x;
+  fg->left_pad = left_pad;
+  fg->top_pad = top_pad;
+  fg->ar_padding = ar_padding;
+  fg->num_block_rows =
+      (height / 2 + (luma_subblock_size_y >> 1) - 1) /
+      (luma_subblock_size_y >> 1);
 
-  int overlap = params->overlap_flag;
   int bit_depth = params->bit_depth;
 
   const int grain_center = 128 << (bit_depth - 8);
-  grain_min = 0 - grain_center;
-  grain_max = grain_center - 1;
+  fg->grain_min = 0 - grain_center;
+  fg->grain_max = grain_center - 1;
 
-  init_arrays(params, luma_stride, chroma_stride, &pred_pos_luma,
-              &pred_pos_chroma, &luma_grain_block, &cb_grain_block,
-              &cr_grain_block, &y_line_buf, &cb_line_buf, &cr_line_buf,
-              &y_col_buf, &cb_col_buf, &cr_col_buf,
+  init_arrays(params, &fg->pred_pos_luma, &fg->pred_pos_chroma,
+              &fg->luma_grain_block, &fg->cb_grain_block, &fg->cr_grain_block,
               luma_block_size_y * luma_block_size_x,
-              chroma_block_size_y * chroma_block_size_x, chroma_subsamp_y,
-              chroma_subsamp_x);
+              chroma_block_size_y * chroma_block_size_x);
 
-  if (generate_luma_grain_block(params, pred_pos_luma, luma_grain_block,
-                                luma_block_size_y, luma_block_size_x,
-                                luma_grain_stride, left_pad, top_pad, right_pad,
-                                bottom_pad))
+  if (generate_luma_grain_block(params, fg->pred_pos_luma,
+                                fg->luma_grain_block, luma_block_size_y,
+                                luma_block_size_x, fg->luma_grain_stride,
+                                left_pad, top_pad, right_pad, bottom_pad,
+                                fg->grain_min, fg->grain_max))
     return -1;
 
   if (generate_chroma_grain_blocks(
           params,
           //                               pred_pos_luma,
-          pred_pos_chroma, luma_grain_block, cb_grain_block, cr_grain_block,
-          luma_grain_stride, chroma_block_size_y, chroma_block_size_x,
-          chroma_grain_stride, left_pad, top_pad, right_pad, bottom_pad,
-          chroma_subsamp_y, chroma_subsamp_x))
+          fg->pred_pos_chroma, fg->luma_grain_block, fg->cb_grain_block,
+          fg->cr_grain_block, fg->luma_grain_stride, chroma_block_size_y,
+          chroma_block_size_x, fg->chroma_grain_stride, left_pad, top_pad,
+          right_pad, bottom_pad, chroma_subsamp_y, chroma_subsamp_x,
+          fg->grain_min, fg->grain_max))
     return -1;
 
   init_scaling_function(params->scaling_points_y, params->num_y_points,
-                        scaling_lut_y);
+                        fg->scaling_lut_y);
 
   if (params->chroma_scaling_from_luma) {
-    memcpy(scaling_lut_cb, scaling_lut_y, sizeof(*scaling_lut_y) * 256);
-    memcpy(scaling_lut_cr, scaling_lut_y, sizeof(*scaling_lut_y) * 256);
+    memcpy(fg->scaling_lut_cb, fg->scaling_lut_y, sizeof(fg->scaling_lut_y));
+    memcpy(fg->scaling_lut_cr, fg->scaling_lut_y, sizeof(fg->scaling_lut_y));
   } else {
     init_scaling_function(params->scaling_points_cb, params->num_cb_points,
-                          scaling_lut_cb);
+                          fg->scaling_lut_cb);
     init_scaling_function(params->scaling_points_cr, params->num_cr_points,
-                          scaling_lut_cr);
+                          fg->scaling_lut_cr);
   }
-  for (int y = 0; y < height / 2; y += (luma_subblock_size_y >> 1)) {
-    init_random_generator(y * 2, params->random_seed);
+  return 0;
+}
 
-    for (int x = 0; x < width / 2; x += (luma_subblock_size_x >> 1)) {
-      int offset_y = get_random_number(8);
-      int offset_x = (offset_y >> 4) & 15;
-      offset_y &= 15;
+static void free_grain_frame(FilmGrainFrame *fg) {
+  dealloc_arrays(fg->params, &fg->pred_pos_luma, &fg->pred_pos_chroma,
+                 &fg->luma_grain_block, &fg->cb_grain_block,
+                 &fg->cr_grain_block);
+}
 
-      int luma_offset_y = left_pad + 2 * ar_padding + (offset_y << 1);
-      int luma_offset_x = top_pad + 2 * ar_padding + (offset_x << 1);
+// Adds grain to the block rows [row_start, row_end) of the frame. Each block
+// row covers luma_subblock_size_y luma lines. The only state carried from one
+// block row to the next one is the grain saved for the overlap, which is
+// rebuilt from the block row above the first one, so the block rows of a
+// frame can be split in stripes which are processed independently.
+// Return 0 for success, -1 for failure
+static int add_film_grain_rows(const FilmGrainFrame *fg, int row_start,
+                               int row_end) {
+  const aom_film_grain_t *params = fg->params;
+  uint8_t *luma = fg->luma;
+  uint8_t *cb = fg->cb;
+  uint8_t *cr = fg->cr;
+  const int height = fg->height;
+  const int width = fg->width;
+  const int luma_stride = fg->luma_stride;
+  const int chroma_stride = fg->chroma_stride;
+  const int use_high_bit_depth = fg->use_high_bit_depth;
+  const int chroma_subsamp_y = fg->chroma_subsamp_y;
+  const int chroma_subsamp_x = fg->chroma_subsamp_x;
+  const int chroma_subblock_size_x = fg->chroma_subblock_size_x;
+  const int mc_identity = fg->mc_identity;
+  int *luma_grain_block = fg->luma_grain_block;
+  int *cb_grain_block = fg->cb_grain_block;
+  int *cr_grain_block = fg->cr_grain_block;
+  const int luma_grain_stride = fg->luma_grain_stride;
+  const int chroma_grain_stride = fg->chroma_grain_stride;
+  const int grain_min = fg->grain_min;
+  const int grain_max = fg->grain_max;
 
-      int chroma_offset_y = top_pad + (2 >> chroma_subsamp_y) * ar_padding +
-                            offset_y * (2 >> chroma_subsamp_y);
-      int chroma_offset_x = left_pad + (2 >> chroma_subsamp_x) * ar_padding +
-                            offset_x * (2 >> chroma_subsamp_x);
+  int overlap = params->overlap_flag;
+  int bit_depth = params->bit_depth;
 
-      if (overlap && x) {
-        ver_boundary_overlap(
-            y_col_buf, 2,
-            luma_grain_block + luma_offset_y * luma_grain_stride +
-                luma_offset_x,
-            luma_grain_stride, y_col_buf, 2, 2,
-            AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
+  FilmGrainOverlapBufs bufs;
+  if (alloc_overlap_bufs(fg, &bufs)) return -1;
 
-        ver_boundary_overlap(
-            cb_col_buf, 2 >> chroma_subsamp_x,
-            cb_grain_block + chroma_offset_y * chroma_grain_stride +
-                chroma_offset_x,
-            chroma_grain_stride, cb_col_buf, 2 >> chroma_subsamp_x,
-            2 >> chroma_subsamp_x,
-            AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                   (height - (y << 1)) >> chroma_subsamp_y));
+  int *y_line_buf = bufs.y_line_buf;
+  int *cb_line_buf = bufs.cb_line_buf;
+  int *cr_line_buf = bufs.cr_line_buf;
 
-        ver_boundary_overlap(
-            cr_col_buf, 2 >> chroma_subsamp_x,
-            cr_grain_block + chroma_offset_y * chroma_grain_stride +
-                chroma_offset_x,
-            chroma_grain_stride, cr_col_buf, 2 >> chroma_subsamp_x,
-            2 >> chroma_subsamp_x,
-            AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                   (height - (y << 1)) >> chroma_subsamp_y));
+  int *y_col_buf = bufs.y_col_buf;
+  int *cb_col_buf = bufs.cb_col_buf;
+  int *cr_col_buf = bufs.cr_col_buf;
+
+  if (fg->src) copy_src_rows(fg, row_start, row_end);
+
+  const int y_start = row_start * (luma_subblock_size_y >> 1);
+  const int y_end = AOMMIN(row_end * (luma_subblock_size_y >> 1), height / 2);
+
+  if (overlap && y_start) {
+    // Rebuild the line buffers from the grain of the block row above.
+    const int y = y_start - (luma_subblock_size_y >> 1);
+    uint16_t random_register =
+        init_random_generator(y * 2, params->random_seed);
+
+    for (int x = 0; x < width / 2; x += (luma_subblock_size_x >> 1)) {
+      int luma_offset_y, luma_offset_x, chroma_offset_y, chroma_offset_x;
+      get_block_offsets(fg, &random_register, &luma_offset_y, &luma_offset_x,
+                        &chroma_offset_y, &chroma_offset_x);
+      if (x) {
+        blend_col_bufs(fg, &bufs, y, luma_offset_y, luma_offset_x,
+                       chroma_offset_y, chroma_offset_x);
+      }
+      save_overlap_bufs(fg, &bufs, x, y, luma_offset_y, luma_offset_x,
+                        chroma_offset_y, chroma_offset_x);
+    }
+  }
+
+  for (int y = y_start; y < y_end; y += (luma_subblock_size_y >> 1)) {
+    uint16_t random_register =
+        init_random_generator(y * 2, params->random_seed);
+
+    for (int x = 0; x < width / 2; x += (luma_subblock_size_x >> 1)) {
+      int luma_offset_y, luma_offset_x, chroma_offset_y, chroma_offset_x;
+      get_block_offsets(fg, &random_register, &luma_offset_y, &luma_offset_x,
+                        &chroma_offset_y, &chroma_offset_x);
+
+      if (overlap && x) {
+        blend_col_bufs(fg, &bufs, y, luma_offset_y, luma_offset_x,
+                       chroma_offset_y, chroma_offset_x);
 
         int i = y ? 1 : 0;
 
         if (use_high_bit_depth) {
           add_noise_to_block_hbd(
-              params,
+              fg,
               (uint16_t *)luma + ((y + i) << 1) * luma_stride + (x << 1),
               (uint16_t *)cb +
                   ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
@@ -1177,7 +1407,7 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
               bit_depth, chroma_subsamp_y, chroma_subsamp_x, mc_identity);
         } else {
           add_noise_to_block(
-              params, luma + ((y + i) << 1) * luma_stride + (x << 1),
+              fg, luma + ((y + i) << 1) * luma_stride + (x << 1),
               cb + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
                   (x << (1 - chroma_subsamp_x)),
               cr + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
@@ -1194,19 +1424,20 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
       if (overlap && y) {
         if (x) {
           hor_boundary_overlap(y_line_buf + (x << 1), luma_stride, y_col_buf, 2,
-                               y_line_buf + (x << 1), luma_stride, 2, 2);
+                               y_line_buf + (x << 1), luma_stride, 2, 2,
+                               grain_min, grain_max);
 
           hor_boundary_overlap(cb_line_buf + x * (2 >> chroma_subsamp_x),
                                chroma_stride, cb_col_buf, 2 >> chroma_subsamp_x,
                                cb_line_buf + x * (2 >> chroma_subsamp_x),
                                chroma_stride, 2 >> chroma_subsamp_x,
-                               2 >> chroma_subsamp_y);
+                               2 >> chroma_subsamp_y, grain_min, grain_max);
 
           hor_boundary_overlap(cr_line_buf + x * (2 >> chroma_subsamp_x),
                                chroma_stride, cr_col_buf, 2 >> chroma_subsamp_x,
                                cr_line_buf + x * (2 >> chroma_subsamp_x),
                                chroma_stride, 2 >> chroma_subsamp_x,
-                               2 >> chroma_subsamp_y);
+                               2 >> chroma_subsamp_y, grain_min, grain_max);
         }
 
         hor_boundary_overlap(
@@ -1216,7 +1447,7 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
             luma_grain_stride, y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
             AOMMIN(luma_subblock_size_x - ((x ? 1 : 0) << 1),
                    width - ((x ? x + 1 : 0) << 1)),
-            2);
+            2, grain_min, grain_max);
 
         hor_boundary_overlap(
             cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
@@ -1229,7 +1460,7 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
             AOMMIN(chroma_subblock_size_x -
                        ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
                    (width - ((x ? x + 1 : 0) << 1)) >> chroma_subsamp_x),
-            2 >> chroma_subsamp_y);
+            2 >> chroma_subsamp_y, grain_min, grain_max);
 
         hor_boundary_overlap(
             cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
@@ -1242,11 +1473,11 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
             AOMMIN(chroma_subblock_size_x -
                        ((x ? 1 : 0) << (1 - chroma_subsamp_x)),
                    (width - ((x ? x + 1 : 0) << 1)) >> chroma_subsamp_x),
-            2 >> chroma_subsamp_y);
+            2 >> chroma_subsamp_y, grain_min, grain_max);
 
         if (use_high_bit_depth) {
           add_noise_to_block_hbd(
-              params, (uint16_t *)luma + (y << 1) * luma_stride + (x << 1),
+              fg, (uint16_t *)luma + (y << 1) * luma_stride + (x << 1),
               (uint16_t *)cb + (y << (1 - chroma_subsamp_y)) * chroma_stride +
                   (x << ((1 - chroma_subsamp_x))),
               (uint16_t *)cr + (y << (1 - chroma_subsamp_y)) * chroma_stride +
@@ -1259,7 +1490,7 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
               chroma_subsamp_y, chroma_subsamp_x, mc_identity);
         } else {
           add_noise_to_block(
-              params, luma + (y << 1) * luma_stride + (x << 1),
+              fg, luma + (y << 1) * luma_stride + (x << 1),
               cb + (y << (1 - chroma_subsamp_y)) * chroma_stride +
                   (x << ((1 - chroma_subsamp_x))),
               cr + (y << (1 - chroma_subsamp_y)) * chroma_stride +
@@ -1278,7 +1509,7 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
 
       if (use_high_bit_depth) {
         add_noise_to_block_hbd(
-            params,
+            fg,
             (uint16_t *)luma + ((y + i) << 1) * luma_stride + ((x + j) << 1),
             (uint16_t *)cb +
                 ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
@@ -1303,7 +1534,7 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
             chroma_subsamp_y, chroma_subsamp_x, mc_identity);
       } else {
         add_noise_to_block(
-            params, luma + ((y + i) << 1) * luma_stride + ((x + j) << 1),
+            fg, luma + ((y + i) << 1) * luma_stride + ((x + j) << 1),
             cb + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
                 ((x + j) << (1 - chroma_subsamp_x)),
             cr + ((y + i) << (1 - chroma_subsamp_y)) * chroma_stride +
@@ -1326,83 +1557,175 @@ int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
       }
 
       if (overlap) {
-        if (x) {
-          // Copy overlapped column bufer to line buffer
-          copy_area(y_col_buf + (luma_subblock_size_y << 1), 2,
-                    y_line_buf + (x << 1), luma_stride, 2, 2);
-
-          copy_area(
-              cb_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
-              2 >> chroma_subsamp_x,
-              cb_line_buf + (x << (1 - chroma_subsamp_x)), chroma_stride,
-              2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
-
-          copy_area(
-              cr_col_buf + (chroma_subblock_size_y << (1 - chroma_subsamp_x)),
-              2 >> chroma_subsamp_x,
-              cr_line_buf + (x << (1 - chroma_subsamp_x)), chroma_stride,
-              2 >> chroma_subsamp_x, 2 >> chroma_subsamp_y);
-        }
-
-        // Copy grain to the line buffer for overlap with a bottom block
-        copy_area(
-            luma_grain_block +
-                (luma_offset_y + luma_subblock_size_y) * luma_grain_stride +
-                luma_offset_x + ((x ? 2 : 0)),
-            luma_grain_stride, y_line_buf + ((x ? x + 1 : 0) << 1), luma_stride,
-            AOMMIN(luma_subblock_size_x, width - (x << 1)) - (x ? 2 : 0), 2);
-
-        copy_area(cb_grain_block +
-                      (chroma_offset_y + chroma_subblock_size_y) *
-                          chroma_grain_stride +
-                      chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
-                  chroma_grain_stride,
-                  cb_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-                  chroma_stride,
-                  AOMMIN(chroma_subblock_size_x,
-                         ((width - (x << 1)) >> chroma_subsamp_x)) -
-                      (x ? 2 >> chroma_subsamp_x : 0),
-                  2 >> chroma_subsamp_y);
-
-        copy_area(cr_grain_block +
-                      (chroma_offset_y + chroma_subblock_size_y) *
-                          chroma_grain_stride +
-                      chroma_offset_x + (x ? 2 >> chroma_subsamp_x : 0),
-                  chroma_grain_stride,
-                  cr_line_buf + ((x ? x + 1 : 0) << (1 - chroma_subsamp_x)),
-                  chroma_stride,
-                  AOMMIN(chroma_subblock_size_x,
-                         ((width - (x << 1)) >> chroma_subsamp_x)) -
-                      (x ? 2 >> chroma_subsamp_x : 0),
-                  2 >> chroma_subsamp_y);
-
-        // Copy grain to the column buffer for overlap with the next block to
-        // the right
-
-        copy_area(luma_grain_block + luma_offset_y * luma_grain_stride +
-                      luma_offset_x + luma_subblock_size_x,
-                  luma_grain_stride, y_col_buf, 2, 2,
-                  AOMMIN(luma_subblock_size_y + 2, height - (y << 1)));
-
-        copy_area(cb_grain_block + chroma_offset_y * chroma_grain_stride +
-                      chroma_offset_x + chroma_subblock_size_x,
-                  chroma_grain_stride, cb_col_buf, 2 >> chroma_subsamp_x,
-                  2 >> chroma_subsamp_x,
-                  AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                         (height - (y << 1)) >> chroma_subsamp_y));
-
-        copy_area(cr_grain_block + chroma_offset_y * chroma_grain_stride +
-                      chroma_offset_x + chroma_subblock_size_x,
-                  chroma_grain_stride, cr_col_buf, 2 >> chroma_subsamp_x,
-                  2 >> chroma_subsamp_x,
-                  AOMMIN(chroma_subblock_size_y + (2 >> chroma_subsamp_y),
-                         (height - (y << 1)) >> chroma_subsamp_y));
+        save_overlap_bufs(fg, &bufs, x, y, luma_offset_y, luma_offset_x,
+                          chroma_offset_y, chroma_offset_x);
       }
     }
   }
 
-  dealloc_arrays(params, &pred_pos_luma, &pred_pos_chroma, &luma_grain_block,
-                 &cb_grain_block, &cr_grain_block, &y_line_buf, &cb_line_buf,
-                 &cr_line_buf, &y_col_buf, &cb_col_buf, &cr_col_buf);
+  free_overlap_bufs(&bufs);
   return 0;
 }
+
+static int film_grain_stripe_hook(void *arg1, void *unused) {
+  (void)unused;
+  const FilmGrainStripe *const stripe = (const FilmGrainStripe *)arg1;
+  return !add_film_grain_rows(stripe->fg, stripe->row_start, stripe->row_end);
+}
+
+int av1_add_film_grain_mt(const aom_film_grain_t *params,
+                          const aom_image_t *src, aom_image_t *dst,
+                          AVxWorker *workers, int num_workers) {
+  uint8_t *luma, *cb, *cr;
+  int height, width, luma_stride, chroma_stride;
+  int use_high_bit_depth = 0;
+  int chroma_subsamp_x = 0;
+  int chroma_subsamp_y = 0;
+  int mc_identity = src->mc == AOM_CICP_MC_IDENTITY ? 1 : 0;
+
+  switch (src->fmt) {
+    case AOM_IMG_FMT_AOMI420:
+    case AOM_IMG_FMT_I420:
+      use_high_bit_depth = 0;
+      chroma_subsamp_x = 1;
+      chroma_subsamp_y = 1;
+      break;
+    case AOM_IMG_FMT_I42016:
+      use_high_bit_depth = 1;
+      chroma_subsamp_x = 1;
+      chroma_subsamp_y = 1;
+      break;
+      //    case AOM_IMG_FMT_444A:
+    case AOM_IMG_FMT_I444:
+      use_high_bit_depth = 0;
+      chroma_subsamp_x = 0;
+      chroma_subsamp_y = 0;
+      break;
+    case AOM_IMG_FMT_I44416:
+      use_high_bit_depth = 1;
+      chroma_subsamp_x = 0;
+      chroma_subsamp_y = 0;
+      break;
+    case AOM_IMG_FMT_I422:
+      use_high_bit_depth = 0;
+      chroma_subsamp_x = 1;
+      chroma_subsamp_y = 0;
+      break;
+    case AOM_IMG_FMT_I42216:
+      use_high_bit_depth = 1;
+      chroma_subsamp_x = 1;
+      chroma_subsamp_y = 0;
+      break;
+    default:  // unknown input format
+      fprintf(stderr, "Film grain error: input format is not supported!");
+      return -1;
+  }
+
+  assert(params->bit_depth == src->bit_depth);
+
+  dst->fmt = src->fmt;
+  dst->bit_depth = src->bit_depth;
+
+  dst->r_w = src->r_w;
+  dst->r_h = src->r_h;
+  dst->d_w = src->d_w;
+  dst->d_h = src->d_h;
+
+  dst->cp = src->cp;
+  dst->tc = src->tc;
+  dst->mc = src->mc;
+
+  dst->monochrome = src->monochrome;
+  dst->csp = src->csp;
+  dst->range = src->range;
+
+  dst->x_chroma_shift = src->x_chroma_shift;
+  dst->y_chroma_shift = src->y_chroma_shift;
+
+  dst->temporal_id = src->temporal_id;
+  dst->spatial_id = src->spatial_id;
+
+  width = src->d_w % 2 ? src->d_w + 1 : src->d_w;
+  height = src->d_h % 2 ? src->d_h + 1 : src->d_h;
+
+  luma = dst->planes[AOM_PLANE_Y];
+  cb = dst->planes[AOM_PLANE_U];
+  cr = dst->planes[AOM_PLANE_V];
+
+  // luma and chroma strides in samples
+  luma_stride = dst->stride[AOM_PLANE_Y] >> use_high_bit_depth;
+  chroma_stride = dst->stride[AOM_PLANE_U] >> use_high_bit_depth;
+
+  // av1_add_film_grain() is exported, so the caller may not have set up the
+  // dsp functions. This only runs once.
+  aom_dsp_rtcd();
+
+  FilmGrainFrame fg;
+  int ret = init_grain_frame(&fg, params, luma, cb, cr, height, width,
+                             luma_stride, chroma_stride, use_high_bit_depth,
+                             chroma_subsamp_y, chroma_subsamp_x, mc_identity);
+  fg.src = src;
+  fg.dst = dst;
+
+  const int num_stripes = AOMMIN(num_workers, fg.num_block_rows);
+  if (ret || num_stripes <= 1) {
+    if (!ret) ret = add_film_grain_rows(&fg, 0, fg.num_block_rows);
+    free_grain_frame(&fg);
+    return ret;
+  }
+
+  FilmGrainStripe *const stripes =
+      (FilmGrainStripe *)aom_malloc(num_stripes * sizeof(*stripes));
+  if (!stripes) {
+    free_grain_frame(&fg);
+    return -1;
+  }
+
+  // The last worker is run on the calling thread.
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  const int first_worker = num_workers - num_stripes;
+  for (int i = 0; i < num_stripes; i++) {
+    FilmGrainStripe *const stripe = &stripes[i];
+    AVxWorker *const worker = &workers[first_worker + i];
+    stripe->fg = &fg;
+    stripe->row_start = i * fg.num_block_rows / num_stripes;
+    stripe->row_end = (i + 1) * fg.num_block_rows / num_stripes;
+
+    worker->hook = film_grain_stripe_hook;
+    worker->data1 = stripe;
+    worker->data2 = NULL;
+    worker->had_error = 0;
+    if (i == num_stripes - 1)
+      winterface->execute(worker);
+    else
+      winterface->launch(worker);
+  }
+
+  for (int i = 0; i < num_stripes; i++) {
+    if (!winterface->sync(&workers[first_worker + i])) ret = -1;
+  }
+
+  aom_free(stripes);
+  free_grain_frame(&fg);
+  return ret;
+}
+
+int av1_add_film_grain(const aom_film_grain_t *params, const aom_image_t *src,
+                       aom_image_t *dst) {
+  return av1_add_film_grain_mt(params, src, dst, NULL, 0);
+}
+
+int av1_add_film_grain_run(const aom_film_grain_t *params, uint8_t *luma,
+                           uint8_t *cb, uint8_t *cr, int height, int width,
+                           int luma_stride, int chroma_stride,
+                           int use_high_bit_depth, int chroma_subsamp_y,
+                           int chroma_subsamp_x, int mc_identity) {
+  aom_dsp_rtcd();
+  FilmGrainFrame fg;
+  int ret = init_grain_frame(&fg, params, luma, cb, cr, height, width,
+                             luma_stride, chroma_stride, use_high_bit_depth,
+                             chroma_subsamp_y, chroma_subsamp_x, mc_identity);
+  if (!ret) ret = add_film_grain_rows(&fg, 0, fg.num_block_rows);
+  free_grain_frame(&fg);
+  return ret;
+}
@@ -16,6 +16,8 @@
 #ifndef AOM_AOM_DSP_GRAIN_SYNTHESIS_H_
 #define AOM_AOM_DSP_GRAIN_SYNTHESIS_H_
 
+#include "aom_util/aom_thread.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -185,6 +187,24 @@ int av1_add_film_grain_run(const aom_film_grain_t *grain_params, uint8_t *luma,
 int av1_add_film_grain(const aom_film_grain_t *grain_params,
                        const aom_image_t *src, aom_image_t *dst);
 
+/*!\brief Add film grain using several threads
+ *
+ * Same as av1_add_film_grain(), with the image split into horizontal stripes
+ * which are processed in parallel. The last worker is run on the calling
+ * thread, the others must have been reset.
+ *
+ * Returns 0 for success, -1 for failure
+ *
+ * \param[in]    grain_params     Grain parameters
+ * \param[in]    src              Source image
+ * \param[out]   dst              Resulting image with grain
+ * \param[in]    workers          Workers
+ * \param[in]    num_workers      Number of workers
+ */
+int av1_add_film_grain_mt(const aom_film_grain_t *grain_params,
+                          const aom_image_t *src, aom_image_t *dst,
+                          AVxWorker *workers, int num_workers);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
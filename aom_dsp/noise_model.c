@@ -14,10 +14,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config/aom_dsp_rtcd.h"
+
 #include "aom_dsp/aom_dsp_common.h"
 #include "aom_dsp/noise_model.h"
 #include "aom_dsp/noise_util.h"
 #include "aom_mem/aom_mem.h"
+#include "aom_util/aom_job_scheduler.h"
 #include "av1/common/common.h"
 #include "av1/encoder/mathutils.h"
 
@@ -550,111 +553,237 @@ static int compare_scores(const void *a, const void *b) {
   return 0;
 }
 
-int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
-                              const uint8_t *const data, int w, int h,
-                              int stride, uint8_t *flat_blocks) {
+// The sums are accumulated in 4 partial sums, the one of column x being
+// (x - 1) % 4, which are only added together at the end. The SIMD versions
+// keep the partial sums in the lanes of a vector, and so give the same
+// results.
+void aom_flat_block_gradient_stats_c(const double *block, int block_size,
+                                     double *sum_gxx, double *sum_gxy,
+                                     double *sum_gyy, double *sum,
+                                     double *sum_sq) {
+  double gxx[4] = { 0 }, gxy[4] = { 0 }, gyy[4] = { 0 };
+  double s[4] = { 0 }, sq[4] = { 0 };
+  for (int yi = 1; yi < block_size - 1; ++yi) {
+    const double *row = block + yi * block_size;
+    for (int xi = 1; xi < block_size - 1; ++xi) {
+      const int k = (xi - 1) & 3;
+      const double gx = (row[xi + 1] - row[xi - 1]) / 2;
+      const double gy = (row[xi + block_size] - row[xi - block_size]) / 2;
+      gxx[k] += gx * gx;
+      gxy[k] += gx * gy;
+      gyy[k] += gy * gy;
+      s[k] += row[xi];
+      sq[k] += row[xi] * row[xi];
+    }
+  }
+  *sum_gxx = (gxx[0] + gxx[2]) + (gxx[1] + gxx[3]);
+  *sum_gxy = (gxy[0] + gxy[2]) + (gxy[1] + gxy[3]);
+  *sum_gyy = (gyy[0] + gyy[2]) + (gyy[1] + gyy[3]);
+  *sum = (s[0] + s[2]) + (s[1] + s[3]);
+  *sum_sq = (sq[0] + sq[2]) + (sq[1] + sq[3]);
+}
+
+// Runs 'hook' on the first 'num_threads' workers, with the elements of
+// 'thread_data', each of 'size' bytes. As for the encoder workers, the first
+// worker is run on the calling thread. Returns 0 if a worker failed.
+static int run_noise_workers(AVxWorker *workers, int num_threads,
+                             AVxWorkerHook hook, void *thread_data,
+                             size_t size) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  int ret = 1;
+  for (int i = num_threads - 1; i >= 0; --i) {
+    AVxWorker *const worker = &workers[i];
+    worker->hook = hook;
+    worker->data1 = (uint8_t *)thread_data + i * size;
+    worker->data2 = NULL;
+    worker->had_error = 0;
+    if (i == 0)
+      winterface->execute(worker);
+    else
+      winterface->launch(worker);
+  }
+  for (int i = num_threads - 1; i >= 0; --i) {
+    if (!winterface->sync(&workers[i])) ret = 0;
+  }
+  return ret;
+}
+
+// Frame wide state of aom_flat_block_finder_run_mt(), shared by the threads.
+typedef struct {
+  const aom_flat_block_finder_t *block_finder;
+  const uint8_t *data;
+  int w;
+  int h;
+  int stride;
+  int num_blocks_w;
+  uint8_t *flat_blocks;
+  index_and_score_t *scores;
+  AVxJobScheduler job_sched;
+} FlatBlockFinderJobs;
+
+typedef struct {
+  FlatBlockFinderJobs *jobs;
+  int queue;
+  double *plane;
+  double *block;
+  // Number of blocks found flat by the thresholds in the rows of the thread.
+  int num_flat;
+} FlatBlockFinderThreadData;
+
+// Scores the blocks of the block row 'by'. Returns the number of blocks which
+// pass the flatness thresholds.
+static int flat_block_finder_row(const FlatBlockFinderJobs *jobs, double *plane,
+                                 double *block, int by) {
   // The gradient-based features used in this code are based on:
   //  A. Kokaram, D. Kelly, H. Denman and A. Crawford, "Measuring noise
   //  correlation for improved video denoising," 2012 19th, ICIP.
   // The thresholds are more lenient to allow for correct grain modeling
   // if extreme cases.
+  const aom_flat_block_finder_t *block_finder = jobs->block_finder;
   const int block_size = block_finder->block_size;
   const int n = block_size * block_size;
   const double kTraceThreshold = 0.15 / (32 * 32);
   const double kRatioThreshold = 1.25;
   const double kNormThreshold = 0.08 / (32 * 32);
   const double kVarThreshold = 0.005 / (double)n;
+  const int num_blocks_w = jobs->num_blocks_w;
+  int num_flat = 0;
+
+  for (int bx = 0; bx < num_blocks_w; ++bx) {
+    // Compute gradient covariance matrix.
+    double Gxx, Gxy, Gyy;
+    double var;
+    double mean;
+    aom_flat_block_finder_extract_block(block_finder, jobs->data, jobs->w,
+                                        jobs->h, jobs->stride, bx * block_size,
+                                        by * block_size, plane, block);
+    aom_flat_block_gradient_stats(block, block_size, &Gxx, &Gxy, &Gyy, &mean,
+                                  &var);
+    mean /= (block_size - 2) * (block_size - 2);
+
+    // Normalize gradients by block_size.
+    Gxx /= ((block_size - 2) * (block_size - 2));
+    Gxy /= ((block_size - 2) * (block_size - 2));
+    Gyy /= ((block_size - 2) * (block_size - 2));
+    var = var / ((block_size - 2) * (block_size - 2)) - mean * mean;
+
+    {
+      const double trace = Gxx + Gyy;
+      const double det = Gxx * Gyy - Gxy * Gxy;
+      const double e1 = (trace + sqrt(trace * trace - 4 * det)) / 2.;
+      const double e2 = (trace - sqrt(trace * trace - 4 * det)) / 2.;
+      const double norm = e1;  // Spectral norm
+      const double ratio = (e1 / AOMMAX(e2, 1e-6));
+      const int is_flat = (trace < kTraceThreshold) &&
+                          (ratio < kRatioThreshold) &&
+                          (norm < kNormThreshold) && (var > kVarThreshold);
+      // The following weights are used to combine the above features to give
+      // a sigmoid score for flatness. If the input was normalized to [0,100]
+      // the magnitude of these values would be close to 1 (e.g., weights
+      // corresponding to variance would be a factor of 10000x smaller).
+      // The weights are given in the following order:
+      //    [{var}, {ratio}, {trace}, {norm}, offset]
+      // with one of the most discriminative being simply the variance.
+      const double weights[5] = { -6682, -0.2056, 13087, -12434, 2.5694 };
+      double sum_weights = weights[0] * var + weights[1] * ratio +
+                           weights[2] * trace + weights[3] * norm +
+                           weights[4];
+      // clamp the value to [-25.0, 100.0] to prevent overflow
+      sum_weights = fclamp(sum_weights, -25.0, 100.0);
+      const float score = (float)(1.0 / (1 + exp(-sum_weights)));
+      jobs->flat_blocks[by * num_blocks_w + bx] = is_flat ? 255 : 0;
+      jobs->scores[by * num_blocks_w + bx].score =
+          var > kVarThreshold ? score : 0;
+      jobs->scores[by * num_blocks_w + bx].index = by * num_blocks_w + bx;
+#ifdef NOISE_MODEL_LOG_SCORE
+      fprintf(stderr, "%g %g %g %g %g %d ", score, var, ratio, trace, norm,
+              is_flat);
+#endif
+      num_flat += is_flat;
+    }
+  }
+#ifdef NOISE_MODEL_LOG_SCORE
+  fprintf(stderr, "\n");
+#endif
+  return num_flat;
+}
+
+static int flat_block_finder_hook(void *arg1, void *unused) {
+  (void)unused;
+  FlatBlockFinderThreadData *const thread_data =
+      (FlatBlockFinderThreadData *)arg1;
+  FlatBlockFinderJobs *const jobs = thread_data->jobs;
+  int by;
+  while ((by = aom_job_scheduler_get_job(&jobs->job_sched,
+                                         thread_data->queue)) >= 0) {
+    thread_data->num_flat += flat_block_finder_row(jobs, thread_data->plane,
+                                                   thread_data->block, by);
+  }
+  return 1;
+}
+
+int aom_flat_block_finder_run_mt(const aom_flat_block_finder_t *block_finder,
+                                 const uint8_t *const data, int w, int h,
+                                 int stride, uint8_t *flat_blocks,
+                                 AVxWorker *workers, int num_workers) {
+  const int block_size = block_finder->block_size;
+  const int n = block_size * block_size;
   const int num_blocks_w = (w + block_size - 1) / block_size;
   const int num_blocks_h = (h + block_size - 1) / block_size;
+  const int num_threads = AOMMAX(AOMMIN(num_workers, num_blocks_h), 1);
   int num_flat = 0;
-  int bx = 0, by = 0;
-  double *plane = (double *)aom_malloc(n * sizeof(*plane));
-  double *block = (double *)aom_malloc(n * sizeof(*block));
+  int alloc_success = 1;
+  FlatBlockFinderJobs jobs;
+  FlatBlockFinderThreadData *thread_data =
+      (FlatBlockFinderThreadData *)aom_calloc(num_threads,
+                                              sizeof(*thread_data));
   index_and_score_t *scores = (index_and_score_t *)aom_malloc(
       num_blocks_w * num_blocks_h * sizeof(*scores));
-  if (plane == NULL || block == NULL || scores == NULL) {
+  memset(&jobs, 0, sizeof(jobs));
+  if (thread_data != NULL) {
+    for (int i = 0; i < num_threads; ++i) {
+      thread_data[i].jobs = &jobs;
+      thread_data[i].queue = i;
+      thread_data[i].plane = (double *)aom_malloc(n * sizeof(double));
+      thread_data[i].block = (double *)aom_malloc(n * sizeof(double));
+      alloc_success &=
+          thread_data[i].plane != NULL && thread_data[i].block != NULL;
+    }
+  }
+  if (num_threads > 1 && thread_data != NULL) {
+    alloc_success &= !aom_job_scheduler_alloc(&jobs.job_sched, num_threads);
+  }
+  if (thread_data == NULL || scores == NULL || !alloc_success) {
     fprintf(stderr, "Failed to allocate memory for block of size %d\n", n);
-    aom_free(plane);
-    aom_free(block);
-    aom_free(scores);
-    return -1;
+    num_flat = -1;
+    goto free_and_return;
   }
 
+  jobs.block_finder = block_finder;
+  jobs.data = data;
+  jobs.w = w;
+  jobs.h = h;
+  jobs.stride = stride;
+  jobs.num_blocks_w = num_blocks_w;
+  jobs.flat_blocks = flat_blocks;
+  jobs.scores = scores;
+
 #ifdef NOISE_MODEL_LOG_SCORE
   fprintf(stderr, "score = [");
 #endif
-  for (by = 0; by < num_blocks_h; ++by) {
-    for (bx = 0; bx < num_blocks_w; ++bx) {
-      // Compute gradient covariance matrix.
-      double Gxx = 0, Gxy = 0, Gyy = 0;
-      double var = 0;
-      double mean = 0;
-      int xi, yi;
-      aom_flat_block_finder_extract_block(block_finder, data, w, h, stride,
-                                          bx * block_size, by * block_size,
-                                          plane, block);
-
-      for (yi = 1; yi < block_size - 1; ++yi) {
-        for (xi = 1; xi < block_size - 1; ++xi) {
-          const double gx = (block[yi * block_size + xi + 1] -
-                             block[yi * block_size + xi - 1]) /
-                            2;
-          const double gy = (block[yi * block_size + xi + block_size] -
-                             block[yi * block_size + xi - block_size]) /
-                            2;
-          Gxx += gx * gx;
-          Gxy += gx * gy;
-          Gyy += gy * gy;
-
-          mean += block[yi * block_size + xi];
-          var += block[yi * block_size + xi] * block[yi * block_size + xi];
-        }
-      }
-      mean /= (block_size - 2) * (block_size - 2);
-
-      // Normalize gradients by block_size.
-      Gxx /= ((block_size - 2) * (block_size - 2));
-      Gxy /= ((block_size - 2) * (block_size - 2));
-      Gyy /= ((block_size - 2) * (block_size - 2));
-      var = var / ((block_size - 2) * (block_size - 2)) - mean * mean;
-
-      {
-        const double trace = Gxx + Gyy;
-        const double det = Gxx * Gyy - Gxy * Gxy;
-        const double e1 = (trace + sqrt(trace * trace - 4 * det)) / 2.;
-        const double e2 = (trace - sqrt(trace * trace - 4 * det)) / 2.;
-        const double norm = e1;  // Spectral norm
-        const double ratio = (e1 / AOMMAX(e2, 1e-6));
-        const int is_flat = (trace < kTraceThreshold) &&
-                            (ratio < kRatioThreshold) &&
-                            (norm < kNormThreshold) && (var > kVarThreshold);
-        // The following weights are used to combine the above features to give
-        // a sigmoid score for flatness. If the input was normalized to [0,100]
-        // the magnitude of these values would be close to 1 (e.g., weights
-        // corresponding to variance would be a factor of 10000x smaller).
-        // The weights are given in the following order:
-        //    [{var}, {ratio}, {trace}, {norm}, offset]
-        // with one of the most discriminative being simply the variance.
-        const double weights[5] = { -6682, -0.2056, 13087, -12434, 2.5694 };
-        double sum_weights = weights[0] * var + weights[1] * ratio +
-                             weights[2] * trace + weights[3] * norm +
-                             weights[4];
-        // clamp the value to [-25.0, 100.0] to prevent overflow
-        sum_weights = fclamp(sum_weights, -25.0, 100.0);
-        const float score = (float)(1.0 / (1 + exp(-sum_weights)));
-        flat_blocks[by * num_blocks_w + bx] = is_flat ? 255 : 0;
-        scores[by * num_blocks_w + bx].score = var > kVarThreshold ? score : 0;
-        scores[by * num_blocks_w + bx].index = by * num_blocks_w + bx;
-#ifdef NOISE_MODEL_LOG_SCORE
-        fprintf(stderr, "%g %g %g %g %g %d ", score, var, ratio, trace, norm,
-                is_flat);
-#endif
-        num_flat += is_flat;
-      }
+  if (num_threads > 1) {
+    aom_job_scheduler_reset(&jobs.job_sched, num_blocks_h, num_threads);
+    if (!run_noise_workers(workers, num_threads, flat_block_finder_hook,
+                           thread_data, sizeof(*thread_data))) {
+      num_flat = -1;
+      goto free_and_return;
+    }
+    for (int i = 0; i < num_threads; ++i) num_flat += thread_data[i].num_flat;
+  } else {
+    for (int by = 0; by < num_blocks_h; ++by) {
+      num_flat += flat_block_finder_row(&jobs, thread_data[0].plane,
+                                        thread_data[0].block, by);
     }
-#ifdef NOISE_MODEL_LOG_SCORE
-    fprintf(stderr, "\n");
-#endif
   }
 #ifdef NOISE_MODEL_LOG_SCORE
   fprintf(stderr, "];\n");
@@ -671,12 +800,27 @@ int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
       flat_blocks[scores[i].index] |= 1;
     }
   }
-  aom_free(block);
-  aom_free(plane);
+
+free_and_return:
+  if (thread_data != NULL) {
+    for (int i = 0; i < num_threads; ++i) {
+      aom_free(thread_data[i].block);
+      aom_free(thread_data[i].plane);
+    }
+  }
+  aom_job_scheduler_free(&jobs.job_sched);
+  aom_free(thread_data);
   aom_free(scores);
   return num_flat;
 }
 
+int aom_flat_block_finder_run(const aom_flat_block_finder_t *block_finder,
+                              const uint8_t *const data, int w, int h,
+                              int stride, uint8_t *flat_blocks) {
+  return aom_flat_block_finder_run_mt(block_finder, data, w, h, stride,
+                                      flat_blocks, NULL, 0);
+}
+
 int aom_noise_model_init(aom_noise_model_t *model,
                          const aom_noise_model_params_t params) {
   const int n = num_coeffs(params);
@@ -1278,9 +1422,17 @@ int aom_noise_model_get_grain_parameters(aom_noise_model_t *const noise_model,
   return 1;
 }
 
-static void pointwise_multiply(const float *a, float *b, int n) {
-  for (int i = 0; i < n; ++i) {
-    b[i] *= a[i];
+void aom_noise_overlap_add_c(float *dst, int dst_stride, const float *block,
+                             const float *plane, const float *window, int w,
+                             int h) {
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const int i = y * w + x;
+      // Apply the window function to the plane approximation, and then to the
+      // sum of plane + block.
+      const float plane_w = plane[i] * window[i];
+      dst[y * dst_stride + x] += (block[i] + plane_w) * window[i];
+    }
   }
 }
 
@@ -1332,23 +1484,103 @@ static float *get_half_cos_window(int block_size) {
 DITHER_AND_QUANTIZE(uint8_t, lowbd);
 DITHER_AND_QUANTIZE(uint16_t, highbd);
 
-int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
-                          int w, int h, int stride[3], int chroma_sub[2],
-                          float *noise_psd[3], int block_size, int bit_depth,
-                          int use_highbd) {
-  float *plane = NULL, *block = NULL, *window_full = NULL,
-        *window_chroma = NULL;
-  double *block_d = NULL, *plane_d = NULL;
-  struct aom_noise_tx_t *tx_full = NULL;
-  struct aom_noise_tx_t *tx_chroma = NULL;
+// State of the pass of aom_wiener_denoise_2d_mt() over one of the four
+// overlapped block grids of a plane, shared by the threads.
+typedef struct {
+  const aom_flat_block_finder_t *block_finder;
+  const uint8_t *data;
+  int w;
+  int h;
+  int stride;
+  // Block size in the plane, and offset of the block grid.
+  int block_size;
+  int offsx;
+  int offsy;
+  int num_blocks_w;
+  const float *window;
+  const float *noise_psd;
+  float *result;
+  int result_stride;
+  AVxJobScheduler job_sched;
+} WienerDenoiseJobs;
+
+typedef struct {
+  WienerDenoiseJobs *jobs;
+  int queue;
+  struct aom_noise_tx_t *tx_full;
+  struct aom_noise_tx_t *tx_chroma;
+  // Transform of the plane being denoised, one of the above.
+  struct aom_noise_tx_t *tx;
+  float *plane;
+  float *block;
+  double *plane_d;
+  double *block_d;
+} WienerDenoiseThreadData;
+
+// Denoises the block row 'by' of the block grid, and adds the result to the
+// rows of jobs->result it covers. These rows are not covered by other block
+// rows of the same grid.
+static void wiener_denoise_row(const WienerDenoiseJobs *jobs,
+                               WienerDenoiseThreadData *thread_data, int by) {
+  const int block_size = jobs->block_size;
+  const int pixels_per_block = block_size * block_size;
+  const float *window_function = jobs->window;
+  float *plane = thread_data->plane;
+  float *block = thread_data->block;
+  double *plane_d = thread_data->plane_d;
+  double *block_d = thread_data->block_d;
+  const int result_y = (by + 1) * block_size + jobs->offsy;
+  float *result_row = jobs->result + result_y * jobs->result_stride;
+  // Pad the boundary when processing each block-set.
+  for (int bx = -1; bx < jobs->num_blocks_w; ++bx) {
+    aom_flat_block_finder_extract_block(
+        jobs->block_finder, jobs->data, jobs->w, jobs->h, jobs->stride,
+        bx * block_size + jobs->offsx, by * block_size + jobs->offsy, plane_d,
+        block_d);
+    for (int j = 0; j < pixels_per_block; ++j) {
+      block[j] = (float)block_d[j] * window_function[j];
+      plane[j] = (float)plane_d[j];
+    }
+    aom_noise_tx_forward(thread_data->tx, block);
+    aom_noise_tx_filter(thread_data->tx, jobs->noise_psd);
+    aom_noise_tx_inverse(thread_data->tx, block);
+
+    aom_noise_overlap_add(result_row + (bx + 1) * block_size + jobs->offsx,
+                          jobs->result_stride, block, plane, window_function,
+                          block_size, block_size);
+  }
+}
+
+static int wiener_denoise_hook(void *arg1, void *unused) {
+  (void)unused;
+  WienerDenoiseThreadData *const thread_data = (WienerDenoiseThreadData *)arg1;
+  WienerDenoiseJobs *const jobs = thread_data->jobs;
+  int job;
+  while ((job = aom_job_scheduler_get_job(&jobs->job_sched,
+                                          thread_data->queue)) >= 0) {
+    wiener_denoise_row(jobs, thread_data, job - 1);
+  }
+  return 1;
+}
+
+int aom_wiener_denoise_2d_mt(const uint8_t *const data[3],
+                             uint8_t *denoised[3], int w, int h, int stride[3],
+                             int chroma_sub[2], float *noise_psd[3],
+                             int block_size, int bit_depth, int use_highbd,
+                             AVxWorker *workers, int num_workers) {
+  float *window_full = NULL, *window_chroma = NULL;
   const int num_blocks_w = (w + block_size - 1) / block_size;
   const int num_blocks_h = (h + block_size - 1) / block_size;
   const int result_stride = (num_blocks_w + 2) * block_size;
   const int result_height = (num_blocks_h + 2) * block_size;
+  // The block rows -1 to num_blocks_h - 1 of each block grid.
+  const int num_threads = AOMMAX(AOMMIN(num_workers, num_blocks_h + 1), 1);
   float *result = NULL;
   int init_success = 1;
   aom_flat_block_finder_t block_finder_full;
   aom_flat_block_finder_t block_finder_chroma;
+  WienerDenoiseJobs jobs;
+  WienerDenoiseThreadData *thread_data = NULL;
   const float kBlockNormalization = (float)((1 << bit_depth) - 1);
   if (chroma_sub[0] != chroma_sub[1]) {
     fprintf(stderr,
@@ -1356,85 +1588,91 @@ int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
             "subsampling");
     return 0;
   }
+  memset(&jobs, 0, sizeof(jobs));
   init_success &= aom_flat_block_finder_init(&block_finder_full, block_size,
                                              bit_depth, use_highbd);
   result = (float *)aom_malloc((num_blocks_h + 2) * block_size * result_stride *
                                sizeof(*result));
-  plane = (float *)aom_malloc(block_size * block_size * sizeof(*plane));
-  block =
-      (float *)aom_memalign(32, 2 * block_size * block_size * sizeof(*block));
-  block_d = (double *)aom_malloc(block_size * block_size * sizeof(*block_d));
-  plane_d = (double *)aom_malloc(block_size * block_size * sizeof(*plane_d));
   window_full = get_half_cos_window(block_size);
-  tx_full = aom_noise_tx_malloc(block_size);
 
   if (chroma_sub[0] != 0) {
     init_success &= aom_flat_block_finder_init(&block_finder_chroma,
                                                block_size >> chroma_sub[0],
                                                bit_depth, use_highbd);
     window_chroma = get_half_cos_window(block_size >> chroma_sub[0]);
-    tx_chroma = aom_noise_tx_malloc(block_size >> chroma_sub[0]);
   } else {
     window_chroma = window_full;
-    tx_chroma = tx_full;
   }
 
-  init_success &= (tx_full != NULL) && (tx_chroma != NULL) && (plane != NULL) &&
-                  (plane_d != NULL) && (block != NULL) && (block_d != NULL) &&
-                  (window_full != NULL) && (window_chroma != NULL) &&
-                  (result != NULL);
+  // Each thread has its own transforms and buffers.
+  thread_data = (WienerDenoiseThreadData *)aom_calloc(num_threads,
+                                                      sizeof(*thread_data));
+  init_success &= (thread_data != NULL);
+  for (int i = 0; thread_data && i < num_threads; ++i) {
+    WienerDenoiseThreadData *const td = &thread_data[i];
+    td->jobs = &jobs;
+    td->queue = i;
+    td->plane =
+        (float *)aom_malloc(block_size * block_size * sizeof(*td->plane));
+    td->block = (float *)aom_memalign(
+        32, 2 * block_size * block_size * sizeof(*td->block));
+    td->block_d =
+        (double *)aom_malloc(block_size * block_size * sizeof(*td->block_d));
+    td->plane_d =
+        (double *)aom_malloc(block_size * block_size * sizeof(*td->plane_d));
+    td->tx_full = aom_noise_tx_malloc(block_size);
+    td->tx_chroma = chroma_sub[0] != 0
+                        ? aom_noise_tx_malloc(block_size >> chroma_sub[0])
+                        : td->tx_full;
+    init_success &= (td->tx_full != NULL) && (td->tx_chroma != NULL) &&
+                    (td->plane != NULL) && (td->plane_d != NULL) &&
+                    (td->block != NULL) && (td->block_d != NULL);
+  }
+  if (num_threads > 1) {
+    init_success &= !aom_job_scheduler_alloc(&jobs.job_sched, num_threads);
+  }
+
+  init_success &=
+      (window_full != NULL) && (window_chroma != NULL) && (result != NULL);
   for (int c = init_success ? 0 : 3; c < 3; ++c) {
-    float *window_function = c == 0 ? window_full : window_chroma;
-    aom_flat_block_finder_t *block_finder = &block_finder_full;
     const int chroma_sub_h = c > 0 ? chroma_sub[1] : 0;
     const int chroma_sub_w = c > 0 ? chroma_sub[0] : 0;
-    struct aom_noise_tx_t *tx =
-        (c > 0 && chroma_sub[0] > 0) ? tx_chroma : tx_full;
     if (!data[c] || !denoised[c]) continue;
+    jobs.block_finder = &block_finder_full;
     if (c > 0 && chroma_sub[0] != 0) {
-      block_finder = &block_finder_chroma;
+      jobs.block_finder = &block_finder_chroma;
+    }
+    jobs.data = data[c];
+    jobs.w = w >> chroma_sub_w;
+    jobs.h = h >> chroma_sub_h;
+    jobs.stride = stride[c];
+    jobs.block_size = block_size >> chroma_sub_w;
+    jobs.num_blocks_w = num_blocks_w;
+    jobs.window = c == 0 ? window_full : window_chroma;
+    jobs.noise_psd = noise_psd[c];
+    jobs.result = result;
+    jobs.result_stride = result_stride;
+    for (int i = 0; i < num_threads; ++i) {
+      WienerDenoiseThreadData *const td = &thread_data[i];
+      td->tx = (c > 0 && chroma_sub[0] > 0) ? td->tx_chroma : td->tx_full;
     }
     memset(result, 0, sizeof(*result) * result_stride * result_height);
-    // Do overlapped block processing (half overlapped). The block rows can
-    // easily be done in parallel
-    for (int offsy = 0; offsy < (block_size >> chroma_sub_h);
-         offsy += (block_size >> chroma_sub_h) / 2) {
-      for (int offsx = 0; offsx < (block_size >> chroma_sub_w);
-           offsx += (block_size >> chroma_sub_w) / 2) {
-        // Pad the boundary when processing each block-set.
-        for (int by = -1; by < num_blocks_h; ++by) {
-          for (int bx = -1; bx < num_blocks_w; ++bx) {
-            const int pixels_per_block =
-                (block_size >> chroma_sub_w) * (block_size >> chroma_sub_h);
-            aom_flat_block_finder_extract_block(
-                block_finder, data[c], w >> chroma_sub_w, h >> chroma_sub_h,
-                stride[c], bx * (block_size >> chroma_sub_w) + offsx,
-                by * (block_size >> chroma_sub_h) + offsy, plane_d, block_d);
-            for (int j = 0; j < pixels_per_block; ++j) {
-              block[j] = (float)block_d[j];
-              plane[j] = (float)plane_d[j];
-            }
-            pointwise_multiply(window_function, block, pixels_per_block);
-            aom_noise_tx_forward(tx, block);
-            aom_noise_tx_filter(tx, noise_psd[c]);
-            aom_noise_tx_inverse(tx, block);
-
-            // Apply window function to the plane approximation (we will apply
-            // it to the sum of plane + block when composing the results).
-            pointwise_multiply(window_function, plane, pixels_per_block);
-
-            for (int y = 0; y < (block_size >> chroma_sub_h); ++y) {
-              const int y_result =
-                  y + (by + 1) * (block_size >> chroma_sub_h) + offsy;
-              for (int x = 0; x < (block_size >> chroma_sub_w); ++x) {
-                const int x_result =
-                    x + (bx + 1) * (block_size >> chroma_sub_w) + offsx;
-                result[y_result * result_stride + x_result] +=
-                    (block[y * (block_size >> chroma_sub_w) + x] +
-                     plane[y * (block_size >> chroma_sub_w) + x]) *
-                    window_function[y * (block_size >> chroma_sub_w) + x];
-              }
-            }
+    // Do overlapped block processing (half overlapped). The block rows of
+    // each block grid are done in parallel: they cover different rows of the
+    // result, which are added to in the same order as by a single thread.
+    for (jobs.offsy = 0; jobs.offsy < (block_size >> chroma_sub_h);
+         jobs.offsy += (block_size >> chroma_sub_h) / 2) {
+      for (jobs.offsx = 0; jobs.offsx < (block_size >> chroma_sub_w);
+           jobs.offsx += (block_size >> chroma_sub_w) / 2) {
+        if (num_threads > 1) {
+          aom_job_scheduler_reset(&jobs.job_sched, num_blocks_h + 1,
+                                  num_threads);
+          init_success &=
+              run_noise_workers(workers, num_threads, wiener_denoise_hook,
+                                thread_data, sizeof(*thread_data));
+        } else {
+          for (int by = -1; by < num_blocks_h; ++by) {
+            wiener_denoise_row(&jobs, &thread_data[0], by);
           }
         }
       }
@@ -1449,24 +1687,37 @@ int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
                                 block_size, kBlockNormalization);
     }
   }
+  for (int i = 0; thread_data && i < num_threads; ++i) {
+    WienerDenoiseThreadData *const td = &thread_data[i];
+    aom_free(td->plane);
+    aom_free(td->block);
+    aom_free(td->plane_d);
+    aom_free(td->block_d);
+    if (td->tx_chroma != td->tx_full) aom_noise_tx_free(td->tx_chroma);
+    aom_noise_tx_free(td->tx_full);
+  }
+  aom_free(thread_data);
+  aom_job_scheduler_free(&jobs.job_sched);
   aom_free(result);
-  aom_free(plane);
-  aom_free(block);
-  aom_free(plane_d);
-  aom_free(block_d);
   aom_free(window_full);
 
-  aom_noise_tx_free(tx_full);
-
   aom_flat_block_finder_free(&block_finder_full);
   if (chroma_sub[0] != 0) {
     aom_flat_block_finder_free(&block_finder_chroma);
     aom_free(window_chroma);
-    aom_noise_tx_free(tx_chroma);
   }
   return init_success;
 }
 
+int aom_wiener_denoise_2d(const uint8_t *const data[3], uint8_t *denoised[3],
+                          int w, int h, int stride[3], int chroma_sub[2],
+                          float *noise_psd[3], int block_size, int bit_depth,
+                          int use_highbd) {
+  return aom_wiener_denoise_2d_mt(data, denoised, w, h, stride, chroma_sub,
+                                  noise_psd, block_size, bit_depth, use_highbd,
+                                  NULL, 0);
+}
+
 struct aom_denoise_and_model_t {
   int block_size;
   int bit_depth;
@@ -1589,9 +1840,10 @@ static int denoise_and_model_realloc_if_necessary(
   return 1;
 }
 
-int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
-                              YV12_BUFFER_CONFIG *sd,
-                              aom_film_grain_t *film_grain) {
+int aom_denoise_and_model_run_mt(struct aom_denoise_and_model_t *ctx,
+                                 YV12_BUFFER_CONFIG *sd,
+                                 aom_film_grain_t *film_grain,
+                                 AVxWorker *workers, int num_workers) {
   const int block_size = ctx->block_size;
   const int use_highbd = (sd->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
   uint8_t *raw_data[3] = {
@@ -1608,12 +1860,14 @@ int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
     return 0;
   }
 
-  aom_flat_block_finder_run(&ctx->flat_block_finder, data[0], sd->y_width,
-                            sd->y_height, strides[0], ctx->flat_blocks);
+  aom_flat_block_finder_run_mt(&ctx->flat_block_finder, data[0], sd->y_width,
+                               sd->y_height, strides[0], ctx->flat_blocks,
+                               workers, num_workers);
 
-  if (!aom_wiener_denoise_2d(data, ctx->denoised, sd->y_width, sd->y_height,
-                             strides, chroma_sub_log2, ctx->noise_psd,
-                             block_size, ctx->bit_depth, use_highbd)) {
+  if (!aom_wiener_denoise_2d_mt(data, ctx->denoised, sd->y_width, sd->y_height,
+                                strides, chroma_sub_log2, ctx->noise_psd,
+                                block_size, ctx->bit_depth, use_highbd,
+                                workers, num_workers)) {
     fprintf(stderr, "Unable to denoise image\n");
     return 0;
   }
@@ -1652,3 +1906,9 @@ int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
   }
   return 1;
 }
+
+int aom_denoise_and_model_run(struct aom_denoise_and_model_t *ctx,
+                              YV12_BUFFER_CONFIG *sd,
+                              aom_film_grain_t *film_grain) {
+  return aom_denoise_and_model_run_mt(ctx, sd, film_grain, NULL, 0);
+}
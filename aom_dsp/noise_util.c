@@ -88,28 +88,29 @@ void aom_noise_tx_forward(struct aom_noise_tx_t *noise_tx, const float *data) {
   noise_tx->fft(data, noise_tx->temp, noise_tx->tx_block);
 }
 
-void aom_noise_tx_filter(struct aom_noise_tx_t *noise_tx, const float *psd) {
-  const int block_size = noise_tx->block_size;
+void aom_noise_tx_filter_coeffs_c(float *coeffs, const float *psd, int n) {
   const float kBeta = 1.1f;
   const float kEps = 1e-6f;
-  for (int y = 0; y < block_size; ++y) {
-    for (int x = 0; x < block_size; ++x) {
-      int i = y * block_size + x;
-      float *c = noise_tx->tx_block + 2 * i;
-      const float c0 = AOMMAX((float)fabs(c[0]), 1e-8f);
-      const float c1 = AOMMAX((float)fabs(c[1]), 1e-8f);
-      const float p = c0 * c0 + c1 * c1;
-      if (p > kBeta * psd[i] && p > 1e-6) {
-        noise_tx->tx_block[2 * i + 0] *= (p - psd[i]) / AOMMAX(p, kEps);
-        noise_tx->tx_block[2 * i + 1] *= (p - psd[i]) / AOMMAX(p, kEps);
-      } else {
-        noise_tx->tx_block[2 * i + 0] *= (kBeta - 1.0f) / kBeta;
-        noise_tx->tx_block[2 * i + 1] *= (kBeta - 1.0f) / kBeta;
-      }
+  for (int i = 0; i < n; ++i) {
+    float *c = coeffs + 2 * i;
+    const float c0 = AOMMAX((float)fabs(c[0]), 1e-8f);
+    const float c1 = AOMMAX((float)fabs(c[1]), 1e-8f);
+    const float p = c0 * c0 + c1 * c1;
+    if (p > kBeta * psd[i] && p > 1e-6) {
+      c[0] *= (p - psd[i]) / AOMMAX(p, kEps);
+      c[1] *= (p - psd[i]) / AOMMAX(p, kEps);
+    } else {
+      c[0] *= (kBeta - 1.0f) / kBeta;
+      c[1] *= (kBeta - 1.0f) / kBeta;
     }
   }
 }
 
+void aom_noise_tx_filter(struct aom_noise_tx_t *noise_tx, const float *psd) {
+  aom_noise_tx_filter_coeffs(noise_tx->tx_block, psd,
+                             noise_tx->block_size * noise_tx->block_size);
+}
+
 void aom_noise_tx_inverse(struct aom_noise_tx_t *noise_tx, float *data) {
   const int n = noise_tx->block_size * noise_tx->block_size;
   noise_tx->ifft(noise_tx->tx_block, noise_tx->temp, data);
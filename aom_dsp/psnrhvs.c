@@ -34,6 +34,7 @@ static void od_bin_fdct8x8(tran_low_t *y, int ystride, const int16_t *x,
       *(y + ystride * i + j) = (*(y + ystride * i + j) + 4) >> 3;
 }
 
+#if CONFIG_AV1_HIGHBITDEPTH
 static void hbd_od_bin_fdct8x8(tran_low_t *y, int ystride, const int16_t *x,
                                int xstride) {
   int i, j;
@@ -43,6 +44,88 @@ static void hbd_od_bin_fdct8x8(tran_low_t *y, int ystride, const int16_t *x,
     for (j = 0; j < 8; j++)
       *(y + ystride * i + j) = (*(y + ystride * i + j) + 4) >> 3;
 }
+#endif  // CONFIG_AV1_HIGHBITDEPTH
+
+// Returns the variance term of the contrast masking of the 8x8 block src, from
+// the mean magnitude of its gradients.
+static double psnrhvs_gvar(const int16_t *src, int pix_max) {
+  int i;
+  int j;
+  int n = 0;
+  double s_gx = 0;
+  double s_gy = 0;
+  double g = 0;
+  double s_gmean = 0;
+  for (i = 1; i < 7; i++) {
+    for (j = 1; j < 7; j++) {
+      s_gx = (src[(i - 1) * 8 + j - 1] * 3 - src[(i - 1) * 8 + j + 1] * 3 +
+              src[i * 8 + j - 1] * 10 - src[i * 8 + j + 1] * 10 +
+              src[(i + 1) * 8 + j - 1] * 3 - src[(i + 1) * 8 + j + 1] * 3) /
+             (pix_max * 16.f);
+      s_gy = (src[(i - 1) * 8 + j - 1] * 3 - src[(i + 1) * 8 + j - 1] * 3 +
+              src[(i - 1) * 8 + j] * 10 - src[(i + 1) * 8 + j] * 10 +
+              src[(i - 1) * 8 + j + 1] * 3 - src[(i + 1) * 8 + j + 1] * 3) /
+             (pix_max * 16.f);
+      g = sqrt(s_gx * s_gx + s_gy * s_gy);
+      if (g > 0.1f) n++;
+      s_gmean += g;
+    }
+  }
+  return 1.f / (36 - n + 1) * s_gmean / 36.f;
+}
+
+// Returns the sum of the squared, masked and weighted differences between the
+// DCT coefficients of the blocks.
+static double psnrhvs_masked_error(const tran_low_t *dct_s_coef,
+                                   const tran_low_t *dct_d_coef,
+                                   const double *csf, const double *mask,
+                                   double s_gvar) {
+  int i;
+  int j;
+  double s_mask = 0;
+  double ret = 0;
+  for (i = 0; i < 8; i++)
+    for (j = (i == 0); j < 8; j++)
+      s_mask += dct_s_coef[i * 8 + j] * dct_s_coef[i * 8 + j] * mask[i * 8 + j];
+  s_mask = sqrt(s_mask * s_gvar) / 8.f;
+  for (i = 0; i < 8; i++) {
+    for (j = 0; j < 8; j++) {
+      double err;
+      err = fabs((double)(dct_s_coef[i * 8 + j] - dct_d_coef[i * 8 + j]));
+      if (i != 0 || j != 0) {
+        const double thr = s_mask / mask[i * 8 + j];
+        err = err < thr ? 0 : err - thr;
+      }
+      ret += (err * csf[i * 8 + j]) * (err * csf[i * 8 + j]);
+    }
+  }
+  return ret;
+}
+
+// Returns the error of the 8x8 block dst against src, with the row-major 8x8
+// contrast sensitivity weights csf and masking weights mask.
+double aom_psnrhvs_8x8_c(const int16_t *src, const int16_t *dst,
+                         const double *csf, const double *mask, int pix_max) {
+  DECLARE_ALIGNED(16, tran_low_t, dct_s_coef[8 * 8]);
+  DECLARE_ALIGNED(16, tran_low_t, dct_d_coef[8 * 8]);
+  const double s_gvar = psnrhvs_gvar(src, pix_max);
+  od_bin_fdct8x8(dct_s_coef, 8, src, 8);
+  od_bin_fdct8x8(dct_d_coef, 8, dst, 8);
+  return psnrhvs_masked_error(dct_s_coef, dct_d_coef, csf, mask, s_gvar);
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+double aom_highbd_psnrhvs_8x8_c(const int16_t *src, const int16_t *dst,
+                                const double *csf, const double *mask,
+                                int pix_max) {
+  DECLARE_ALIGNED(16, tran_low_t, dct_s_coef[8 * 8]);
+  DECLARE_ALIGNED(16, tran_low_t, dct_d_coef[8 * 8]);
+  const double s_gvar = psnrhvs_gvar(src, pix_max);
+  hbd_od_bin_fdct8x8(dct_s_coef, 8, src, 8);
+  hbd_od_bin_fdct8x8(dct_d_coef, 8, dst, 8);
+  return psnrhvs_masked_error(dct_s_coef, dct_d_coef, csf, mask, s_gvar);
+}
+#endif  // CONFIG_AV1_HIGHBITDEPTH
 
 /* Normalized inverse quantization matrix for 8x8 DCT at the point of
  * transparency. This is not the JPEG based matrix from the paper,
@@ -121,8 +204,6 @@ static double calc_psnrhvs(const unsigned char *src, int _systride,
   const uint16_t *_dst16 = CONVERT_TO_SHORTPTR(dst);
   DECLARE_ALIGNED(16, int16_t, dct_s[8 * 8]);
   DECLARE_ALIGNED(16, int16_t, dct_d[8 * 8]);
-  DECLARE_ALIGNED(16, tran_low_t, dct_s_coef[8 * 8]);
-  DECLARE_ALIGNED(16, tran_low_t, dct_d_coef[8 * 8]);
   double mask[8][8];
   int pixels;
   int x;
@@ -173,13 +254,6 @@ static double calc_psnrhvs(const unsigned char *src, int _systride,
     for (x = 0; x < _w - 7; x += _step) {
       int i;
       int j;
-      int n = 0;
-      double s_gx = 0;
-      double s_gy = 0;
-      double g = 0;
-      double s_gmean = 0;
-      double s_gvar = 0;
-      double s_mask = 0;
       for (i = 0; i < 8; i++) {
         for (j = 0; j < 8; j++) {
           if (!buf_is_hbd) {
@@ -192,45 +266,17 @@ static double calc_psnrhvs(const unsigned char *src, int _systride,
           dct_d[i * 8 + j] += (int)(delt + 0.5f);
         }
       }
-      for (i = 1; i < 7; i++) {
-        for (j = 1; j < 7; j++) {
-          s_gx = (dct_s[(i - 1) * 8 + j - 1] * 3 -
-                  dct_s[(i - 1) * 8 + j + 1] * 3 + dct_s[i * 8 + j - 1] * 10 -
-                  dct_s[i * 8 + j + 1] * 10 + dct_s[(i + 1) * 8 + j - 1] * 3 -
-                  dct_s[(i + 1) * 8 + j + 1] * 3) /
-                 (pix_max * 16.f);
-          s_gy = (dct_s[(i - 1) * 8 + j - 1] * 3 -
-                  dct_s[(i + 1) * 8 + j - 1] * 3 + dct_s[(i - 1) * 8 + j] * 10 -
-                  dct_s[(i + 1) * 8 + j] * 10 + dct_s[(i - 1) * 8 + j + 1] * 3 -
-                  dct_s[(i + 1) * 8 + j + 1] * 3) /
-                 (pix_max * 16.f);
-          g = sqrt(s_gx * s_gx + s_gy * s_gy);
-          if (g > 0.1f) n++;
-          s_gmean += g;
-        }
-      }
-      s_gvar = 1.f / (36 - n + 1) * s_gmean / 36.f;
       if (!buf_is_hbd) {
-        od_bin_fdct8x8(dct_s_coef, 8, dct_s, 8);
-        od_bin_fdct8x8(dct_d_coef, 8, dct_d, 8);
+        ret += aom_psnrhvs_8x8(dct_s, dct_d, &_csf[0][0], &mask[0][0], pix_max);
       } else {
-        hbd_od_bin_fdct8x8(dct_s_coef, 8, dct_s, 8);
-        hbd_od_bin_fdct8x8(dct_d_coef, 8, dct_d, 8);
-      }
-      for (i = 0; i < 8; i++)
-        for (j = (i == 0); j < 8; j++)
-          s_mask += dct_s_coef[i * 8 + j] * dct_s_coef[i * 8 + j] * mask[i][j];
-      s_mask = sqrt(s_mask * s_gvar) / 8.f;
-      for (i = 0; i < 8; i++) {
-        for (j = 0; j < 8; j++) {
-          double err;
-          err = fabs((double)(dct_s_coef[i * 8 + j] - dct_d_coef[i * 8 + j]));
-          if (i != 0 || j != 0)
-            err = err < s_mask / mask[i][j] ? 0 : err - s_mask / mask[i][j];
-          ret += (err * _csf[i][j]) * (err * _csf[i][j]);
-          pixels++;
-        }
+#if CONFIG_AV1_HIGHBITDEPTH
+        ret += aom_highbd_psnrhvs_8x8(dct_s, dct_d, &_csf[0][0], &mask[0][0],
+                                      pix_max);
+#else
+        assert(0);
+#endif  // CONFIG_AV1_HIGHBITDEPTH
       }
+      pixels += 64;
     }
   }
   if (pixels <= 0) return 0;
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+
+// As in the C version, the vectors read the same pixels past an odd width and
+// height as the last scalar outputs do.
+void aom_fastssim_downsample_avx2(const uint8_t *src, int stride,
+                                  uint32_t *dst, int w, int h) {
+  const __m256i ones = _mm256_set1_epi8(1);
+  for (int j = 0; j < h; j++, dst += w) {
+    const uint8_t *const src0 = src + 2 * j * stride;
+    const uint8_t *const src1 = src0 + stride;
+    int i = 0;
+    for (; i + 16 <= w; i += 16) {
+      const __m256i sum0 = _mm256_maddubs_epi16(
+          _mm256_loadu_si256((const __m256i *)(src0 + 2 * i)), ones);
+      const __m256i sum1 = _mm256_maddubs_epi16(
+          _mm256_loadu_si256((const __m256i *)(src1 + 2 * i)), ones);
+      const __m256i sum = _mm256_add_epi16(sum0, sum1);
+      _mm256_storeu_si256((__m256i *)(dst + i),
+                          _mm256_cvtepu16_epi32(_mm256_castsi256_si128(sum)));
+      _mm256_storeu_si256(
+          (__m256i *)(dst + i + 8),
+          _mm256_cvtepu16_epi32(_mm256_extracti128_si256(sum, 1)));
+    }
+    for (; i < w; i++) {
+      dst[i] = src0[2 * i] + src0[2 * i + 1] + src1[2 * i] + src1[2 * i + 1];
+    }
+  }
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+// The shifted pixels have at most 12 bits, so that the pairs are added with
+// _mm256_madd_epi16().
+void aom_highbd_fastssim_downsample_avx2(const uint16_t *src, int stride,
+                                         uint32_t *dst, int w, int h,
+                                         int shift) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  const __m128i count = _mm_cvtsi32_si128(shift);
+  for (int j = 0; j < h; j++, dst += w) {
+    const uint16_t *const src0 = src + 2 * j * stride;
+    const uint16_t *const src1 = src0 + stride;
+    int i = 0;
+    for (; i + 8 <= w; i += 8) {
+      const __m256i s0 = _mm256_srl_epi16(
+          _mm256_loadu_si256((const __m256i *)(src0 + 2 * i)), count);
+      const __m256i s1 = _mm256_srl_epi16(
+          _mm256_loadu_si256((const __m256i *)(src1 + 2 * i)), count);
+      _mm256_storeu_si256((__m256i *)(dst + i),
+                          _mm256_madd_epi16(_mm256_add_epi16(s0, s1), ones));
+    }
+    for (; i < w; i++) {
+      dst[i] = (src0[2 * i] >> shift) + (src0[2 * i + 1] >> shift) +
+               (src1[2 * i] >> shift) + (src1[2 * i + 1] >> shift);
+    }
+  }
+}
+#endif  // CONFIG_AV1_HIGHBITDEPTH
+
+void aom_fastssim_downsample_level_avx2(const uint32_t *src, int src_w,
+                                        uint32_t *dst, int w, int h) {
+  for (int j = 0; j < h; j++, dst += w) {
+    const uint32_t *const src0 = src + 2 * j * src_w;
+    const uint32_t *const src1 = src0 + src_w;
+    int i = 0;
+    for (; i + 8 <= w; i += 8) {
+      const __m256i a = _mm256_add_epi32(
+          _mm256_loadu_si256((const __m256i *)(src0 + 2 * i)),
+          _mm256_loadu_si256((const __m256i *)(src1 + 2 * i)));
+      const __m256i b = _mm256_add_epi32(
+          _mm256_loadu_si256((const __m256i *)(src0 + 2 * i + 8)),
+          _mm256_loadu_si256((const __m256i *)(src1 + 2 * i + 8)));
+      // The pairs of a and b are added in place within each 128 bit lane.
+      const __m256i sum = _mm256_hadd_epi32(a, b);
+      _mm256_storeu_si256((__m256i *)(dst + i),
+                          _mm256_permute4x64_epi64(sum, 0xd8));
+    }
+    for (; i < w; i++) {
+      dst[i] = src0[2 * i] + src0[2 * i + 1] + src1[2 * i] + src1[2 * i + 1];
+    }
+  }
+}
+
+void aom_fastssim_gradient_avx2(const uint32_t *im, int w, uint32_t *g) {
+  int i = 0;
+  for (; i + 8 <= w - 1; i += 8) {
+    const __m256i a0 = _mm256_loadu_si256((const __m256i *)(im + i));
+    const __m256i a1 = _mm256_loadu_si256((const __m256i *)(im + i + 1));
+    const __m256i b0 = _mm256_loadu_si256((const __m256i *)(im + w + i));
+    const __m256i b1 = _mm256_loadu_si256((const __m256i *)(im + w + i + 1));
+    const __m256i g1 = _mm256_abs_epi32(_mm256_sub_epi32(b1, a0));
+    const __m256i g2 = _mm256_abs_epi32(_mm256_sub_epi32(b0, a1));
+    const __m256i res =
+        _mm256_add_epi32(_mm256_slli_epi32(_mm256_max_epu32(g1, g2), 2),
+                         _mm256_min_epu32(g1, g2));
+    _mm256_storeu_si256((__m256i *)(g + i), res);
+  }
+  for (; i < w - 1; i++) {
+    const unsigned g1 = abs((int)im[w + i + 1] - (int)im[i]);
+    const unsigned g2 = abs((int)im[w + i] - (int)im[i + 1]);
+    g[i] = 4 * (g1 > g2 ? g1 : g2) + (g1 < g2 ? g1 : g2);
+  }
+}
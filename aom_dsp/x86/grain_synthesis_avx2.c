@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+#include "aom_dsp/x86/synonyms.h"
+
+// Returns clamp(pix + ((scale * grain + round) >> shift), min, max).
+static INLINE __m256i add_noise_8(__m256i pix, __m256i scale, const int *grain,
+                                  __m256i round, __m128i shift, __m256i min,
+                                  __m256i max) {
+  __m256i noise = _mm256_mullo_epi32(
+      scale, _mm256_loadu_si256((const __m256i *)grain));
+  noise = _mm256_sra_epi32(_mm256_add_epi32(noise, round), shift);
+  return _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(pix, noise), min),
+                          max);
+}
+
+static INLINE void store_u8_8(uint8_t *dst, __m256i v) {
+  const __m128i v16 = _mm_packs_epi32(_mm256_castsi256_si128(v),
+                                      _mm256_extracti128_si256(v, 1));
+  xx_storel_64(dst, _mm_packus_epi16(v16, v16));
+}
+
+static INLINE void store_u16_8(uint16_t *dst, __m256i v) {
+  xx_storeu_128(dst, _mm_packus_epi32(_mm256_castsi256_si128(v),
+                                      _mm256_extracti128_si256(v, 1)));
+}
+
+// Scaling function of 8 samples in [0, (256 << (bd - 8)) - 1], interpolated
+// between the LUT entries above 8 bits.
+static INLINE __m256i highbd_scale_lut_8(const int *scaling_lut, __m256i index,
+                                         int bd) {
+  if (bd == 8) return _mm256_i32gather_epi32(scaling_lut, index, 4);
+
+  const __m128i shift = _mm_cvtsi32_si128(bd - 8);
+  const __m256i x = _mm256_srl_epi32(index, shift);
+  // x + 1 is clamped to the last entry, where the interpolation is a no-op.
+  const __m256i x1 =
+      _mm256_min_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(1)),
+                       _mm256_set1_epi32(255));
+  const __m256i start = _mm256_i32gather_epi32(scaling_lut, x, 4);
+  const __m256i end = _mm256_i32gather_epi32(scaling_lut, x1, 4);
+  const __m256i frac =
+      _mm256_and_si256(index, _mm256_set1_epi32((1 << (bd - 8)) - 1));
+  __m256i delta = _mm256_mullo_epi32(_mm256_sub_epi32(end, start), frac);
+  delta = _mm256_add_epi32(delta, _mm256_set1_epi32(1 << (bd - 9)));
+  return _mm256_add_epi32(start, _mm256_sra_epi32(delta, shift));
+}
+
+void aom_film_grain_add_noise_luma_avx2(uint8_t *luma, int luma_stride,
+                                        const int *grain, int grain_stride,
+                                        const int *scaling_lut, int width,
+                                        int height, int scaling_shift,
+                                        int min_val, int max_val) {
+  const __m256i round = _mm256_set1_epi32(1 << (scaling_shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(scaling_shift);
+  const __m256i min = _mm256_set1_epi32(min_val);
+  const __m256i max = _mm256_set1_epi32(max_val);
+  const int simd_width = width & ~7;
+
+  for (int i = 0; i < height; i++) {
+    uint8_t *const row = luma + i * luma_stride;
+    const int *const grain_row = grain + i * grain_stride;
+    for (int j = 0; j < simd_width; j += 8) {
+      const __m256i pix = _mm256_cvtepu8_epi32(xx_loadl_64(row + j));
+      const __m256i scale = _mm256_i32gather_epi32(scaling_lut, pix, 4);
+      store_u8_8(row + j, add_noise_8(pix, scale, grain_row + j, round, shift,
+                                      min, max));
+    }
+  }
+  if (simd_width < width) {
+    aom_film_grain_add_noise_luma_sse4_1(
+        luma + simd_width, luma_stride, grain + simd_width, grain_stride,
+        scaling_lut, width - simd_width, height, scaling_shift, min_val,
+        max_val);
+  }
+}
+
+void aom_film_grain_add_noise_chroma_avx2(
+    uint8_t *chroma, int chroma_stride, const uint8_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val) {
+  const __m256i round = _mm256_set1_epi32(1 << (scaling_shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(scaling_shift);
+  const __m256i min = _mm256_set1_epi32(min_val);
+  const __m256i max = _mm256_set1_epi32(max_val);
+  const __m256i luma_mult_v = _mm256_set1_epi32(luma_mult);
+  const __m256i chroma_mult_v = _mm256_set1_epi32(chroma_mult);
+  const __m256i offset_v = _mm256_set1_epi32(offset);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i ones_16 = _mm256_set1_epi16(1);
+  const __m256i lut_max = _mm256_set1_epi32(255);
+  const int simd_width = width & ~7;
+
+  for (int i = 0; i < height; i++) {
+    uint8_t *const row = chroma + i * chroma_stride;
+    const uint8_t *const luma_row = luma + (i << subsamp_y) * luma_stride;
+    const int *const grain_row = grain + i * grain_stride;
+    for (int j = 0; j < simd_width; j += 8) {
+      __m256i average_luma;
+      if (subsamp_x) {
+        const __m256i l =
+            _mm256_cvtepu8_epi16(xx_loadu_128(luma_row + (j << 1)));
+        average_luma = _mm256_srli_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(l, ones_16), one), 1);
+      } else {
+        average_luma = _mm256_cvtepu8_epi32(xx_loadl_64(luma_row + j));
+      }
+      const __m256i pix = _mm256_cvtepu8_epi32(xx_loadl_64(row + j));
+      __m256i merged =
+          _mm256_add_epi32(_mm256_mullo_epi32(average_luma, luma_mult_v),
+                           _mm256_mullo_epi32(pix, chroma_mult_v));
+      merged = _mm256_add_epi32(_mm256_srai_epi32(merged, 6), offset_v);
+      merged = _mm256_min_epi32(_mm256_max_epi32(merged, zero), lut_max);
+      const __m256i scale = _mm256_i32gather_epi32(scaling_lut, merged, 4);
+      store_u8_8(row + j, add_noise_8(pix, scale, grain_row + j, round, shift,
+                                      min, max));
+    }
+  }
+  if (simd_width < width) {
+    aom_film_grain_add_noise_chroma_sse4_1(
+        chroma + simd_width, chroma_stride, luma + (simd_width << subsamp_x),
+        luma_stride, grain + simd_width, grain_stride, scaling_lut,
+        width - simd_width, height, subsamp_x, subsamp_y, luma_mult,
+        chroma_mult, offset, scaling_shift, min_val, max_val);
+  }
+}
+
+void aom_highbd_film_grain_add_noise_luma_avx2(
+    uint16_t *luma, int luma_stride, const int *grain, int grain_stride,
+    const int *scaling_lut, int width, int height, int scaling_shift,
+    int min_val, int max_val, int bd) {
+  const __m256i round = _mm256_set1_epi32(1 << (scaling_shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(scaling_shift);
+  const __m256i min = _mm256_set1_epi32(min_val);
+  const __m256i max = _mm256_set1_epi32(max_val);
+  const int simd_width = width & ~7;
+
+  for (int i = 0; i < height; i++) {
+    uint16_t *const row = luma + i * luma_stride;
+    const int *const grain_row = grain + i * grain_stride;
+    for (int j = 0; j < simd_width; j += 8) {
+      const __m256i pix = _mm256_cvtepu16_epi32(xx_loadu_128(row + j));
+      const __m256i scale = highbd_scale_lut_8(scaling_lut, pix, bd);
+      store_u16_8(row + j, add_noise_8(pix, scale, grain_row + j, round, shift,
+                                       min, max));
+    }
+  }
+  if (simd_width < width) {
+    aom_highbd_film_grain_add_noise_luma_c(
+        luma + simd_width, luma_stride, grain + simd_width, grain_stride,
+        scaling_lut, width - simd_width, height, scaling_shift, min_val,
+        max_val, bd);
+  }
+}
+
+void aom_highbd_film_grain_add_noise_chroma_avx2(
+    uint16_t *chroma, int chroma_stride, const uint16_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val, int bd) {
+  const __m256i round = _mm256_set1_epi32(1 << (scaling_shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(scaling_shift);
+  const __m256i min = _mm256_set1_epi32(min_val);
+  const __m256i max = _mm256_set1_epi32(max_val);
+  const __m256i luma_mult_v = _mm256_set1_epi32(luma_mult);
+  const __m256i chroma_mult_v = _mm256_set1_epi32(chroma_mult);
+  const __m256i offset_v = _mm256_set1_epi32(offset);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i ones_16 = _mm256_set1_epi16(1);
+  const __m256i lut_max = _mm256_set1_epi32((256 << (bd - 8)) - 1);
+  const int simd_width = width & ~7;
+
+  for (int i = 0; i < height; i++) {
+    uint16_t *const row = chroma + i * chroma_stride;
+    const uint16_t *const luma_row = luma + (i << subsamp_y) * luma_stride;
+    const int *const grain_row = grain + i * grain_stride;
+    for (int j = 0; j < simd_width; j += 8) {
+      __m256i average_luma;
+      if (subsamp_x) {
+        // Samples are at most 12 bits, so the signed 16-bit madd is exact.
+        const __m256i l =
+            _mm256_loadu_si256((const __m256i *)(luma_row + (j << 1)));
+        average_luma = _mm256_srli_epi32(
+            _mm256_add_epi32(_mm256_madd_epi16(l, ones_16), one), 1);
+      } else {
+        average_luma = _mm256_cvtepu16_epi32(xx_loadu_128(luma_row + j));
+      }
+      const __m256i pix = _mm256_cvtepu16_epi32(xx_loadu_128(row + j));
+      __m256i merged =
+          _mm256_add_epi32(_mm256_mullo_epi32(average_luma, luma_mult_v),
+                           _mm256_mullo_epi32(pix, chroma_mult_v));
+      merged = _mm256_add_epi32(_mm256_srai_epi32(merged, 6), offset_v);
+      merged = _mm256_min_epi32(_mm256_max_epi32(merged, zero), lut_max);
+      const __m256i scale = highbd_scale_lut_8(scaling_lut, merged, bd);
+      store_u16_8(row + j, add_noise_8(pix, scale, grain_row + j, round, shift,
+                                       min, max));
+    }
+  }
+  if (simd_width < width) {
+    aom_highbd_film_grain_add_noise_chroma_c(
+        chroma + simd_width, chroma_stride, luma + (simd_width << subsamp_x),
+        luma_stride, grain + simd_width, grain_stride, scaling_lut,
+        width - simd_width, height, subsamp_x, subsamp_y, luma_mult,
+        chroma_mult, offset, scaling_shift, min_val, max_val, bd);
+  }
+}
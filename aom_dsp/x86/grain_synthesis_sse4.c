@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <smmintrin.h>  // SSE4.1
+
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+#include "aom_dsp/x86/synonyms.h"
+#include "aom_ports/mem.h"
+
+// Looks up the scaling function values of 4 samples in [0, 255].
+static INLINE __m128i scale_lut_4(const int *scaling_lut, __m128i index) {
+  DECLARE_ALIGNED(16, int, idx[4]);
+  xx_store_128(idx, index);
+  return _mm_setr_epi32(scaling_lut[idx[0]], scaling_lut[idx[1]],
+                        scaling_lut[idx[2]], scaling_lut[idx[3]]);
+}
+
+// Returns clamp(pix + ((scale * grain + round) >> shift), min, max).
+static INLINE __m128i add_noise_4(__m128i pix, __m128i scale, const int *grain,
+                                  __m128i round, __m128i shift, __m128i min,
+                                  __m128i max) {
+  __m128i noise = _mm_mullo_epi32(scale, xx_loadu_128(grain));
+  noise = _mm_sra_epi32(_mm_add_epi32(noise, round), shift);
+  return _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(pix, noise), min), max);
+}
+
+static INLINE void store_u8_4(uint8_t *dst, __m128i v) {
+  v = _mm_packs_epi32(v, v);
+  xx_storel_32(dst, _mm_packus_epi16(v, v));
+}
+
+void aom_film_grain_add_noise_luma_sse4_1(uint8_t *luma, int luma_stride,
+                                          const int *grain, int grain_stride,
+                                          const int *scaling_lut, int width,
+                                          int height, int scaling_shift,
+                                          int min_val, int max_val) {
+  const __m128i round = _mm_set1_epi32(1 << (scaling_shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(scaling_shift);
+  const __m128i min = _mm_set1_epi32(min_val);
+  const __m128i max = _mm_set1_epi32(max_val);
+  const int simd_width = width & ~3;
+
+  for (int i = 0; i < height; i++) {
+    uint8_t *const row = luma + i * luma_stride;
+    const int *const grain_row = grain + i * grain_stride;
+    for (int j = 0; j < simd_width; j += 4) {
+      const __m128i pix = _mm_cvtepu8_epi32(xx_loadl_32(row + j));
+      const __m128i out =
+          add_noise_4(pix, scale_lut_4(scaling_lut, pix), grain_row + j, round,
+                      shift, min, max);
+      store_u8_4(row + j, out);
+    }
+    if (simd_width < width) {
+      aom_film_grain_add_noise_luma_c(
+          row + simd_width, luma_stride, grain_row + simd_width, grain_stride,
+          scaling_lut, width - simd_width, 1, scaling_shift, min_val, max_val);
+    }
+  }
+}
+
+void aom_film_grain_add_noise_chroma_sse4_1(
+    uint8_t *chroma, int chroma_stride, const uint8_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val) {
+  const __m128i round = _mm_set1_epi32(1 << (scaling_shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(scaling_shift);
+  const __m128i min = _mm_set1_epi32(min_val);
+  const __m128i max = _mm_set1_epi32(max_val);
+  const __m128i luma_mult_v = _mm_set1_epi32(luma_mult);
+  const __m128i chroma_mult_v = _mm_set1_epi32(chroma_mult);
+  const __m128i offset_v = _mm_set1_epi32(offset);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lut_max = _mm_set1_epi32(255);
+  const __m128i even_mask = _mm_set1_epi16(0xff);
+  const int simd_width = width & ~3;
+
+  for (int i = 0; i < height; i++) {
+    uint8_t *const row = chroma + i * chroma_stride;
+    const uint8_t *const luma_row = luma + (i << subsamp_y) * luma_stride;
+    const int *const grain_row = grain + i * grain_stride;
+    for (int j = 0; j < simd_width; j += 4) {
+      __m128i average_luma;
+      if (subsamp_x) {
+        const __m128i l = xx_loadl_64(luma_row + (j << 1));
+        const __m128i even = _mm_and_si128(l, even_mask);
+        const __m128i odd = _mm_srli_epi16(l, 8);
+        average_luma = _mm_cvtepu16_epi32(_mm_avg_epu16(even, odd));
+      } else {
+        average_luma = _mm_cvtepu8_epi32(xx_loadl_32(luma_row + j));
+      }
+      const __m128i pix = _mm_cvtepu8_epi32(xx_loadl_32(row + j));
+      __m128i merged =
+          _mm_add_epi32(_mm_mullo_epi32(average_luma, luma_mult_v),
+                        _mm_mullo_epi32(pix, chroma_mult_v));
+      merged = _mm_add_epi32(_mm_srai_epi32(merged, 6), offset_v);
+      merged = _mm_min_epi32(_mm_max_epi32(merged, zero), lut_max);
+      const __m128i out =
+          add_noise_4(pix, scale_lut_4(scaling_lut, merged), grain_row + j,
+                      round, shift, min, max);
+      store_u8_4(row + j, out);
+    }
+    if (simd_width < width) {
+      aom_film_grain_add_noise_chroma_c(
+          row + simd_width, chroma_stride, luma_row + (simd_width << subsamp_x),
+          luma_stride, grain_row + simd_width, grain_stride, scaling_lut,
+          width - simd_width, 1, subsamp_x, subsamp_y, luma_mult, chroma_mult,
+          offset, scaling_shift, min_val, max_val);
+    }
+  }
+}
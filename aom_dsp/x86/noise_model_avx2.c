@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+
+void aom_noise_tx_filter_coeffs_avx2(float *coeffs, const float *psd, int n) {
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 min_coeff = _mm256_set1_ps(1e-8f);
+  const __m256 beta = _mm256_set1_ps(1.1f);
+  // 1e-6f is the largest float below 1e-6, so p > 1e-6f gives the same result
+  // as the comparison of the C version, which is done in double.
+  const __m256 min_power = _mm256_set1_ps(1e-6f);
+  const __m256 attenuation = _mm256_set1_ps((1.1f - 1.0f) / 1.1f);
+  int i = 0;
+  // 4 complex coefficients at a time, as pairs of real and imaginary parts.
+  for (; i + 4 <= n; i += 4) {
+    const __m256 c = _mm256_loadu_ps(coeffs + 2 * i);
+    const __m256 a = _mm256_max_ps(_mm256_and_ps(c, abs_mask), min_coeff);
+    const __m256 sq = _mm256_mul_ps(a, a);
+    // The power, in both elements of each pair.
+    const __m256 p = _mm256_add_ps(sq, _mm256_permute_ps(sq, 0xb1));
+    const __m128 s = _mm_loadu_ps(psd + i);
+    const __m256 s2 = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_unpacklo_ps(s, s)), _mm_unpackhi_ps(s, s),
+        1);
+    const __m256 keep =
+        _mm256_and_ps(_mm256_cmp_ps(p, _mm256_mul_ps(beta, s2), _CMP_GT_OQ),
+                      _mm256_cmp_ps(p, min_power, _CMP_GT_OQ));
+    // Where the coefficient is kept, p is above 1e-6f, which is kEps in the C
+    // version, so that p is also its maximum with kEps.
+    const __m256 gain = _mm256_div_ps(_mm256_sub_ps(p, s2), p);
+    const __m256 scale = _mm256_blendv_ps(attenuation, gain, keep);
+    _mm256_storeu_ps(coeffs + 2 * i, _mm256_mul_ps(c, scale));
+  }
+  if (i < n) aom_noise_tx_filter_coeffs_c(coeffs + 2 * i, psd + i, n - i);
+}
+
+void aom_noise_overlap_add_avx2(float *dst, int dst_stride, const float *block,
+                                const float *plane, const float *window, int w,
+                                int h) {
+  if (w & 7) {
+    aom_noise_overlap_add_c(dst, dst_stride, block, plane, window, w, h);
+    return;
+  }
+  for (int y = 0; y < h; ++y, dst += dst_stride) {
+    for (int x = 0; x < w; x += 8) {
+      const int i = y * w + x;
+      const __m256 win = _mm256_loadu_ps(window + i);
+      const __m256 plane_w = _mm256_mul_ps(_mm256_loadu_ps(plane + i), win);
+      const __m256 sum = _mm256_add_ps(_mm256_loadu_ps(block + i), plane_w);
+      _mm256_storeu_ps(dst + x, _mm256_add_ps(_mm256_loadu_ps(dst + x),
+                                              _mm256_mul_ps(sum, win)));
+    }
+  }
+}
+
+// Returns the sum of the 4 partial sums of v, added in the order of the C
+// version.
+static INLINE double hsum_pd(__m256d v) {
+  const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v),
+                               _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+void aom_flat_block_gradient_stats_avx2(const double *block, int block_size,
+                                        double *sum_gxx, double *sum_gxy,
+                                        double *sum_gyy, double *sum,
+                                        double *sum_sq) {
+  const __m256d half = _mm256_set1_pd(0.5);
+  // The columns of the last vector of each row. The others are loaded as 0,
+  // which leaves the partial sums as they are.
+  const int tail = (block_size - 2) & 3;
+  const __m256i mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(tail ? tail : 4),
+                                          _mm256_set_epi64x(3, 2, 1, 0));
+  __m256d gxx = _mm256_setzero_pd();
+  __m256d gxy = _mm256_setzero_pd();
+  __m256d gyy = _mm256_setzero_pd();
+  __m256d s = _mm256_setzero_pd();
+  __m256d sq = _mm256_setzero_pd();
+  for (int yi = 1; yi < block_size - 1; ++yi) {
+    const double *row = block + yi * block_size;
+    for (int xi = 1; xi < block_size - 1; xi += 4) {
+      __m256d left, right, above, below, c;
+      if (xi + 4 <= block_size - 1) {
+        left = _mm256_loadu_pd(row + xi - 1);
+        right = _mm256_loadu_pd(row + xi + 1);
+        above = _mm256_loadu_pd(row + xi - block_size);
+        below = _mm256_loadu_pd(row + xi + block_size);
+        c = _mm256_loadu_pd(row + xi);
+      } else {
+        left = _mm256_maskload_pd(row + xi - 1, mask);
+        right = _mm256_maskload_pd(row + xi + 1, mask);
+        above = _mm256_maskload_pd(row + xi - block_size, mask);
+        below = _mm256_maskload_pd(row + xi + block_size, mask);
+        c = _mm256_maskload_pd(row + xi, mask);
+      }
+      const __m256d gx = _mm256_mul_pd(_mm256_sub_pd(right, left), half);
+      const __m256d gy = _mm256_mul_pd(_mm256_sub_pd(below, above), half);
+      gxx = _mm256_add_pd(gxx, _mm256_mul_pd(gx, gx));
+      gxy = _mm256_add_pd(gxy, _mm256_mul_pd(gx, gy));
+      gyy = _mm256_add_pd(gyy, _mm256_mul_pd(gy, gy));
+      s = _mm256_add_pd(s, c);
+      sq = _mm256_add_pd(sq, _mm256_mul_pd(c, c));
+    }
+  }
+  *sum_gxx = hsum_pd(gxx);
+  *sum_gxy = hsum_pd(gxy);
+  *sum_gyy = hsum_pd(gyy);
+  *sum = hsum_pd(s);
+  *sum_sq = hsum_pd(sq);
+}
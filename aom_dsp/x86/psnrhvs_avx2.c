@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+#include <math.h>
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom_dsp/txfm_common.h"
+#include "aom_ports/mem.h"
+
+static INLINE double hsum_pd(__m256d v) {
+  const __m128d sum_2 = _mm_add_pd(_mm256_castpd256_pd128(v),
+                                   _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(sum_2, _mm_unpackhi_pd(sum_2, sum_2)));
+}
+
+// Returns the elements of v moved down by n = 1 or 2 lanes.
+static INLINE __m256i shift_lanes_epi32(__m256i v, int n) {
+  const __m256i idx = _mm256_min_epi32(
+      _mm256_add_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                       _mm256_set1_epi32(n)),
+      _mm256_set1_epi32(7));
+  return _mm256_permutevar8x32_epi32(v, idx);
+}
+
+// Computes the magnitudes of the 4 gradients whose horizontal and vertical
+// filter sums are in the low and high lanes of g. Adds them to *sum and the
+// number of those above 0.1 to *count.
+static INLINE void accumulate_gradients(__m256i g, __m256 scale, __m256d *sum,
+                                        __m256i *count) {
+  const __m256 g_ps = _mm256_div_ps(_mm256_cvtepi32_ps(g), scale);
+  const __m256d gx = _mm256_cvtps_pd(_mm256_castps256_ps128(g_ps));
+  const __m256d gy = _mm256_cvtps_pd(_mm256_extractf128_ps(g_ps, 1));
+  const __m256d mag = _mm256_sqrt_pd(
+      _mm256_add_pd(_mm256_mul_pd(gx, gx), _mm256_mul_pd(gy, gy)));
+  *sum = _mm256_add_pd(*sum, mag);
+  // The comparisons are -1 where true.
+  *count = _mm256_sub_epi64(
+      *count, _mm256_castpd_si256(_mm256_cmp_pd(mag, _mm256_set1_pd(0.1f),
+                                                _CMP_GT_OQ)));
+}
+
+// As psnrhvs_gvar() in the C version. The 6 gradients of a row are in lanes
+// 0-5 of the filter sums, and the last two of a pair of rows are gathered, so
+// that only the order of the sum of their magnitudes differs.
+static double psnrhvs_gvar_avx2(const int16_t *src, int pix_max) {
+  const __m256i three = _mm256_set1_epi32(3);
+  const __m256i ten = _mm256_set1_epi32(10);
+  const __m256 scale = _mm256_set1_ps(pix_max * 16.f);
+  __m256i rows[8], diff_02[8], g_hi[2];
+  for (int i = 0; i < 8; i++) {
+    rows[i] =
+        _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + 8 * i)));
+    // src[i][j - 1] - src[i][j + 1], in lane j - 1.
+    diff_02[i] = _mm256_sub_epi32(rows[i], shift_lanes_epi32(rows[i], 2));
+  }
+
+  __m256d sum = _mm256_setzero_pd();
+  __m256i count = _mm256_setzero_si256();
+  for (int i = 1; i < 7; i++) {
+    const __m256i gx = _mm256_add_epi32(
+        _mm256_mullo_epi32(_mm256_add_epi32(diff_02[i - 1], diff_02[i + 1]),
+                           three),
+        _mm256_mullo_epi32(diff_02[i], ten));
+    const __m256i diff_v = _mm256_sub_epi32(rows[i - 1], rows[i + 1]);
+    const __m256i gy = _mm256_add_epi32(
+        _mm256_mullo_epi32(
+            _mm256_add_epi32(diff_v, shift_lanes_epi32(diff_v, 2)), three),
+        _mm256_mullo_epi32(shift_lanes_epi32(diff_v, 1), ten));
+    accumulate_gradients(_mm256_permute2x128_si256(gx, gy, 0x20), scale, &sum,
+                         &count);
+    g_hi[i & 1] = _mm256_permute2x128_si256(gx, gy, 0x31);
+    if (!(i & 1)) {
+      accumulate_gradients(_mm256_unpacklo_epi64(g_hi[1], g_hi[0]), scale,
+                           &sum, &count);
+    }
+  }
+
+  const __m128i count_2 = _mm_add_epi64(_mm256_castsi256_si128(count),
+                                        _mm256_extracti128_si256(count, 1));
+  const int n = _mm_cvtsi128_si32(_mm_add_epi64(count_2,
+                                                _mm_srli_si128(count_2, 8)));
+  const double s_gmean = hsum_pd(sum);
+  return 1.f / (36 - n + 1) * s_gmean / 36.f;
+}
+
+static INLINE __m256i round_shift_dct(__m256i x) {
+  return _mm256_srai_epi32(
+      _mm256_add_epi32(x, _mm256_set1_epi32(DCT_CONST_ROUNDING)),
+      DCT_CONST_BITS);
+}
+
+// Returns a * ca + b * cb.
+static INLINE __m256i mul_add_epi32(__m256i a, int ca, __m256i b, int cb) {
+  return _mm256_add_epi32(_mm256_mullo_epi32(a, _mm256_set1_epi32(ca)),
+                          _mm256_mullo_epi32(b, _mm256_set1_epi32(cb)));
+}
+
+// One pass of aom_fdct8x8_c() on the 8 elements of each lane of in.
+static INLINE void fdct8_epi32(const __m256i *in, __m256i *out) {
+  const int c16 = (int)cospi_16_64;
+  // stage 1
+  const __m256i s0 = _mm256_add_epi32(in[0], in[7]);
+  const __m256i s1 = _mm256_add_epi32(in[1], in[6]);
+  const __m256i s2 = _mm256_add_epi32(in[2], in[5]);
+  const __m256i s3 = _mm256_add_epi32(in[3], in[4]);
+  const __m256i s4 = _mm256_sub_epi32(in[3], in[4]);
+  const __m256i s5 = _mm256_sub_epi32(in[2], in[5]);
+  const __m256i s6 = _mm256_sub_epi32(in[1], in[6]);
+  const __m256i s7 = _mm256_sub_epi32(in[0], in[7]);
+
+  // fdct4(step, step);
+  const __m256i x0 = _mm256_add_epi32(s0, s3);
+  const __m256i x1 = _mm256_add_epi32(s1, s2);
+  const __m256i x2 = _mm256_sub_epi32(s1, s2);
+  const __m256i x3 = _mm256_sub_epi32(s0, s3);
+  out[0] = round_shift_dct(
+      _mm256_mullo_epi32(_mm256_add_epi32(x0, x1), _mm256_set1_epi32(c16)));
+  out[4] = round_shift_dct(
+      _mm256_mullo_epi32(_mm256_sub_epi32(x0, x1), _mm256_set1_epi32(c16)));
+  out[2] = round_shift_dct(
+      mul_add_epi32(x2, (int)cospi_24_64, x3, (int)cospi_8_64));
+  out[6] = round_shift_dct(
+      mul_add_epi32(x2, -(int)cospi_8_64, x3, (int)cospi_24_64));
+
+  // Stage 2
+  const __m256i t2 = round_shift_dct(
+      _mm256_mullo_epi32(_mm256_sub_epi32(s6, s5), _mm256_set1_epi32(c16)));
+  const __m256i t3 = round_shift_dct(
+      _mm256_mullo_epi32(_mm256_add_epi32(s6, s5), _mm256_set1_epi32(c16)));
+
+  // Stage 3
+  const __m256i y0 = _mm256_add_epi32(s4, t2);
+  const __m256i y1 = _mm256_sub_epi32(s4, t2);
+  const __m256i y2 = _mm256_sub_epi32(s7, t3);
+  const __m256i y3 = _mm256_add_epi32(s7, t3);
+
+  // Stage 4
+  out[1] = round_shift_dct(
+      mul_add_epi32(y0, (int)cospi_28_64, y3, (int)cospi_4_64));
+  out[5] = round_shift_dct(
+      mul_add_epi32(y1, (int)cospi_12_64, y2, (int)cospi_20_64));
+  out[3] = round_shift_dct(
+      mul_add_epi32(y2, (int)cospi_12_64, y1, -(int)cospi_20_64));
+  out[7] = round_shift_dct(
+      mul_add_epi32(y3, (int)cospi_28_64, y0, -(int)cospi_4_64));
+}
+
+static INLINE void transpose_8x8_epi32(const __m256i *in, __m256i *out) {
+  const __m256i a0 = _mm256_unpacklo_epi32(in[0], in[1]);
+  const __m256i a1 = _mm256_unpackhi_epi32(in[0], in[1]);
+  const __m256i a2 = _mm256_unpacklo_epi32(in[2], in[3]);
+  const __m256i a3 = _mm256_unpackhi_epi32(in[2], in[3]);
+  const __m256i a4 = _mm256_unpacklo_epi32(in[4], in[5]);
+  const __m256i a5 = _mm256_unpackhi_epi32(in[4], in[5]);
+  const __m256i a6 = _mm256_unpacklo_epi32(in[6], in[7]);
+  const __m256i a7 = _mm256_unpackhi_epi32(in[6], in[7]);
+  const __m256i b0 = _mm256_unpacklo_epi64(a0, a2);
+  const __m256i b1 = _mm256_unpackhi_epi64(a0, a2);
+  const __m256i b2 = _mm256_unpacklo_epi64(a1, a3);
+  const __m256i b3 = _mm256_unpackhi_epi64(a1, a3);
+  const __m256i b4 = _mm256_unpacklo_epi64(a4, a6);
+  const __m256i b5 = _mm256_unpackhi_epi64(a4, a6);
+  const __m256i b6 = _mm256_unpacklo_epi64(a5, a7);
+  const __m256i b7 = _mm256_unpackhi_epi64(a5, a7);
+  out[0] = _mm256_permute2x128_si256(b0, b4, 0x20);
+  out[1] = _mm256_permute2x128_si256(b1, b5, 0x20);
+  out[2] = _mm256_permute2x128_si256(b2, b6, 0x20);
+  out[3] = _mm256_permute2x128_si256(b3, b7, 0x20);
+  out[4] = _mm256_permute2x128_si256(b0, b4, 0x31);
+  out[5] = _mm256_permute2x128_si256(b1, b5, 0x31);
+  out[6] = _mm256_permute2x128_si256(b2, b6, 0x31);
+  out[7] = _mm256_permute2x128_si256(b3, b7, 0x31);
+}
+
+// Applies the rounding of od_bin_fdct8x8() to the coefficients x of
+// aom_fdct8x8() before their final division by 2, which truncates.
+static INLINE __m256i round_coeffs(__m256i x) {
+  const __m256i half =
+      _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 31)), 1);
+  return _mm256_srai_epi32(_mm256_add_epi32(half, _mm256_set1_epi32(4)), 3);
+}
+
+// The 8-bit pixels and their differences keep the intermediate values of
+// aom_fdct8x8_c() within 32 bits, so that the rows are transformed with 32
+// bit multiplications and give the same coefficients.
+static void fdct8x8_avx2(const int16_t *src, __m256i *coeffs) {
+  __m256i buf0[8], buf1[8];
+  for (int i = 0; i < 8; i++) {
+    buf0[i] = _mm256_slli_epi32(
+        _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(src + 8 * i))),
+        2);
+  }
+  fdct8_epi32(buf0, buf1);
+  transpose_8x8_epi32(buf1, buf0);
+  fdct8_epi32(buf0, buf1);
+  transpose_8x8_epi32(buf1, buf0);
+  for (int i = 0; i < 8; i++) coeffs[i] = round_coeffs(buf0[i]);
+}
+
+// As psnrhvs_masked_error() in the C version, on the rows of coefficients
+// s_coeffs and d_coeffs.
+static double psnrhvs_masked_error_avx2(const __m256i *s_coeffs,
+                                        const __m256i *d_coeffs,
+                                        const double *csf, const double *mask,
+                                        double s_gvar) {
+  const __m256d zero = _mm256_setzero_pd();
+  __m256d sum = _mm256_setzero_pd();
+  for (int i = 0; i < 8; i++) {
+    __m256i sq = _mm256_mullo_epi32(s_coeffs[i], s_coeffs[i]);
+    // The DC coefficient is left out.
+    if (i == 0) sq = _mm256_blend_epi32(sq, _mm256_setzero_si256(), 0x01);
+    sum = _mm256_add_pd(
+        sum, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sq)),
+                           _mm256_loadu_pd(mask + 8 * i)));
+    sum = _mm256_add_pd(
+        sum, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sq, 1)),
+                           _mm256_loadu_pd(mask + 8 * i + 4)));
+  }
+  const __m256d s_mask = _mm256_set1_pd(sqrt(hsum_pd(sum) * s_gvar) / 8.f);
+
+  __m256d ret = _mm256_setzero_pd();
+  for (int i = 0; i < 8; i++) {
+    const __m256i diff =
+        _mm256_abs_epi32(_mm256_sub_epi32(s_coeffs[i], d_coeffs[i]));
+    for (int k = 0; k < 2; k++) {
+      const __m256d err = _mm256_cvtepi32_pd(
+          k == 0 ? _mm256_castsi256_si128(diff)
+                 : _mm256_extracti128_si256(diff, 1));
+      __m256d thr =
+          _mm256_div_pd(s_mask, _mm256_loadu_pd(mask + 8 * i + 4 * k));
+      // The DC coefficient is not masked.
+      if (i == 0 && k == 0) thr = _mm256_blend_pd(thr, zero, 0x01);
+      const __m256d err_w = _mm256_mul_pd(
+          _mm256_max_pd(_mm256_sub_pd(err, thr), zero),
+          _mm256_loadu_pd(csf + 8 * i + 4 * k));
+      ret = _mm256_add_pd(ret, _mm256_mul_pd(err_w, err_w));
+    }
+  }
+  return hsum_pd(ret);
+}
+
+double aom_psnrhvs_8x8_avx2(const int16_t *src, const int16_t *dst,
+                            const double *csf, const double *mask,
+                            int pix_max) {
+  __m256i s_coeffs[8], d_coeffs[8];
+  const double s_gvar = psnrhvs_gvar_avx2(src, pix_max);
+  fdct8x8_avx2(src, s_coeffs);
+  fdct8x8_avx2(dst, d_coeffs);
+  return psnrhvs_masked_error_avx2(s_coeffs, d_coeffs, csf, mask, s_gvar);
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+// The high bit depth transforms need 64 bit intermediate values, and are done
+// by aom_highbd_fdct8x8().
+static void highbd_fdct8x8_avx2(const int16_t *src, __m256i *coeffs) {
+  DECLARE_ALIGNED(32, tran_low_t, buf[8 * 8]);
+  aom_highbd_fdct8x8(src, buf, 8);
+  for (int i = 0; i < 8; i++) {
+    const __m256i x = _mm256_load_si256((const __m256i *)(buf + 8 * i));
+    coeffs[i] =
+        _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(4)), 3);
+  }
+}
+
+double aom_highbd_psnrhvs_8x8_avx2(const int16_t *src, const int16_t *dst,
+                                   const double *csf, const double *mask,
+                                   int pix_max) {
+  __m256i s_coeffs[8], d_coeffs[8];
+  const double s_gvar = psnrhvs_gvar_avx2(src, pix_max);
+  highbd_fdct8x8_avx2(src, s_coeffs);
+  highbd_fdct8x8_avx2(dst, d_coeffs);
+  return psnrhvs_masked_error_avx2(s_coeffs, d_coeffs, csf, mask, s_gvar);
+}
+#endif  // CONFIG_AV1_HIGHBITDEPTH
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+#include <immintrin.h>  // AVX-512
+
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+
+static INLINE __m512i load_2x32(const uint8_t *p, int stride) {
+  const __m256i row0 = _mm256_loadu_si256((const __m256i *)p);
+  const __m256i row1 = _mm256_loadu_si256((const __m256i *)(p + stride));
+  return _mm512_inserti64x4(_mm512_castsi256_si512(row0), row1, 1);
+}
+
+// Adds the sads of the 64 bytes of src and ref0..ref3 to sum[0..3].
+static INLINE void sad64_x4(__m512i src, __m512i ref0, __m512i ref1,
+                            __m512i ref2, __m512i ref3, __m512i *sum) {
+  sum[0] = _mm512_add_epi32(sum[0], _mm512_sad_epu8(ref0, src));
+  sum[1] = _mm512_add_epi32(sum[1], _mm512_sad_epu8(ref1, src));
+  sum[2] = _mm512_add_epi32(sum[2], _mm512_sad_epu8(ref2, src));
+  sum[3] = _mm512_add_epi32(sum[3], _mm512_sad_epu8(ref3, src));
+}
+
+static INLINE void store_sad_x4(__m512i *sum, uint32_t res[4]) {
+  // The sad of each 8 bytes is in the low 32 bits of each 64 bits. Put the
+  // sums of ref i in the 32 bits i of each 128 bit lane and add the lanes.
+  sum[1] = _mm512_bslli_epi128(sum[1], 4);
+  sum[3] = _mm512_bslli_epi128(sum[3], 4);
+  sum[0] = _mm512_or_si512(sum[0], sum[1]);
+  sum[2] = _mm512_or_si512(sum[2], sum[3]);
+  const __m512i sum_0123 =
+      _mm512_add_epi32(_mm512_unpacklo_epi64(sum[0], sum[2]),
+                       _mm512_unpackhi_epi64(sum[0], sum[2]));
+  const __m256i sum_256 =
+      _mm256_add_epi32(_mm512_castsi512_si256(sum_0123),
+                       _mm512_extracti64x4_epi64(sum_0123, 1));
+  const __m128i sum_128 = _mm_add_epi32(_mm256_castsi256_si128(sum_256),
+                                        _mm256_extracti128_si256(sum_256, 1));
+  _mm_storeu_si128((__m128i *)res, sum_128);
+}
+
+// Two rows of 32 pixels per vector.
+static INLINE void sad32xh_x4d_avx512(const uint8_t *src, int src_stride,
+                                      const uint8_t *const ref[4],
+                                      int ref_stride, int h, uint32_t res[4]) {
+  __m512i sum[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(),
+                     _mm512_setzero_si512(), _mm512_setzero_si512() };
+  for (int i = 0; i < h; i += 2) {
+    const int ref_offset = i * ref_stride;
+    sad64_x4(load_2x32(src + i * src_stride, src_stride),
+             load_2x32(ref[0] + ref_offset, ref_stride),
+             load_2x32(ref[1] + ref_offset, ref_stride),
+             load_2x32(ref[2] + ref_offset, ref_stride),
+             load_2x32(ref[3] + ref_offset, ref_stride), sum);
+  }
+  store_sad_x4(sum, res);
+}
+
+static INLINE void sadwxh_x4d_avx512(const uint8_t *src, int src_stride,
+                                     const uint8_t *const ref[4],
+                                     int ref_stride, int w, int h,
+                                     uint32_t res[4]) {
+  __m512i sum[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(),
+                     _mm512_setzero_si512(), _mm512_setzero_si512() };
+  for (int i = 0; i < h; ++i) {
+    const int ref_offset = i * ref_stride;
+    for (int j = 0; j < w; j += 64) {
+      sad64_x4(_mm512_loadu_si512(src + i * src_stride + j),
+               _mm512_loadu_si512(ref[0] + ref_offset + j),
+               _mm512_loadu_si512(ref[1] + ref_offset + j),
+               _mm512_loadu_si512(ref[2] + ref_offset + j),
+               _mm512_loadu_si512(ref[3] + ref_offset + j), sum);
+    }
+  }
+  store_sad_x4(sum, res);
+}
+
+#define SAD32XN_X4D_AVX512(n)                                                  \
+  void aom_sad32x##n##x4d_avx512(const uint8_t *src, int src_stride,           \
+                                 const uint8_t *const ref[4], int ref_stride,  \
+                                 uint32_t res[4]) {                            \
+    sad32xh_x4d_avx512(src, src_stride, ref, ref_stride, n, res);              \
+  }
+
+#define SADMXN_X4D_AVX512(m, n)                                                \
+  void aom_sad##m##x##n##x4d_avx512(const uint8_t *src, int src_stride,        \
+                                    const uint8_t *const ref[4],               \
+                                    int ref_stride, uint32_t res[4]) {         \
+    sadwxh_x4d_avx512(src, src_stride, ref, ref_stride, m, n, res);            \
+  }
+
+SAD32XN_X4D_AVX512(8)
+SAD32XN_X4D_AVX512(16)
+SAD32XN_X4D_AVX512(32)
+SAD32XN_X4D_AVX512(64)
+
+SADMXN_X4D_AVX512(64, 16)
+SADMXN_X4D_AVX512(64, 32)
+SADMXN_X4D_AVX512(64, 64)
+SADMXN_X4D_AVX512(64, 128)
+
+SADMXN_X4D_AVX512(128, 64)
+SADMXN_X4D_AVX512(128, 128)
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+
+// Adds the sums of the 32 bit elements of sum_s, sum_r, sum_sq_s, sum_sq_r and
+// sum_sxr to the corresponding outputs.
+static INLINE void add_ssim_parms(__m256i sum_s, __m256i sum_r,
+                                  __m256i sum_sq_s, __m256i sum_sq_r,
+                                  __m256i sum_sxr, uint32_t *out_s,
+                                  uint32_t *out_r, uint32_t *out_sq_s,
+                                  uint32_t *out_sq_r, uint32_t *out_sxr) {
+  const __m256i t0 = _mm256_hadd_epi32(sum_s, sum_r);
+  const __m256i t1 = _mm256_hadd_epi32(sum_sq_s, sum_sq_r);
+  const __m256i t2 = _mm256_hadd_epi32(sum_sxr, sum_sxr);
+  const __m256i u0 = _mm256_hadd_epi32(t0, t1);
+  const __m256i u1 = _mm256_hadd_epi32(t2, t2);
+  // The sums of s, r, s * s and r * r, and of s * r.
+  const __m128i v0 = _mm_add_epi32(_mm256_castsi256_si128(u0),
+                                   _mm256_extracti128_si256(u0, 1));
+  const __m128i v1 = _mm_add_epi32(_mm256_castsi256_si128(u1),
+                                   _mm256_extracti128_si256(u1, 1));
+  *out_s += (uint32_t)_mm_cvtsi128_si32(v0);
+  *out_r += (uint32_t)_mm_extract_epi32(v0, 1);
+  *out_sq_s += (uint32_t)_mm_extract_epi32(v0, 2);
+  *out_sq_r += (uint32_t)_mm_extract_epi32(v0, 3);
+  *out_sxr += (uint32_t)_mm_cvtsi128_si32(v1);
+}
+
+void aom_ssim_parms_8x8_avx2(const uint8_t *s, int sp, const uint8_t *r,
+                             int rp, uint32_t *sum_s, uint32_t *sum_r,
+                             uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                             uint32_t *sum_sxr) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i s_16 = _mm256_setzero_si256();
+  __m256i r_16 = _mm256_setzero_si256();
+  __m256i sq_s = _mm256_setzero_si256();
+  __m256i sq_r = _mm256_setzero_si256();
+  __m256i sxr = _mm256_setzero_si256();
+
+  // Two rows at a time, as 16 bit pixels.
+  for (int i = 0; i < 8; i += 2, s += 2 * sp, r += 2 * rp) {
+    const __m256i s_2 = _mm256_cvtepu8_epi16(
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)s),
+                           _mm_loadl_epi64((const __m128i *)(s + sp))));
+    const __m256i r_2 = _mm256_cvtepu8_epi16(
+        _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)r),
+                           _mm_loadl_epi64((const __m128i *)(r + rp))));
+    s_16 = _mm256_add_epi16(s_16, s_2);
+    r_16 = _mm256_add_epi16(r_16, r_2);
+    sq_s = _mm256_add_epi32(sq_s, _mm256_madd_epi16(s_2, s_2));
+    sq_r = _mm256_add_epi32(sq_r, _mm256_madd_epi16(r_2, r_2));
+    sxr = _mm256_add_epi32(sxr, _mm256_madd_epi16(s_2, r_2));
+  }
+
+  add_ssim_parms(_mm256_madd_epi16(s_16, ones), _mm256_madd_epi16(r_16, ones),
+                 sq_s, sq_r, sxr, sum_s, sum_r, sum_sq_s, sum_sq_r, sum_sxr);
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+// The pixels have at most 12 bits, so that their products fit the signed
+// multiplications of _mm256_madd_epi16() and the sums of 4 of them 16 bits.
+void aom_highbd_ssim_parms_8x8_avx2(const uint16_t *s, int sp,
+                                    const uint16_t *r, int rp, uint32_t *sum_s,
+                                    uint32_t *sum_r, uint32_t *sum_sq_s,
+                                    uint32_t *sum_sq_r, uint32_t *sum_sxr) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i s_16 = _mm256_setzero_si256();
+  __m256i r_16 = _mm256_setzero_si256();
+  __m256i sq_s = _mm256_setzero_si256();
+  __m256i sq_r = _mm256_setzero_si256();
+  __m256i sxr = _mm256_setzero_si256();
+
+  for (int i = 0; i < 8; i += 2, s += 2 * sp, r += 2 * rp) {
+    const __m256i s_2 = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)s)),
+        _mm_loadu_si128((const __m128i *)(s + sp)), 1);
+    const __m256i r_2 = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)r)),
+        _mm_loadu_si128((const __m128i *)(r + rp)), 1);
+    s_16 = _mm256_add_epi16(s_16, s_2);
+    r_16 = _mm256_add_epi16(r_16, r_2);
+    sq_s = _mm256_add_epi32(sq_s, _mm256_madd_epi16(s_2, s_2));
+    sq_r = _mm256_add_epi32(sq_r, _mm256_madd_epi16(r_2, r_2));
+    sxr = _mm256_add_epi32(sxr, _mm256_madd_epi16(s_2, r_2));
+  }
+
+  add_ssim_parms(_mm256_madd_epi16(s_16, ones), _mm256_madd_epi16(r_16, ones),
+                 sq_s, sq_r, sxr, sum_s, sum_r, sum_sq_s, sum_sq_r, sum_sxr);
+}
+#endif  // CONFIG_AV1_HIGHBITDEPTH
@@ -9,11 +9,14 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <assert.h>
 #include <immintrin.h>
 
 #include "config/aom_dsp_rtcd.h"
 
 #include "aom_dsp/x86/masked_variance_intrin_ssse3.h"
+#include "aom_dsp/x86/synonyms.h"
+#include "aom_dsp/x86/synonyms_avx2.h"
 
 static INLINE __m128i mm256_add_hi_lo_epi16(const __m256i val) {
   return _mm_add_epi16(_mm256_castsi256_si128(val),
@@ -524,3 +527,66 @@ void aom_highbd_comp_mask_pred_avx2(uint8_t *comp_pred8, const uint8_t *pred8,
     } while (i < height);
   }
 }
+
+static INLINE uint64_t mse_sum_epu32_avx2(const __m256i sum) {
+  const __m256i zeros = _mm256_setzero_si256();
+  const __m256i sum_64x4 = _mm256_add_epi64(_mm256_unpacklo_epi32(sum, zeros),
+                                            _mm256_unpackhi_epi32(sum, zeros));
+  const __m128i sum_64x2 = _mm_add_epi64(_mm256_castsi256_si128(sum_64x4),
+                                         _mm256_extracti128_si256(sum_64x4, 1));
+  uint64_t res;
+  xx_storel_64(&res, _mm_add_epi64(sum_64x2, _mm_srli_si128(sum_64x2, 8)));
+  return res;
+}
+
+static uint64_t mse_4xh_16bit_avx2(uint8_t *dst, int dstride, uint16_t *src,
+                                   int sstride, int h) {
+  __m256i sum = _mm256_setzero_si256();
+  for (int i = 0; i < h; i += 4) {
+    const __m128i dst_8x8_lo =
+        _mm_unpacklo_epi32(xx_loadl_32(&dst[i * dstride]),
+                           xx_loadl_32(&dst[(i + 1) * dstride]));
+    const __m128i dst_8x8_hi =
+        _mm_unpacklo_epi32(xx_loadl_32(&dst[(i + 2) * dstride]),
+                           xx_loadl_32(&dst[(i + 3) * dstride]));
+    const __m256i dst_16x16 =
+        _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(dst_8x8_lo, dst_8x8_hi));
+    const __m128i src_16x8_lo =
+        _mm_unpacklo_epi64(xx_loadl_64(&src[i * sstride]),
+                           xx_loadl_64(&src[(i + 1) * sstride]));
+    const __m128i src_16x8_hi =
+        _mm_unpacklo_epi64(xx_loadl_64(&src[(i + 2) * sstride]),
+                           xx_loadl_64(&src[(i + 3) * sstride]));
+    const __m256i src_16x16 = yy_set_m128i(src_16x8_hi, src_16x8_lo);
+    const __m256i diff = _mm256_sub_epi16(dst_16x16, src_16x16);
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(diff, diff));
+  }
+  return mse_sum_epu32_avx2(sum);
+}
+
+static uint64_t mse_8xh_16bit_avx2(uint8_t *dst, int dstride, uint16_t *src,
+                                   int sstride, int h) {
+  __m256i sum = _mm256_setzero_si256();
+  for (int i = 0; i < h; i += 2) {
+    const __m256i dst_16x16 = _mm256_cvtepu8_epi16(
+        _mm_unpacklo_epi64(xx_loadl_64(&dst[i * dstride]),
+                           xx_loadl_64(&dst[(i + 1) * dstride])));
+    const __m256i src_16x16 =
+        yy_loadu2_128(&src[(i + 1) * sstride], &src[i * sstride]);
+    const __m256i diff = _mm256_sub_epi16(dst_16x16, src_16x16);
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(diff, diff));
+  }
+  return mse_sum_epu32_avx2(sum);
+}
+
+// Only the 4x4, 4x8, 8x4 and 8x8 blocks of the CDEF search are supported.
+uint64_t aom_mse_wxh_16bit_avx2(uint8_t *dst, int dstride, uint16_t *src,
+                                int sstride, int w, int h) {
+  assert((w == 8 || w == 4) && (h == 8 || h == 4) &&
+         "w=8/4 and h=8/4 must be satisfied");
+  switch (w) {
+    case 4: return mse_4xh_16bit_avx2(dst, dstride, src, sstride, h);
+    case 8: return mse_8xh_16bit_avx2(dst, dstride, src, sstride, h);
+    default: assert(0 && "unsupported width"); return -1;
+  }
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>
+
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_integer.h"
+#include "aom_dsp/aom_dsp_common.h"
+
+static INLINE __m512i load_2x32(const uint8_t *p, int stride) {
+  const __m256i row0 = _mm256_loadu_si256((const __m256i *)p);
+  const __m256i row1 = _mm256_loadu_si256((const __m256i *)(p + stride));
+  return _mm512_inserti64x4(_mm512_castsi256_si512(row0), row1, 1);
+}
+
+static INLINE void variance_kernel_avx512(const __m512i src, const __m512i ref,
+                                          __m512i *const sse,
+                                          __m512i *const sum) {
+  const __m512i adj_sub = _mm512_set1_epi16((short)0xff01);  // (1,-1)
+
+  // unpack into pairs of source and reference values
+  const __m512i src_ref0 = _mm512_unpacklo_epi8(src, ref);
+  const __m512i src_ref1 = _mm512_unpackhi_epi8(src, ref);
+
+  // subtract adjacent elements using src*1 + ref*-1
+  const __m512i diff0 = _mm512_maddubs_epi16(src_ref0, adj_sub);
+  const __m512i diff1 = _mm512_maddubs_epi16(src_ref1, adj_sub);
+  const __m512i madd0 = _mm512_madd_epi16(diff0, diff0);
+  const __m512i madd1 = _mm512_madd_epi16(diff1, diff1);
+
+  // add to the running totals
+  *sum = _mm512_add_epi16(*sum, _mm512_add_epi16(diff0, diff1));
+  *sse = _mm512_add_epi32(*sse, _mm512_add_epi32(madd0, madd1));
+}
+
+// Accumulates the differences of w x h pixels, w being 32, 64 or 128. Each
+// kernel call adds at most 2 * 255 to the 16 bit sums, so they are widened to
+// 32 bits every 64 calls.
+static INLINE void variance_avx512(const uint8_t *src, int src_stride,
+                                   const uint8_t *ref, int ref_stride, int w,
+                                   int h, __m512i *const vsse,
+                                   __m512i *const vsum) {
+  const __m512i one = _mm512_set1_epi16(1);
+  const int rows_per_step = w == 32 ? 2 : 1;
+  const int rows_per_flush = 64 * 64 / w;
+
+  for (int i = 0; i < h; i += rows_per_flush) {
+    __m512i vsum16 = _mm512_setzero_si512();
+    const int rows = AOMMIN(rows_per_flush, h - i);
+    for (int r = 0; r < rows; r += rows_per_step) {
+      if (w == 32) {
+        variance_kernel_avx512(load_2x32(src, src_stride),
+                               load_2x32(ref, ref_stride), vsse, &vsum16);
+      } else {
+        for (int j = 0; j < w; j += 64) {
+          variance_kernel_avx512(_mm512_loadu_si512(src + j),
+                                 _mm512_loadu_si512(ref + j), vsse, &vsum16);
+        }
+      }
+      src += rows_per_step * src_stride;
+      ref += rows_per_step * ref_stride;
+    }
+    *vsum = _mm512_add_epi32(*vsum, _mm512_madd_epi16(vsum16, one));
+  }
+}
+
+static INLINE int variance_final_avx512(__m512i vsse, __m512i vsum,
+                                        unsigned int *const sse) {
+  // Interleave the sse and sum totals and add the four 128 bit lanes.
+  const __m512i sse_sum = _mm512_add_epi32(_mm512_unpacklo_epi32(vsse, vsum),
+                                           _mm512_unpackhi_epi32(vsse, vsum));
+  const __m256i sse_sum_256 =
+      _mm256_add_epi32(_mm512_castsi512_si256(sse_sum),
+                       _mm512_extracti64x4_epi64(sse_sum, 1));
+  const __m128i sse_sum_128 =
+      _mm_add_epi32(_mm256_castsi256_si128(sse_sum_256),
+                    _mm256_extracti128_si256(sse_sum_256, 1));
+  const __m128i res =
+      _mm_add_epi32(sse_sum_128, _mm_srli_si128(sse_sum_128, 8));
+  *sse = (unsigned int)_mm_cvtsi128_si32(res);
+  return _mm_extract_epi32(res, 1);
+}
+
+#define AOM_VAR_AVX512(bw, bh, bits)                                           \
+  unsigned int aom_variance##bw##x##bh##_avx512(                               \
+      const uint8_t *src, int src_stride, const uint8_t *ref, int ref_stride,  \
+      unsigned int *sse) {                                                     \
+    __m512i vsse = _mm512_setzero_si512();                                     \
+    __m512i vsum = _mm512_setzero_si512();                                     \
+    variance_avx512(src, src_stride, ref, ref_stride, bw, bh, &vsse, &vsum);   \
+    const int sum = variance_final_avx512(vsse, vsum, sse);                    \
+    return *sse - (uint32_t)(((int64_t)sum * sum) >> bits);                    \
+  }
+
+AOM_VAR_AVX512(32, 8, 8)
+AOM_VAR_AVX512(32, 16, 9)
+AOM_VAR_AVX512(32, 32, 10)
+AOM_VAR_AVX512(32, 64, 11)
+
+AOM_VAR_AVX512(64, 16, 10)
+AOM_VAR_AVX512(64, 32, 11)
+AOM_VAR_AVX512(64, 64, 12)
+AOM_VAR_AVX512(64, 128, 13)
+
+AOM_VAR_AVX512(128, 64, 13)
+AOM_VAR_AVX512(128, 128, 14)
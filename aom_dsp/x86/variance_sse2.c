@@ -755,3 +755,56 @@ void aom_highbd_comp_mask_pred_sse2(uint8_t *comp_pred8, const uint8_t *pred8,
     } while (i < height);
   }
 }
+
+static INLINE uint64_t mse_sum_epu32_sse2(const __m128i sum) {
+  const __m128i zeros = _mm_setzero_si128();
+  const __m128i sum_64x2 = _mm_add_epi64(_mm_unpacklo_epi32(sum, zeros),
+                                         _mm_unpackhi_epi32(sum, zeros));
+  uint64_t res;
+  xx_storel_64(&res, _mm_add_epi64(sum_64x2, _mm_srli_si128(sum_64x2, 8)));
+  return res;
+}
+
+static uint64_t mse_4xh_16bit_sse2(uint8_t *dst, int dstride, uint16_t *src,
+                                   int sstride, int h) {
+  const __m128i zeros = _mm_setzero_si128();
+  __m128i sum = _mm_setzero_si128();
+  for (int i = 0; i < h; i += 2) {
+    const __m128i dst_8x8 =
+        _mm_unpacklo_epi32(xx_loadl_32(&dst[i * dstride]),
+                           xx_loadl_32(&dst[(i + 1) * dstride]));
+    const __m128i dst_16x8 = _mm_unpacklo_epi8(dst_8x8, zeros);
+    const __m128i src_16x8 =
+        _mm_unpacklo_epi64(xx_loadl_64(&src[i * sstride]),
+                           xx_loadl_64(&src[(i + 1) * sstride]));
+    const __m128i diff = _mm_sub_epi16(dst_16x8, src_16x8);
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(diff, diff));
+  }
+  return mse_sum_epu32_sse2(sum);
+}
+
+static uint64_t mse_8xh_16bit_sse2(uint8_t *dst, int dstride, uint16_t *src,
+                                   int sstride, int h) {
+  const __m128i zeros = _mm_setzero_si128();
+  __m128i sum = _mm_setzero_si128();
+  for (int i = 0; i < h; i++) {
+    const __m128i dst_16x8 =
+        _mm_unpacklo_epi8(xx_loadl_64(&dst[i * dstride]), zeros);
+    const __m128i src_16x8 = xx_loadu_128(&src[i * sstride]);
+    const __m128i diff = _mm_sub_epi16(dst_16x8, src_16x8);
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(diff, diff));
+  }
+  return mse_sum_epu32_sse2(sum);
+}
+
+// Only the 4x4, 4x8, 8x4 and 8x8 blocks of the CDEF search are supported.
+uint64_t aom_mse_wxh_16bit_sse2(uint8_t *dst, int dstride, uint16_t *src,
+                                int sstride, int w, int h) {
+  assert((w == 8 || w == 4) && (h == 8 || h == 4) &&
+         "w=8/4 and h=8/4 must be satisfied");
+  switch (w) {
+    case 4: return mse_4xh_16bit_sse2(dst, dstride, src, sstride, h);
+    case 8: return mse_8xh_16bit_sse2(dst, dstride, src, sstride, h);
+    default: assert(0 && "unsupported width"); return -1;
+  }
+}
@@ -163,6 +163,7 @@ static INLINE uint64_t xgetbv(void) {
 #define HAS_AVX 0x40
 #define HAS_AVX2 0x80
 #define HAS_SSE4_2 0x100
+#define HAS_AVX512 0x200
 #ifndef BIT
 #define BIT(n) (1 << n)
 #endif
@@ -215,6 +216,15 @@ static INLINE int x86_simd_caps(void) {
         cpuid(7, 0, reg_eax, reg_ebx, reg_ecx, reg_edx);
 
         if (reg_ebx & BIT(5)) flags |= HAS_AVX2;
+
+        // AVX-512 F (bit 16), DQ (17), CD (28), BW (30) and VL (31), with the
+        // opmask and ZMM state enabled by the OS.
+        const unsigned int avx512_bits =
+            (1u << 16) | (1u << 17) | (1u << 28) | (1u << 30) | (1u << 31);
+        if ((reg_ebx & avx512_bits) == avx512_bits &&
+            (xgetbv() & 0xe6) == 0xe6) {
+          flags |= HAS_AVX512;
+        }
       }
     }
   }
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "aom_mem/aom_mem.h"
+#include "aom_util/aom_job_scheduler.h"
+
+// Number of chunks the jobs are split into per worker. More chunks balance the
+// load better, fewer chunks take the shared lock less often.
+#define CHUNKS_PER_QUEUE 4
+
+static INLINE void lock_queue(AVxJobQueue *q) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&q->mutex);
+#else
+  (void)q;
+#endif
+}
+
+static INLINE void unlock_queue(AVxJobQueue *q) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(&q->mutex);
+#else
+  (void)q;
+#endif
+}
+
+int aom_job_scheduler_alloc(AVxJobScheduler *sched, int num_queues) {
+  memset(sched, 0, sizeof(*sched));
+  sched->queues = (AVxJobQueue *)aom_memalign(
+      64, num_queues * sizeof(*sched->queues));
+  if (sched->queues == NULL) return 1;
+  memset(sched->queues, 0, num_queues * sizeof(*sched->queues));
+#if CONFIG_MULTITHREAD
+  sched->mutex = (pthread_mutex_t *)aom_malloc(sizeof(*sched->mutex));
+  if (sched->mutex == NULL) {
+    aom_free(sched->queues);
+    sched->queues = NULL;
+    return 1;
+  }
+  pthread_mutex_init(sched->mutex, NULL);
+  for (int i = 0; i < num_queues; ++i) {
+    pthread_mutex_init(&sched->queues[i].mutex, NULL);
+  }
+#endif
+  sched->alloc_queues = num_queues;
+  return 0;
+}
+
+void aom_job_scheduler_free(AVxJobScheduler *sched) {
+  if (sched == NULL) return;
+#if CONFIG_MULTITHREAD
+  if (sched->mutex != NULL) {
+    pthread_mutex_destroy(sched->mutex);
+    aom_free(sched->mutex);
+  }
+  for (int i = 0; i < sched->alloc_queues; ++i) {
+    pthread_mutex_destroy(&sched->queues[i].mutex);
+  }
+#endif
+  aom_free(sched->queues);
+  memset(sched, 0, sizeof(*sched));
+}
+
+void aom_job_scheduler_reset(AVxJobScheduler *sched, int num_jobs,
+                             int num_queues) {
+  assert(num_queues > 0 && num_queues <= sched->alloc_queues);
+  sched->next_job = 0;
+  sched->num_jobs = num_jobs;
+  sched->chunk_size = num_jobs / (num_queues * CHUNKS_PER_QUEUE);
+  if (sched->chunk_size < 1) sched->chunk_size = 1;
+  sched->num_queues = num_queues;
+  for (int i = 0; i < num_queues; ++i) {
+    sched->queues[i].next = 0;
+    sched->queues[i].end = 0;
+  }
+}
+
+// Hands out the next chunk of jobs to the queue, and returns its first job.
+static int get_chunk(AVxJobScheduler *sched, AVxJobQueue *q) {
+  int first, last;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(sched->mutex);
+#endif
+  first = sched->next_job;
+  last = first + sched->chunk_size;
+  if (last > sched->num_jobs) last = sched->num_jobs;
+  if (first < last) sched->next_job = last;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(sched->mutex);
+#endif
+  if (first >= last) return -1;
+
+  lock_queue(q);
+  q->next = first + 1;
+  q->end = last;
+  unlock_queue(q);
+  return first;
+}
+
+// Moves the first half of the jobs of another queue to the given one, and
+// returns the first of them.
+static int steal_jobs(AVxJobScheduler *sched, int queue) {
+  AVxJobQueue *const q = &sched->queues[queue];
+  for (int i = 1; i < sched->num_queues; ++i) {
+    AVxJobQueue *const victim =
+        &sched->queues[(queue + i) % sched->num_queues];
+    int first, last;
+    lock_queue(victim);
+    first = victim->next;
+    last = first + ((victim->end - first + 1) >> 1);
+    victim->next = last;
+    unlock_queue(victim);
+    if (first < last) {
+      lock_queue(q);
+      q->next = first + 1;
+      q->end = last;
+      unlock_queue(q);
+      return first;
+    }
+  }
+  return -1;
+}
+
+int aom_job_scheduler_get_job(AVxJobScheduler *sched, int queue) {
+  AVxJobQueue *const q = &sched->queues[queue];
+  int job = -1;
+  assert(queue >= 0 && queue < sched->num_queues);
+
+  lock_queue(q);
+  if (q->next < q->end) job = q->next++;
+  unlock_queue(q);
+  if (job >= 0) return job;
+
+  job = get_chunk(sched, q);
+  if (job >= 0) return job;
+  return steal_jobs(sched, queue);
+}
+
+void aom_job_scheduler_cancel(AVxJobScheduler *sched) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(sched->mutex);
+#endif
+  sched->next_job = sched->num_jobs;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(sched->mutex);
+#endif
+  for (int i = 0; i < sched->num_queues; ++i) {
+    AVxJobQueue *const q = &sched->queues[i];
+    lock_queue(q);
+    q->next = q->end;
+    unlock_queue(q);
+  }
+}
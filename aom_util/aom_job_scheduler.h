@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+//
+// Work-stealing job scheduler for the AVxWorker based stages.
+//
+// The jobs of a stage are numbered 0 to num_jobs - 1. Each worker owns a
+// queue which it refills with small chunks of consecutive jobs from a shared
+// counter, so that the shared lock is only taken once per chunk. Once all the
+// chunks are handed out, a worker whose queue is empty steals the first half
+// of the jobs queued by another worker.
+//
+// The jobs are started roughly in increasing order, and a worker never
+// starts a job while an earlier job is left in its own queue. So a job may
+// wait for the jobs before it (e.g. the row above it) without deadlocking,
+// whatever the number of workers.
+
+#ifndef AOM_AOM_UTIL_AOM_JOB_SCHEDULER_H_
+#define AOM_AOM_UTIL_AOM_JOB_SCHEDULER_H_
+
+#include "config/aom_config.h"
+
+#include "aom_ports/mem.h"
+#include "aom_util/aom_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Jobs of one worker. Each queue is on its own cache lines, so that the
+// workers do not slow each other down when they take their own jobs.
+typedef struct AVxJobQueue {
+  // The jobs next to end - 1 are queued.
+  DECLARE_ALIGNED(64, int, next);
+  int end;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex;
+#endif
+} AVxJobQueue;
+
+typedef struct AVxJobScheduler {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t *mutex;  // Protects next_job.
+#endif
+  // First job not handed out to any queue yet.
+  int next_job;
+  int num_jobs;
+  int chunk_size;
+  AVxJobQueue *queues;
+  // Number of queues of the current stage, and number of allocated queues.
+  int num_queues;
+  int alloc_queues;
+} AVxJobScheduler;
+
+// Allocates a scheduler for up to 'num_queues' workers. Returns 0 on success.
+int aom_job_scheduler_alloc(AVxJobScheduler *sched, int num_queues);
+
+void aom_job_scheduler_free(AVxJobScheduler *sched);
+
+// Sets up the jobs 0 to 'num_jobs' - 1 for 'num_queues' workers, which must
+// not be more than the allocated number. Not thread-safe: must be called
+// before the workers are launched.
+void aom_job_scheduler_reset(AVxJobScheduler *sched, int num_jobs,
+                             int num_queues);
+
+// Returns the next job of the worker with the given queue, or -1 once all the
+// jobs are started.
+int aom_job_scheduler_get_job(AVxJobScheduler *sched, int queue);
+
+// Drops the jobs which are not queued by a worker yet or are left in the
+// queues. The calls to aom_job_scheduler_get_job() which are in progress may
+// still return a job.
+void aom_job_scheduler_cancel(AVxJobScheduler *sched);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_AOM_UTIL_AOM_JOB_SCHEDULER_H_
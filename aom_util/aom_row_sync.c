@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+// Enable GNU extensions in glibc so that we can call syscall().
+// This must be before any #include statements.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+
+#include "aom_mem/aom_mem.h"
+#include "aom_util/aom_row_sync.h"
+
+#if CONFIG_MULTITHREAD
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define USE_FUTEX 1
+#else
+#define USE_FUTEX 0
+#endif
+
+#if ARCH_X86 || ARCH_X86_64
+#include <emmintrin.h>
+#define cpu_relax() _mm_pause()
+#else
+#define cpu_relax()
+#endif
+
+// Number of checks of the progress before the worker goes to sleep.
+#define SPIN_COUNT 1024
+
+#if defined(__GNUC__) || defined(__clang__)
+static INLINE int load_acquire(const int *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static INLINE int load_seq_cst(const int *p) {
+  return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+static INLINE void store_seq_cst(int *p, int v) {
+  __atomic_store_n(p, v, __ATOMIC_SEQ_CST);
+}
+static INLINE void add_seq_cst(int *p, int v) {
+  __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+// The interlocked functions are full barriers.
+static INLINE int load_acquire(const int *p) {
+  return _InterlockedOr((volatile long *)p, 0);
+}
+static INLINE int load_seq_cst(const int *p) {
+  return _InterlockedOr((volatile long *)p, 0);
+}
+static INLINE void store_seq_cst(int *p, int v) {
+  _InterlockedExchange((volatile long *)p, v);
+}
+static INLINE void add_seq_cst(int *p, int v) {
+  _InterlockedExchangeAdd((volatile long *)p, v);
+}
+#else
+#error "Atomic operations are not implemented for this compiler."
+#endif
+
+#endif  // CONFIG_MULTITHREAD
+
+int aom_row_sync_alloc(AVxRowSync *sync, int num_rows) {
+  memset(sync, 0, sizeof(*sync));
+  sync->rows =
+      (AVxRowProgress *)aom_memalign(64, num_rows * sizeof(*sync->rows));
+  if (sync->rows == NULL) return 1;
+  memset(sync->rows, 0, num_rows * sizeof(*sync->rows));
+  sync->num_rows = num_rows;
+#if CONFIG_MULTITHREAD && !USE_FUTEX
+  sync->mutex = (pthread_mutex_t *)aom_malloc(sizeof(*sync->mutex));
+  sync->cond = (pthread_cond_t *)aom_malloc(sizeof(*sync->cond));
+  if (sync->mutex == NULL || sync->cond == NULL) {
+    aom_free(sync->mutex);
+    aom_free(sync->cond);
+    aom_free(sync->rows);
+    memset(sync, 0, sizeof(*sync));
+    return 1;
+  }
+  pthread_mutex_init(sync->mutex, NULL);
+  pthread_cond_init(sync->cond, NULL);
+#endif
+  return 0;
+}
+
+void aom_row_sync_free(AVxRowSync *sync) {
+  if (sync == NULL) return;
+#if CONFIG_MULTITHREAD
+  if (sync->mutex != NULL) {
+    pthread_mutex_destroy(sync->mutex);
+    aom_free(sync->mutex);
+  }
+  if (sync->cond != NULL) {
+    pthread_cond_destroy(sync->cond);
+    aom_free(sync->cond);
+  }
+#endif
+  aom_free(sync->rows);
+  memset(sync, 0, sizeof(*sync));
+}
+
+void aom_row_sync_reset(AVxRowSync *sync, int value) {
+  for (int i = 0; i < sync->num_rows; ++i) {
+    sync->rows[i].value = value;
+    sync->rows[i].num_waiters = 0;
+  }
+}
+
+void aom_row_sync_set(AVxRowSync *sync, int row, int value) {
+  AVxRowProgress *const p = &sync->rows[row];
+  assert(row >= 0 && row < sync->num_rows);
+#if CONFIG_MULTITHREAD
+  // The waiters register before they check the value, and the value is set
+  // before the waiters are checked, so that either the waiter sees the new
+  // value or it is woken up.
+  store_seq_cst(&p->value, value);
+  if (load_seq_cst(&p->num_waiters) == 0) return;
+#if USE_FUTEX
+  syscall(SYS_futex, &p->value, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+  pthread_mutex_lock(sync->mutex);
+  pthread_cond_broadcast(sync->cond);
+  pthread_mutex_unlock(sync->mutex);
+#endif
+#else
+  p->value = value;
+#endif  // CONFIG_MULTITHREAD
+}
+
+void aom_row_sync_wait(AVxRowSync *sync, int row, int value) {
+  AVxRowProgress *const p = &sync->rows[row];
+  assert(row >= 0 && row < sync->num_rows);
+#if CONFIG_MULTITHREAD
+  for (int i = 0; i < SPIN_COUNT; ++i) {
+    if (load_acquire(&p->value) >= value) return;
+    cpu_relax();
+  }
+#if USE_FUTEX
+  while (1) {
+    int cur = load_acquire(&p->value);
+    if (cur >= value) break;
+    add_seq_cst(&p->num_waiters, 1);
+    cur = load_seq_cst(&p->value);
+    // Sleeps unless the value is not 'cur' anymore.
+    if (cur < value) {
+      syscall(SYS_futex, &p->value, FUTEX_WAIT_PRIVATE, cur, NULL, NULL, 0);
+    }
+    add_seq_cst(&p->num_waiters, -1);
+  }
+#else
+  pthread_mutex_lock(sync->mutex);
+  add_seq_cst(&p->num_waiters, 1);
+  while (load_seq_cst(&p->value) < value) {
+    pthread_cond_wait(sync->cond, sync->mutex);
+  }
+  add_seq_cst(&p->num_waiters, -1);
+  pthread_mutex_unlock(sync->mutex);
+#endif
+#else
+  // Nothing to wait for without threads.
+  (void)p;
+  (void)value;
+#endif  // CONFIG_MULTITHREAD
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+//
+// Row progress synchronization for the wavefront (row-MT) stages.
+//
+// Each row has a progress value, e.g. the last superblock column processed,
+// which only the worker processing the row increases. The worker processing
+// the next row waits for the value to be large enough.
+//
+// The progress is an atomic int, so that neither updating nor checking it
+// takes a lock. A worker which has to wait spins for a short time, as the row
+// above is usually only a few superblocks ahead, and then sleeps: on a futex
+// on Linux, on a condition variable elsewhere. The wake-up call is skipped
+// when no worker sleeps on the row.
+
+#ifndef AOM_AOM_UTIL_AOM_ROW_SYNC_H_
+#define AOM_AOM_UTIL_AOM_ROW_SYNC_H_
+
+#include "config/aom_config.h"
+
+#include "aom_ports/mem.h"
+#include "aom_util/aom_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Progress of one row. Each row is on its own cache line, so that the workers
+// of neighboring rows do not slow each other down.
+typedef struct AVxRowProgress {
+  DECLARE_ALIGNED(64, int, value);
+  // Number of workers sleeping until the value increases.
+  int num_waiters;
+} AVxRowProgress;
+
+typedef struct AVxRowSync {
+  AVxRowProgress *rows;
+  int num_rows;
+#if CONFIG_MULTITHREAD
+  // Only used where futexes are not available.
+  pthread_mutex_t *mutex;
+  pthread_cond_t *cond;
+#endif
+} AVxRowSync;
+
+// Allocates the progress of 'num_rows' rows. Returns 0 on success.
+int aom_row_sync_alloc(AVxRowSync *sync, int num_rows);
+
+void aom_row_sync_free(AVxRowSync *sync);
+
+// Sets the progress of all the rows to 'value'. Not thread-safe: must be
+// called before the workers are launched.
+void aom_row_sync_reset(AVxRowSync *sync, int value);
+
+// Sets the progress of the row, and wakes up the workers waiting for it. The
+// writes done before are visible to the workers which see the new value.
+void aom_row_sync_set(AVxRowSync *sync, int row, int value);
+
+// Waits until the progress of the row is at least 'value'.
+void aom_row_sync_wait(AVxRowSync *sync, int row, int value);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // AOM_AOM_UTIL_AOM_ROW_SYNC_H_
@@ -26,42 +26,67 @@
 #include "aom_mem/aom_mem.h"
 #include "aom_util/aom_thread.h"
 
+struct aom_thread_pool {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex;
+  pthread_cond_t work_cond;  // signaled when a hook is queued
+  pthread_cond_t done_cond;  // broadcast when a hook is finished
+  pthread_t *threads;
+  int num_threads;
+  // Workers whose hook is queued, in launch order.
+  AVxWorker *head;
+  AVxWorker *tail;
+  int shutdown;
+#else
+  int unused;
+#endif
+};
+
 #if CONFIG_MULTITHREAD
 
 struct AVxWorkerImpl {
   pthread_mutex_t mutex_;
   pthread_cond_t condition_;
   pthread_t thread_;
+  // Workers of a pool only: next worker in the queue of the pool, and whether
+  // the hook is queued but not started yet. Protected by the pool mutex.
+  AVxWorker *next_;
+  int queued_;
 };
 
 //------------------------------------------------------------------------------
 
 static void execute(AVxWorker *const worker);  // Forward declaration.
 
-static THREADFN thread_loop(void *ptr) {
-  AVxWorker *const worker = (AVxWorker *)ptr;
+static void set_thread_name(const char *name) {
 #ifdef __APPLE__
-  if (worker->thread_name != NULL) {
+  if (name != NULL) {
     // Apple's version of pthread_setname_np takes one argument and operates on
     // the current thread only. The maximum size of the thread_name buffer was
     // noted in the Chromium source code and was confirmed by experiments. If
     // thread_name is too long, pthread_setname_np returns -1 with errno
     // ENAMETOOLONG (63).
     char thread_name[64];
-    strncpy(thread_name, worker->thread_name, sizeof(thread_name) - 1);
+    strncpy(thread_name, name, sizeof(thread_name) - 1);
     thread_name[sizeof(thread_name) - 1] = '\0';
     pthread_setname_np(thread_name);
   }
 #elif defined(__GLIBC__) || defined(__BIONIC__)
-  if (worker->thread_name != NULL) {
+  if (name != NULL) {
     // Linux and Android require names (with nul) fit in 16 chars, otherwise
     // pthread_setname_np() returns ERANGE (34).
     char thread_name[16];
-    strncpy(thread_name, worker->thread_name, sizeof(thread_name) - 1);
+    strncpy(thread_name, name, sizeof(thread_name) - 1);
     thread_name[sizeof(thread_name) - 1] = '\0';
     pthread_setname_np(pthread_self(), thread_name);
   }
 #endif
+  (void)name;
+}
+
+static THREADFN thread_loop(void *ptr) {
+  AVxWorker *const worker = (AVxWorker *)ptr;
+  set_thread_name(worker->thread_name);
   int done = 0;
   while (!done) {
     pthread_mutex_lock(&worker->impl_->mutex_);
@@ -103,6 +128,87 @@ static void change_state(AVxWorker *const worker, AVxWorkerStatus new_status) {
   pthread_mutex_unlock(&worker->impl_->mutex_);
 }
 
+//------------------------------------------------------------------------------
+// Workers running on a shared pool
+
+static THREADFN pool_thread_loop(void *ptr) {
+  aom_thread_pool_t *const pool = (aom_thread_pool_t *)ptr;
+  set_thread_name("aom pool worker");
+  pthread_mutex_lock(&pool->mutex);
+  while (1) {
+    while (pool->head == NULL && !pool->shutdown) {
+      pthread_cond_wait(&pool->work_cond, &pool->mutex);
+    }
+    AVxWorker *const worker = pool->head;
+    if (worker == NULL) break;
+    pool->head = worker->impl_->next_;
+    if (pool->head == NULL) pool->tail = NULL;
+    worker->impl_->queued_ = 0;
+    pthread_mutex_unlock(&pool->mutex);
+    execute(worker);
+    pthread_mutex_lock(&pool->mutex);
+    worker->status_ = OK;
+    pthread_cond_broadcast(&pool->done_cond);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return THREAD_RETURN(NULL);
+}
+
+// Waits for the hook of the worker to finish. The pool mutex must be held. A
+// hook which is still queued is run on the calling thread instead: the calling
+// thread would only wait otherwise, and the pool threads may all be busy with
+// hooks which wait for this one.
+static void pool_wait(AVxWorker *const worker) {
+  aom_thread_pool_t *const pool = worker->pool;
+  if (worker->status_ == WORK && worker->impl_->queued_) {
+    AVxWorker **prev = &pool->head;
+    while (*prev != worker) prev = &(*prev)->impl_->next_;
+    *prev = worker->impl_->next_;
+    if (pool->tail == worker) {
+      pool->tail = NULL;
+      for (AVxWorker *w = pool->head; w != NULL; w = w->impl_->next_) {
+        pool->tail = w;
+      }
+    }
+    worker->impl_->queued_ = 0;
+    pthread_mutex_unlock(&pool->mutex);
+    execute(worker);
+    pthread_mutex_lock(&pool->mutex);
+    worker->status_ = OK;
+  }
+  while (worker->status_ == WORK) {
+    pthread_cond_wait(&pool->done_cond, &pool->mutex);
+  }
+}
+
+static void pool_launch(AVxWorker *const worker) {
+  aom_thread_pool_t *const pool = worker->pool;
+  if (worker->impl_ == NULL) return;
+
+  pthread_mutex_lock(&pool->mutex);
+  if (worker->status_ >= OK) {
+    pool_wait(worker);
+    worker->status_ = WORK;
+    worker->impl_->queued_ = 1;
+    worker->impl_->next_ = NULL;
+    if (pool->tail != NULL) {
+      pool->tail->impl_->next_ = worker;
+    } else {
+      pool->head = worker;
+    }
+    pool->tail = worker;
+    pthread_cond_signal(&pool->work_cond);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+static void pool_sync(AVxWorker *const worker) {
+  if (worker->impl_ == NULL) return;
+  pthread_mutex_lock(&worker->pool->mutex);
+  pool_wait(worker);
+  pthread_mutex_unlock(&worker->pool->mutex);
+}
+
 #endif  // CONFIG_MULTITHREAD
 
 //------------------------------------------------------------------------------
@@ -114,7 +220,11 @@ static void init(AVxWorker *const worker) {
 
 static int sync(AVxWorker *const worker) {
 #if CONFIG_MULTITHREAD
-  change_state(worker, OK);
+  if (worker->pool != NULL) {
+    pool_sync(worker);
+  } else {
+    change_state(worker, OK);
+  }
 #endif
   assert(worker->status_ <= OK);
   return !worker->had_error;
@@ -129,6 +239,11 @@ static int reset(AVxWorker *const worker) {
     if (worker->impl_ == NULL) {
       return 0;
     }
+    if (worker->pool != NULL) {
+      // The hook runs on the threads of the pool, no thread to create.
+      worker->status_ = OK;
+      return 1;
+    }
     if (pthread_mutex_init(&worker->impl_->mutex_, NULL)) {
       goto Error;
     }
@@ -166,7 +281,11 @@ static void execute(AVxWorker *const worker) {
 
 static void launch(AVxWorker *const worker) {
 #if CONFIG_MULTITHREAD
-  change_state(worker, WORK);
+  if (worker->pool != NULL) {
+    pool_launch(worker);
+  } else {
+    change_state(worker, WORK);
+  }
 #else
   execute(worker);
 #endif
@@ -174,7 +293,16 @@ static void launch(AVxWorker *const worker) {
 
 static void end(AVxWorker *const worker) {
 #if CONFIG_MULTITHREAD
-  if (worker->impl_ != NULL) {
+  if (worker->pool != NULL) {
+    if (worker->impl_ != NULL) {
+      pthread_mutex_lock(&worker->pool->mutex);
+      pool_wait(worker);
+      worker->status_ = NOT_OK;
+      pthread_mutex_unlock(&worker->pool->mutex);
+      aom_free(worker->impl_);
+      worker->impl_ = NULL;
+    }
+  } else if (worker->impl_ != NULL) {
     change_state(worker, NOT_OK);
     pthread_join(worker->impl_->thread_, NULL);
     pthread_mutex_destroy(&worker->impl_->mutex_);
@@ -210,3 +338,59 @@ const AVxWorkerInterface *aom_get_worker_interface(void) {
 }
 
 //------------------------------------------------------------------------------
+
+aom_thread_pool_t *aom_thread_pool_create(int num_threads) {
+  if (num_threads < 1) return NULL;
+  aom_thread_pool_t *const pool =
+      (aom_thread_pool_t *)aom_calloc(1, sizeof(*pool));
+  if (pool == NULL) return NULL;
+#if CONFIG_MULTITHREAD
+  pool->threads = (pthread_t *)aom_malloc(num_threads * sizeof(*pool->threads));
+  if (pool->threads == NULL) goto Error;
+  if (pthread_mutex_init(&pool->mutex, NULL)) goto Error;
+  if (pthread_cond_init(&pool->work_cond, NULL)) {
+    pthread_mutex_destroy(&pool->mutex);
+    goto Error;
+  }
+  if (pthread_cond_init(&pool->done_cond, NULL)) {
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    goto Error;
+  }
+  for (; pool->num_threads < num_threads; ++pool->num_threads) {
+    if (pthread_create(&pool->threads[pool->num_threads], NULL,
+                       pool_thread_loop, pool)) {
+      aom_thread_pool_destroy(pool);
+      return NULL;
+    }
+  }
+  return pool;
+
+Error:
+  aom_free(pool->threads);
+  aom_free(pool);
+  return NULL;
+#else
+  (void)num_threads;
+  return pool;
+#endif
+}
+
+void aom_thread_pool_destroy(aom_thread_pool_t *pool) {
+  if (pool == NULL) return;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(&pool->mutex);
+  assert(pool->head == NULL);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work_cond);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int i = 0; i < pool->num_threads; ++i) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->work_cond);
+  pthread_cond_destroy(&pool->done_cond);
+  aom_free(pool->threads);
+#endif
+  aom_free(pool);
+}
@@ -19,6 +19,8 @@
 
 #include "config/aom_config.h"
 
+#include "aom/aom_thread_pool.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -314,6 +316,9 @@ typedef struct {
   // outlives the worker thread. For portability, use a name <= 15 characters
   // long (not including the terminating NUL character).
   const char *thread_name;
+  // If not NULL, the hook is run on a thread of this pool rather than on a
+  // thread owned by the worker. Must be set before reset().
+  aom_thread_pool_t *pool;
   AVxWorkerHook hook;  // hook to call
   void *data1;         // first argument passed to 'hook'
   void *data2;         // second argument passed to 'hook'
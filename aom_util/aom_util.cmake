@@ -15,6 +15,10 @@ set(AOM_AOM_UTIL_AOM_UTIL_CMAKE_ 1)
 
 list(APPEND AOM_UTIL_SOURCES "${AOM_ROOT}/aom_util/aom_thread.c"
             "${AOM_ROOT}/aom_util/aom_thread.h"
+            "${AOM_ROOT}/aom_util/aom_job_scheduler.c"
+            "${AOM_ROOT}/aom_util/aom_job_scheduler.h"
+            "${AOM_ROOT}/aom_util/aom_row_sync.c"
+            "${AOM_ROOT}/aom_util/aom_row_sync.h"
             "${AOM_ROOT}/aom_util/endian_inl.h"
             "${AOM_ROOT}/aom_util/debug_util.c"
             "${AOM_ROOT}/aom_util/debug_util.h")
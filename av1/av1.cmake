@@ -191,6 +191,7 @@ list(APPEND AOM_AV1_ENCODER_SOURCES
             "${AOM_ROOT}/av1/encoder/pass2_strategy.h"
             "${AOM_ROOT}/av1/encoder/pass2_strategy.c"
             "${AOM_ROOT}/av1/encoder/pickcdef.c"
+            "${AOM_ROOT}/av1/encoder/pickcdef.h"
             "${AOM_ROOT}/av1/encoder/picklpf.c"
             "${AOM_ROOT}/av1/encoder/picklpf.h"
             "${AOM_ROOT}/av1/encoder/pickrst.c"
@@ -265,7 +266,8 @@ list(APPEND AOM_AV1_COMMON_INTRIN_SSSE3
             "${AOM_ROOT}/av1/common/x86/highbd_convolve_2d_ssse3.c"
             "${AOM_ROOT}/av1/common/x86/highbd_wiener_convolve_ssse3.c"
             "${AOM_ROOT}/av1/common/x86/jnt_convolve_ssse3.c"
-            "${AOM_ROOT}/av1/common/x86/reconinter_ssse3.c")
+            "${AOM_ROOT}/av1/common/x86/reconinter_ssse3.c"
+            "${AOM_ROOT}/av1/common/x86/resize_ssse3.c")
 
 if(NOT CONFIG_AV1_HIGHBITDEPTH)
   list(REMOVE_ITEM AOM_AV1_COMMON_INTRIN_SSSE3
@@ -307,6 +309,7 @@ list(APPEND AOM_AV1_COMMON_INTRIN_AVX2
             "${AOM_ROOT}/av1/common/x86/highbd_wiener_convolve_avx2.c"
             "${AOM_ROOT}/av1/common/x86/jnt_convolve_avx2.c"
             "${AOM_ROOT}/av1/common/x86/reconinter_avx2.c"
+            "${AOM_ROOT}/av1/common/x86/resize_avx2.c"
             "${AOM_ROOT}/av1/common/x86/selfguided_avx2.c"
             "${AOM_ROOT}/av1/common/x86/warp_plane_avx2.c"
             "${AOM_ROOT}/av1/common/x86/wiener_convolve_avx2.c")
@@ -316,6 +319,9 @@ if(NOT CONFIG_AV1_HIGHBITDEPTH)
                    "${AOM_ROOT}/av1/common/x86/highbd_convolve_2d_avx2.c")
 endif()
 
+list(APPEND AOM_AV1_COMMON_INTRIN_AVX512
+            "${AOM_ROOT}/av1/common/x86/convolve_2d_avx512.c")
+
 list(APPEND AOM_AV1_ENCODER_ASM_SSE2 "${AOM_ROOT}/av1/encoder/x86/dct_sse2.asm"
             "${AOM_ROOT}/av1/encoder/x86/error_sse2.asm")
 
@@ -354,6 +360,7 @@ list(APPEND AOM_AV1_ENCODER_INTRIN_SSE4_1
 list(APPEND AOM_AV1_ENCODER_INTRIN_AVX2
             "${AOM_ROOT}/av1/encoder/x86/av1_quantize_avx2.c"
             "${AOM_ROOT}/av1/encoder/x86/av1_highbd_quantize_avx2.c"
+            "${AOM_ROOT}/av1/encoder/x86/cnn_avx2.c"
             "${AOM_ROOT}/av1/encoder/x86/corner_match_avx2.c"
             "${AOM_ROOT}/av1/encoder/x86/error_intrin_avx2.c"
             "${AOM_ROOT}/av1/encoder/x86/highbd_block_error_intrin_avx2.c"
@@ -372,6 +379,10 @@ if(NOT CONFIG_AV1_HIGHBITDEPTH)
                 "${AOM_ROOT}/av1/encoder/x86/highbd_block_error_intrin_avx2.c")
 endif()
 
+list(APPEND AOM_AV1_ENCODER_INTRIN_AVX512
+            "${AOM_ROOT}/av1/encoder/x86/error_intrin_avx512.c"
+            "${AOM_ROOT}/av1/encoder/x86/highbd_fwd_txfm_avx512.c")
+
 list(APPEND AOM_AV1_ENCODER_INTRIN_NEON
             "${AOM_ROOT}/av1/encoder/arm/neon/quantize_neon.c"
             "${AOM_ROOT}/av1/encoder/arm/neon/av1_error_neon.c")
@@ -436,6 +447,8 @@ if(CONFIG_REALTIME_ONLY)
                    "${AOM_ROOT}/av1/encoder/tpl_model.c"
                    "${AOM_ROOT}/av1/encoder/tpl_model.h"
                    "${AOM_ROOT}/av1/encoder/x86/temporal_filter_sse4.c")
+  list(REMOVE_ITEM AOM_AV1_ENCODER_INTRIN_AVX2
+                   "${AOM_ROOT}/av1/encoder/x86/cnn_avx2.c")
 endif()
 
 # Setup AV1 common/decoder/encoder targets. The libaom target must exist before
@@ -548,6 +561,19 @@ function(setup_av1_targets)
     endif()
   endif()
 
+  if(HAVE_AVX512)
+    require_compiler_flag_nomsvc("${AOM_AVX512_FLAGS}" NO)
+    add_intrinsics_object_library("${AOM_AVX512_FLAGS}" "avx512"
+                                  "aom_av1_common"
+                                  "AOM_AV1_COMMON_INTRIN_AVX512")
+
+    if(CONFIG_AV1_ENCODER)
+      add_intrinsics_object_library("${AOM_AVX512_FLAGS}" "avx512"
+                                    "aom_av1_encoder"
+                                    "AOM_AV1_ENCODER_INTRIN_AVX512")
+    endif()
+  endif()
+
   if(HAVE_NEON)
     if(AOM_AV1_COMMON_INTRIN_NEON)
       add_intrinsics_object_library("${AOM_NEON_INTRIN_FLAG}" "neon"
@@ -8,6 +8,7 @@
  * Media Patent License 1.0 was not distributed with this source code in the
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -20,6 +21,7 @@
 
 #include "aom/aom_encoder.h"
 #include "aom/internal/aom_codec_internal.h"
+#include "aom/internal/aom_image_internal.h"
 
 #include "av1/av1_iface_common.h"
 #include "av1/encoder/bitstream.h"
@@ -276,6 +278,53 @@ static struct av1_extracfg default_extra_cfg = {
   0,            // sb_multipass_unit_test
 };
 
+#if CONFIG_MULTITHREAD
+#define ASYNC_QUEUE_SIZE 8
+
+// A frame queued by aom_codec_encode() in the asynchronous mode.
+typedef struct {
+  aom_image_t *img;  // A copy of the image, or NULL to flush.
+  aom_codec_pts_t pts;
+  unsigned long duration;
+  aom_enc_frame_flags_t flags;
+} AsyncFrame;
+
+// A copy of a packet of an encoded frame, followed by its data.
+typedef struct AsyncPacket {
+  aom_codec_cx_pkt_t pkt;
+  struct AsyncPacket *next;
+} AsyncPacket;
+
+// The asynchronous mode (AV1E_SET_ASYNC_ENCODE): the worker encodes the queued
+// frames and appends copies of their packets to a list.
+typedef struct {
+  int enabled;
+  AVxWorker worker;
+  pthread_mutex_t mutex;
+  // Signaled when a frame leaves the queue and when the worker stops.
+  pthread_cond_t cond;
+  AsyncFrame frames[ASYNC_QUEUE_SIZE];
+  int frame_start;
+  int num_frames;
+  // Whether the worker was launched and has not emptied the queue yet.
+  int running;
+  // Whether the worker drops the queued frames rather than encoding them.
+  int drop_frames;
+  // The first error of the worker and its detail, not returned yet.
+  aom_codec_err_t error;
+  int has_error_detail;
+  char error_detail[80];
+  // The detail of the error last returned, which aom_codec_error_detail()
+  // points to. Only used by the caller thread.
+  char returned_error_detail[80];
+  AsyncPacket *packets;
+  AsyncPacket *last_packet;
+  // The packet last returned by aom_codec_get_cx_data(), freed on the next
+  // call.
+  AsyncPacket *returned_packet;
+} AsyncEncoder;
+#endif  // CONFIG_MULTITHREAD
+
 struct aom_codec_alg_priv {
   aom_codec_priv_t base;
   aom_codec_enc_cfg_t cfg;
@@ -305,6 +354,9 @@ struct aom_codec_alg_priv {
   // Number of stats buffers required for look ahead
   int num_lap_buffers;
   STATS_BUFFER_CTX stats_buf_context;
+#if CONFIG_MULTITHREAD
+  AsyncEncoder *async;
+#endif
 };
 
 static INLINE int gcd(int64_t a, int b) {
@@ -325,15 +377,30 @@ static INLINE void reduce_ratio(aom_rational64_t *ratio) {
 }
 
 static aom_codec_err_t update_error_state(
-    aom_codec_alg_priv_t *ctx, const struct aom_internal_error_info *error) {
+    const struct aom_internal_error_info *error, const char **err_detail) {
   const aom_codec_err_t res = error->error_code;
 
   if (res != AOM_CODEC_OK)
-    ctx->base.err_detail = error->has_detail ? error->detail : NULL;
+    *err_detail = error->has_detail ? error->detail : NULL;
 
   return res;
 }
 
+// Waits for the worker of the asynchronous mode to encode the queued frames,
+// so that the encoder may be used by the calling thread. An error of the
+// worker is returned by the next aom_codec_encode() call.
+static void wait_for_async_encoder(aom_codec_alg_priv_t *ctx) {
+#if CONFIG_MULTITHREAD
+  AsyncEncoder *const async = ctx->async;
+  if (async == NULL) return;
+  pthread_mutex_lock(&async->mutex);
+  while (async->running) pthread_cond_wait(&async->cond, &async->mutex);
+  pthread_mutex_unlock(&async->mutex);
+#else
+  (void)ctx;
+#endif  // CONFIG_MULTITHREAD
+}
+
 #undef ERROR
 #define ERROR(str)                  \
   do {                              \
@@ -1031,6 +1098,7 @@ static aom_codec_err_t encoder_set_config(aom_codec_alg_priv_t *ctx,
                                           const aom_codec_enc_cfg_t *cfg) {
   aom_codec_err_t res;
   int force_key = 0;
+  wait_for_async_encoder(ctx);
 
   if (cfg->g_w != ctx->cfg.g_w || cfg->g_h != ctx->cfg.g_h) {
     if (cfg->g_lag_in_frames > 1 || cfg->g_pass != AOM_RC_ONE_PASS)
@@ -1068,12 +1136,14 @@ static aom_codec_err_t encoder_set_config(aom_codec_alg_priv_t *ctx,
 }
 
 static aom_fixed_buf_t *encoder_get_global_headers(aom_codec_alg_priv_t *ctx) {
+  wait_for_async_encoder(ctx);
   return av1_get_global_headers(ctx->cpi);
 }
 
 static aom_codec_err_t ctrl_get_quantizer(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
   int *const arg = va_arg(args, int *);
+  wait_for_async_encoder(ctx);
   if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
   *arg = av1_get_quantizer(ctx->cpi);
   return AOM_CODEC_OK;
@@ -1082,6 +1152,7 @@ static aom_codec_err_t ctrl_get_quantizer(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_get_quantizer64(aom_codec_alg_priv_t *ctx,
                                             va_list args) {
   int *const arg = va_arg(args, int *);
+  wait_for_async_encoder(ctx);
   if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
   *arg = av1_qindex_to_quantizer(av1_get_quantizer(ctx->cpi));
   return AOM_CODEC_OK;
@@ -1089,7 +1160,9 @@ static aom_codec_err_t ctrl_get_quantizer64(aom_codec_alg_priv_t *ctx,
 
 static aom_codec_err_t update_extra_cfg(aom_codec_alg_priv_t *ctx,
                                         struct av1_extracfg *extra_cfg) {
-  const aom_codec_err_t res = validate_config(ctx, &ctx->cfg, extra_cfg);
+  aom_codec_err_t res;
+  wait_for_async_encoder(ctx);
+  res = validate_config(ctx, &ctx->cfg, extra_cfg);
   if (res == AOM_CODEC_OK) {
     ctx->extra_cfg = *extra_cfg;
     set_encoder_config(&ctx->oxcf, &ctx->cfg, &ctx->extra_cfg);
@@ -1957,7 +2030,35 @@ static void destroy_stats_buffer(STATS_BUFFER_CTX *stats_buf_context,
   aom_free(frame_stats_buffer);
 }
 
+#if CONFIG_MULTITHREAD
+static void free_async_packets(AsyncPacket *packet) {
+  while (packet != NULL) {
+    AsyncPacket *const next = packet->next;
+    aom_free(packet);
+    packet = next;
+  }
+}
+
+static void free_async_encoder(AsyncEncoder *async) {
+  if (async == NULL) return;
+  pthread_mutex_lock(&async->mutex);
+  async->drop_frames = 1;
+  while (async->running) pthread_cond_wait(&async->cond, &async->mutex);
+  pthread_mutex_unlock(&async->mutex);
+  aom_get_worker_interface()->end(&async->worker);
+  free_async_packets(async->packets);
+  free_async_packets(async->returned_packet);
+  pthread_mutex_destroy(&async->mutex);
+  pthread_cond_destroy(&async->cond);
+  aom_free(async);
+}
+#endif  // CONFIG_MULTITHREAD
+
 static aom_codec_err_t encoder_destroy(aom_codec_alg_priv_t *ctx) {
+#if CONFIG_MULTITHREAD
+  // Stops the worker before the encoder it uses is freed.
+  free_async_encoder(ctx->async);
+#endif
   free(ctx->cx_data);
   destroy_context_and_bufferpool(ctx->cpi, ctx->buffer_pool);
   if (ctx->cpi_lap) {
@@ -1988,11 +2089,13 @@ static aom_codec_frame_flags_t get_frame_pkt_flags(const AV1_COMP *cpi,
 
 // TODO(Mufaddal): Check feasibility of abstracting functions related to LAP
 // into a separate function.
-static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
-                                      const aom_image_t *img,
-                                      aom_codec_pts_t pts,
-                                      unsigned long duration,
-                                      aom_enc_frame_flags_t enc_flags) {
+// The detail of an error is stored in *err_detail.
+static aom_codec_err_t encoder_encode_frame(aom_codec_alg_priv_t *ctx,
+                                            const aom_image_t *img,
+                                            aom_codec_pts_t pts,
+                                            unsigned long duration,
+                                            aom_enc_frame_flags_t enc_flags,
+                                            const char **err_detail) {
   const size_t kMinCompressedSize = 8192;
   volatile aom_codec_err_t res = AOM_CODEC_OK;
   AV1_COMP *const cpi = ctx->cpi;
@@ -2044,7 +2147,7 @@ static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
   // before it returns.
   if (setjmp(cpi->common.error.jmp)) {
     cpi->common.error.setjmp = 0;
-    res = update_error_state(ctx, &cpi->common.error);
+    res = update_error_state(&cpi->common.error, err_detail);
     aom_clear_system_state();
     return res;
   }
@@ -2052,7 +2155,7 @@ static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
   if (cpi_lap != NULL) {
     if (setjmp(cpi_lap->common.error.jmp)) {
       cpi_lap->common.error.setjmp = 0;
-      res = update_error_state(ctx, &cpi_lap->common.error);
+      res = update_error_state(&cpi_lap->common.error, err_detail);
       aom_clear_system_state();
       return res;
     }
@@ -2120,7 +2223,7 @@ static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
       // key frame flag when we actually encode this frame.
       if (av1_receive_raw_frame(cpi, flags | ctx->next_frame_flags, &sd,
                                 dst_time_stamp, dst_end_time_stamp)) {
-        res = update_error_state(ctx, &cpi->common.error);
+        res = update_error_state(&cpi->common.error, err_detail);
       }
       ctx->next_frame_flags = 0;
     }
@@ -2300,14 +2403,252 @@ static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
   return res;
 }
 
+#if CONFIG_MULTITHREAD
+// Returns a copy of the image and its metadata, or NULL if the allocation
+// fails.
+static aom_image_t *copy_image(const aom_image_t *img) {
+  aom_image_t *const copy = aom_img_alloc(NULL, img->fmt, img->w, img->h, 32);
+  if (copy == NULL) return NULL;
+  const int bytes_per_sample = (img->fmt & AOM_IMG_FMT_HIGHBITDEPTH) ? 2 : 1;
+  for (int plane = 0; plane < 3; ++plane) {
+    if (img->planes[plane] == NULL) continue;
+    const unsigned int ss_x = plane > 0 ? img->x_chroma_shift : 0;
+    const unsigned int ss_y = plane > 0 ? img->y_chroma_shift : 0;
+    const size_t row_size =
+        (size_t)((img->w + ss_x) >> ss_x) * bytes_per_sample;
+    const unsigned int rows = (img->h + ss_y) >> ss_y;
+    for (unsigned int row = 0; row < rows; ++row) {
+      memcpy(copy->planes[plane] + (size_t)row * copy->stride[plane],
+             img->planes[plane] + (size_t)row * img->stride[plane], row_size);
+    }
+  }
+  copy->cp = img->cp;
+  copy->tc = img->tc;
+  copy->mc = img->mc;
+  copy->monochrome = img->monochrome;
+  copy->csp = img->csp;
+  copy->range = img->range;
+  copy->w = img->w;
+  copy->h = img->h;
+  copy->bit_depth = img->bit_depth;
+  copy->d_w = img->d_w;
+  copy->d_h = img->d_h;
+  copy->r_w = img->r_w;
+  copy->r_h = img->r_h;
+  copy->temporal_id = img->temporal_id;
+  copy->spatial_id = img->spatial_id;
+  copy->user_priv = img->user_priv;
+  if (img->metadata != NULL) {
+    for (size_t i = 0; i < img->metadata->sz; ++i) {
+      const aom_metadata_t *const metadata = img->metadata->metadata_array[i];
+      if (aom_img_add_metadata(copy, metadata->type, metadata->payload,
+                               metadata->sz, metadata->insert_flag)) {
+        aom_img_free(copy);
+        return NULL;
+      }
+    }
+  }
+  return copy;
+}
+
+// Moves the packets of ctx->pkt_list to the list of copies [*first, *last].
+static aom_codec_err_t copy_packets(aom_codec_alg_priv_t *ctx,
+                                    AsyncPacket **first, AsyncPacket **last) {
+  aom_codec_err_t res = AOM_CODEC_OK;
+  aom_codec_iter_t iter = NULL;
+  const aom_codec_cx_pkt_t *pkt;
+  while ((pkt = aom_codec_pkt_list_get(&ctx->pkt_list.head, &iter)) != NULL) {
+    // All the packets but the PSNR ones point to their data with data.raw.
+    const size_t sz = pkt->kind == AOM_CODEC_PSNR_PKT ? 0 : pkt->data.raw.sz;
+    AsyncPacket *const copy = (AsyncPacket *)aom_malloc(sizeof(*copy) + sz);
+    if (copy == NULL) {
+      res = AOM_CODEC_MEM_ERROR;
+      break;
+    }
+    copy->pkt = *pkt;
+    copy->next = NULL;
+    if (sz > 0) {
+      memcpy(copy + 1, pkt->data.raw.buf, sz);
+      copy->pkt.data.raw.buf = copy + 1;
+    }
+    if (*last != NULL) {
+      (*last)->next = copy;
+    } else {
+      *first = copy;
+    }
+    *last = copy;
+  }
+  aom_codec_pkt_list_init(&ctx->pkt_list);
+  return res;
+}
+
+// Returns the error of the worker, if any, once the frames queued after it
+// are dropped, and sets its detail. Must be called with async->mutex held, on
+// the caller thread.
+static aom_codec_err_t get_async_error(aom_codec_alg_priv_t *ctx) {
+  AsyncEncoder *const async = ctx->async;
+  if (async->error == AOM_CODEC_OK) return AOM_CODEC_OK;
+  while (async->running) pthread_cond_wait(&async->cond, &async->mutex);
+  const aom_codec_err_t res = async->error;
+  memcpy(async->returned_error_detail, async->error_detail,
+         sizeof(async->returned_error_detail));
+  ctx->base.err_detail =
+      async->has_error_detail ? async->returned_error_detail : NULL;
+  async->error = AOM_CODEC_OK;
+  async->drop_frames = 0;
+  return res;
+}
+
+// Encodes the queued frames until the queue is empty.
+static int async_encode_worker_hook(void *arg1, void *unused) {
+  aom_codec_alg_priv_t *const ctx = (aom_codec_alg_priv_t *)arg1;
+  AsyncEncoder *const async = ctx->async;
+  (void)unused;
+
+  pthread_mutex_lock(&async->mutex);
+  while (async->num_frames > 0) {
+    const AsyncFrame frame = async->frames[async->frame_start];
+    const int drop = async->drop_frames;
+    pthread_mutex_unlock(&async->mutex);
+
+    aom_codec_err_t res = AOM_CODEC_OK;
+    const char *err_detail = NULL;
+    AsyncPacket *first = NULL;
+    AsyncPacket *last = NULL;
+    if (!drop) {
+      // The image is validated by async_encode(), and the error detail is
+      // only set by get_async_error(), so that ctx->base is not written here.
+      res = encoder_encode_frame(ctx, frame.img, frame.pts, frame.duration,
+                                 frame.flags, &err_detail);
+      const aom_codec_err_t copy_res = copy_packets(ctx, &first, &last);
+      if (res == AOM_CODEC_OK) res = copy_res;
+    }
+    aom_img_free(frame.img);
+
+    pthread_mutex_lock(&async->mutex);
+    // The frame leaves the queue once encoded, so that a flush waits for it.
+    async->frame_start = (async->frame_start + 1) % ASYNC_QUEUE_SIZE;
+    --async->num_frames;
+    if (first != NULL) {
+      if (async->last_packet != NULL) {
+        async->last_packet->next = first;
+      } else {
+        async->packets = first;
+      }
+      async->last_packet = last;
+    }
+    if (res != AOM_CODEC_OK && async->error == AOM_CODEC_OK) {
+      async->error = res;
+      async->has_error_detail = err_detail != NULL;
+      if (err_detail != NULL) {
+        snprintf(async->error_detail, sizeof(async->error_detail), "%s",
+                 err_detail);
+      }
+      async->drop_frames = 1;
+    }
+    pthread_cond_broadcast(&async->cond);
+  }
+  async->running = 0;
+  pthread_cond_broadcast(&async->cond);
+  pthread_mutex_unlock(&async->mutex);
+  return 1;
+}
+
+// Queues a copy of the frame for the worker, or waits for the queued frames
+// to be encoded if img is NULL.
+static aom_codec_err_t async_encode(aom_codec_alg_priv_t *ctx,
+                                    const aom_image_t *img, aom_codec_pts_t pts,
+                                    unsigned long duration,
+                                    aom_enc_frame_flags_t flags) {
+  AsyncEncoder *const async = ctx->async;
+  aom_image_t *copy = NULL;
+  if (img != NULL) {
+    const aom_codec_err_t res = validate_img(ctx, img);
+    if (res != AOM_CODEC_OK) return res;
+    copy = copy_image(img);
+    if (copy == NULL) return AOM_CODEC_MEM_ERROR;
+  }
+
+  pthread_mutex_lock(&async->mutex);
+  aom_codec_err_t res = get_async_error(ctx);
+  if (res != AOM_CODEC_OK) {
+    pthread_mutex_unlock(&async->mutex);
+    aom_img_free(copy);
+    return res;
+  }
+  while (async->num_frames == ASYNC_QUEUE_SIZE) {
+    pthread_cond_wait(&async->cond, &async->mutex);
+  }
+  AsyncFrame *const frame =
+      &async->frames[(async->frame_start + async->num_frames) %
+                     ASYNC_QUEUE_SIZE];
+  frame->img = copy;
+  frame->pts = pts;
+  frame->duration = duration;
+  frame->flags = flags;
+  ++async->num_frames;
+  if (!async->running) {
+    async->running = 1;
+    pthread_mutex_unlock(&async->mutex);
+    aom_get_worker_interface()->launch(&async->worker);
+    pthread_mutex_lock(&async->mutex);
+  }
+  if (img == NULL) {
+    while (async->running) pthread_cond_wait(&async->cond, &async->mutex);
+    res = get_async_error(ctx);
+  }
+  pthread_mutex_unlock(&async->mutex);
+  return res;
+}
+#endif  // CONFIG_MULTITHREAD
+
+static aom_codec_err_t encoder_encode(aom_codec_alg_priv_t *ctx,
+                                      const aom_image_t *img,
+                                      aom_codec_pts_t pts,
+                                      unsigned long duration,
+                                      aom_enc_frame_flags_t flags) {
+#if CONFIG_MULTITHREAD
+  if (ctx->async != NULL && ctx->async->enabled) {
+    return async_encode(ctx, img, pts, duration, flags);
+  }
+#endif
+  return encoder_encode_frame(ctx, img, pts, duration, flags,
+                              &ctx->base.err_detail);
+}
+
 static const aom_codec_cx_pkt_t *encoder_get_cxdata(aom_codec_alg_priv_t *ctx,
                                                     aom_codec_iter_t *iter) {
+#if CONFIG_MULTITHREAD
+  AsyncEncoder *const async = ctx->async;
+  if (async != NULL) {
+    // In the asynchronous mode, each packet is returned once regardless of
+    // iter.
+    aom_free(async->returned_packet);
+    async->returned_packet = NULL;
+    pthread_mutex_lock(&async->mutex);
+    AsyncPacket *const packet = async->packets;
+    if (packet != NULL) {
+      async->packets = packet->next;
+      if (async->packets == NULL) async->last_packet = NULL;
+    }
+    const int enabled = async->enabled;
+    pthread_mutex_unlock(&async->mutex);
+    if (packet != NULL) {
+      packet->next = NULL;
+      async->returned_packet = packet;
+      return &packet->pkt;
+    }
+    // The worker may be writing ctx->pkt_list.
+    if (enabled) return NULL;
+  }
+#endif
   return aom_codec_pkt_list_get(&ctx->pkt_list.head, iter);
 }
 
 static aom_codec_err_t ctrl_set_reference(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
   av1_ref_frame_t *const frame = va_arg(args, av1_ref_frame_t *);
+  wait_for_async_encoder(ctx);
 
   if (frame != NULL) {
     YV12_BUFFER_CONFIG sd;
@@ -2323,6 +2664,7 @@ static aom_codec_err_t ctrl_set_reference(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_copy_reference(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   av1_ref_frame_t *const frame = va_arg(args, av1_ref_frame_t *);
+  wait_for_async_encoder(ctx);
 
   if (frame != NULL) {
     YV12_BUFFER_CONFIG sd;
@@ -2338,6 +2680,7 @@ static aom_codec_err_t ctrl_copy_reference(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_get_reference(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
   av1_ref_frame_t *const frame = va_arg(args, av1_ref_frame_t *);
+  wait_for_async_encoder(ctx);
 
   if (frame != NULL) {
     YV12_BUFFER_CONFIG *fb = get_ref_frame(&ctx->cpi->common, frame->idx);
@@ -2353,6 +2696,7 @@ static aom_codec_err_t ctrl_get_reference(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_get_new_frame_image(aom_codec_alg_priv_t *ctx,
                                                 va_list args) {
   aom_image_t *const new_img = va_arg(args, aom_image_t *);
+  wait_for_async_encoder(ctx);
 
   if (new_img != NULL) {
     YV12_BUFFER_CONFIG new_frame;
@@ -2371,6 +2715,7 @@ static aom_codec_err_t ctrl_get_new_frame_image(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_copy_new_frame_image(aom_codec_alg_priv_t *ctx,
                                                  va_list args) {
   aom_image_t *const new_img = va_arg(args, aom_image_t *);
+  wait_for_async_encoder(ctx);
 
   if (new_img != NULL) {
     YV12_BUFFER_CONFIG new_frame;
@@ -2389,6 +2734,7 @@ static aom_codec_err_t ctrl_copy_new_frame_image(aom_codec_alg_priv_t *ctx,
 
 static aom_image_t *encoder_get_preview(aom_codec_alg_priv_t *ctx) {
   YV12_BUFFER_CONFIG sd;
+  wait_for_async_encoder(ctx);
 
   if (av1_get_preview_raw_frame(ctx->cpi, &sd) == 0) {
     yuvconfig2image(&ctx->preview_img, &sd, NULL);
@@ -2401,6 +2747,7 @@ static aom_image_t *encoder_get_preview(aom_codec_alg_priv_t *ctx) {
 static aom_codec_err_t ctrl_use_reference(aom_codec_alg_priv_t *ctx,
                                           va_list args) {
   const int reference_flag = va_arg(args, int);
+  wait_for_async_encoder(ctx);
 
   av1_use_as_reference(&ctx->cpi->ext_flags.ref_frame_flags, reference_flag);
   return AOM_CODEC_OK;
@@ -2418,6 +2765,7 @@ static aom_codec_err_t ctrl_set_roi_map(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_set_active_map(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   aom_active_map_t *const map = va_arg(args, aom_active_map_t *);
+  wait_for_async_encoder(ctx);
 
   if (map) {
     if (!av1_set_active_map(ctx->cpi, map->active_map, (int)map->rows,
@@ -2433,6 +2781,7 @@ static aom_codec_err_t ctrl_set_active_map(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_get_active_map(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   aom_active_map_t *const map = va_arg(args, aom_active_map_t *);
+  wait_for_async_encoder(ctx);
 
   if (map) {
     if (!av1_get_active_map(ctx->cpi, map->active_map, (int)map->rows,
@@ -2448,6 +2797,7 @@ static aom_codec_err_t ctrl_get_active_map(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_set_scale_mode(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   aom_scaling_mode_t *const mode = va_arg(args, aom_scaling_mode_t *);
+  wait_for_async_encoder(ctx);
 
   if (mode) {
     const int res = av1_set_internal_size(
@@ -2462,6 +2812,7 @@ static aom_codec_err_t ctrl_set_scale_mode(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_set_spatial_layer_id(aom_codec_alg_priv_t *ctx,
                                                  va_list args) {
   const int spatial_layer_id = va_arg(args, int);
+  wait_for_async_encoder(ctx);
   if (spatial_layer_id >= MAX_NUM_SPATIAL_LAYERS)
     return AOM_CODEC_INVALID_PARAM;
   ctx->cpi->common.spatial_layer_id = spatial_layer_id;
@@ -2471,6 +2822,7 @@ static aom_codec_err_t ctrl_set_spatial_layer_id(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_set_number_spatial_layers(aom_codec_alg_priv_t *ctx,
                                                       va_list args) {
   const int number_spatial_layers = va_arg(args, int);
+  wait_for_async_encoder(ctx);
   if (number_spatial_layers > MAX_NUM_SPATIAL_LAYERS)
     return AOM_CODEC_INVALID_PARAM;
   ctx->cpi->common.number_spatial_layers = number_spatial_layers;
@@ -2480,6 +2832,7 @@ static aom_codec_err_t ctrl_set_number_spatial_layers(aom_codec_alg_priv_t *ctx,
 static aom_codec_err_t ctrl_set_layer_id(aom_codec_alg_priv_t *ctx,
                                          va_list args) {
   aom_svc_layer_id_t *const data = va_arg(args, aom_svc_layer_id_t *);
+  wait_for_async_encoder(ctx);
   ctx->cpi->common.spatial_layer_id = data->spatial_layer_id;
   ctx->cpi->common.temporal_layer_id = data->temporal_layer_id;
   ctx->cpi->svc.spatial_layer_id = data->spatial_layer_id;
@@ -2491,6 +2844,7 @@ static aom_codec_err_t ctrl_set_svc_params(aom_codec_alg_priv_t *ctx,
                                            va_list args) {
   AV1_COMP *const cpi = ctx->cpi;
   aom_svc_params_t *const params = va_arg(args, aom_svc_params_t *);
+  wait_for_async_encoder(ctx);
   cpi->common.number_spatial_layers = params->number_spatial_layers;
   cpi->common.number_temporal_layers = params->number_temporal_layers;
   cpi->svc.number_spatial_layers = params->number_spatial_layers;
@@ -2525,6 +2879,7 @@ static aom_codec_err_t ctrl_set_svc_ref_frame_config(aom_codec_alg_priv_t *ctx,
   AV1_COMP *const cpi = ctx->cpi;
   aom_svc_ref_frame_config_t *const data =
       va_arg(args, aom_svc_ref_frame_config_t *);
+  wait_for_async_encoder(ctx);
   cpi->svc.external_ref_frame_config = 1;
   for (unsigned int i = 0; i < INTER_REFS_PER_FRAME; ++i) {
     cpi->svc.reference[i] = data->reference[i];
@@ -2620,11 +2975,68 @@ static aom_codec_err_t ctrl_get_seq_level_idx(aom_codec_alg_priv_t *ctx,
                                               va_list args) {
   int *const arg = va_arg(args, int *);
   const AV1_COMP *const cpi = ctx->cpi;
+  wait_for_async_encoder(ctx);
   if (arg == NULL) return AOM_CODEC_INVALID_PARAM;
   return av1_get_seq_level_idx(&cpi->common.seq_params, &cpi->level_params,
                                arg);
 }
 
+static aom_codec_err_t ctrl_set_thread_pool(aom_codec_alg_priv_t *ctx,
+                                           va_list args) {
+  wait_for_async_encoder(ctx);
+  // The workers are created on the first frame.
+  if (ctx->cpi->num_workers > 0 ||
+      (ctx->cpi_lap != NULL && ctx->cpi_lap->num_workers > 0)) {
+    return AOM_CODEC_ERROR;
+  }
+  aom_thread_pool_t *const pool = va_arg(args, aom_thread_pool_t *);
+  ctx->cpi->thread_pool = pool;
+  if (ctx->cpi_lap != NULL) ctx->cpi_lap->thread_pool = pool;
+  return AOM_CODEC_OK;
+}
+
+static aom_codec_err_t ctrl_set_async_encode(aom_codec_alg_priv_t *ctx,
+                                            va_list args) {
+  const unsigned int enable = CAST(AV1E_SET_ASYNC_ENCODE, args);
+#if CONFIG_MULTITHREAD
+  if (ctx->async == NULL) {
+    if (!enable) return AOM_CODEC_OK;
+    AsyncEncoder *const async = aom_calloc(1, sizeof(*async));
+    if (async == NULL) return AOM_CODEC_MEM_ERROR;
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    winterface->init(&async->worker);
+    async->worker.thread_name = "aom async enc";
+    if (pthread_mutex_init(&async->mutex, NULL)) {
+      aom_free(async);
+      return AOM_CODEC_MEM_ERROR;
+    }
+    if (pthread_cond_init(&async->cond, NULL)) {
+      pthread_mutex_destroy(&async->mutex);
+      aom_free(async);
+      return AOM_CODEC_MEM_ERROR;
+    }
+    if (!winterface->reset(&async->worker)) {
+      free_async_encoder(async);
+      return AOM_CODEC_MEM_ERROR;
+    }
+    async->worker.hook = async_encode_worker_hook;
+    async->worker.data1 = ctx;
+    async->worker.data2 = NULL;
+    ctx->async = async;
+  }
+  AsyncEncoder *const async = ctx->async;
+  pthread_mutex_lock(&async->mutex);
+  while (async->running) pthread_cond_wait(&async->cond, &async->mutex);
+  const aom_codec_err_t res = get_async_error(ctx);
+  async->enabled = enable != 0;
+  pthread_mutex_unlock(&async->mutex);
+  return res;
+#else
+  (void)ctx;
+  return enable ? AOM_CODEC_INCAPABLE : AOM_CODEC_OK;
+#endif  // CONFIG_MULTITHREAD
+}
+
 static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1_COPY_REFERENCE, ctrl_copy_reference },
   { AOME_USE_REFERENCE, ctrl_use_reference },
@@ -2747,6 +3159,8 @@ static aom_codec_ctrl_fn_map_t encoder_ctrl_maps[] = {
   { AV1E_SET_SVC_PARAMS, ctrl_set_svc_params },
   { AV1E_SET_SVC_REF_FRAME_CONFIG, ctrl_set_svc_ref_frame_config },
   { AV1E_ENABLE_SB_MULTIPASS_UNIT_TEST, ctrl_enable_sb_multipass_unit_test },
+  { AV1_SET_THREAD_POOL, ctrl_set_thread_pool },
+  { AV1E_SET_ASYNC_ENCODE, ctrl_set_async_encode },
 
   // Getters
   { AOME_GET_LAST_QUANTIZER, ctrl_get_quantizer },
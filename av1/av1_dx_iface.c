@@ -52,6 +52,7 @@ struct aom_codec_alg_priv {
   unsigned int tile_mode;
   unsigned int ext_tile_debug;
   unsigned int row_mt;
+  aom_thread_pool_t *thread_pool;
   EXTERNAL_REFERENCES ext_refs;
   unsigned int is_annexb;
   int operating_point;
@@ -62,6 +63,9 @@ struct aom_codec_alg_priv {
   aom_image_t image_with_grain;
   aom_codec_frame_buffer_t grain_image_frame_buffers[MAX_NUM_SPATIAL_LAYERS];
   size_t num_grain_image_frame_buffers;
+  // Recycled output buffers for the images with grain, used when the frame
+  // buffers are allocated internally.
+  InternalFrameBufferList grain_frame_buffers;
   int need_resync;  // wait for key/intra-only frame
   // BufferPool that holds all reference frames. Shared by all the FrameWorkers.
   BufferPool *buffer_pool;
@@ -111,6 +115,22 @@ static aom_codec_err_t decoder_init(aom_codec_ctx_t *ctx) {
   return AOM_CODEC_OK;
 }
 
+static void release_grain_image_frame_buffers(aom_codec_alg_priv_t *ctx) {
+  BufferPool *const pool = ctx->buffer_pool;
+  for (size_t i = 0; i < ctx->num_grain_image_frame_buffers; i++) {
+    aom_codec_frame_buffer_t *const fb = &ctx->grain_image_frame_buffers[i];
+    if (ctx->grain_frame_buffers.int_fb != NULL) {
+      av1_release_frame_buffer(&ctx->grain_frame_buffers, fb);
+    } else {
+      pool->release_fb_cb(pool->cb_priv, fb);
+    }
+    fb->data = NULL;
+    fb->size = 0;
+    fb->priv = NULL;
+  }
+  ctx->num_grain_image_frame_buffers = 0;
+}
+
 static aom_codec_err_t decoder_destroy(aom_codec_alg_priv_t *ctx) {
   if (ctx->frame_worker != NULL) {
     AVxWorker *const worker = ctx->frame_worker;
@@ -128,13 +148,11 @@ static aom_codec_err_t decoder_destroy(aom_codec_alg_priv_t *ctx) {
   }
 
   if (ctx->buffer_pool) {
-    for (size_t i = 0; i < ctx->num_grain_image_frame_buffers; i++) {
-      ctx->buffer_pool->release_fb_cb(ctx->buffer_pool->cb_priv,
-                                      &ctx->grain_image_frame_buffers[i]);
-    }
+    release_grain_image_frame_buffers(ctx);
     av1_free_ref_frame_buffers(ctx->buffer_pool);
     av1_free_internal_frame_buffers(&ctx->buffer_pool->int_frame_buffers);
   }
+  av1_free_internal_frame_buffers(&ctx->grain_frame_buffers);
 
   aom_free(ctx->frame_worker);
   aom_free(ctx->buffer_pool);
@@ -394,6 +412,16 @@ static void init_buffer_callbacks(aom_codec_alg_priv_t *ctx) {
                          "Failed to initialize internal frame buffers");
 
     pool->cb_priv = &pool->int_frame_buffers;
+
+    // The images with grain are only held until the next decode call, so
+    // they are kept apart from the reference frame buffers.
+    InternalFrameBufferList *const grain_list = &ctx->grain_frame_buffers;
+    grain_list->int_fb = (InternalFrameBuffer *)aom_calloc(
+        MAX_NUM_SPATIAL_LAYERS, sizeof(*grain_list->int_fb));
+    if (grain_list->int_fb == NULL)
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to initialize grain frame buffers");
+    grain_list->num_internal_frame_buffers = MAX_NUM_SPATIAL_LAYERS;
   }
 }
 
@@ -467,6 +495,7 @@ static aom_codec_err_t init_decoder(aom_codec_alg_priv_t *ctx) {
   frame_worker_data->pbi->output_all_layers = ctx->output_all_layers;
   frame_worker_data->pbi->ext_tile_debug = ctx->ext_tile_debug;
   frame_worker_data->pbi->row_mt = ctx->row_mt;
+  frame_worker_data->pbi->thread_pool = ctx->thread_pool;
 
   worker->hook = frame_worker_hook;
 
@@ -597,13 +626,7 @@ static aom_codec_err_t decoder_decode(aom_codec_alg_priv_t *ctx,
     }
     pbi->num_output_frames = 0;
     unlock_buffer_pool(pool);
-    for (size_t j = 0; j < ctx->num_grain_image_frame_buffers; j++) {
-      pool->release_fb_cb(pool->cb_priv, &ctx->grain_image_frame_buffers[j]);
-      ctx->grain_image_frame_buffers[j].data = NULL;
-      ctx->grain_image_frame_buffers[j].size = 0;
-      ctx->grain_image_frame_buffers[j].priv = NULL;
-    }
-    ctx->num_grain_image_frame_buffers = 0;
+    release_grain_image_frame_buffers(ctx);
   }
 
   /* Sanity checks */
@@ -673,21 +696,49 @@ static aom_codec_err_t decoder_decode(aom_codec_alg_priv_t *ctx,
 
 typedef struct {
   BufferPool *pool;
+  InternalFrameBufferList *grain_list;
+  size_t reserve_size;
   aom_codec_frame_buffer_t *fb;
 } AllocCbParam;
 
 static void *AllocWithGetFrameBufferCb(void *priv, size_t size) {
   AllocCbParam *param = (AllocCbParam *)priv;
-  if (param->pool->get_fb_cb(param->pool->cb_priv, size, param->fb) < 0)
+  if (param->grain_list != NULL) {
+    // Grow the buffer to the largest frame of the sequence at once, so that it
+    // is not reallocated on frame size changes.
+    if (av1_get_frame_buffer(param->grain_list,
+                             AOMMAX(size, param->reserve_size), param->fb) < 0)
+      return NULL;
+  } else if (param->pool->get_fb_cb(param->pool->cb_priv, size, param->fb) <
+             0) {
     return NULL;
+  }
   if (param->fb->data == NULL || param->fb->size < size) return NULL;
   return param->fb->data;
 }
 
+static void *GetAllocSizeCb(void *priv, size_t size) {
+  *(size_t *)priv = size;
+  return NULL;
+}
+
+// Returns the size of an image with grain for the largest frame allowed by
+// the sequence header.
+static size_t get_grain_image_reserve_size(const SequenceHeader *seq_params,
+                                           aom_img_fmt_t fmt) {
+  const int w_even = ALIGN_POWER_OF_TWO(seq_params->max_frame_width, 1);
+  const int h_even = ALIGN_POWER_OF_TWO(seq_params->max_frame_height, 1);
+  size_t size = 0;
+  aom_image_t img;
+  // The allocation always fails, GetAllocSizeCb only records its size.
+  aom_img_alloc_with_cb(&img, fmt, w_even, h_even, 16, GetAllocSizeCb, &size);
+  return size;
+}
+
 // If grain_params->apply_grain is false, returns img. Otherwise, adds film
 // grain to img, saves the result in grain_img, and returns grain_img.
 static aom_image_t *add_grain_if_needed(aom_codec_alg_priv_t *ctx,
-                                        aom_image_t *img,
+                                        AV1Decoder *pbi, aom_image_t *img,
                                         aom_image_t *grain_img,
                                         aom_film_grain_t *grain_params) {
   if (!grain_params->apply_grain) return img;
@@ -700,7 +751,14 @@ static aom_image_t *add_grain_if_needed(aom_codec_alg_priv_t *ctx,
       &ctx->grain_image_frame_buffers[ctx->num_grain_image_frame_buffers];
   AllocCbParam param;
   param.pool = pool;
+  param.grain_list = NULL;
+  param.reserve_size = 0;
   param.fb = fb;
+  if (ctx->grain_frame_buffers.int_fb != NULL) {
+    param.grain_list = &ctx->grain_frame_buffers;
+    param.reserve_size =
+        get_grain_image_reserve_size(&pbi->common.seq_params, img->fmt);
+  }
   if (!aom_img_alloc_with_cb(grain_img, img->fmt, w_even, h_even, 16,
                              AllocWithGetFrameBufferCb, &param)) {
     return NULL;
@@ -708,8 +766,14 @@ static aom_image_t *add_grain_if_needed(aom_codec_alg_priv_t *ctx,
 
   grain_img->user_priv = img->user_priv;
   grain_img->fb_priv = fb->priv;
-  if (av1_add_film_grain(grain_params, img, grain_img)) {
-    pool->release_fb_cb(pool->cb_priv, fb);
+  // The tile workers are idle once the frame is decoded.
+  if (av1_add_film_grain_mt(grain_params, img, grain_img, pbi->tile_workers,
+                            pbi->num_workers)) {
+    if (param.grain_list != NULL) {
+      av1_release_frame_buffer(param.grain_list, fb);
+    } else {
+      pool->release_fb_cb(pool->cb_priv, fb);
+    }
     return NULL;
   }
 
@@ -817,8 +881,8 @@ static aom_image_t *decoder_get_frame(aom_codec_alg_priv_t *ctx,
         img->temporal_id = cm->temporal_layer_id;
         img->spatial_id = cm->spatial_layer_id;
         if (pbi->skip_film_grain) grain_params->apply_grain = 0;
-        aom_image_t *res =
-            add_grain_if_needed(ctx, img, &ctx->image_with_grain, grain_params);
+        aom_image_t *res = add_grain_if_needed(
+            ctx, pbi, img, &ctx->image_with_grain, grain_params);
         if (!res) {
           aom_internal_error(&pbi->common.error, AOM_CODEC_CORRUPT_FRAME,
                              "Grain systhesis failed\n");
@@ -1325,6 +1389,14 @@ static aom_codec_err_t ctrl_set_row_mt(aom_codec_alg_priv_t *ctx,
   return AOM_CODEC_OK;
 }
 
+static aom_codec_err_t ctrl_set_thread_pool(aom_codec_alg_priv_t *ctx,
+                                           va_list args) {
+  // The tile workers are created on the first frame.
+  if (ctx->frame_worker != NULL) return AOM_CODEC_ERROR;
+  ctx->thread_pool = va_arg(args, aom_thread_pool_t *);
+  return AOM_CODEC_OK;
+}
+
 static aom_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { AV1_COPY_REFERENCE, ctrl_copy_reference },
 
@@ -1344,6 +1416,7 @@ static aom_codec_ctrl_fn_map_t decoder_ctrl_maps[] = {
   { AV1D_SET_ROW_MT, ctrl_set_row_mt },
   { AV1D_SET_EXT_REF_PTR, ctrl_set_ext_ref_ptr },
   { AV1D_SET_SKIP_FILM_GRAIN, ctrl_set_skip_film_grain },
+  { AV1_SET_THREAD_POOL, ctrl_set_thread_pool },
 
   // Getters
   { AOMD_GET_FRAME_CORRUPTED, ctrl_get_frame_corrupted },
@@ -47,6 +47,9 @@ void av1_free_ref_frame_buffers(BufferPool *pool) {
     pool->frame_bufs[i].mvs = NULL;
     aom_free(pool->frame_bufs[i].seg_map);
     pool->frame_bufs[i].seg_map = NULL;
+    aom_free(pool->frame_bufs[i].corners);
+    pool->frame_bufs[i].corners = NULL;
+    pool->frame_bufs[i].corners_valid = 0;
     aom_free_frame_buffer(&pool->frame_bufs[i].buf);
   }
 }
@@ -155,6 +155,13 @@ typedef struct RefCntBuffer {
   // so it's extremely convenient to keep it here.
   int interp_filter_selected[SWITCHABLE];
 
+  // Encoder only. The FAST corners of the luma plane of 'buf', detected the
+  // first time the buffer is used as a global motion reference and kept until
+  // the buffer is reassigned. 'corners' holds 2 * MAX_CORNERS entries.
+  int *corners;
+  int num_corners;
+  int corners_valid;
+
   // Inter frame reference frame delta for loop filter
   int8_t ref_deltas[REF_FRAMES];
 
@@ -807,6 +814,7 @@ static INLINE RefCntBuffer *assign_cur_frame_new_fb(AV1_COMMON *const cm) {
 
   cm->cur_frame = &cm->buffer_pool->frame_bufs[new_fb_idx];
   cm->cur_frame->buf.buf_8bit_valid = 0;
+  cm->cur_frame->corners_valid = 0;
   av1_zero(cm->cur_frame->interp_filter_selected);
   return cm->cur_frame;
 }
@@ -37,14 +37,42 @@ static INLINE int constrain(int diff, int threshold, int damping) {
 extern "C" {
 #endif
 
+// Unfiltered pixels around the boundaries between 64x64 filter block rows.
+// A boundary is saved before either of its adjacent rows is filtered, so that
+// the rows can then be filtered independently of each other and in any order.
+typedef struct CdefLineBufs {
+  uint16_t *linebuf[MAX_MB_PLANE];
+  int stride;
+  int nvfb;  // Number of filter block rows.
+  int nhfb;  // Number of filter block columns.
+} CdefLineBufs;
+
+// Returns the CDEF_VBORDER lines above filter block row 'fbr'. They are
+// followed by the CDEF_VBORDER lines below row fbr - 1, which are the first
+// lines of row 'fbr'.
+static INLINE uint16_t *cdef_top_lines(const CdefLineBufs *lb, int pli,
+                                       int fbr) {
+  return lb->linebuf[pli] + (fbr - 1) * 2 * CDEF_VBORDER * lb->stride;
+}
+
 int av1_cdef_compute_sb_list(const CommonModeInfoParams *const mi_params,
                              int mi_row, int mi_col, cdef_list *dlist,
                              BLOCK_SIZE bsize);
 void av1_cdef_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm, MACROBLOCKD *xd);
 
-void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
-                     AV1_COMMON *cm, MACROBLOCKD *xd, int pick_method,
-                     int rdmult);
+// Sets up xd for 'frame' and allocates the line buffers in 'lb'. On an
+// allocation error, the buffers are freed before the error is raised.
+void av1_cdef_init_frame(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                         MACROBLOCKD *xd, CdefLineBufs *lb);
+// Saves the unfiltered lines around the top boundary of filter block row
+// 'fbr' (0 < fbr < lb->nvfb) into 'lb'.
+void av1_cdef_save_boundary_lines(const AV1_COMMON *cm, const MACROBLOCKD *xd,
+                                  const CdefLineBufs *lb, int fbr);
+// Filters one 64x64 filter block row in place. Rows only read 'lb' and 'xd',
+// so different rows may be filtered concurrently.
+void av1_cdef_fb_row(const AV1_COMMON *cm, const MACROBLOCKD *xd,
+                     const CdefLineBufs *lb, int fbr);
+void av1_cdef_free_frame(CdefLineBufs *lb);
 
 #ifdef __cplusplus
 }  // extern "C"
@@ -25,6 +25,7 @@
 #include "av1/common/resize.h"
 
 #include "config/aom_scale_rtcd.h"
+#include "config/av1_rtcd.h"
 
 // Filters for interpolation (0.5-band) - note this also filters integer pels.
 static const InterpKernel filteredinterp_filters500[(1 << RS_SUBPEL_BITS)] = {
@@ -210,6 +211,10 @@ const int16_t av1_resize_filter_normative[(
 #endif  // UPSCALE_NORMATIVE_TAPS == 8
 };
 
+// The width of the blocks of columns of the vertical pass of
+// av1_resize_plane().
+#define RESIZE_VERT_BLOCK_COLS 256
+
 // Filters for interpolation (full-band) - no filtering for integer pixels
 #define filteredinterp_filters1000 av1_resize_filter_normative
 
@@ -217,6 +222,13 @@ const int16_t av1_resize_filter_normative[(
 static const int16_t av1_down2_symeven_half_filter[] = { 56, 12, -3, -1 };
 static const int16_t av1_down2_symodd_half_filter[] = { 64, 35, 0, -3 };
 
+// The same filters with their 8 taps, which are applied to the pixels
+// -3 to 4 around the even positions.
+static const int16_t av1_down2_symeven_filter[SUBPEL_TAPS] = { -1, -3, 12, 56,
+                                                               56, 12, -3, -1 };
+static const int16_t av1_down2_symodd_filter[SUBPEL_TAPS] = { -3, 0, 35, 64,
+                                                              35, 0,  -3, 0 };
+
 static const InterpKernel *choose_interp_filter(int in_length, int out_length) {
   int out_length16 = out_length * 16;
   if (out_length16 >= in_length * 16)
@@ -231,12 +243,12 @@ static const InterpKernel *choose_interp_filter(int in_length, int out_length) {
     return filteredinterp_filters500;
 }
 
-static void interpolate_core(const uint8_t *const input, int in_length,
-                             uint8_t *output, int out_length,
-                             const int16_t *interp_filters, int interp_taps) {
-  const int32_t delta =
-      (((uint32_t)in_length << RS_SCALE_SUBPEL_BITS) + out_length / 2) /
-      out_length;
+// Returns the step and the initial position, in 1 / (1 << RS_SCALE_SUBPEL_BITS)
+// pixels, of the interpolation of in_length pixels to out_length.
+static void get_interp_step(int in_length, int out_length, int32_t *delta,
+                            int32_t *y0) {
+  *delta = (((uint32_t)in_length << RS_SCALE_SUBPEL_BITS) + out_length / 2) /
+           out_length;
   const int32_t offset =
       in_length > out_length
           ? (((int32_t)(in_length - out_length) << (RS_SCALE_SUBPEL_BITS - 1)) +
@@ -246,70 +258,40 @@ static void interpolate_core(const uint8_t *const input, int in_length,
                << (RS_SCALE_SUBPEL_BITS - 1)) +
               out_length / 2) /
                 out_length;
-  uint8_t *optr = output;
-  int x, x1, x2, sum, k, int_pel, sub_pel;
-  int32_t y;
+  *y0 = offset + RS_SCALE_EXTRA_OFF;
+}
 
-  x = 0;
-  y = offset + RS_SCALE_EXTRA_OFF;
-  while ((y >> RS_SCALE_SUBPEL_BITS) < (interp_taps / 2 - 1)) {
-    x++;
-    y += delta;
+void av1_resize_vert_8tap_c(const uint8_t *const *rows, uint8_t *dst,
+                            int width, const int16_t *filter) {
+  for (int j = 0; j < width; ++j) {
+    int sum = 0;
+    for (int k = 0; k < SUBPEL_TAPS; ++k) sum += filter[k] * rows[k][j];
+    dst[j] = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
   }
-  x1 = x;
-  x = out_length - 1;
-  y = delta * x + offset + RS_SCALE_EXTRA_OFF;
-  while ((y >> RS_SCALE_SUBPEL_BITS) + (int32_t)(interp_taps / 2) >=
-         in_length) {
-    x--;
-    y -= delta;
+}
+
+void av1_resize_down2_horz_c(const uint8_t *input, uint8_t *output,
+                             int out_length, const int16_t *filter) {
+  for (int i = 0; i < out_length; ++i) {
+    const uint8_t *const in = input + 2 * i - (SUBPEL_TAPS / 2 - 1);
+    int sum = 0;
+    for (int k = 0; k < SUBPEL_TAPS; ++k) sum += filter[k] * in[k];
+    output[i] = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
   }
-  x2 = x;
-  if (x1 > x2) {
-    for (x = 0, y = offset + RS_SCALE_EXTRA_OFF; x < out_length;
-         ++x, y += delta) {
-      int_pel = y >> RS_SCALE_SUBPEL_BITS;
-      sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
-      const int16_t *filter = &interp_filters[sub_pel * interp_taps];
-      sum = 0;
-      for (k = 0; k < interp_taps; ++k) {
-        const int pk = int_pel - interp_taps / 2 + 1 + k;
-        sum += filter[k] * input[AOMMAX(AOMMIN(pk, in_length - 1), 0)];
-      }
-      *optr++ = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
-    }
-  } else {
-    // Initial part.
-    for (x = 0, y = offset + RS_SCALE_EXTRA_OFF; x < x1; ++x, y += delta) {
-      int_pel = y >> RS_SCALE_SUBPEL_BITS;
-      sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
-      const int16_t *filter = &interp_filters[sub_pel * interp_taps];
-      sum = 0;
-      for (k = 0; k < interp_taps; ++k)
-        sum += filter[k] * input[AOMMAX(int_pel - interp_taps / 2 + 1 + k, 0)];
-      *optr++ = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
-    }
-    // Middle part.
-    for (; x <= x2; ++x, y += delta) {
-      int_pel = y >> RS_SCALE_SUBPEL_BITS;
-      sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
-      const int16_t *filter = &interp_filters[sub_pel * interp_taps];
-      sum = 0;
-      for (k = 0; k < interp_taps; ++k)
-        sum += filter[k] * input[int_pel - interp_taps / 2 + 1 + k];
-      *optr++ = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
-    }
-    // End part.
-    for (; x < out_length; ++x, y += delta) {
-      int_pel = y >> RS_SCALE_SUBPEL_BITS;
-      sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
-      const int16_t *filter = &interp_filters[sub_pel * interp_taps];
-      sum = 0;
-      for (k = 0; k < interp_taps; ++k)
-        sum += filter[k] *
-               input[AOMMIN(int_pel - interp_taps / 2 + 1 + k, in_length - 1)];
-      *optr++ = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
-    }
+}
+
+void av1_resize_interp_horz_c(const uint8_t *input, uint8_t *output,
+                              int out_length, int32_t y0, int32_t delta,
+                              const int16_t *filters) {
+  int32_t y = y0;
+  for (int x = 0; x < out_length; ++x, y += delta) {
+    const int int_pel = y >> RS_SCALE_SUBPEL_BITS;
+    const int sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
+    const int16_t *const filter = &filters[sub_pel * SUBPEL_TAPS];
+    const uint8_t *const in = input + int_pel - (SUBPEL_TAPS / 2 - 1);
+    int sum = 0;
+    for (int k = 0; k < SUBPEL_TAPS; ++k) sum += filter[k] * in[k];
+    output[x] = clip_pixel(ROUND_POWER_OF_TWO(sum, FILTER_BITS));
   }
 }
 
@@ -398,15 +380,6 @@ static void interpolate_core_double_prec(const double *const input,
   }
 }
 
-static void interpolate(const uint8_t *const input, int in_length,
-                        uint8_t *output, int out_length) {
-  const InterpKernel *interp_filters =
-      choose_interp_filter(in_length, out_length);
-
-  interpolate_core(input, in_length, output, out_length, &interp_filters[0][0],
-                   SUBPEL_TAPS);
-}
-
 static void interpolate_double_prec(const double *const input, int in_length,
                                     double *output, int out_length) {
   const InterpKernel *interp_filters =
@@ -431,116 +404,6 @@ static int32_t get_upscale_convolve_x0(int in_length, int out_length,
   return (int32_t)((uint32_t)x0 & RS_SCALE_SUBPEL_MASK);
 }
 
-static void down2_symeven(const uint8_t *const input, int length,
-                          uint8_t *output) {
-  // Actual filter len = 2 * filter_len_half.
-  const int16_t *filter = av1_down2_symeven_half_filter;
-  const int filter_len_half = sizeof(av1_down2_symeven_half_filter) / 2;
-  int i, j;
-  uint8_t *optr = output;
-  int l1 = filter_len_half;
-  int l2 = (length - filter_len_half);
-  l1 += (l1 & 1);
-  l2 += (l2 & 1);
-  if (l1 > l2) {
-    // Short input length.
-    for (i = 0; i < length; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1));
-      for (j = 0; j < filter_len_half; ++j) {
-        sum +=
-            (input[AOMMAX(i - j, 0)] + input[AOMMIN(i + 1 + j, length - 1)]) *
-            filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-  } else {
-    // Initial part.
-    for (i = 0; i < l1; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1));
-      for (j = 0; j < filter_len_half; ++j) {
-        sum += (input[AOMMAX(i - j, 0)] + input[i + 1 + j]) * filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-    // Middle part.
-    for (; i < l2; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1));
-      for (j = 0; j < filter_len_half; ++j) {
-        sum += (input[i - j] + input[i + 1 + j]) * filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-    // End part.
-    for (; i < length; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1));
-      for (j = 0; j < filter_len_half; ++j) {
-        sum +=
-            (input[i - j] + input[AOMMIN(i + 1 + j, length - 1)]) * filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-  }
-}
-
-static void down2_symodd(const uint8_t *const input, int length,
-                         uint8_t *output) {
-  // Actual filter len = 2 * filter_len_half - 1.
-  const int16_t *filter = av1_down2_symodd_half_filter;
-  const int filter_len_half = sizeof(av1_down2_symodd_half_filter) / 2;
-  int i, j;
-  uint8_t *optr = output;
-  int l1 = filter_len_half - 1;
-  int l2 = (length - filter_len_half + 1);
-  l1 += (l1 & 1);
-  l2 += (l2 & 1);
-  if (l1 > l2) {
-    // Short input length.
-    for (i = 0; i < length; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1)) + input[i] * filter[0];
-      for (j = 1; j < filter_len_half; ++j) {
-        sum += (input[(i - j < 0 ? 0 : i - j)] +
-                input[(i + j >= length ? length - 1 : i + j)]) *
-               filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-  } else {
-    // Initial part.
-    for (i = 0; i < l1; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1)) + input[i] * filter[0];
-      for (j = 1; j < filter_len_half; ++j) {
-        sum += (input[(i - j < 0 ? 0 : i - j)] + input[i + j]) * filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-    // Middle part.
-    for (; i < l2; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1)) + input[i] * filter[0];
-      for (j = 1; j < filter_len_half; ++j) {
-        sum += (input[i - j] + input[i + j]) * filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-    // End part.
-    for (; i < length; i += 2) {
-      int sum = (1 << (FILTER_BITS - 1)) + input[i] * filter[0];
-      for (j = 1; j < filter_len_half; ++j) {
-        sum += (input[i - j] + input[(i + j >= length ? length - 1 : i + j)]) *
-               filter[j];
-      }
-      sum >>= FILTER_BITS;
-      *optr++ = clip_pixel(sum);
-    }
-  }
-}
-
 static int get_down2_length(int length, int steps) {
   for (int s = 0; s < steps; ++s) length = (length + 1) >> 1;
   return length;
@@ -562,38 +425,99 @@ static int get_down2_steps(int in_length, int out_length) {
   return steps;
 }
 
-static void resize_multistep(const uint8_t *const input, int length,
-                             uint8_t *output, int olength, uint8_t *otmp) {
+// Replicates the first and the last pixels of a row of length pixels to the
+// RESIZE_HORZ_BORDER pixels before and after it.
+static void extend_row(uint8_t *row, int length) {
+  memset(row - RESIZE_HORZ_BORDER, row[0], RESIZE_HORZ_BORDER);
+  memset(row + length, row[length - 1], RESIZE_HORZ_BORDER);
+}
+
+// Resizes a row of length pixels to olength. The steps are computed in the
+// rows rowbuf[0] and rowbuf[1], which have borders of RESIZE_HORZ_BORDER
+// pixels.
+static void resize_horz_multistep(const uint8_t *const input, int length,
+                                  uint8_t *output, int olength,
+                                  uint8_t *const rowbuf[2]) {
   if (length == olength) {
     memcpy(output, input, sizeof(output[0]) * length);
     return;
   }
   const int steps = get_down2_steps(length, olength);
+  uint8_t *in = rowbuf[0];
+  memcpy(in, input, sizeof(in[0]) * length);
+  extend_row(in, length);
+
+  for (int s = 0; s < steps; ++s) {
+    const int out_length = get_down2_length(length, 1);
+    uint8_t *const out = (s == steps - 1 && out_length == olength)
+                             ? output
+                             : rowbuf[(s + 1) & 1];
+    av1_resize_down2_horz(
+        in, out, out_length,
+        length & 1 ? av1_down2_symodd_filter : av1_down2_symeven_filter);
+    length = out_length;
+    if (out == output) return;
+    extend_row(out, length);
+    in = out;
+  }
 
-  if (steps > 0) {
-    uint8_t *out = NULL;
-    int filteredlength = length;
+  int32_t delta, y0;
+  get_interp_step(length, olength, &delta, &y0);
+  av1_resize_interp_horz(in, output, olength, y0, delta,
+                         &choose_interp_filter(length, olength)[0][0]);
+}
 
-    assert(otmp != NULL);
-    uint8_t *otmp2 = otmp + get_down2_length(length, 1);
-    for (int s = 0; s < steps; ++s) {
-      const int proj_filteredlength = get_down2_length(filteredlength, 1);
-      const uint8_t *const in = (s == 0 ? input : out);
-      if (s == steps - 1 && proj_filteredlength == olength)
-        out = output;
-      else
-        out = (s & 1 ? otmp2 : otmp);
-      if (filteredlength & 1)
-        down2_symodd(in, filteredlength, out);
-      else
-        down2_symeven(in, filteredlength, out);
-      filteredlength = proj_filteredlength;
+// Resizes the columns of a block of width pixels from length rows to olength.
+// The filters are applied to whole rows, and the steps of the 2:1
+// downscaling are computed in tmp, whose rows are width pixels.
+static void resize_vert_multistep(const uint8_t *const input, int in_stride,
+                                  int length, uint8_t *output, int out_stride,
+                                  int olength, int width, uint8_t *tmp) {
+  const uint8_t *rows[SUBPEL_TAPS];
+  if (length == olength) {
+    for (int i = 0; i < length; ++i) {
+      memcpy(output + i * out_stride, input + i * in_stride,
+             sizeof(output[0]) * width);
     }
-    if (filteredlength != olength) {
-      interpolate(out, filteredlength, output, olength);
+    return;
+  }
+  const int steps = get_down2_steps(length, olength);
+  uint8_t *const tmp2 = tmp + get_down2_length(length, 1) * width;
+  const uint8_t *in = input;
+  int stride = in_stride;
+
+  for (int s = 0; s < steps; ++s) {
+    const int out_length = get_down2_length(length, 1);
+    const int is_last = s == steps - 1 && out_length == olength;
+    uint8_t *const out = is_last ? output : (s & 1 ? tmp2 : tmp);
+    const int ostride = is_last ? out_stride : width;
+    const int16_t *const filter =
+        length & 1 ? av1_down2_symodd_filter : av1_down2_symeven_filter;
+    for (int i = 0; i < out_length; ++i) {
+      for (int k = 0; k < SUBPEL_TAPS; ++k) {
+        const int r = 2 * i - (SUBPEL_TAPS / 2 - 1) + k;
+        rows[k] = in + clamp(r, 0, length - 1) * stride;
+      }
+      av1_resize_vert_8tap(rows, out + i * ostride, width, filter);
     }
-  } else {
-    interpolate(input, length, output, olength);
+    if (is_last) return;
+    in = out;
+    stride = width;
+    length = out_length;
+  }
+
+  const int16_t *const filters = &choose_interp_filter(length, olength)[0][0];
+  int32_t delta, y;
+  get_interp_step(length, olength, &delta, &y);
+  for (int i = 0; i < olength; ++i, y += delta) {
+    const int int_pel = y >> RS_SCALE_SUBPEL_BITS;
+    const int sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
+    for (int k = 0; k < SUBPEL_TAPS; ++k) {
+      const int r = int_pel - (SUBPEL_TAPS / 2 - 1) + k;
+      rows[k] = in + clamp(r, 0, length - 1) * stride;
+    }
+    av1_resize_vert_8tap(rows, output + i * out_stride, width,
+                         &filters[sub_pel * SUBPEL_TAPS]);
   }
 }
 
@@ -603,24 +527,6 @@ static void upscale_multistep_double_prec(const double *const input, int length,
   interpolate_double_prec(input, length, output, olength);
 }
 
-static void fill_col_to_arr(uint8_t *img, int stride, int len, uint8_t *arr) {
-  int i;
-  uint8_t *iptr = img;
-  uint8_t *aptr = arr;
-  for (i = 0; i < len; ++i, iptr += stride) {
-    *aptr++ = *iptr;
-  }
-}
-
-static void fill_arr_to_col(uint8_t *img, int stride, int len, uint8_t *arr) {
-  int i;
-  uint8_t *iptr = img;
-  uint8_t *aptr = arr;
-  for (i = 0; i < len; ++i, iptr += stride) {
-    *iptr = *aptr++;
-  }
-}
-
 static void fill_col_to_arr_double_prec(double *img, int stride, int len,
                                         double *arr) {
   int i;
@@ -644,32 +550,35 @@ static void fill_arr_to_col_double_prec(double *img, int stride, int len,
 void av1_resize_plane(const uint8_t *const input, int height, int width,
                       int in_stride, uint8_t *output, int height2, int width2,
                       int out_stride) {
-  int i;
+  // The vertical pass is done in blocks of columns, so that the steps of its
+  // 2:1 downscaling stay in the cache.
+  const int block_cols = AOMMIN(width2, RESIZE_VERT_BLOCK_COLS);
+  const int row_size = width + 2 * RESIZE_HORZ_BORDER;
   uint8_t *intbuf = (uint8_t *)aom_malloc(sizeof(uint8_t) * width2 * height);
-  uint8_t *tmpbuf =
-      (uint8_t *)aom_malloc(sizeof(uint8_t) * AOMMAX(width, height));
-  uint8_t *arrbuf = (uint8_t *)aom_malloc(sizeof(uint8_t) * height);
-  uint8_t *arrbuf2 = (uint8_t *)aom_malloc(sizeof(uint8_t) * height2);
-  if (intbuf == NULL || tmpbuf == NULL || arrbuf == NULL || arrbuf2 == NULL)
-    goto Error;
+  uint8_t *rowbuf = (uint8_t *)aom_malloc(sizeof(uint8_t) * 2 * row_size);
+  uint8_t *tmpbuf = (uint8_t *)aom_malloc(
+      sizeof(uint8_t) * block_cols *
+      (get_down2_length(height, 1) + get_down2_length(height, 2)));
+  if (intbuf == NULL || rowbuf == NULL || tmpbuf == NULL) goto Error;
   assert(width > 0);
   assert(height > 0);
   assert(width2 > 0);
   assert(height2 > 0);
-  for (i = 0; i < height; ++i)
-    resize_multistep(input + in_stride * i, width, intbuf + width2 * i, width2,
-                     tmpbuf);
-  for (i = 0; i < width2; ++i) {
-    fill_col_to_arr(intbuf + i, width2, height, arrbuf);
-    resize_multistep(arrbuf, height, arrbuf2, height2, tmpbuf);
-    fill_arr_to_col(output + i, out_stride, height2, arrbuf2);
+  uint8_t *const rows[2] = { rowbuf + RESIZE_HORZ_BORDER,
+                             rowbuf + row_size + RESIZE_HORZ_BORDER };
+  for (int i = 0; i < height; ++i) {
+    resize_horz_multistep(input + in_stride * i, width, intbuf + width2 * i,
+                          width2, rows);
+  }
+  for (int j = 0; j < width2; j += block_cols) {
+    resize_vert_multistep(intbuf + j, width2, height, output + j, out_stride,
+                          height2, AOMMIN(block_cols, width2 - j), tmpbuf);
   }
 
 Error:
   aom_free(intbuf);
+  aom_free(rowbuf);
   aom_free(tmpbuf);
-  aom_free(arrbuf);
-  aom_free(arrbuf2);
 }
 
 void av1_upscale_plane_double_prec(const double *const input, int height,
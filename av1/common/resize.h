@@ -108,6 +108,10 @@ extern const int16_t av1_resize_filter_normative[1 << RS_SUBPEL_BITS]
 
 int32_t av1_get_upscale_convolve_step(int in_length, int out_length);
 
+// The number of pixels by which the rows are extended on each side before the
+// horizontal resize filters are applied to them.
+#define RESIZE_HORZ_BORDER 32
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
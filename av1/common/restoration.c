@@ -10,6 +10,7 @@
  *
  */
 
+#include <limits.h>
 #include <math.h>
 
 #include "config/aom_config.h"
@@ -135,42 +136,52 @@ void av1_loop_restoration_precal() {
 }
 
 static void extend_frame_lowbd(uint8_t *data, int width, int height, int stride,
-                               int border_horz, int border_vert) {
+                               int border_horz, int border_vert, int row_start,
+                               int row_end) {
   uint8_t *data_p;
   int i;
-  for (i = 0; i < height; ++i) {
+  for (i = row_start; i < row_end; ++i) {
     data_p = data + i * stride;
     memset(data_p - border_horz, data_p[0], border_horz);
     memset(data_p + width, data_p[width - 1], border_horz);
   }
   data_p = data - border_horz;
-  for (i = -border_vert; i < 0; ++i) {
-    memcpy(data_p + i * stride, data_p, width + 2 * border_horz);
+  if (row_start == 0) {
+    for (i = -border_vert; i < 0; ++i) {
+      memcpy(data_p + i * stride, data_p, width + 2 * border_horz);
+    }
   }
-  for (i = height; i < height + border_vert; ++i) {
-    memcpy(data_p + i * stride, data_p + (height - 1) * stride,
-           width + 2 * border_horz);
+  if (row_end == height) {
+    for (i = height; i < height + border_vert; ++i) {
+      memcpy(data_p + i * stride, data_p + (height - 1) * stride,
+             width + 2 * border_horz);
+    }
   }
 }
 
 #if CONFIG_AV1_HIGHBITDEPTH
 static void extend_frame_highbd(uint16_t *data, int width, int height,
-                                int stride, int border_horz, int border_vert) {
+                                int stride, int border_horz, int border_vert,
+                                int row_start, int row_end) {
   uint16_t *data_p;
   int i, j;
-  for (i = 0; i < height; ++i) {
+  for (i = row_start; i < row_end; ++i) {
     data_p = data + i * stride;
     for (j = -border_horz; j < 0; ++j) data_p[j] = data_p[0];
     for (j = width; j < width + border_horz; ++j) data_p[j] = data_p[width - 1];
   }
   data_p = data - border_horz;
-  for (i = -border_vert; i < 0; ++i) {
-    memcpy(data_p + i * stride, data_p,
-           (width + 2 * border_horz) * sizeof(uint16_t));
+  if (row_start == 0) {
+    for (i = -border_vert; i < 0; ++i) {
+      memcpy(data_p + i * stride, data_p,
+             (width + 2 * border_horz) * sizeof(uint16_t));
+    }
   }
-  for (i = height; i < height + border_vert; ++i) {
-    memcpy(data_p + i * stride, data_p + (height - 1) * stride,
-           (width + 2 * border_horz) * sizeof(uint16_t));
+  if (row_end == height) {
+    for (i = height; i < height + border_vert; ++i) {
+      memcpy(data_p + i * stride, data_p + (height - 1) * stride,
+             (width + 2 * border_horz) * sizeof(uint16_t));
+    }
   }
 }
 
@@ -181,17 +192,25 @@ static void copy_tile_highbd(int width, int height, const uint16_t *src,
 }
 #endif
 
-void av1_extend_frame(uint8_t *data, int width, int height, int stride,
-                      int border_horz, int border_vert, int highbd) {
+void av1_extend_frame_rows(uint8_t *data, int width, int height, int stride,
+                           int border_horz, int border_vert, int row_start,
+                           int row_end, int highbd) {
 #if CONFIG_AV1_HIGHBITDEPTH
   if (highbd) {
     extend_frame_highbd(CONVERT_TO_SHORTPTR(data), width, height, stride,
-                        border_horz, border_vert);
+                        border_horz, border_vert, row_start, row_end);
     return;
   }
 #endif
   (void)highbd;
-  extend_frame_lowbd(data, width, height, stride, border_horz, border_vert);
+  extend_frame_lowbd(data, width, height, stride, border_horz, border_vert,
+                     row_start, row_end);
+}
+
+void av1_extend_frame(uint8_t *data, int width, int height, int stride,
+                      int border_horz, int border_vert, int highbd) {
+  av1_extend_frame_rows(data, width, height, stride, border_horz, border_vert,
+                        0, height, highbd);
 }
 
 static void copy_tile_lowbd(int width, int height, const uint8_t *src,
@@ -1106,7 +1125,7 @@ static void filter_frame_on_unit(const RestorationTileLimits *limits,
 void av1_loop_restoration_filter_frame_init(AV1LrStruct *lr_ctxt,
                                             YV12_BUFFER_CONFIG *frame,
                                             AV1_COMMON *cm, int optimized_lr,
-                                            int num_planes) {
+                                            int num_planes, int extend) {
   const SequenceHeader *const seq_params = &cm->seq_params;
   const int bit_depth = seq_params->bit_depth;
   const int highbd = seq_params->use_highbitdepth;
@@ -1137,9 +1156,11 @@ void av1_loop_restoration_filter_frame_init(AV1LrStruct *lr_ctxt,
     const int plane_height = frame->crop_heights[is_uv];
     FilterFrameCtxt *lr_plane_ctxt = &lr_ctxt->ctxt[plane];
 
-    av1_extend_frame(frame->buffers[plane], plane_width, plane_height,
-                     frame->strides[is_uv], RESTORATION_BORDER,
-                     RESTORATION_BORDER, highbd);
+    if (extend) {
+      av1_extend_frame(frame->buffers[plane], plane_width, plane_height,
+                       frame->strides[is_uv], RESTORATION_BORDER,
+                       RESTORATION_BORDER, highbd);
+    }
 
     lr_plane_ctxt->rsi = rsi;
     lr_plane_ctxt->ss_x = is_uv && seq_params->subsampling_x;
@@ -1196,7 +1217,7 @@ void av1_loop_restoration_filter_frame(YV12_BUFFER_CONFIG *frame,
   AV1LrStruct *loop_rest_ctxt = (AV1LrStruct *)lr_ctxt;
 
   av1_loop_restoration_filter_frame_init(loop_rest_ctxt, frame, cm,
-                                         optimized_lr, num_planes);
+                                         optimized_lr, num_planes, 1);
 
   foreach_rest_unit_in_planes(loop_rest_ctxt, cm, num_planes);
 
@@ -1209,7 +1230,7 @@ void av1_foreach_rest_unit_in_row(
     int unit_idx0, int hunits_per_tile, int vunits_per_tile, int plane,
     void *priv, int32_t *tmpbuf, RestorationLineBuffers *rlbs,
     sync_read_fn_t on_sync_read, sync_write_fn_t on_sync_write,
-    struct AV1LrSyncData *const lr_sync) {
+    void *const lr_sync) {
   const int tile_w = tile_rect->right - tile_rect->left;
   const int ext_size = unit_size * 3 / 2;
   int x0 = 0, j = 0;
@@ -1490,9 +1511,12 @@ static void save_cdef_boundary_lines(const YV12_BUFFER_CONFIG *frame,
                RESTORATION_EXTRA_HORZ, use_highbd);
 }
 
+// Only the stripe boundaries which lie in luma rows [row_start, row_end) are
+// saved.
 static void save_tile_row_boundary_lines(const YV12_BUFFER_CONFIG *frame,
                                          int use_highbd, int plane,
-                                         AV1_COMMON *cm, int after_cdef) {
+                                         AV1_COMMON *cm, int after_cdef,
+                                         int row_start, int row_end) {
   const int is_uv = plane > 0;
   const int ss_y = is_uv && cm->seq_params.subsampling_y;
   const int stripe_height = RESTORATION_PROC_UNIT_SIZE >> ss_y;
@@ -1523,14 +1547,18 @@ static void save_tile_row_boundary_lines(const YV12_BUFFER_CONFIG *frame,
     // can use deblocked pixels from adjacent tiles for context.
     const int use_deblock_above = (frame_stripe > 0);
     const int use_deblock_below = (y1 < plane_height);
+    const int above_in_range =
+        (y0 << ss_y) >= row_start && (y0 << ss_y) < row_end;
+    const int below_in_range =
+        (y1 << ss_y) >= row_start && (y1 << ss_y) < row_end;
 
     if (!after_cdef) {
       // Save deblocked context where needed.
-      if (use_deblock_above) {
+      if (use_deblock_above && above_in_range) {
         save_deblock_boundary_lines(frame, cm, plane, y0 - RESTORATION_CTX_VERT,
                                     frame_stripe, use_highbd, 1, boundaries);
       }
-      if (use_deblock_below) {
+      if (use_deblock_below && below_in_range) {
         save_deblock_boundary_lines(frame, cm, plane, y1, frame_stripe,
                                     use_highbd, 0, boundaries);
       }
@@ -1541,11 +1569,11 @@ static void save_tile_row_boundary_lines(const YV12_BUFFER_CONFIG *frame,
       //
       // In addition, we need to save copies of the outermost line within
       // the tile, rather than using data from outside the tile.
-      if (!use_deblock_above) {
+      if (!use_deblock_above && above_in_range) {
         save_cdef_boundary_lines(frame, cm, plane, y0, frame_stripe, use_highbd,
                                  1, boundaries);
       }
-      if (!use_deblock_below) {
+      if (!use_deblock_below && below_in_range) {
         save_cdef_boundary_lines(frame, cm, plane, y1 - 1, frame_stripe,
                                  use_highbd, 0, boundaries);
       }
@@ -1561,6 +1589,21 @@ void av1_loop_restoration_save_boundary_lines(const YV12_BUFFER_CONFIG *frame,
   const int num_planes = av1_num_planes(cm);
   const int use_highbd = cm->seq_params.use_highbitdepth;
   for (int p = 0; p < num_planes; ++p) {
-    save_tile_row_boundary_lines(frame, use_highbd, p, cm, after_cdef);
+    save_tile_row_boundary_lines(frame, use_highbd, p, cm, after_cdef, 0,
+                                 INT_MAX);
+  }
+}
+
+// Same as av1_loop_restoration_save_boundary_lines(), but only saves the
+// lines of the stripe boundaries which lie in luma rows [row_start, row_end).
+// This allows the boundaries to be saved as the frame is being filtered.
+void av1_loop_restoration_save_boundary_lines_range(
+    const YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm, int after_cdef,
+    int row_start, int row_end) {
+  const int num_planes = av1_num_planes(cm);
+  const int use_highbd = cm->seq_params.use_highbitdepth;
+  for (int p = 0; p < num_planes; ++p) {
+    save_tile_row_boundary_lines(frame, use_highbd, p, cm, after_cdef,
+                                 row_start, row_end);
   }
 }
@@ -9,13 +9,19 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <assert.h>
+#include <limits.h>
+
 #include "config/aom_config.h"
 #include "config/aom_scale_rtcd.h"
 
 #include "aom_dsp/aom_dsp_common.h"
 #include "aom_mem/aom_mem.h"
 #include "av1/common/av1_loopfilter.h"
+#include "av1/common/cdef.h"
 #include "av1/common/entropymode.h"
+#include "av1/common/resize.h"
+#include "av1/common/restoration.h"
 #include "av1/common/thread_common.h"
 #include "av1/common/reconinter.h"
 
@@ -57,44 +63,43 @@ static void loop_filter_alloc(AV1LfSync *lf_sync, AV1_COMMON *cm, int rows,
   lf_sync->rows = rows;
 #if CONFIG_MULTITHREAD
   {
-    int i, j;
-
-    for (j = 0; j < MAX_MB_PLANE; j++) {
-      CHECK_MEM_ERROR(cm, lf_sync->mutex_[j],
-                      aom_malloc(sizeof(*(lf_sync->mutex_[j])) * rows));
-      if (lf_sync->mutex_[j]) {
-        for (i = 0; i < rows; ++i) {
-          pthread_mutex_init(&lf_sync->mutex_[j][i], NULL);
-        }
-      }
-
-      CHECK_MEM_ERROR(cm, lf_sync->cond_[j],
-                      aom_malloc(sizeof(*(lf_sync->cond_[j])) * rows));
-      if (lf_sync->cond_[j]) {
-        for (i = 0; i < rows; ++i) {
-          pthread_cond_init(&lf_sync->cond_[j][i], NULL);
-        }
-      }
-    }
-
     CHECK_MEM_ERROR(cm, lf_sync->job_mutex,
                     aom_malloc(sizeof(*(lf_sync->job_mutex))));
     if (lf_sync->job_mutex) {
       pthread_mutex_init(lf_sync->job_mutex, NULL);
     }
+
+    CHECK_MEM_ERROR(cm, lf_sync->pipeline_cond,
+                    aom_malloc(sizeof(*(lf_sync->pipeline_cond))));
+    if (lf_sync->pipeline_cond) {
+      pthread_cond_init(lf_sync->pipeline_cond, NULL);
+    }
   }
 #endif  // CONFIG_MULTITHREAD
   CHECK_MEM_ERROR(cm, lf_sync->lfdata,
                   aom_malloc(num_workers * sizeof(*(lf_sync->lfdata))));
   lf_sync->num_workers = num_workers;
+  if (aom_job_scheduler_alloc(&lf_sync->job_sched, num_workers))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate loop filter job scheduler");
 
   for (int j = 0; j < MAX_MB_PLANE; j++) {
-    CHECK_MEM_ERROR(cm, lf_sync->cur_sb_col[j],
-                    aom_malloc(sizeof(*(lf_sync->cur_sb_col[j])) * rows));
+    if (aom_row_sync_alloc(&lf_sync->cur_sb_col[j], rows))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate loop filter row synchronization");
   }
-  CHECK_MEM_ERROR(
-      cm, lf_sync->job_queue,
-      aom_malloc(sizeof(*(lf_sync->job_queue)) * rows * MAX_MB_PLANE * 2));
+  // Room for the deblocking jobs of each row and plane, plus the two CDEF
+  // filter block rows per row of the deblocking -> CDEF pipeline, and as many
+  // loop restoration unit rows per plane.
+  CHECK_MEM_ERROR(cm, lf_sync->job_queue,
+                  aom_malloc(sizeof(*(lf_sync->job_queue)) * rows *
+                             (MAX_MB_PLANE * 4 + 2)));
+  CHECK_MEM_ERROR(cm, lf_sync->horz_planes_done,
+                  aom_malloc(sizeof(*(lf_sync->horz_planes_done)) * rows));
+  CHECK_MEM_ERROR(cm, lf_sync->cdef_row_done,
+                  aom_malloc(sizeof(*(lf_sync->cdef_row_done)) * rows * 2));
+  CHECK_MEM_ERROR(cm, lf_sync->cdef_lb,
+                  aom_calloc(1, sizeof(*(lf_sync->cdef_lb))));
   // Set up nsync.
   lf_sync->sync_range = get_sync_range(width);
 }
@@ -104,32 +109,25 @@ void av1_loop_filter_dealloc(AV1LfSync *lf_sync) {
   if (lf_sync != NULL) {
     int j;
 #if CONFIG_MULTITHREAD
-    int i;
-    for (j = 0; j < MAX_MB_PLANE; j++) {
-      if (lf_sync->mutex_[j] != NULL) {
-        for (i = 0; i < lf_sync->rows; ++i) {
-          pthread_mutex_destroy(&lf_sync->mutex_[j][i]);
-        }
-        aom_free(lf_sync->mutex_[j]);
-      }
-      if (lf_sync->cond_[j] != NULL) {
-        for (i = 0; i < lf_sync->rows; ++i) {
-          pthread_cond_destroy(&lf_sync->cond_[j][i]);
-        }
-        aom_free(lf_sync->cond_[j]);
-      }
-    }
     if (lf_sync->job_mutex != NULL) {
       pthread_mutex_destroy(lf_sync->job_mutex);
       aom_free(lf_sync->job_mutex);
     }
+    if (lf_sync->pipeline_cond != NULL) {
+      pthread_cond_destroy(lf_sync->pipeline_cond);
+      aom_free(lf_sync->pipeline_cond);
+    }
 #endif  // CONFIG_MULTITHREAD
     aom_free(lf_sync->lfdata);
     for (j = 0; j < MAX_MB_PLANE; j++) {
-      aom_free(lf_sync->cur_sb_col[j]);
+      aom_row_sync_free(&lf_sync->cur_sb_col[j]);
     }
 
     aom_free(lf_sync->job_queue);
+    aom_job_scheduler_free(&lf_sync->job_sched);
+    aom_free(lf_sync->horz_planes_done);
+    aom_free(lf_sync->cdef_row_done);
+    aom_free(lf_sync->cdef_lb);
     // clear the structure as the source of this call may be a resize in which
     // case this call will be followed by an _alloc() which may fail.
     av1_zero(*lf_sync);
@@ -155,15 +153,8 @@ static INLINE void sync_read(AV1LfSync *const lf_sync, int r, int c,
 #if CONFIG_MULTITHREAD
   const int nsync = lf_sync->sync_range;
 
-  if (r && !(c & (nsync - 1))) {
-    pthread_mutex_t *const mutex = &lf_sync->mutex_[plane][r - 1];
-    pthread_mutex_lock(mutex);
-
-    while (c > lf_sync->cur_sb_col[plane][r - 1] - nsync) {
-      pthread_cond_wait(&lf_sync->cond_[plane][r - 1], mutex);
-    }
-    pthread_mutex_unlock(mutex);
-  }
+  if (r && !(c & (nsync - 1)))
+    aom_row_sync_wait(&lf_sync->cur_sb_col[plane], r - 1, c + nsync);
 #else
   (void)lf_sync;
   (void)r;
@@ -187,14 +178,7 @@ static INLINE void sync_write(AV1LfSync *const lf_sync, int r, int c,
     cur = sb_cols + nsync;
   }
 
-  if (sig) {
-    pthread_mutex_lock(&lf_sync->mutex_[plane][r]);
-
-    lf_sync->cur_sb_col[plane][r] = cur;
-
-    pthread_cond_broadcast(&lf_sync->cond_[plane][r]);
-    pthread_mutex_unlock(&lf_sync->mutex_[plane][r]);
-  }
+  if (sig) aom_row_sync_set(&lf_sync->cur_sb_col[plane], r, cur);
 #else
   (void)lf_sync;
   (void)r;
@@ -213,7 +197,6 @@ static void enqueue_lf_jobs(AV1LfSync *lf_sync, AV1_COMMON *cm, int start,
   int mi_row, plane, dir;
   AV1LfMTInfo *lf_job_queue = lf_sync->job_queue;
   lf_sync->jobs_enqueued = 0;
-  lf_sync->jobs_dequeued = 0;
 
   for (dir = 0; dir < 2; dir++) {
     for (plane = plane_start; plane < plane_end; plane++) {
@@ -243,30 +226,128 @@ static void enqueue_lf_jobs(AV1LfSync *lf_sync, AV1_COMMON *cm, int start,
   }
 }
 
-static AV1LfMTInfo *get_lf_job_info(AV1LfSync *lf_sync) {
-  AV1LfMTInfo *cur_job_info = NULL;
+static AV1LfMTInfo *get_lf_job_info(AV1LfSync *lf_sync, int worker_idx) {
+  const int job = aom_job_scheduler_get_job(&lf_sync->job_sched, worker_idx);
+  return job >= 0 ? lf_sync->job_queue + job : NULL;
+}
+
+// Returns the last deblocking row which touches pixels that CDEF filter block
+// row 'fbr' reads or writes. Horizontal edges read up to 8 luma rows above
+// them, and the CDEF borders extend up to 2 * CDEF_VBORDER luma rows below
+// the filter block row.
+static INLINE int cdef_last_lf_row(int fbr, int sb_rows) {
+  const int y_end = ((fbr + 1) * MI_SIZE_64X64 << MI_SIZE_LOG2) +
+                    2 * CDEF_VBORDER + 8;
+  return AOMMIN((y_end - 1) >> (MAX_MIB_SIZE_LOG2 + MI_SIZE_LOG2),
+                sb_rows - 1);
+}
 
+// Waits until superblock row r may be deblocked. Returns 0 if the pipeline
+// was aborted, in which case the row is not filtered.
+static int lf_pipeline_wait_src(AV1LfSync *const lf_sync, int r) {
+  int ready;
 #if CONFIG_MULTITHREAD
   pthread_mutex_lock(lf_sync->job_mutex);
+  while (lf_sync->src_rows_ready <= r && !lf_sync->pipeline_exit) {
+    pthread_cond_wait(lf_sync->pipeline_cond, lf_sync->job_mutex);
+  }
+#endif
+  ready = lf_sync->src_rows_ready > r && !lf_sync->pipeline_exit;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+  return ready;
+}
 
-  if (lf_sync->jobs_dequeued < lf_sync->jobs_enqueued) {
-    cur_job_info = lf_sync->job_queue + lf_sync->jobs_dequeued;
-    lf_sync->jobs_dequeued++;
+static void lf_pipeline_row_done(AV1LfSync *const lf_sync, int r) {
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(lf_sync->job_mutex);
+#endif
+  lf_sync->horz_planes_done[r]++;
+  while (lf_sync->rows_deblocked < lf_sync->rows &&
+         lf_sync->horz_planes_done[lf_sync->rows_deblocked] ==
+             lf_sync->num_lf_planes) {
+    lf_sync->rows_deblocked++;
   }
+#if CONFIG_MULTITHREAD
+  pthread_cond_broadcast(lf_sync->pipeline_cond);
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+}
 
+static void cdef_pipeline_row(AV1LfSync *const lf_sync,
+                              const YV12_BUFFER_CONFIG *const frame_buffer,
+                              AV1_COMMON *const cm, const MACROBLOCKD *xd,
+                              int fbr) {
+  const CdefLineBufs *const lb = lf_sync->cdef_lb;
+  const int last_lf_row = cdef_last_lf_row(fbr, lf_sync->rows);
+  const int fb_height = MI_SIZE_64X64 << MI_SIZE_LOG2;
+  const int row_start = fbr * fb_height;
+  const int row_end = fbr + 1 < lb->nvfb ? (fbr + 1) * fb_height : INT_MAX;
+  int ready;
+#if CONFIG_MULTITHREAD
+  // Wait for the deblocking to be done, and for the previous row to save the
+  // boundary lines above this one.
+  pthread_mutex_lock(lf_sync->job_mutex);
+  while ((lf_sync->rows_deblocked <= last_lf_row ||
+          lf_sync->cdef_rows_ready < fbr) &&
+         !lf_sync->pipeline_exit) {
+    pthread_cond_wait(lf_sync->pipeline_cond, lf_sync->job_mutex);
+  }
+#endif
+  ready = lf_sync->rows_deblocked > last_lf_row &&
+          lf_sync->cdef_rows_ready >= fbr;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+  if (!ready) return;
+
+  // Save the lines this row is about to overwrite which are needed by the
+  // next row and by loop restoration, then let the next row start.
+  if (fbr + 1 < lb->nvfb) av1_cdef_save_boundary_lines(cm, xd, lb, fbr + 1);
+  if (lf_sync->save_lr_lines) {
+    av1_loop_restoration_save_boundary_lines_range(frame_buffer, cm, 0,
+                                                   row_start, row_end);
+  }
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(lf_sync->job_mutex);
+#endif
+  lf_sync->cdef_rows_ready = fbr + 1;
+#if CONFIG_MULTITHREAD
+  pthread_cond_broadcast(lf_sync->pipeline_cond);
   pthread_mutex_unlock(lf_sync->job_mutex);
-#else
-  (void)lf_sync;
 #endif
 
-  return cur_job_info;
+  av1_cdef_fb_row(cm, xd, lb, fbr);
+
+  if (lf_sync->lr_sync) {
+    // Without superres, the CDEF output is the loop restoration context at
+    // the top and the bottom of the frame.
+    av1_loop_restoration_save_boundary_lines_range(frame_buffer, cm, 1,
+                                                   row_start, row_end);
+#if CONFIG_MULTITHREAD
+    pthread_mutex_lock(lf_sync->job_mutex);
+#endif
+    lf_sync->cdef_row_done[fbr] = 1;
+    while (lf_sync->cdef_rows_done < lb->nvfb &&
+           lf_sync->cdef_row_done[lf_sync->cdef_rows_done]) {
+      lf_sync->cdef_rows_done++;
+    }
+#if CONFIG_MULTITHREAD
+    pthread_cond_broadcast(lf_sync->pipeline_cond);
+    pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+  }
 }
 
+static void lr_pipeline_row(AV1LfSync *const lf_sync, int lr_job,
+                            int worker_idx);
+
 // Implement row loopfiltering for each thread.
 static INLINE void thread_loop_filter_rows(
     const YV12_BUFFER_CONFIG *const frame_buffer, AV1_COMMON *const cm,
     struct macroblockd_plane *planes, MACROBLOCKD *xd,
-    AV1LfSync *const lf_sync) {
+    AV1LfSync *const lf_sync, int worker_idx) {
   const int sb_cols =
       ALIGN_POWER_OF_TWO(cm->mi_params.mi_cols, MAX_MIB_SIZE_LOG2) >>
       MAX_MIB_SIZE_LOG2;
@@ -274,7 +355,7 @@ static INLINE void thread_loop_filter_rows(
   int r, c;
 
   while (1) {
-    AV1LfMTInfo *cur_job_info = get_lf_job_info(lf_sync);
+    AV1LfMTInfo *cur_job_info = get_lf_job_info(lf_sync, worker_idx);
 
     if (cur_job_info != NULL) {
       mi_row = cur_job_info->mi_row;
@@ -283,6 +364,11 @@ static INLINE void thread_loop_filter_rows(
       r = mi_row >> MAX_MIB_SIZE_LOG2;
 
       if (dir == 0) {
+        if (lf_sync->pipelined && !lf_pipeline_wait_src(lf_sync, r)) {
+          // Release the jobs waiting for this row.
+          sync_write(lf_sync, r, sb_cols - 1, sb_cols, plane);
+          continue;
+        }
         for (mi_col = 0; mi_col < cm->mi_params.mi_cols;
              mi_col += MAX_MIB_SIZE) {
           c = mi_col >> MAX_MIB_SIZE_LOG2;
@@ -295,23 +381,31 @@ static INLINE void thread_loop_filter_rows(
           sync_write(lf_sync, r, c, sb_cols, plane);
         }
       } else if (dir == 1) {
-        for (mi_col = 0; mi_col < cm->mi_params.mi_cols;
-             mi_col += MAX_MIB_SIZE) {
-          c = mi_col >> MAX_MIB_SIZE_LOG2;
-
-          // Wait for vertical edge filtering of the top-right block to be
-          // completed
-          sync_read(lf_sync, r, c, plane);
-
-          // Wait for vertical edge filtering of the right block to be
-          // completed
-          sync_read(lf_sync, r + 1, c, plane);
-
-          av1_setup_dst_planes(planes, cm->seq_params.sb_size, frame_buffer,
-                               mi_row, mi_col, plane, plane + 1);
-          av1_filter_block_plane_horz(cm, xd, plane, &planes[plane], mi_row,
-                                      mi_col);
+        if (!lf_sync->pipelined || lf_pipeline_wait_src(lf_sync, r)) {
+          for (mi_col = 0; mi_col < cm->mi_params.mi_cols;
+               mi_col += MAX_MIB_SIZE) {
+            c = mi_col >> MAX_MIB_SIZE_LOG2;
+
+            // Wait for vertical edge filtering of the top-right block to be
+            // completed
+            sync_read(lf_sync, r, c, plane);
+
+            // Wait for vertical edge filtering of the right block to be
+            // completed
+            sync_read(lf_sync, r + 1, c, plane);
+
+            av1_setup_dst_planes(planes, cm->seq_params.sb_size, frame_buffer,
+                                 mi_row, mi_col, plane, plane + 1);
+            av1_filter_block_plane_horz(cm, xd, plane, &planes[plane], mi_row,
+                                        mi_col);
+          }
         }
+        if (lf_sync->pipelined) lf_pipeline_row_done(lf_sync, r);
+      } else if (dir == 2) {
+        cdef_pipeline_row(lf_sync, frame_buffer, cm, xd,
+                          mi_row / MI_SIZE_64X64);
+      } else {
+        lr_pipeline_row(lf_sync, cur_job_info->lr_job, worker_idx);
       }
     } else {
       break;
@@ -324,7 +418,8 @@ static int loop_filter_row_worker(void *arg1, void *arg2) {
   AV1LfSync *const lf_sync = (AV1LfSync *)arg1;
   LFWorkerData *const lf_data = (LFWorkerData *)arg2;
   thread_loop_filter_rows(lf_data->frame_buffer, lf_data->cm, lf_data->planes,
-                          lf_data->xd, lf_sync);
+                          lf_data->xd, lf_sync,
+                          (int)(lf_data - lf_sync->lfdata));
   return 1;
 }
 
@@ -332,7 +427,7 @@ static int loop_filter_row_worker(void *arg1, void *arg2) {
 static INLINE void thread_loop_filter_bitmask_rows(
     const YV12_BUFFER_CONFIG *const frame_buffer, AV1_COMMON *const cm,
     struct macroblockd_plane *planes, MACROBLOCKD *xd,
-    AV1LfSync *const lf_sync) {
+    AV1LfSync *const lf_sync, int worker_idx) {
   const int sb_cols =
       ALIGN_POWER_OF_TWO(cm->mi_params.mi_cols, MIN_MIB_SIZE_LOG2) >>
       MIN_MIB_SIZE_LOG2;
@@ -341,7 +436,7 @@ static INLINE void thread_loop_filter_bitmask_rows(
   (void)xd;
 
   while (1) {
-    AV1LfMTInfo *cur_job_info = get_lf_job_info(lf_sync);
+    AV1LfMTInfo *cur_job_info = get_lf_job_info(lf_sync, worker_idx);
 
     if (cur_job_info != NULL) {
       mi_row = cur_job_info->mi_row;
@@ -391,7 +486,8 @@ static int loop_filter_bitmask_row_worker(void *arg1, void *arg2) {
   AV1LfSync *const lf_sync = (AV1LfSync *)arg1;
   LFWorkerData *const lf_data = (LFWorkerData *)arg2;
   thread_loop_filter_bitmask_rows(lf_data->frame_buffer, lf_data->cm,
-                                  lf_data->planes, lf_data->xd, lf_sync);
+                                  lf_data->planes, lf_data->xd, lf_sync,
+                                  (int)(lf_data - lf_sync->lfdata));
   return 1;
 }
 #endif  // CONFIG_LPF_MASK
@@ -431,8 +527,7 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
 
   // Initialize cur_sb_col to -1 for all SB rows.
   for (i = 0; i < MAX_MB_PLANE; i++) {
-    memset(lf_sync->cur_sb_col[i], -1,
-           sizeof(*(lf_sync->cur_sb_col[i])) * sb_rows);
+    aom_row_sync_reset(&lf_sync->cur_sb_col[i], -1);
   }
 
   enqueue_lf_jobs(lf_sync, cm, start, stop,
@@ -440,6 +535,8 @@ static void loop_filter_rows_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
                   is_decoding,
 #endif
                   plane_start, plane_end);
+  aom_job_scheduler_reset(&lf_sync->job_sched, lf_sync->jobs_enqueued,
+                          num_workers);
 
   // Set up loopfilter thread data.
   for (i = 0; i < num_workers; ++i) {
@@ -528,20 +625,257 @@ void av1_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
 #endif
 }
 
-static INLINE void lr_sync_read(void *const lr_sync, int r, int c, int plane) {
+static int lr_pipeline_job_ready(const AV1LfSync *lf_sync,
+                                 const AV1LrMTInfo *job, int cdef_rows,
+                                 const int *rows_done);
+
+// Queues the deblocking jobs of each row right after the vertical edge jobs
+// of the row below it, each CDEF filter block row right after the last
+// deblocking job it depends on, and each loop restoration unit row right
+// after the last CDEF row and unit rows it depends on. A job only ever waits
+// for jobs queued before it (or for the source), so the pipeline cannot
+// deadlock regardless of the number of workers.
+static void enqueue_lf_cdef_jobs(AV1LfSync *lf_sync, AV1_COMMON *cm,
+                                 int sb_rows, int nvfb) {
+  const int num_planes = av1_num_planes(cm);
+  const int lf_plane_enabled[MAX_MB_PLANE] = { 1, cm->lf.filter_level_u != 0,
+                                               cm->lf.filter_level_v != 0 };
+  AV1LrSync *const lr_sync = lf_sync->lr_sync;
+  AV1LfMTInfo *lf_job_queue = lf_sync->job_queue;
+  int fbr = 0;
+  lf_sync->jobs_enqueued = 0;
+
+  for (int r = 0; r <= sb_rows; r++) {
+    for (int dir = 0; dir < 2; dir++) {
+      // Vertical edges of row r, then horizontal edges of row r - 1.
+      const int row = r - dir;
+      if (row < 0 || row >= sb_rows) continue;
+      for (int plane = 0; plane < num_planes; plane++) {
+        if (!lf_plane_enabled[plane]) continue;
+        lf_job_queue->mi_row = row << MAX_MIB_SIZE_LOG2;
+        lf_job_queue->plane = plane;
+        lf_job_queue->dir = dir;
+        lf_job_queue++;
+        lf_sync->jobs_enqueued++;
+      }
+    }
+    while (fbr < nvfb && r > 0 && cdef_last_lf_row(fbr, sb_rows) <= r - 1) {
+      lf_job_queue->mi_row = fbr * MI_SIZE_64X64;
+      lf_job_queue->plane = 0;
+      lf_job_queue->dir = 2;
+      lf_job_queue++;
+      lf_sync->jobs_enqueued++;
+      fbr++;
+
+      // While the jobs are queued, lr_sync->rows_done flags the queued unit
+      // rows. The even rows come first in lr_sync->job_queue, so an odd row
+      // is queued in the same pass as the last of the rows next to it.
+      for (int j = 0; lr_sync && j < lr_sync->jobs_enqueued; j++) {
+        const AV1LrMTInfo *const lr_job_info = &lr_sync->job_queue[j];
+        int *const queued = &lr_sync->rows_done[lr_job_info->plane *
+                                                    lr_sync->rows +
+                                                lr_job_info->lr_unit_row];
+        if (*queued ||
+            !lr_pipeline_job_ready(lf_sync, lr_job_info, fbr,
+                                   lr_sync->rows_done))
+          continue;
+        *queued = 1;
+        lf_job_queue->mi_row = 0;
+        lf_job_queue->plane = lr_job_info->plane;
+        lf_job_queue->dir = 3;
+        lf_job_queue->lr_job = j;
+        lf_job_queue++;
+        lf_sync->jobs_enqueued++;
+      }
+    }
+  }
+  assert(fbr == nvfb);
+  assert(lf_sync->jobs_enqueued <= sb_rows * (MAX_MB_PLANE * 4 + 2));
+  if (lr_sync) {
+    memset(lr_sync->rows_done, 0,
+           sizeof(*(lr_sync->rows_done)) * lr_sync->rows * lr_sync->num_planes);
+  }
+}
+
+static void loop_restoration_sync_init(AV1LrStruct *lr_ctxt, int num_workers,
+                                       AV1LrSync *lr_sync, AV1_COMMON *cm);
+
+void av1_lf_pipeline_init(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                          MACROBLOCKD *xd, int do_cdef, int save_lr_lines,
+                          AV1LrSync *lr_sync, void *lr_ctxt, int src_rows,
+                          int num_workers, AV1LfSync *lf_sync) {
+  const int num_planes = av1_num_planes(cm);
+  const int sb_rows =
+      ALIGN_POWER_OF_TWO(cm->mi_params.mi_rows, MAX_MIB_SIZE_LOG2) >>
+      MAX_MIB_SIZE_LOG2;
+  int i;
+
+  assert(cm->lf.filter_level[0] || cm->lf.filter_level[1]);
+  av1_loop_filter_frame_init(cm, 0, num_planes);
+
+  if (!lf_sync->sync_range || sb_rows != lf_sync->rows ||
+      num_workers > lf_sync->num_workers) {
+    av1_loop_filter_dealloc(lf_sync);
+    loop_filter_alloc(lf_sync, cm, sb_rows, cm->width, num_workers);
+  }
+
+  // Initialize cur_sb_col to -1 for all SB rows.
+  for (i = 0; i < MAX_MB_PLANE; i++) {
+    aom_row_sync_reset(&lf_sync->cur_sb_col[i], -1);
+  }
+  memset(lf_sync->horz_planes_done, 0,
+         sizeof(*(lf_sync->horz_planes_done)) * sb_rows);
+  lf_sync->num_lf_planes = 1;
+  if (num_planes > 1) {
+    lf_sync->num_lf_planes +=
+        (cm->lf.filter_level_u != 0) + (cm->lf.filter_level_v != 0);
+  }
+  lf_sync->pipelined = 1;
+  lf_sync->src_rows_ready = src_rows;
+  lf_sync->pipeline_exit = 0;
+  lf_sync->rows_deblocked = 0;
+  lf_sync->cdef_rows_ready = 0;
+  lf_sync->cdef_rows_done = 0;
+  lf_sync->do_cdef = do_cdef;
+  lf_sync->save_lr_lines = save_lr_lines;
+  lf_sync->lr_sync = lr_sync;
+
+  if (do_cdef) {
+    av1_cdef_init_frame(frame, cm, xd, lf_sync->cdef_lb);
+    memset(lf_sync->cdef_row_done, 0,
+           sizeof(*(lf_sync->cdef_row_done)) * lf_sync->cdef_lb->nvfb);
+  } else {
+    lf_sync->cdef_lb->nvfb = 0;
+  }
+  if (lr_sync) {
+    assert(do_cdef && save_lr_lines && !av1_superres_scaled(cm));
+    // CDEF is on, so the stripe boundaries are not optimized away, and each
+    // unit row extends its rows once they are filtered by CDEF.
+    av1_loop_restoration_filter_frame_init((AV1LrStruct *)lr_ctxt, frame, cm,
+                                           0, num_planes, 0);
+    loop_restoration_sync_init((AV1LrStruct *)lr_ctxt, num_workers, lr_sync,
+                               cm);
+  }
+  enqueue_lf_cdef_jobs(lf_sync, cm, sb_rows, lf_sync->cdef_lb->nvfb);
+  aom_job_scheduler_reset(&lf_sync->job_sched, lf_sync->jobs_enqueued,
+                          num_workers);
+
+  for (i = 0; i < num_workers; ++i) {
+    loop_filter_data_reset(&lf_sync->lfdata[i], frame, cm, xd);
+  }
+}
+
+void av1_lf_pipeline_process(AV1LfSync *lf_sync, int worker_idx) {
+  LFWorkerData *const lf_data = &lf_sync->lfdata[worker_idx];
+  assert(lf_sync->pipelined);
+  thread_loop_filter_rows(lf_data->frame_buffer, lf_data->cm, lf_data->planes,
+                          lf_data->xd, lf_sync, worker_idx);
+}
+
+void av1_lf_pipeline_set_src_rows(AV1LfSync *lf_sync, int src_rows) {
 #if CONFIG_MULTITHREAD
-  AV1LrSync *const loop_res_sync = (AV1LrSync *)lr_sync;
-  const int nsync = loop_res_sync->sync_range;
+  pthread_mutex_lock(lf_sync->job_mutex);
+#endif
+  if (src_rows > lf_sync->src_rows_ready) {
+    lf_sync->src_rows_ready = src_rows;
+#if CONFIG_MULTITHREAD
+    pthread_cond_broadcast(lf_sync->pipeline_cond);
+#endif
+  }
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+}
 
-  if (r && !(c & (nsync - 1))) {
-    pthread_mutex_t *const mutex = &loop_res_sync->mutex_[plane][r - 1];
-    pthread_mutex_lock(mutex);
+void av1_lf_pipeline_abort(AV1LfSync *lf_sync) {
+  const AV1_COMMON *const cm = lf_sync->lfdata[0].cm;
+  const int sb_cols =
+      ALIGN_POWER_OF_TWO(cm->mi_params.mi_cols, MAX_MIB_SIZE_LOG2) >>
+      MAX_MIB_SIZE_LOG2;
+  int plane, r;
 
-    while (c > loop_res_sync->cur_sb_col[plane][r - 1] - nsync) {
-      pthread_cond_wait(&loop_res_sync->cond_[plane][r - 1], mutex);
+  aom_job_scheduler_cancel(&lf_sync->job_sched);
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(lf_sync->job_mutex);
+#endif
+  lf_sync->pipeline_exit = 1;
+#if CONFIG_MULTITHREAD
+  pthread_cond_broadcast(lf_sync->pipeline_cond);
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+
+  // The jobs are started out of order, so a horizontal edge job may wait for
+  // the vertical edges of a row whose job was just dropped. Mark all the rows
+  // as filtered. A vertical edge job which is still running ends by doing the
+  // same.
+  for (plane = 0; plane < MAX_MB_PLANE; plane++) {
+    for (r = 0; r < lf_sync->rows; r++) {
+      aom_row_sync_set(&lf_sync->cur_sb_col[plane], r,
+                       sb_cols + lf_sync->sync_range);
     }
-    pthread_mutex_unlock(mutex);
   }
+}
+
+void av1_lf_pipeline_finish(AV1LfSync *lf_sync) {
+  if (lf_sync->do_cdef) av1_cdef_free_frame(lf_sync->cdef_lb);
+  lf_sync->pipelined = 0;
+  lf_sync->pipeline_exit = 0;
+  lf_sync->do_cdef = 0;
+  lf_sync->lr_sync = NULL;
+}
+
+// Deblocking -> CDEF pipeline hook
+static int lf_pipeline_worker(void *arg1, void *arg2) {
+  AV1LfSync *const lf_sync = (AV1LfSync *)arg1;
+  LFWorkerData *const lf_data = (LFWorkerData *)arg2;
+  av1_lf_pipeline_process(lf_sync, (int)(lf_data - lf_sync->lfdata));
+  return 1;
+}
+
+void av1_loop_filter_cdef_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                                   MACROBLOCKD *xd, int save_lr_lines,
+                                   AV1LrSync *lr_sync, void *lr_ctxt,
+                                   AVxWorker *workers, int num_workers,
+                                   AV1LfSync *lf_sync) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  const int sb_rows =
+      ALIGN_POWER_OF_TWO(cm->mi_params.mi_rows, MAX_MIB_SIZE_LOG2) >>
+      MAX_MIB_SIZE_LOG2;
+  int i;
+
+  av1_lf_pipeline_init(frame, cm, xd, 1, save_lr_lines, lr_sync, lr_ctxt,
+                       sb_rows, num_workers, lf_sync);
+
+  for (i = 0; i < num_workers; ++i) {
+    AVxWorker *const worker = &workers[i];
+
+    worker->hook = lf_pipeline_worker;
+    worker->data1 = lf_sync;
+    worker->data2 = &lf_sync->lfdata[i];
+
+    // Start loopfiltering
+    if (i == num_workers - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+
+  // Wait till all rows are finished
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+
+  av1_lf_pipeline_finish(lf_sync);
+}
+
+static INLINE void lr_sync_read(void *const lr_sync, int r, int c, int plane) {
+#if CONFIG_MULTITHREAD
+  AV1LrSync *const loop_res_sync = (AV1LrSync *)lr_sync;
+  const int nsync = loop_res_sync->sync_range;
+
+  if (r && !(c & (nsync - 1)))
+    aom_row_sync_wait(&loop_res_sync->cur_sb_col[plane], r - 1, c + nsync);
 #else
   (void)lr_sync;
   (void)r;
@@ -566,14 +900,7 @@ static INLINE void lr_sync_write(void *const lr_sync, int r, int c,
     cur = sb_cols + nsync;
   }
 
-  if (sig) {
-    pthread_mutex_lock(&loop_res_sync->mutex_[plane][r]);
-
-    loop_res_sync->cur_sb_col[plane][r] = cur;
-
-    pthread_cond_broadcast(&loop_res_sync->cond_[plane][r]);
-    pthread_mutex_unlock(&loop_res_sync->mutex_[plane][r]);
-  }
+  if (sig) aom_row_sync_set(&loop_res_sync->cur_sb_col[plane], r, cur);
 #else
   (void)lr_sync;
   (void)r;
@@ -589,35 +916,6 @@ static void loop_restoration_alloc(AV1LrSync *lr_sync, AV1_COMMON *cm,
                                    int num_planes, int width) {
   lr_sync->rows = num_rows_lr;
   lr_sync->num_planes = num_planes;
-#if CONFIG_MULTITHREAD
-  {
-    int i, j;
-
-    for (j = 0; j < num_planes; j++) {
-      CHECK_MEM_ERROR(cm, lr_sync->mutex_[j],
-                      aom_malloc(sizeof(*(lr_sync->mutex_[j])) * num_rows_lr));
-      if (lr_sync->mutex_[j]) {
-        for (i = 0; i < num_rows_lr; ++i) {
-          pthread_mutex_init(&lr_sync->mutex_[j][i], NULL);
-        }
-      }
-
-      CHECK_MEM_ERROR(cm, lr_sync->cond_[j],
-                      aom_malloc(sizeof(*(lr_sync->cond_[j])) * num_rows_lr));
-      if (lr_sync->cond_[j]) {
-        for (i = 0; i < num_rows_lr; ++i) {
-          pthread_cond_init(&lr_sync->cond_[j][i], NULL);
-        }
-      }
-    }
-
-    CHECK_MEM_ERROR(cm, lr_sync->job_mutex,
-                    aom_malloc(sizeof(*(lr_sync->job_mutex))));
-    if (lr_sync->job_mutex) {
-      pthread_mutex_init(lr_sync->job_mutex, NULL);
-    }
-  }
-#endif  // CONFIG_MULTITHREAD
   CHECK_MEM_ERROR(cm, lr_sync->lrworkerdata,
                   aom_malloc(num_workers * sizeof(*(lr_sync->lrworkerdata))));
 
@@ -635,52 +933,41 @@ static void loop_restoration_alloc(AV1LrSync *lr_sync, AV1_COMMON *cm,
   }
 
   lr_sync->num_workers = num_workers;
+  if (aom_job_scheduler_alloc(&lr_sync->job_sched, num_workers))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate loop restoration job scheduler");
 
   for (int j = 0; j < num_planes; j++) {
-    CHECK_MEM_ERROR(
-        cm, lr_sync->cur_sb_col[j],
-        aom_malloc(sizeof(*(lr_sync->cur_sb_col[j])) * num_rows_lr));
+    if (aom_row_sync_alloc(&lr_sync->cur_sb_col[j], num_rows_lr))
+      aom_internal_error(
+          &cm->error, AOM_CODEC_MEM_ERROR,
+          "Failed to allocate loop restoration row synchronization");
   }
   CHECK_MEM_ERROR(
       cm, lr_sync->job_queue,
       aom_malloc(sizeof(*(lr_sync->job_queue)) * num_rows_lr * num_planes));
+  CHECK_MEM_ERROR(
+      cm, lr_sync->rows_done,
+      aom_malloc(sizeof(*(lr_sync->rows_done)) * num_rows_lr * num_planes));
   // Set up nsync.
   lr_sync->sync_range = get_lr_sync_range(width);
 }
 
 // Deallocate loop restoration synchronization related mutex and data
-void av1_loop_restoration_dealloc(AV1LrSync *lr_sync, int num_workers) {
+void av1_loop_restoration_dealloc(AV1LrSync *lr_sync) {
   if (lr_sync != NULL) {
-    int j;
-#if CONFIG_MULTITHREAD
-    int i;
-    for (j = 0; j < MAX_MB_PLANE; j++) {
-      if (lr_sync->mutex_[j] != NULL) {
-        for (i = 0; i < lr_sync->rows; ++i) {
-          pthread_mutex_destroy(&lr_sync->mutex_[j][i]);
-        }
-        aom_free(lr_sync->mutex_[j]);
-      }
-      if (lr_sync->cond_[j] != NULL) {
-        for (i = 0; i < lr_sync->rows; ++i) {
-          pthread_cond_destroy(&lr_sync->cond_[j][i]);
-        }
-        aom_free(lr_sync->cond_[j]);
-      }
-    }
-    if (lr_sync->job_mutex != NULL) {
-      pthread_mutex_destroy(lr_sync->job_mutex);
-      aom_free(lr_sync->job_mutex);
-    }
-#endif  // CONFIG_MULTITHREAD
-    for (j = 0; j < MAX_MB_PLANE; j++) {
-      aom_free(lr_sync->cur_sb_col[j]);
+    for (int j = 0; j < MAX_MB_PLANE; j++) {
+      aom_row_sync_free(&lr_sync->cur_sb_col[j]);
     }
 
     aom_free(lr_sync->job_queue);
+    aom_free(lr_sync->rows_done);
+    aom_job_scheduler_free(&lr_sync->job_sched);
 
     if (lr_sync->lrworkerdata) {
-      for (int worker_idx = 0; worker_idx < num_workers - 1; worker_idx++) {
+      // The buffers of the last worker are the ones of AV1_COMMON.
+      for (int worker_idx = 0; worker_idx < lr_sync->num_workers - 1;
+           worker_idx++) {
         LRWorkerData *const workerdata_data =
             lr_sync->lrworkerdata + worker_idx;
 
@@ -704,7 +991,6 @@ static void enqueue_lr_jobs(AV1LrSync *lr_sync, AV1LrStruct *lr_ctxt,
   AV1LrMTInfo *lr_job_queue = lr_sync->job_queue;
   int32_t lr_job_counter[2], num_even_lr_jobs = 0;
   lr_sync->jobs_enqueued = 0;
-  lr_sync->jobs_dequeued = 0;
 
   for (int plane = 0; plane < num_planes; plane++) {
     if (cm->rst_info[plane].frame_restoration_type == RESTORE_NONE) continue;
@@ -774,25 +1060,18 @@ static void enqueue_lr_jobs(AV1LrSync *lr_sync, AV1LrStruct *lr_ctxt,
   }
 }
 
-static AV1LrMTInfo *get_lr_job_info(AV1LrSync *lr_sync) {
-  AV1LrMTInfo *cur_job_info = NULL;
-
-#if CONFIG_MULTITHREAD
-  pthread_mutex_lock(lr_sync->job_mutex);
-
-  if (lr_sync->jobs_dequeued < lr_sync->jobs_enqueued) {
-    cur_job_info = lr_sync->job_queue + lr_sync->jobs_dequeued;
-    lr_sync->jobs_dequeued++;
-  }
-
-  pthread_mutex_unlock(lr_sync->job_mutex);
-#else
-  (void)lr_sync;
-#endif
-
-  return cur_job_info;
+static AV1LrMTInfo *get_lr_job_info(AV1LrSync *lr_sync, int worker_idx) {
+  const int job = aom_job_scheduler_get_job(&lr_sync->job_sched, worker_idx);
+  return job >= 0 ? lr_sync->job_queue + job : NULL;
 }
 
+typedef void (*copy_fun)(const YV12_BUFFER_CONFIG *src_ybc,
+                         YV12_BUFFER_CONFIG *dst_ybc, int hstart, int hend,
+                         int vstart, int vend);
+static const copy_fun copy_funs[3] = { aom_yv12_partial_coloc_copy_y,
+                                       aom_yv12_partial_coloc_copy_u,
+                                       aom_yv12_partial_coloc_copy_v };
+
 // Implement row loop restoration for each thread.
 static int loop_restoration_row_worker(void *arg1, void *arg2) {
   AV1LrSync *const lr_sync = (AV1LrSync *)arg1;
@@ -805,15 +1084,10 @@ static int loop_restoration_row_worker(void *arg1, void *arg2) {
   const int tile_col = LR_TILE_COL;
   const int tile_cols = LR_TILE_COLS;
   const int tile_idx = tile_col + tile_row * tile_cols;
-  typedef void (*copy_fun)(const YV12_BUFFER_CONFIG *src_ybc,
-                           YV12_BUFFER_CONFIG *dst_ybc, int hstart, int hend,
-                           int vstart, int vend);
-  static const copy_fun copy_funs[3] = { aom_yv12_partial_coloc_copy_y,
-                                         aom_yv12_partial_coloc_copy_u,
-                                         aom_yv12_partial_coloc_copy_v };
 
   while (1) {
-    AV1LrMTInfo *cur_job_info = get_lr_job_info(lr_sync);
+    AV1LrMTInfo *cur_job_info = get_lr_job_info(
+        lr_sync, (int)(lrworkerdata - lr_sync->lrworkerdata));
     if (cur_job_info != NULL) {
       RestorationTileLimits limits;
       sync_read_fn_t on_sync_read;
@@ -849,14 +1123,98 @@ static int loop_restoration_row_worker(void *arg1, void *arg2) {
   return 1;
 }
 
-static void foreach_rest_unit_in_planes_mt(AV1LrStruct *lr_ctxt,
-                                           AVxWorker *workers, int nworkers,
-                                           AV1LrSync *lr_sync, AV1_COMMON *cm) {
+// Returns 1 if loop restoration job 'job' of the deblocking -> CDEF pipeline
+// may run once the first 'cdef_rows' CDEF filter block rows are done, where
+// 'rows_done' flags the unit rows which are done. Besides its own rows, a unit
+// row overwrites the RESTORATION_BORDER rows above and below it while it is
+// filtered, and an odd unit row copies its output into them, so the odd rows
+// also wait for the even rows next to them.
+static int lr_pipeline_job_ready(const AV1LfSync *lf_sync,
+                                 const AV1LrMTInfo *job, int cdef_rows,
+                                 const int *rows_done) {
+  const AV1LrSync *const lr_sync = lf_sync->lr_sync;
+  const AV1LrStruct *const lr_ctxt =
+      (const AV1LrStruct *)lr_sync->lrworkerdata[0].lr_ctxt;
+  const FilterFrameCtxt *const ctxt = &lr_ctxt->ctxt[job->plane];
+  const int fb_height = MI_SIZE_64X64 << MI_SIZE_LOG2;
+  const int y_end = (job->v_end + RESTORATION_BORDER) << ctxt->ss_y;
+  const int last_fbr =
+      AOMMIN((y_end - 1) / fb_height, lf_sync->cdef_lb->nvfb - 1);
+  if (cdef_rows <= last_fbr) return 0;
+  if (job->sync_mode == 0) return 1;
+
+  const int *const plane_rows_done = rows_done + job->plane * lr_sync->rows;
+  const int row = job->lr_unit_row;
+  const int last_row = row + 1 == ctxt->rsi->vert_units_per_tile;
+  return plane_rows_done[row - 1] && (last_row || plane_rows_done[row + 1]);
+}
+
+// Filters the loop restoration unit row of job 'lr_job' of the pipeline once
+// the rows it depends on are done.
+static void lr_pipeline_row(AV1LfSync *const lf_sync, int lr_job,
+                            int worker_idx) {
+  AV1LrSync *const lr_sync = lf_sync->lr_sync;
+  const AV1LrMTInfo *const job = &lr_sync->job_queue[lr_job];
+  LRWorkerData *const lrworkerdata = &lr_sync->lrworkerdata[worker_idx];
+  AV1LrStruct *const lr_ctxt = (AV1LrStruct *)lrworkerdata->lr_ctxt;
+  YV12_BUFFER_CONFIG *const frame = lr_ctxt->frame;
+  const int plane = job->plane;
+  const int is_uv = plane > 0;
+  FilterFrameCtxt *const ctxt = &lr_ctxt->ctxt[plane];
+  const int tile_idx = LR_TILE_COL + LR_TILE_ROW * LR_TILE_COLS;
+  RestorationTileLimits limits;
+  int ready;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(lf_sync->job_mutex);
+  while (!lr_pipeline_job_ready(lf_sync, job, lf_sync->cdef_rows_done,
+                                lr_sync->rows_done) &&
+         !lf_sync->pipeline_exit) {
+    pthread_cond_wait(lf_sync->pipeline_cond, lf_sync->job_mutex);
+  }
+#endif
+  ready = lr_pipeline_job_ready(lf_sync, job, lf_sync->cdef_rows_done,
+                                lr_sync->rows_done);
+#if CONFIG_MULTITHREAD
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+  if (!ready) return;
+
+  av1_extend_frame_rows(frame->buffers[plane], frame->crop_widths[is_uv],
+                        frame->crop_heights[is_uv], frame->strides[is_uv],
+                        RESTORATION_BORDER, RESTORATION_BORDER, job->v_start,
+                        job->v_end, ctxt->highbd);
+
+  // The rows next to this one are not filtered concurrently, so no sync is
+  // needed within the row.
+  limits.v_start = job->v_start;
+  limits.v_end = job->v_end;
+  av1_foreach_rest_unit_in_row(
+      &limits, &ctxt->tile_rect, lr_ctxt->on_rest_unit, job->lr_unit_row,
+      ctxt->rsi->restoration_unit_size, tile_idx * ctxt->rsi->units_per_tile,
+      ctxt->rsi->horz_units_per_tile, ctxt->rsi->vert_units_per_tile, plane,
+      ctxt, lrworkerdata->rst_tmpbuf, lrworkerdata->rlbs,
+      av1_lr_sync_read_dummy, av1_lr_sync_write_dummy, lr_sync);
+
+  copy_funs[plane](lr_ctxt->dst, frame, ctxt->tile_rect.left,
+                   ctxt->tile_rect.right, job->v_copy_start, job->v_copy_end);
+
+#if CONFIG_MULTITHREAD
+  pthread_mutex_lock(lf_sync->job_mutex);
+#endif
+  lr_sync->rows_done[plane * lr_sync->rows + job->lr_unit_row] = 1;
+#if CONFIG_MULTITHREAD
+  pthread_cond_broadcast(lf_sync->pipeline_cond);
+  pthread_mutex_unlock(lf_sync->job_mutex);
+#endif
+}
+
+// Sets up lr_sync for 'num_workers' workers and queues the jobs of the frame.
+static void loop_restoration_sync_init(AV1LrStruct *lr_ctxt, int num_workers,
+                                       AV1LrSync *lr_sync, AV1_COMMON *cm) {
   FilterFrameCtxt *ctxt = lr_ctxt->ctxt;
 
   const int num_planes = av1_num_planes(cm);
 
-  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
   int num_rows_lr = 0;
 
   for (int plane = 0; plane < num_planes; plane++) {
@@ -871,29 +1229,44 @@ static void foreach_rest_unit_in_planes_mt(AV1LrStruct *lr_ctxt,
         AOMMAX(num_rows_lr, av1_lr_count_units_in_tile(unit_size, max_tile_h));
   }
 
-  const int num_workers = nworkers;
   int i;
   assert(MAX_MB_PLANE == 3);
 
   if (!lr_sync->sync_range || num_rows_lr != lr_sync->rows ||
       num_workers > lr_sync->num_workers || num_planes != lr_sync->num_planes) {
-    av1_loop_restoration_dealloc(lr_sync, num_workers);
+    av1_loop_restoration_dealloc(lr_sync);
     loop_restoration_alloc(lr_sync, cm, num_workers, num_rows_lr, num_planes,
                            cm->width);
   }
 
   // Initialize cur_sb_col to -1 for all SB rows.
   for (i = 0; i < num_planes; i++) {
-    memset(lr_sync->cur_sb_col[i], -1,
-           sizeof(*(lr_sync->cur_sb_col[i])) * num_rows_lr);
+    aom_row_sync_reset(&lr_sync->cur_sb_col[i], -1);
   }
+  memset(lr_sync->rows_done, 0,
+         sizeof(*(lr_sync->rows_done)) * num_rows_lr * num_planes);
 
   enqueue_lr_jobs(lr_sync, lr_ctxt, cm);
 
+  for (i = 0; i < num_workers; ++i) {
+    lr_sync->lrworkerdata[i].lr_ctxt = (void *)lr_ctxt;
+  }
+}
+
+static void foreach_rest_unit_in_planes_mt(AV1LrStruct *lr_ctxt,
+                                           AVxWorker *workers, int nworkers,
+                                           AV1LrSync *lr_sync, AV1_COMMON *cm) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  const int num_workers = nworkers;
+  int i;
+
+  loop_restoration_sync_init(lr_ctxt, num_workers, lr_sync, cm);
+  aom_job_scheduler_reset(&lr_sync->job_sched, lr_sync->jobs_enqueued,
+                          num_workers);
+
   // Set up looprestoration thread data.
   for (i = 0; i < num_workers; ++i) {
     AVxWorker *const worker = &workers[i];
-    lr_sync->lrworkerdata[i].lr_ctxt = (void *)lr_ctxt;
     worker->hook = loop_restoration_row_worker;
     worker->data1 = lr_sync;
     worker->data2 = &lr_sync->lrworkerdata[i];
@@ -923,8 +1296,75 @@ void av1_loop_restoration_filter_frame_mt(YV12_BUFFER_CONFIG *frame,
   AV1LrStruct *loop_rest_ctxt = (AV1LrStruct *)lr_ctxt;
 
   av1_loop_restoration_filter_frame_init(loop_rest_ctxt, frame, cm,
-                                         optimized_lr, num_planes);
+                                         optimized_lr, num_planes, 1);
 
   foreach_rest_unit_in_planes_mt(loop_rest_ctxt, workers, num_workers, lr_sync,
                                  cm);
 }
+
+// Deallocate CDEF synchronization related data
+void av1_cdef_sync_dealloc(AV1CdefSync *cdef_sync) {
+  if (cdef_sync != NULL) {
+    aom_job_scheduler_free(&cdef_sync->job_sched);
+    av1_zero(*cdef_sync);
+  }
+}
+
+// Row-based multi-threaded CDEF hook
+static int cdef_row_worker(void *arg1, void *arg2) {
+  AV1CdefSync *const cdef_sync = (AV1CdefSync *)arg1;
+  const int worker_idx = (int)((AVxWorker *)arg2 - cdef_sync->workers);
+  int fbr;
+  while ((fbr = aom_job_scheduler_get_job(&cdef_sync->job_sched,
+                                          worker_idx)) >= 0) {
+    av1_cdef_fb_row(cdef_sync->cm, cdef_sync->xd, cdef_sync->lb, fbr);
+  }
+  return 1;
+}
+
+void av1_cdef_frame_mt(YV12_BUFFER_CONFIG *frame, AV1_COMMON *cm,
+                       MACROBLOCKD *xd, AVxWorker *workers, int num_workers,
+                       AV1CdefSync *cdef_sync) {
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  CdefLineBufs lb;
+  int i;
+
+  if (num_workers > cdef_sync->num_workers) {
+    av1_cdef_sync_dealloc(cdef_sync);
+    if (aom_job_scheduler_alloc(&cdef_sync->job_sched, num_workers))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate CDEF job scheduler");
+    cdef_sync->num_workers = num_workers;
+  }
+
+  av1_zero(lb);
+  av1_cdef_init_frame(frame, cm, xd, &lb);
+  for (i = 1; i < lb.nvfb; ++i) av1_cdef_save_boundary_lines(cm, xd, &lb, i);
+  aom_job_scheduler_reset(&cdef_sync->job_sched, lb.nvfb, num_workers);
+  cdef_sync->workers = workers;
+  cdef_sync->cm = cm;
+  cdef_sync->xd = xd;
+  cdef_sync->lb = &lb;
+
+  for (i = 0; i < num_workers; ++i) {
+    AVxWorker *const worker = &workers[i];
+    worker->hook = cdef_row_worker;
+    worker->data1 = cdef_sync;
+    worker->data2 = worker;
+
+    // Start CDEF filtering
+    if (i == num_workers - 1) {
+      winterface->execute(worker);
+    } else {
+      winterface->launch(worker);
+    }
+  }
+
+  // Wait till all rows are finished
+  for (i = 0; i < num_workers; ++i) {
+    winterface->sync(&workers[i]);
+  }
+
+  av1_cdef_free_frame(&lb);
+  cdef_sync->lb = NULL;
+}
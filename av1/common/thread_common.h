@@ -15,6 +15,8 @@
 #include "config/aom_config.h"
 
 #include "av1/common/av1_loopfilter.h"
+#include "aom_util/aom_job_scheduler.h"
+#include "aom_util/aom_row_sync.h"
 #include "aom_util/aom_thread.h"
 
 #ifdef __cplusplus
@@ -22,21 +24,24 @@ extern "C" {
 #endif
 
 struct AV1Common;
+struct AV1LrSyncData;
+struct CdefLineBufs;
 
 typedef struct AV1LfMTInfo {
   int mi_row;
   int plane;
+  // 0 and 1 filter the vertical and the horizontal edges of a superblock row.
+  // In the deblocking -> CDEF pipeline, 2 applies CDEF to the filter block
+  // row of mi_row, and 3 runs the loop restoration job 'lr_job' of the
+  // AV1LrSync.
   int dir;
+  int lr_job;
 } AV1LfMTInfo;
 
 // Loopfilter row synchronization
 typedef struct AV1LfSyncData {
-#if CONFIG_MULTITHREAD
-  pthread_mutex_t *mutex_[MAX_MB_PLANE];
-  pthread_cond_t *cond_[MAX_MB_PLANE];
-#endif
-  // Allocate memory to store the loop-filtered superblock index in each row.
-  int *cur_sb_col[MAX_MB_PLANE];
+  // Index of the last loop-filtered superblock in each row.
+  AVxRowSync cur_sb_col[MAX_MB_PLANE];
   // The optimal sync_range for different resolution and platform should be
   // determined by testing. Currently, it is chosen to be a power-of-2 number.
   int sync_range;
@@ -46,12 +51,41 @@ typedef struct AV1LfSyncData {
   LFWorkerData *lfdata;
   int num_workers;
 
+  AV1LfMTInfo *job_queue;
+  int jobs_enqueued;
+  // Hands out the jobs of job_queue, indexed by the worker's lfdata.
+  AVxJobScheduler job_sched;
+
+  // Deblocking -> CDEF pipeline, see av1_lf_pipeline_init(). These are
+  // protected by job_mutex.
 #if CONFIG_MULTITHREAD
   pthread_mutex_t *job_mutex;
 #endif
-  AV1LfMTInfo *job_queue;
-  int jobs_enqueued;
-  int jobs_dequeued;
+#if CONFIG_MULTITHREAD
+  pthread_cond_t *pipeline_cond;
+#endif
+  int pipelined;
+  // Number of leading superblock rows which may be deblocked, i.e. the rows
+  // whose pixels are no longer needed unfiltered by the decoding of the frame.
+  int src_rows_ready;
+  // Set when the frame failed to decode. The remaining jobs are dropped.
+  int pipeline_exit;
+  // Number of planes whose horizontal edges have been filtered in each row.
+  int *horz_planes_done;
+  int num_lf_planes;
+  // Number of leading superblock rows which are completely deblocked.
+  int rows_deblocked;
+  // Number of leading CDEF filter block rows whose top boundary is saved.
+  int cdef_rows_ready;
+  // Whether each CDEF filter block row is filtered, and the number of leading
+  // rows which are.
+  int *cdef_row_done;
+  int cdef_rows_done;
+  int do_cdef;
+  int save_lr_lines;
+  struct CdefLineBufs *cdef_lb;
+  // Loop restoration jobs of the pipeline, or NULL.
+  struct AV1LrSyncData *lr_sync;
 } AV1LfSync;
 
 typedef struct AV1LrMTInfo {
@@ -72,12 +106,8 @@ typedef struct LoopRestorationWorkerData {
 
 // Looprestoration row synchronization
 typedef struct AV1LrSyncData {
-#if CONFIG_MULTITHREAD
-  pthread_mutex_t *mutex_[MAX_MB_PLANE];
-  pthread_cond_t *cond_[MAX_MB_PLANE];
-#endif
-  // Allocate memory to store the loop-restoration block index in each row.
-  int *cur_sb_col[MAX_MB_PLANE];
+  // Index of the last loop-restored block in each row.
+  AVxRowSync cur_sb_col[MAX_MB_PLANE];
   // The optimal sync_range for different resolution and platform should be
   // determined by testing. Currently, it is chosen to be a power-of-2 number.
   int sync_range;
@@ -86,17 +116,31 @@ typedef struct AV1LrSyncData {
 
   int num_workers;
 
-#if CONFIG_MULTITHREAD
-  pthread_mutex_t *job_mutex;
-#endif
   // Row-based parallel loopfilter data
   LRWorkerData *lrworkerdata;
 
   AV1LrMTInfo *job_queue;
   int jobs_enqueued;
-  int jobs_dequeued;
+  // Hands out the jobs of job_queue, indexed by the worker's lrworkerdata.
+  AVxJobScheduler job_sched;
+  // Whether each unit row of each plane is filtered, when the jobs run in the
+  // deblocking -> CDEF pipeline. Protected by the job_mutex of its AV1LfSync.
+  int *rows_done;
 } AV1LrSync;
 
+// CDEF row-based multi-threading data. Once the filter block row boundaries
+// are saved, the rows are independent, and each filter block row is a job.
+typedef struct AV1CdefSyncData {
+  // Hands out the filter block rows, indexed by the worker's position in
+  // 'workers'.
+  AVxJobScheduler job_sched;
+  int num_workers;
+  AVxWorker *workers;
+  struct AV1Common *cm;
+  struct macroblockd *xd;
+  struct CdefLineBufs *lb;
+} AV1CdefSync;
+
 // Deallocate loopfilter synchronization related mutex and data.
 void av1_loop_filter_dealloc(AV1LfSync *lf_sync);
 
@@ -108,12 +152,55 @@ void av1_loop_filter_frame_mt(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
 #endif
                               AVxWorker *workers, int num_workers,
                               AV1LfSync *lf_sync);
+// Deblocking -> CDEF pipeline. The deblocking jobs of each superblock row are
+// queued right after the ones of the row below it, and, if 'do_cdef' is set,
+// each CDEF filter block row is filtered as soon as the deblocking rows it
+// depends on are done. If 'save_lr_lines' is set, the deblocked loop
+// restoration stripe boundaries are saved too, which replaces the
+// av1_loop_restoration_save_boundary_lines(frame, cm, 0) call.
+//
+// If 'lr_sync' is not NULL, which needs 'do_cdef' and 'save_lr_lines' and no
+// superres, each loop restoration unit row is filtered as soon as the CDEF
+// rows it depends on are done, using 'lr_ctxt'. This replaces the rest of the
+// loop restoration of the frame.
+//
+// Deblocking of superblock row r only starts once 'src_rows' > r, so that the
+// jobs can run while the frame is still being decoded. Each worker calls
+// av1_lf_pipeline_process() with its own index, and the source progress is
+// reported with av1_lf_pipeline_set_src_rows().
+void av1_lf_pipeline_init(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
+                          struct macroblockd *xd, int do_cdef,
+                          int save_lr_lines, struct AV1LrSyncData *lr_sync,
+                          void *lr_ctxt, int src_rows, int num_workers,
+                          AV1LfSync *lf_sync);
+void av1_lf_pipeline_process(AV1LfSync *lf_sync, int worker_idx);
+void av1_lf_pipeline_set_src_rows(AV1LfSync *lf_sync, int src_rows);
+// Drops the remaining jobs, and releases the workers waiting for the source or
+// for the jobs dropped.
+void av1_lf_pipeline_abort(AV1LfSync *lf_sync);
+// Must be called once all the workers are done.
+void av1_lf_pipeline_finish(AV1LfSync *lf_sync);
+
+// Deblocks the whole frame and applies CDEF (and loop restoration, if
+// 'lr_sync' is not NULL) to it in a single pass, using the pipeline above.
+void av1_loop_filter_cdef_frame_mt(YV12_BUFFER_CONFIG *frame,
+                                   struct AV1Common *cm, struct macroblockd *xd,
+                                   int save_lr_lines,
+                                   struct AV1LrSyncData *lr_sync, void *lr_ctxt,
+                                   AVxWorker *workers, int num_workers,
+                                   AV1LfSync *lf_sync);
 void av1_loop_restoration_filter_frame_mt(YV12_BUFFER_CONFIG *frame,
                                           struct AV1Common *cm,
                                           int optimized_lr, AVxWorker *workers,
                                           int num_workers, AV1LrSync *lr_sync,
                                           void *lr_ctxt);
-void av1_loop_restoration_dealloc(AV1LrSync *lr_sync, int num_workers);
+void av1_loop_restoration_dealloc(AV1LrSync *lr_sync);
+
+void av1_cdef_frame_mt(YV12_BUFFER_CONFIG *frame, struct AV1Common *cm,
+                       struct macroblockd *xd, AVxWorker *workers,
+                       int num_workers, AV1CdefSync *cdef_sync);
+// Deallocate CDEF synchronization related data.
+void av1_cdef_sync_dealloc(AV1CdefSync *cdef_sync);
 
 #ifdef __cplusplus
 }  // extern "C"
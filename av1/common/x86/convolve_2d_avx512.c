@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <immintrin.h>
+
+#include "config/av1_rtcd.h"
+
+#include "aom_dsp/x86/convolve_avx2.h"
+#include "aom_dsp/aom_dsp_common.h"
+#include "aom_dsp/aom_filter.h"
+#include "av1/common/convolve.h"
+
+static INLINE void prepare_coeffs_lowbd_avx512(
+    const InterpFilterParams *const filter_params, const int subpel_q4,
+    __m512i *const coeffs /* [4] */) {
+  const int16_t *const filter = av1_get_interp_filter_subpel_kernel(
+      filter_params, subpel_q4 & SUBPEL_MASK);
+  const __m128i coeffs_8 = _mm_loadu_si128((__m128i *)filter);
+
+  // As in avx2, the co-efficients are all even and are halved so that the
+  // products of pairs of pixels fit in 16 bits.
+  const __m512i coeffs_1 =
+      _mm512_srai_epi16(_mm512_broadcast_i32x4(coeffs_8), 1);
+
+  coeffs[0] = _mm512_shuffle_epi8(coeffs_1, _mm512_set1_epi16(0x0200u));
+  coeffs[1] = _mm512_shuffle_epi8(coeffs_1, _mm512_set1_epi16(0x0604u));
+  coeffs[2] = _mm512_shuffle_epi8(coeffs_1, _mm512_set1_epi16(0x0a08u));
+  coeffs[3] = _mm512_shuffle_epi8(coeffs_1, _mm512_set1_epi16(0x0e0cu));
+}
+
+static INLINE void prepare_coeffs_avx512(
+    const InterpFilterParams *const filter_params, const int subpel_q4,
+    __m512i *const coeffs /* [4] */) {
+  const int16_t *const filter = av1_get_interp_filter_subpel_kernel(
+      filter_params, subpel_q4 & SUBPEL_MASK);
+  const __m512i coeff =
+      _mm512_broadcast_i32x4(_mm_loadu_si128((__m128i *)filter));
+
+  coeffs[0] = _mm512_shuffle_epi32(coeff, 0x00);
+  coeffs[1] = _mm512_shuffle_epi32(coeff, 0x55);
+  coeffs[2] = _mm512_shuffle_epi32(coeff, 0xaa);
+  coeffs[3] = _mm512_shuffle_epi32(coeff, 0xff);
+}
+
+// Filters 32 pixels of a row horizontally. Each 128 bit lane computes 8
+// pixels from the 16 bytes which start at its first pixel.
+static INLINE __m512i convolve_x_32_avx512(const uint8_t *src,
+                                           const __m512i *const coeffs,
+                                           const __m512i *const filt,
+                                           const __m512i round_const,
+                                           const __m128i round_shift) {
+  const __m256i data_0 = _mm256_loadu_si256((const __m256i *)src);
+  const __m256i data_8 = _mm256_loadu_si256((const __m256i *)(src + 8));
+  const __m512i data_0_8 =
+      _mm512_inserti64x4(_mm512_castsi256_si512(data_0), data_8, 1);
+  // Bytes 0-15, 8-23, 16-31 and 24-39.
+  const __m512i data =
+      _mm512_shuffle_i64x2(data_0_8, data_0_8, _MM_SHUFFLE(3, 1, 2, 0));
+
+  const __m512i res_01 =
+      _mm512_maddubs_epi16(_mm512_shuffle_epi8(data, filt[0]), coeffs[0]);
+  const __m512i res_23 =
+      _mm512_maddubs_epi16(_mm512_shuffle_epi8(data, filt[1]), coeffs[1]);
+  const __m512i res_45 =
+      _mm512_maddubs_epi16(_mm512_shuffle_epi8(data, filt[2]), coeffs[2]);
+  const __m512i res_67 =
+      _mm512_maddubs_epi16(_mm512_shuffle_epi8(data, filt[3]), coeffs[3]);
+  const __m512i res = _mm512_add_epi16(_mm512_add_epi16(res_01, res_45),
+                                       _mm512_add_epi16(res_23, res_67));
+  return _mm512_sra_epi16(_mm512_add_epi16(res, round_const), round_shift);
+}
+
+static INLINE __m512i convolve_avx512(const __m512i *const s,
+                                      const __m512i *const coeffs) {
+  const __m512i res_0 = _mm512_madd_epi16(s[0], coeffs[0]);
+  const __m512i res_1 = _mm512_madd_epi16(s[1], coeffs[1]);
+  const __m512i res_2 = _mm512_madd_epi16(s[2], coeffs[2]);
+  const __m512i res_3 = _mm512_madd_epi16(s[3], coeffs[3]);
+  return _mm512_add_epi32(_mm512_add_epi32(res_0, res_1),
+                          _mm512_add_epi32(res_2, res_3));
+}
+
+// Filters 32 pixels of a row vertically from the interleaved pairs of rows s
+// and stores them to dst.
+static INLINE void convolve_y_32_avx512(
+    const __m512i *const s, const __m512i *const coeffs,
+    const __m512i sum_round, const __m128i sum_shift, const __m512i round_const,
+    const __m128i round_shift, uint8_t *dst) {
+  __m512i res_a = convolve_avx512(s, coeffs);
+  __m512i res_b = convolve_avx512(s + 4, coeffs);
+
+  // Combine V round and 2F-H-V round into a single rounding
+  res_a = _mm512_sra_epi32(_mm512_add_epi32(res_a, sum_round), sum_shift);
+  res_b = _mm512_sra_epi32(_mm512_add_epi32(res_b, sum_round), sum_shift);
+  res_a = _mm512_sra_epi32(_mm512_add_epi32(res_a, round_const), round_shift);
+  res_b = _mm512_sra_epi32(_mm512_add_epi32(res_b, round_const), round_shift);
+
+  // Saturate to 16 bits, then to uint8.
+  const __m512i res_16bit = _mm512_max_epi16(
+      _mm512_packs_epi32(res_a, res_b), _mm512_setzero_si512());
+  _mm256_storeu_si256((__m256i *)dst, _mm512_cvtusepi16_epi8(res_16bit));
+}
+
+void av1_convolve_2d_sr_avx512(const uint8_t *src, int src_stride,
+                               uint8_t *dst, int dst_stride, int w, int h,
+                               const InterpFilterParams *filter_params_x,
+                               const InterpFilterParams *filter_params_y,
+                               const int subpel_x_qn, const int subpel_y_qn,
+                               ConvolveParams *conv_params) {
+  // Narrow blocks do not fill the vectors.
+  if (w < 32) {
+    av1_convolve_2d_sr_avx2(src, src_stride, dst, dst_stride, w, h,
+                            filter_params_x, filter_params_y, subpel_x_qn,
+                            subpel_y_qn, conv_params);
+    return;
+  }
+
+  const int bd = 8;
+  const int bits =
+      FILTER_BITS * 2 - conv_params->round_0 - conv_params->round_1;
+  const int offset_bits = bd + 2 * FILTER_BITS - conv_params->round_0;
+
+  assert(conv_params->round_0 > 0);
+  assert(filter_params_x->taps == 8 && filter_params_y->taps == 8);
+  assert(!(h & 1));
+
+  const __m512i round_const_h = _mm512_set1_epi16(
+      ((1 << (conv_params->round_0 - 1)) >> 1) + (1 << (bd + FILTER_BITS - 2)));
+  const __m128i round_shift_h = _mm_cvtsi32_si128(conv_params->round_0 - 1);
+
+  const __m512i sum_round_v = _mm512_set1_epi32(
+      (1 << offset_bits) + ((1 << conv_params->round_1) >> 1));
+  const __m128i sum_shift_v = _mm_cvtsi32_si128(conv_params->round_1);
+
+  const __m512i round_const_v = _mm512_set1_epi32(
+      ((1 << bits) >> 1) - (1 << (offset_bits - conv_params->round_1)) -
+      ((1 << (offset_bits - conv_params->round_1)) >> 1));
+  const __m128i round_shift_v = _mm_cvtsi32_si128(bits);
+
+  __m512i filt[4], coeffs_h[4], coeffs_v[4];
+  for (int k = 0; k < 4; ++k) {
+    filt[k] = _mm512_broadcast_i32x4(
+        _mm_load_si128((__m128i const *)(filt_global_avx2 + 32 * k)));
+  }
+  prepare_coeffs_lowbd_avx512(filter_params_x, subpel_x_qn, coeffs_h);
+  prepare_coeffs_avx512(filter_params_y, subpel_y_qn, coeffs_v);
+
+  const int fo_vert = filter_params_y->taps / 2 - 1;
+  const int fo_horiz = filter_params_x->taps / 2 - 1;
+  const uint8_t *const src_ptr = src - fo_vert * src_stride - fo_horiz;
+
+  // The blocks are filtered in columns of 32 pixels. The horizontal pass of a
+  // column is kept in im_block, whose rows are one vector each.
+  DECLARE_ALIGNED(64, int16_t, im_block[(MAX_SB_SIZE + SUBPEL_TAPS) * 32]);
+  const int im_h = h + filter_params_y->taps - 1;
+  __m512i *const im = (__m512i *)im_block;
+
+  for (int j = 0; j < w; j += 32) {
+    for (int i = 0; i < im_h; ++i) {
+      im[i] = convolve_x_32_avx512(src_ptr + i * src_stride + j, coeffs_h,
+                                   filt, round_const_h, round_shift_h);
+    }
+
+    // s0 and s1 hold the pairs of rows interleaved for the output rows i and
+    // i + 1.
+    __m512i s0[8], s1[8];
+    s0[0] = _mm512_unpacklo_epi16(im[0], im[1]);
+    s0[1] = _mm512_unpacklo_epi16(im[2], im[3]);
+    s0[2] = _mm512_unpacklo_epi16(im[4], im[5]);
+    s0[4] = _mm512_unpackhi_epi16(im[0], im[1]);
+    s0[5] = _mm512_unpackhi_epi16(im[2], im[3]);
+    s0[6] = _mm512_unpackhi_epi16(im[4], im[5]);
+    s1[0] = _mm512_unpacklo_epi16(im[1], im[2]);
+    s1[1] = _mm512_unpacklo_epi16(im[3], im[4]);
+    s1[2] = _mm512_unpacklo_epi16(im[5], im[6]);
+    s1[4] = _mm512_unpackhi_epi16(im[1], im[2]);
+    s1[5] = _mm512_unpackhi_epi16(im[3], im[4]);
+    s1[6] = _mm512_unpackhi_epi16(im[5], im[6]);
+
+    for (int i = 0; i < h; i += 2) {
+      const __m512i im6 = im[i + 6];
+      const __m512i im7 = im[i + 7];
+      const __m512i im8 = im[i + 8];
+      s0[3] = _mm512_unpacklo_epi16(im6, im7);
+      s0[7] = _mm512_unpackhi_epi16(im6, im7);
+      s1[3] = _mm512_unpacklo_epi16(im7, im8);
+      s1[7] = _mm512_unpackhi_epi16(im7, im8);
+
+      convolve_y_32_avx512(s0, coeffs_v, sum_round_v, sum_shift_v,
+                           round_const_v, round_shift_v,
+                           dst + i * dst_stride + j);
+      convolve_y_32_avx512(s1, coeffs_v, sum_round_v, sum_shift_v,
+                           round_const_v, round_shift_v,
+                           dst + (i + 1) * dst_stride + j);
+
+      s0[0] = s0[1];
+      s0[1] = s0[2];
+      s0[2] = s0[3];
+      s0[4] = s0[5];
+      s0[5] = s0[6];
+      s0[6] = s0[7];
+      s1[0] = s1[1];
+      s1[1] = s1[2];
+      s1[2] = s1[3];
+      s1[4] = s1[5];
+      s1[5] = s1[6];
+      s1[6] = s1[7];
+    }
+  }
+}
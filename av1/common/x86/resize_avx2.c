@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <immintrin.h>
+
+#include "config/av1_rtcd.h"
+
+#include "aom_dsp/aom_filter.h"
+#include "av1/common/resize.h"
+
+static INLINE __m256i pair_coeffs_epi16(const int16_t *f) {
+  return _mm256_set1_epi32((int32_t)((uint16_t)f[0] | ((uint32_t)f[1] << 16)));
+}
+
+static INLINE __m256i pair_coeffs_epi8(const int16_t *f) {
+  return _mm256_set1_epi16((int16_t)((uint8_t)f[0] | ((uint16_t)f[1] << 8)));
+}
+
+// Adds the products of the 32 pixels of the rows a and b by the taps of coeff
+// to sum[0..3]. Each 128 bit lane of sum[i] holds 4 pixels of the 16 pixels
+// of the lane, so that packing them back restores the order of the pixels.
+static INLINE void madd_rows_32(__m256i a, __m256i b, __m256i coeff,
+                                __m256i *sum) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i lo = _mm256_unpacklo_epi8(a, b);
+  const __m256i hi = _mm256_unpackhi_epi8(a, b);
+  sum[0] = _mm256_add_epi32(
+      sum[0], _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), coeff));
+  sum[1] = _mm256_add_epi32(
+      sum[1], _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), coeff));
+  sum[2] = _mm256_add_epi32(
+      sum[2], _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), coeff));
+  sum[3] = _mm256_add_epi32(
+      sum[3], _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), coeff));
+}
+
+void av1_resize_vert_8tap_avx2(const uint8_t *const *rows, uint8_t *dst,
+                               int width, const int16_t *filter) {
+  if (width < 32) {
+    av1_resize_vert_8tap_ssse3(rows, dst, width, filter);
+    return;
+  }
+  const __m256i round = _mm256_set1_epi32(1 << (FILTER_BITS - 1));
+  __m256i coeffs[SUBPEL_TAPS / 2];
+  for (int k = 0; k < SUBPEL_TAPS / 2; ++k) {
+    coeffs[k] = pair_coeffs_epi16(filter + 2 * k);
+  }
+
+  int j = 0;
+  for (; j + 32 <= width; j += 32) {
+    __m256i sum[4] = { round, round, round, round };
+    for (int k = 0; k < SUBPEL_TAPS; k += 2) {
+      madd_rows_32(_mm256_loadu_si256((const __m256i *)(rows[k] + j)),
+                   _mm256_loadu_si256((const __m256i *)(rows[k + 1] + j)),
+                   coeffs[k / 2], sum);
+    }
+    const __m256i res_lo =
+        _mm256_packs_epi32(_mm256_srai_epi32(sum[0], FILTER_BITS),
+                           _mm256_srai_epi32(sum[1], FILTER_BITS));
+    const __m256i res_hi =
+        _mm256_packs_epi32(_mm256_srai_epi32(sum[2], FILTER_BITS),
+                           _mm256_srai_epi32(sum[3], FILTER_BITS));
+    _mm256_storeu_si256((__m256i *)(dst + j),
+                        _mm256_packus_epi16(res_lo, res_hi));
+  }
+  if (j < width) {
+    const uint8_t *tail_rows[SUBPEL_TAPS];
+    for (int k = 0; k < SUBPEL_TAPS; ++k) tail_rows[k] = rows[k] + j;
+    av1_resize_vert_8tap_ssse3(tail_rows, dst + j, width - j, filter);
+  }
+}
+
+// As in the ssse3 version, only the addition of the last pair of taps can
+// exceed 16 bits, and it saturates.
+void av1_resize_down2_horz_avx2(const uint8_t *input, uint8_t *output,
+                                int out_length, const int16_t *filter) {
+  const __m256i round = _mm256_set1_epi16(1 << (FILTER_BITS - 1));
+  const __m256i coeff_01 = pair_coeffs_epi8(filter + 0);
+  const __m256i coeff_23 = pair_coeffs_epi8(filter + 2);
+  const __m256i coeff_45 = pair_coeffs_epi8(filter + 4);
+  const __m256i coeff_67 = pair_coeffs_epi8(filter + 6);
+  assert(filter[0] <= 0 && filter[1] <= 0 && filter[6] <= 0 && filter[7] <= 0);
+
+  int i = 0;
+  for (; i + 16 <= out_length; i += 16) {
+    const uint8_t *const in = input + 2 * i - (SUBPEL_TAPS / 2 - 1);
+    // The lanes of v0 hold the pixels 0-15 and 16-31, and those of v1 the
+    // pixels 16-31 and 32-47, so that the in-lane alignr shifts each lane
+    // of v0 by pixels which follow it.
+    const __m256i v0 = _mm256_loadu_si256((const __m256i *)in);
+    const __m256i v1 = _mm256_loadu_si256((const __m256i *)(in + 16));
+    const __m256i res_01 = _mm256_maddubs_epi16(v0, coeff_01);
+    const __m256i res_23 =
+        _mm256_maddubs_epi16(_mm256_alignr_epi8(v1, v0, 2), coeff_23);
+    const __m256i res_45 =
+        _mm256_maddubs_epi16(_mm256_alignr_epi8(v1, v0, 4), coeff_45);
+    const __m256i res_67 =
+        _mm256_maddubs_epi16(_mm256_alignr_epi8(v1, v0, 6), coeff_67);
+    const __m256i sum_0167 =
+        _mm256_add_epi16(_mm256_add_epi16(res_01, res_67), round);
+    const __m256i sum =
+        _mm256_adds_epi16(_mm256_add_epi16(sum_0167, res_23), res_45);
+    const __m256i res = _mm256_srai_epi16(sum, FILTER_BITS);
+    const __m256i res_8 = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(res, res), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)(output + i), _mm256_castsi256_si128(res_8));
+  }
+  if (i < out_length) {
+    av1_resize_down2_horz_ssse3(input + 2 * i, output + i, out_length - i,
+                                filter);
+  }
+}
+
+// Returns the products of the 8 pixels at the positions y and y + 4 * delta
+// by their taps, as 4 partial sums in each 128 bit lane.
+static INLINE __m256i interp_madd_x2(const uint8_t *input, int32_t y,
+                                     int32_t delta, const int16_t *filters) {
+  const int32_t y1 = y + 4 * delta;
+  const int int_pel0 = y >> RS_SCALE_SUBPEL_BITS;
+  const int int_pel1 = y1 >> RS_SCALE_SUBPEL_BITS;
+  const int sub_pel0 = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
+  const int sub_pel1 = (y1 >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
+  const __m256i data = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadl_epi64(
+          (const __m128i *)(input + int_pel0 - (SUBPEL_TAPS / 2 - 1)))),
+      _mm_loadl_epi64(
+          (const __m128i *)(input + int_pel1 - (SUBPEL_TAPS / 2 - 1))),
+      1);
+  const __m256i coeffs = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128(
+          (const __m128i *)(filters + sub_pel0 * SUBPEL_TAPS))),
+      _mm_loadu_si128((const __m128i *)(filters + sub_pel1 * SUBPEL_TAPS)),
+      1);
+  return _mm256_madd_epi16(_mm256_unpacklo_epi8(data, _mm256_setzero_si256()),
+                           coeffs);
+}
+
+void av1_resize_interp_horz_avx2(const uint8_t *input, uint8_t *output,
+                                 int out_length, int32_t y0, int32_t delta,
+                                 const int16_t *filters) {
+  const __m256i round = _mm256_set1_epi32(1 << (FILTER_BITS - 1));
+  int32_t y = y0;
+  int x = 0;
+  for (; x + 8 <= out_length; x += 8, y += 8 * delta) {
+    // The outputs k and k + 4 are computed in the two lanes.
+    const __m256i sum_0 = interp_madd_x2(input, y, delta, filters);
+    const __m256i sum_1 = interp_madd_x2(input, y + delta, delta, filters);
+    const __m256i sum_2 = interp_madd_x2(input, y + 2 * delta, delta, filters);
+    const __m256i sum_3 = interp_madd_x2(input, y + 3 * delta, delta, filters);
+    const __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(sum_0, sum_1),
+                                          _mm256_hadd_epi32(sum_2, sum_3));
+    const __m256i res_32 =
+        _mm256_srai_epi32(_mm256_add_epi32(sum, round), FILTER_BITS);
+    const __m256i res_16 = _mm256_packs_epi32(res_32, res_32);
+    const __m256i res_8 = _mm256_packus_epi16(res_16, res_16);
+    _mm_storel_epi64((__m128i *)(output + x),
+                     _mm_unpacklo_epi32(_mm256_castsi256_si128(res_8),
+                                        _mm256_extracti128_si256(res_8, 1)));
+  }
+  if (x < out_length) {
+    av1_resize_interp_horz_c(input, output + x, out_length - x, y, delta,
+                             filters);
+  }
+}
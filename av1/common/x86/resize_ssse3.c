@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <tmmintrin.h>
+
+#include "config/av1_rtcd.h"
+
+#include "aom_dsp/aom_filter.h"
+#include "av1/common/resize.h"
+
+// Returns the taps f[0] and f[1] as the two 16 bit halves of each 32 bits.
+static INLINE __m128i pair_coeffs_epi16(const int16_t *f) {
+  return _mm_set1_epi32((int32_t)((uint16_t)f[0] | ((uint32_t)f[1] << 16)));
+}
+
+// Returns the taps f[0] and f[1] as the two signed bytes of each 16 bits.
+static INLINE __m128i pair_coeffs_epi8(const int16_t *f) {
+  return _mm_set1_epi16((int16_t)((uint8_t)f[0] | ((uint16_t)f[1] << 8)));
+}
+
+// Adds the products of the 16 pixels of the rows a and b by the taps of coeff
+// to sum[0..3], 4 pixels each.
+static INLINE void madd_rows_16(__m128i a, __m128i b, __m128i coeff,
+                                __m128i *sum) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i lo = _mm_unpacklo_epi8(a, b);
+  const __m128i hi = _mm_unpackhi_epi8(a, b);
+  sum[0] = _mm_add_epi32(sum[0],
+                         _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), coeff));
+  sum[1] = _mm_add_epi32(sum[1],
+                         _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), coeff));
+  sum[2] = _mm_add_epi32(sum[2],
+                         _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), coeff));
+  sum[3] = _mm_add_epi32(sum[3],
+                         _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), coeff));
+}
+
+void av1_resize_vert_8tap_ssse3(const uint8_t *const *rows, uint8_t *dst,
+                                int width, const int16_t *filter) {
+  const __m128i round = _mm_set1_epi32(1 << (FILTER_BITS - 1));
+  __m128i coeffs[SUBPEL_TAPS / 2];
+  for (int k = 0; k < SUBPEL_TAPS / 2; ++k) {
+    coeffs[k] = pair_coeffs_epi16(filter + 2 * k);
+  }
+
+  int j = 0;
+  for (; j + 16 <= width; j += 16) {
+    __m128i sum[4] = { round, round, round, round };
+    for (int k = 0; k < SUBPEL_TAPS; k += 2) {
+      madd_rows_16(_mm_loadu_si128((const __m128i *)(rows[k] + j)),
+                   _mm_loadu_si128((const __m128i *)(rows[k + 1] + j)),
+                   coeffs[k / 2], sum);
+    }
+    const __m128i res_lo =
+        _mm_packs_epi32(_mm_srai_epi32(sum[0], FILTER_BITS),
+                        _mm_srai_epi32(sum[1], FILTER_BITS));
+    const __m128i res_hi =
+        _mm_packs_epi32(_mm_srai_epi32(sum[2], FILTER_BITS),
+                        _mm_srai_epi32(sum[3], FILTER_BITS));
+    _mm_storeu_si128((__m128i *)(dst + j), _mm_packus_epi16(res_lo, res_hi));
+  }
+  if (j < width) {
+    const uint8_t *tail_rows[SUBPEL_TAPS];
+    for (int k = 0; k < SUBPEL_TAPS; ++k) tail_rows[k] = rows[k] + j;
+    av1_resize_vert_8tap_c(tail_rows, dst + j, width - j, filter);
+  }
+}
+
+// The pairs of taps are applied with _mm_maddubs_epi16(). The 2:1 filters have
+// their positive taps in the two middle pairs, so the sums fit in 16 bits until
+// the last pair is added. That addition saturates, to a value which is clipped
+// to 255 like the exact sum.
+void av1_resize_down2_horz_ssse3(const uint8_t *input, uint8_t *output,
+                                 int out_length, const int16_t *filter) {
+  const __m128i round = _mm_set1_epi16(1 << (FILTER_BITS - 1));
+  const __m128i coeff_01 = pair_coeffs_epi8(filter + 0);
+  const __m128i coeff_23 = pair_coeffs_epi8(filter + 2);
+  const __m128i coeff_45 = pair_coeffs_epi8(filter + 4);
+  const __m128i coeff_67 = pair_coeffs_epi8(filter + 6);
+  assert(filter[0] <= 0 && filter[1] <= 0 && filter[6] <= 0 && filter[7] <= 0);
+
+  int i = 0;
+  for (; i + 8 <= out_length; i += 8) {
+    const uint8_t *const in = input + 2 * i - (SUBPEL_TAPS / 2 - 1);
+    const __m128i v0 = _mm_loadu_si128((const __m128i *)in);
+    const __m128i v1 = _mm_loadu_si128((const __m128i *)(in + 16));
+    const __m128i res_01 = _mm_maddubs_epi16(v0, coeff_01);
+    const __m128i res_23 =
+        _mm_maddubs_epi16(_mm_alignr_epi8(v1, v0, 2), coeff_23);
+    const __m128i res_45 =
+        _mm_maddubs_epi16(_mm_alignr_epi8(v1, v0, 4), coeff_45);
+    const __m128i res_67 =
+        _mm_maddubs_epi16(_mm_alignr_epi8(v1, v0, 6), coeff_67);
+    const __m128i sum_0167 =
+        _mm_add_epi16(_mm_add_epi16(res_01, res_67), round);
+    const __m128i sum =
+        _mm_adds_epi16(_mm_add_epi16(sum_0167, res_23), res_45);
+    const __m128i res = _mm_srai_epi16(sum, FILTER_BITS);
+    _mm_storel_epi64((__m128i *)(output + i), _mm_packus_epi16(res, res));
+  }
+  if (i < out_length) {
+    av1_resize_down2_horz_c(input + 2 * i, output + i, out_length - i, filter);
+  }
+}
+
+// Returns the sum of the products of the 8 pixels at in by the 8 taps of
+// filter in each 32 bits, as 4 partial sums.
+static INLINE __m128i interp_madd(const uint8_t *in, const int16_t *filter) {
+  const __m128i data = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)in),
+                                         _mm_setzero_si128());
+  return _mm_madd_epi16(data, _mm_loadu_si128((const __m128i *)filter));
+}
+
+void av1_resize_interp_horz_ssse3(const uint8_t *input, uint8_t *output,
+                                  int out_length, int32_t y0, int32_t delta,
+                                  const int16_t *filters) {
+  const __m128i round = _mm_set1_epi32(1 << (FILTER_BITS - 1));
+  int32_t y = y0;
+  int x = 0;
+  for (; x + 8 <= out_length; x += 8) {
+    __m128i sum[8];
+    for (int k = 0; k < 8; ++k, y += delta) {
+      const int int_pel = y >> RS_SCALE_SUBPEL_BITS;
+      const int sub_pel = (y >> RS_SCALE_EXTRA_BITS) & RS_SUBPEL_MASK;
+      sum[k] = interp_madd(input + int_pel - (SUBPEL_TAPS / 2 - 1),
+                           filters + sub_pel * SUBPEL_TAPS);
+    }
+    const __m128i sum_0123 = _mm_hadd_epi32(_mm_hadd_epi32(sum[0], sum[1]),
+                                            _mm_hadd_epi32(sum[2], sum[3]));
+    const __m128i sum_4567 = _mm_hadd_epi32(_mm_hadd_epi32(sum[4], sum[5]),
+                                            _mm_hadd_epi32(sum[6], sum[7]));
+    const __m128i res = _mm_packs_epi32(
+        _mm_srai_epi32(_mm_add_epi32(sum_0123, round), FILTER_BITS),
+        _mm_srai_epi32(_mm_add_epi32(sum_4567, round), FILTER_BITS));
+    _mm_storel_epi64((__m128i *)(output + x), _mm_packus_epi16(res, res));
+  }
+  if (x < out_length) {
+    av1_resize_interp_horz_c(input, output + x, out_length - x, y, delta,
+                             filters);
+  }
+}
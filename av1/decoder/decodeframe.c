@@ -2523,30 +2523,9 @@ static INLINE int get_sync_range(int width) {
 static AOM_INLINE void dec_row_mt_alloc(AV1DecRowMTSync *dec_row_mt_sync,
                                         AV1_COMMON *cm, int rows) {
   dec_row_mt_sync->allocated_sb_rows = rows;
-#if CONFIG_MULTITHREAD
-  {
-    int i;
-
-    CHECK_MEM_ERROR(cm, dec_row_mt_sync->mutex_,
-                    aom_malloc(sizeof(*(dec_row_mt_sync->mutex_)) * rows));
-    if (dec_row_mt_sync->mutex_) {
-      for (i = 0; i < rows; ++i) {
-        pthread_mutex_init(&dec_row_mt_sync->mutex_[i], NULL);
-      }
-    }
-
-    CHECK_MEM_ERROR(cm, dec_row_mt_sync->cond_,
-                    aom_malloc(sizeof(*(dec_row_mt_sync->cond_)) * rows));
-    if (dec_row_mt_sync->cond_) {
-      for (i = 0; i < rows; ++i) {
-        pthread_cond_init(&dec_row_mt_sync->cond_[i], NULL);
-      }
-    }
-  }
-#endif  // CONFIG_MULTITHREAD
-
-  CHECK_MEM_ERROR(cm, dec_row_mt_sync->cur_sb_col,
-                  aom_malloc(sizeof(*(dec_row_mt_sync->cur_sb_col)) * rows));
+  if (aom_row_sync_alloc(&dec_row_mt_sync->cur_sb_col, rows))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate row synchronization");
 
   // Set up nsync.
   dec_row_mt_sync->sync_range = get_sync_range(cm->width);
@@ -2555,22 +2534,7 @@ static AOM_INLINE void dec_row_mt_alloc(AV1DecRowMTSync *dec_row_mt_sync,
 // Deallocate decoder row synchronization related mutex and data
 void av1_dec_row_mt_dealloc(AV1DecRowMTSync *dec_row_mt_sync) {
   if (dec_row_mt_sync != NULL) {
-#if CONFIG_MULTITHREAD
-    int i;
-    if (dec_row_mt_sync->mutex_ != NULL) {
-      for (i = 0; i < dec_row_mt_sync->allocated_sb_rows; ++i) {
-        pthread_mutex_destroy(&dec_row_mt_sync->mutex_[i]);
-      }
-      aom_free(dec_row_mt_sync->mutex_);
-    }
-    if (dec_row_mt_sync->cond_ != NULL) {
-      for (i = 0; i < dec_row_mt_sync->allocated_sb_rows; ++i) {
-        pthread_cond_destroy(&dec_row_mt_sync->cond_[i]);
-      }
-      aom_free(dec_row_mt_sync->cond_);
-    }
-#endif  // CONFIG_MULTITHREAD
-    aom_free(dec_row_mt_sync->cur_sb_col);
+    aom_row_sync_free(&dec_row_mt_sync->cur_sb_col);
 
     // clear the structure as the source of this call may be a resize in which
     // case this call will be followed by an _alloc() which may fail.
@@ -2583,15 +2547,8 @@ static INLINE void sync_read(AV1DecRowMTSync *const dec_row_mt_sync, int r,
 #if CONFIG_MULTITHREAD
   const int nsync = dec_row_mt_sync->sync_range;
 
-  if (r && !(c & (nsync - 1))) {
-    pthread_mutex_t *const mutex = &dec_row_mt_sync->mutex_[r - 1];
-    pthread_mutex_lock(mutex);
-
-    while (c > dec_row_mt_sync->cur_sb_col[r - 1] - nsync) {
-      pthread_cond_wait(&dec_row_mt_sync->cond_[r - 1], mutex);
-    }
-    pthread_mutex_unlock(mutex);
-  }
+  if (r && !(c & (nsync - 1)))
+    aom_row_sync_wait(&dec_row_mt_sync->cur_sb_col, r - 1, c + nsync);
 #else
   (void)dec_row_mt_sync;
   (void)r;
@@ -2613,14 +2570,7 @@ static INLINE void sync_write(AV1DecRowMTSync *const dec_row_mt_sync, int r,
     cur = sb_cols + nsync;
   }
 
-  if (sig) {
-    pthread_mutex_lock(&dec_row_mt_sync->mutex_[r]);
-
-    dec_row_mt_sync->cur_sb_col[r] = cur;
-
-    pthread_cond_signal(&dec_row_mt_sync->cond_[r]);
-    pthread_mutex_unlock(&dec_row_mt_sync->mutex_[r]);
-  }
+  if (sig) aom_row_sync_set(&dec_row_mt_sync->cur_sb_col, r, cur);
 #else
   (void)dec_row_mt_sync;
   (void)r;
@@ -2882,21 +2832,11 @@ static const uint8_t *decode_tiles(AV1Decoder *pbi, const uint8_t *data,
   return aom_reader_find_end(&tile_data->bit_reader);
 }
 
-static TileJobsDec *get_dec_job_info(AV1DecTileMT *tile_mt_info) {
-  TileJobsDec *cur_job_info = NULL;
-#if CONFIG_MULTITHREAD
-  pthread_mutex_lock(tile_mt_info->job_mutex);
-
-  if (tile_mt_info->jobs_dequeued < tile_mt_info->jobs_enqueued) {
-    cur_job_info = tile_mt_info->job_queue + tile_mt_info->jobs_dequeued;
-    tile_mt_info->jobs_dequeued++;
-  }
-
-  pthread_mutex_unlock(tile_mt_info->job_mutex);
-#else
-  (void)tile_mt_info;
-#endif
-  return cur_job_info;
+static TileJobsDec *get_dec_job_info(AV1DecTileMT *tile_mt_info,
+                                     int worker_idx) {
+  const int job = aom_job_scheduler_get_job(&tile_mt_info->job_sched,
+                                            worker_idx);
+  return job >= 0 ? tile_mt_info->job_queue + job : NULL;
 }
 
 static AOM_INLINE void tile_worker_hook_init(
@@ -2964,7 +2904,8 @@ static int tile_worker_hook(void *arg1, void *arg2) {
 
   assert(cm->tiles.cols > 0);
   while (!td->xd.corrupted) {
-    TileJobsDec *cur_job_info = get_dec_job_info(&pbi->tile_mt_info);
+    TileJobsDec *cur_job_info = get_dec_job_info(
+        &pbi->tile_mt_info, (int)(thread_data - pbi->thread_data));
 
     if (cur_job_info != NULL) {
       const TileBufferDec *const tile_buffer = cur_job_info->tile_buffer;
@@ -3175,6 +3116,32 @@ static AOM_INLINE void parse_tile_row_mt(AV1Decoder *pbi, ThreadData *const td,
   aom_merge_corrupted_flag(&td->xd.corrupted, corrupted);
 }
 
+// Records that the superblock row at 'mi_row' of one tile is reconstructed.
+// Returns the number of leading loop filter superblock rows which may be
+// deblocked: deblocking modifies the bottom pixels of a row, which the intra
+// prediction of the superblock row below it reads.
+// The caller must hold pbi->row_mt_mutex_ when calling this function.
+static int dec_sb_row_decoded(AV1Decoder *const pbi, int mi_row) {
+  AV1_COMMON *const cm = &pbi->common;
+  AV1DecRowMTInfo *frame_row_mt_info = &pbi->frame_row_mt_info;
+  const int mib_size_log2 = cm->seq_params.mib_size_log2;
+  const int mi_rows = cm->mi_params.mi_rows;
+  const int sb_rows = (mi_rows + (1 << mib_size_log2) - 1) >> mib_size_log2;
+
+  frame_row_mt_info->sb_row_tiles_decoded[mi_row >> mib_size_log2]++;
+  while (frame_row_mt_info->sb_rows_decoded < sb_rows &&
+         frame_row_mt_info
+                 ->sb_row_tiles_decoded[frame_row_mt_info->sb_rows_decoded] ==
+             cm->tiles.cols) {
+    frame_row_mt_info->sb_rows_decoded++;
+  }
+  if (frame_row_mt_info->sb_rows_decoded == sb_rows) return INT_MAX;
+  const int mi_rows_decoded = frame_row_mt_info->sb_rows_decoded
+                              << mib_size_log2;
+  return AOMMAX(0, (mi_rows_decoded - (1 << mib_size_log2)) >>
+                       MAX_MIB_SIZE_LOG2);
+}
+
 static int row_mt_worker_hook(void *arg1, void *arg2) {
   DecWorkerData *const thread_data = (DecWorkerData *)arg1;
   AV1Decoder *const pbi = (AV1Decoder *)arg2;
@@ -3198,6 +3165,8 @@ static int row_mt_worker_hook(void *arg1, void *arg2) {
     pthread_cond_broadcast(pbi->row_mt_cond_);
     pthread_mutex_unlock(pbi->row_mt_mutex_);
 #endif
+    if (frame_row_mt_info->filter_overlap)
+      av1_lf_pipeline_abort(&pbi->lf_row_sync);
     return 0;
   }
   thread_data->error_info.setjmp = 1;
@@ -3209,7 +3178,8 @@ static int row_mt_worker_hook(void *arg1, void *arg2) {
 
   assert(cm->tiles.cols > 0);
   while (!td->xd.corrupted) {
-    TileJobsDec *cur_job_info = get_dec_job_info(&pbi->tile_mt_info);
+    TileJobsDec *cur_job_info = get_dec_job_info(
+        &pbi->tile_mt_info, (int)(thread_data - pbi->thread_data));
 
     if (cur_job_info != NULL) {
       const TileBufferDec *const tile_buffer = cur_job_info->tile_buffer;
@@ -3247,6 +3217,8 @@ static int row_mt_worker_hook(void *arg1, void *arg2) {
     pthread_cond_broadcast(pbi->row_mt_cond_);
     pthread_mutex_unlock(pbi->row_mt_mutex_);
 #endif
+    if (frame_row_mt_info->filter_overlap)
+      av1_lf_pipeline_abort(&pbi->lf_row_sync);
     return 0;
   }
 
@@ -3285,13 +3257,25 @@ static int row_mt_worker_hook(void *arg1, void *arg2) {
 
     decode_tile_sb_row(pbi, td, tile_info, mi_row);
 
+    int lf_rows_ready = 0;
 #if CONFIG_MULTITHREAD
     pthread_mutex_lock(pbi->row_mt_mutex_);
 #endif
     dec_row_mt_sync->num_threads_working--;
+    if (frame_row_mt_info->filter_overlap)
+      lf_rows_ready = dec_sb_row_decoded(pbi, mi_row);
 #if CONFIG_MULTITHREAD
     pthread_mutex_unlock(pbi->row_mt_mutex_);
 #endif
+    if (frame_row_mt_info->filter_overlap)
+      av1_lf_pipeline_set_src_rows(&pbi->lf_row_sync, lf_rows_ready);
+  }
+
+  // Filter the rows which are already decoded while the other workers finish
+  // their decode jobs.
+  if (frame_row_mt_info->filter_overlap) {
+    av1_lf_pipeline_process(&pbi->lf_row_sync,
+                            (int)(thread_data - pbi->thread_data));
   }
   thread_data->error_info.setjmp = 0;
   return !td->xd.corrupted;
@@ -3311,7 +3295,6 @@ static AOM_INLINE void enqueue_tile_jobs(AV1Decoder *pbi, AV1_COMMON *cm,
   AV1DecTileMT *tile_mt_info = &pbi->tile_mt_info;
   TileJobsDec *tile_job_queue = tile_mt_info->job_queue;
   tile_mt_info->jobs_enqueued = 0;
-  tile_mt_info->jobs_dequeued = 0;
 
   for (int row = tile_rows_start; row < tile_rows_end; row++) {
     for (int col = tile_cols_start; col < tile_cols_end; col++) {
@@ -3328,20 +3311,13 @@ static AOM_INLINE void enqueue_tile_jobs(AV1Decoder *pbi, AV1_COMMON *cm,
 
 static AOM_INLINE void alloc_dec_jobs(AV1DecTileMT *tile_mt_info,
                                       AV1_COMMON *cm, int tile_rows,
-                                      int tile_cols) {
+                                      int tile_cols, int num_workers) {
   tile_mt_info->alloc_tile_rows = tile_rows;
   tile_mt_info->alloc_tile_cols = tile_cols;
   int num_tiles = tile_rows * tile_cols;
-#if CONFIG_MULTITHREAD
-  {
-    CHECK_MEM_ERROR(cm, tile_mt_info->job_mutex,
-                    aom_malloc(sizeof(*tile_mt_info->job_mutex) * num_tiles));
-
-    for (int i = 0; i < num_tiles; i++) {
-      pthread_mutex_init(&tile_mt_info->job_mutex[i], NULL);
-    }
-  }
-#endif
+  if (aom_job_scheduler_alloc(&tile_mt_info->job_sched, num_workers))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate tile job scheduler");
   CHECK_MEM_ERROR(cm, tile_mt_info->job_queue,
                   aom_malloc(sizeof(*tile_mt_info->job_queue) * num_tiles));
 }
@@ -3475,6 +3451,7 @@ static AOM_INLINE void decode_mt_init(AV1Decoder *pbi) {
 
       winterface->init(worker);
       worker->thread_name = "aom tile worker";
+      worker->pool = pbi->thread_pool;
       if (worker_idx < num_threads - 1 && !winterface->reset(worker)) {
         aom_internal_error(&cm->error, AOM_CODEC_ERROR,
                            "Tile decoder thread creation failed");
@@ -3508,17 +3485,21 @@ static AOM_INLINE void tile_mt_queue(AV1Decoder *pbi, int tile_cols,
                                      int tile_rows, int tile_rows_start,
                                      int tile_rows_end, int tile_cols_start,
                                      int tile_cols_end, int start_tile,
-                                     int end_tile) {
+                                     int end_tile, int num_workers) {
   AV1_COMMON *const cm = &pbi->common;
   if (pbi->tile_mt_info.alloc_tile_cols != tile_cols ||
-      pbi->tile_mt_info.alloc_tile_rows != tile_rows) {
+      pbi->tile_mt_info.alloc_tile_rows != tile_rows ||
+      pbi->tile_mt_info.job_sched.alloc_queues < num_workers) {
     av1_dealloc_dec_jobs(&pbi->tile_mt_info);
-    alloc_dec_jobs(&pbi->tile_mt_info, cm, tile_rows, tile_cols);
+    alloc_dec_jobs(&pbi->tile_mt_info, cm, tile_rows, tile_cols,
+                   pbi->max_threads);
   }
   enqueue_tile_jobs(pbi, cm, tile_rows_start, tile_rows_end, tile_cols_start,
                     tile_cols_end, start_tile, end_tile);
   qsort(pbi->tile_mt_info.job_queue, pbi->tile_mt_info.jobs_enqueued,
         sizeof(pbi->tile_mt_info.job_queue[0]), compare_tile_buffers);
+  aom_job_scheduler_reset(&pbi->tile_mt_info.job_sched,
+                          pbi->tile_mt_info.jobs_enqueued, num_workers);
 }
 
 static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
@@ -3594,7 +3575,8 @@ static const uint8_t *decode_tiles_mt(AV1Decoder *pbi, const uint8_t *data,
   }
 
   tile_mt_queue(pbi, tile_cols, tile_rows, tile_rows_start, tile_rows_end,
-                tile_cols_start, tile_cols_end, start_tile, end_tile);
+                tile_cols_start, tile_cols_end, start_tile, end_tile,
+                num_workers);
 
   reset_dec_workers(pbi, tile_worker_hook, num_workers);
   launch_dec_workers(pbi, data_end, num_workers);
@@ -3634,7 +3616,7 @@ static AOM_INLINE void dec_alloc_cb_buf(AV1Decoder *pbi) {
 static AOM_INLINE void row_mt_frame_init(AV1Decoder *pbi, int tile_rows_start,
                                          int tile_rows_end, int tile_cols_start,
                                          int tile_cols_end, int start_tile,
-                                         int end_tile, int max_sb_rows) {
+                                         int end_tile) {
   AV1_COMMON *const cm = &pbi->common;
   AV1DecRowMTInfo *frame_row_mt_info = &pbi->frame_row_mt_info;
 
@@ -3673,8 +3655,7 @@ static AOM_INLINE void row_mt_frame_init(AV1Decoder *pbi, int tile_rows_start,
           tile_data->dec_row_mt_sync.mi_rows;
 
       // Initialize cur_sb_col to -1 for all SB rows.
-      memset(tile_data->dec_row_mt_sync.cur_sb_col, -1,
-             sizeof(*tile_data->dec_row_mt_sync.cur_sb_col) * max_sb_rows);
+      aom_row_sync_reset(&tile_data->dec_row_mt_sync.cur_sb_col, -1);
     }
   }
 
@@ -3697,9 +3678,13 @@ static AOM_INLINE void row_mt_frame_init(AV1Decoder *pbi, int tile_rows_start,
 #endif
 }
 
+// If 'filter_overlap' is set, the in-loop filters are started while the frame
+// is being decoded, see av1_lf_pipeline_init().
 static const uint8_t *decode_tiles_row_mt(AV1Decoder *pbi, const uint8_t *data,
                                           const uint8_t *data_end,
-                                          int start_tile, int end_tile) {
+                                          int start_tile, int end_tile,
+                                          int filter_overlap, int do_cdef,
+                                          int save_lr_lines, int pipeline_lr) {
   AV1_COMMON *const cm = &pbi->common;
   CommonTileParams *const tiles = &cm->tiles;
   const int tile_cols = tiles->cols;
@@ -3794,17 +3779,47 @@ static const uint8_t *decode_tiles_row_mt(AV1Decoder *pbi, const uint8_t *data,
   }
 
   tile_mt_queue(pbi, tile_cols, tile_rows, tile_rows_start, tile_rows_end,
-                tile_cols_start, tile_cols_end, start_tile, end_tile);
+                tile_cols_start, tile_cols_end, start_tile, end_tile,
+                num_workers);
 
   dec_alloc_cb_buf(pbi);
 
   row_mt_frame_init(pbi, tile_rows_start, tile_rows_end, tile_cols_start,
-                    tile_cols_end, start_tile, end_tile, max_sb_rows);
+                    tile_cols_end, start_tile, end_tile);
+
+  AV1DecRowMTInfo *frame_row_mt_info = &pbi->frame_row_mt_info;
+  frame_row_mt_info->filter_overlap = filter_overlap;
+  if (filter_overlap) {
+    const int mib_size_log2 = cm->seq_params.mib_size_log2;
+    const int sb_rows =
+        (cm->mi_params.mi_rows + (1 << mib_size_log2) - 1) >> mib_size_log2;
+    if (frame_row_mt_info->allocated_sb_rows < sb_rows) {
+      aom_free(frame_row_mt_info->sb_row_tiles_decoded);
+      frame_row_mt_info->allocated_sb_rows = 0;
+      CHECK_MEM_ERROR(
+          cm, frame_row_mt_info->sb_row_tiles_decoded,
+          aom_malloc(sizeof(*frame_row_mt_info->sb_row_tiles_decoded) *
+                     sb_rows));
+      frame_row_mt_info->allocated_sb_rows = sb_rows;
+    }
+    memset(frame_row_mt_info->sb_row_tiles_decoded, 0,
+           sizeof(*frame_row_mt_info->sb_row_tiles_decoded) * sb_rows);
+    frame_row_mt_info->sb_rows_decoded = 0;
+    av1_lf_pipeline_init(&cm->cur_frame->buf, cm, &pbi->mb, do_cdef,
+                         save_lr_lines,
+                         pipeline_lr ? &pbi->lr_row_sync : NULL, &pbi->lr_ctxt,
+                         0, num_workers, &pbi->lf_row_sync);
+  }
 
   reset_dec_workers(pbi, row_mt_worker_hook, num_workers);
   launch_dec_workers(pbi, data_end, num_workers);
   sync_dec_workers(pbi, num_workers);
 
+  if (filter_overlap) {
+    av1_lf_pipeline_finish(&pbi->lf_row_sync);
+    frame_row_mt_info->filter_overlap = 0;
+  }
+
   if (pbi->mb.corrupted)
     aom_internal_error(&cm->error, AOM_CODEC_CORRUPT_FRAME,
                        "Failed to decode tile data");
@@ -5210,10 +5225,49 @@ void av1_decode_tg_tiles_and_wrapup(AV1Decoder *pbi, const uint8_t *data,
   av1_loop_filter_frame_init(cm, 0, num_planes);
 #endif
 
-  if (pbi->max_threads > 1 && !(tiles->large_scale && !pbi->ext_tile_debug) &&
-      pbi->row_mt)
-    *p_data_end =
-        decode_tiles_row_mt(pbi, data, data_end, start_tile, end_tile);
+  const int apply_loop_filters =
+      !cm->features.allow_intrabc && !tiles->single_tile_decoding;
+  const int do_loop_filter = cm->lf.filter_level[0] || cm->lf.filter_level[1];
+  const int do_loop_restoration =
+      cm->rst_info[0].frame_restoration_type != RESTORE_NONE ||
+      cm->rst_info[1].frame_restoration_type != RESTORE_NONE ||
+      cm->rst_info[2].frame_restoration_type != RESTORE_NONE;
+  const int do_cdef =
+      !pbi->skip_loop_filter && !cm->features.coded_lossless &&
+      (cm->cdef_info.cdef_bits || cm->cdef_info.cdef_strengths[0] ||
+       cm->cdef_info.cdef_uv_strengths[0]);
+  const int do_superres = av1_superres_scaled(cm);
+  const int optimized_loop_restoration = !do_cdef && !do_superres;
+  const int use_row_mt = pbi->max_threads > 1 &&
+                         !(tiles->large_scale && !pbi->ext_tile_debug) &&
+                         pbi->row_mt;
+#if CONFIG_LPF_MASK || !CONFIG_MULTITHREAD
+  const int filter_overlap = 0;
+#else
+  // Deblocking (and CDEF) start while the frame is being decoded. This needs
+  // the whole frame to be in this tile group.
+  const int filter_overlap =
+      use_row_mt && apply_loop_filters && do_loop_filter &&
+      !tiles->large_scale && start_tile == 0 &&
+      end_tile == tiles->rows * tiles->cols - 1;
+#endif
+#if CONFIG_LPF_MASK
+  const int pipeline_lf_cdef = 0;
+#else
+  // Run CDEF on the rows which are already deblocked instead of waiting for
+  // the whole frame.
+  const int pipeline_lf_cdef = do_loop_filter && do_cdef &&
+                               (filter_overlap || pbi->num_workers > 1);
+#endif
+  // Without superres, loop restoration runs on the rows which are already
+  // filtered by CDEF too.
+  const int pipeline_lr =
+      pipeline_lf_cdef && do_loop_restoration && !do_superres;
+
+  if (use_row_mt)
+    *p_data_end = decode_tiles_row_mt(
+        pbi, data, data_end, start_tile, end_tile, filter_overlap, do_cdef,
+        do_cdef && do_loop_restoration, filter_overlap && pipeline_lr);
   else if (pbi->max_threads > 1 && tile_count_tg > 1 &&
            !(tiles->large_scale && !pbi->ext_tile_debug))
     *p_data_end = decode_tiles_mt(pbi, data, data_end, start_tile, end_tile);
@@ -5229,45 +5283,53 @@ void av1_decode_tg_tiles_and_wrapup(AV1Decoder *pbi, const uint8_t *data,
     return;
   }
 
-  if (!cm->features.allow_intrabc && !tiles->single_tile_decoding) {
-    if (cm->lf.filter_level[0] || cm->lf.filter_level[1]) {
-      if (pbi->num_workers > 1) {
-        av1_loop_filter_frame_mt(
-            &cm->cur_frame->buf, cm, &pbi->mb, 0, num_planes, 0,
+  if (apply_loop_filters) {
+    // With filter_overlap, the deblocking (and CDEF) are already done by the
+    // decode workers.
+    if (!filter_overlap) {
+      if (pipeline_lf_cdef) {
+        av1_loop_filter_cdef_frame_mt(
+            &cm->cur_frame->buf, cm, &pbi->mb, do_loop_restoration,
+            pipeline_lr ? &pbi->lr_row_sync : NULL, &pbi->lr_ctxt,
+            pbi->tile_workers, pbi->num_workers, &pbi->lf_row_sync);
+      } else if (do_loop_filter) {
+        if (pbi->num_workers > 1) {
+          av1_loop_filter_frame_mt(
+              &cm->cur_frame->buf, cm, &pbi->mb, 0, num_planes, 0,
 #if CONFIG_LPF_MASK
-            1,
+              1,
 #endif
-            pbi->tile_workers, pbi->num_workers, &pbi->lf_row_sync);
-      } else {
-        av1_loop_filter_frame(&cm->cur_frame->buf, cm, &pbi->mb,
+              pbi->tile_workers, pbi->num_workers, &pbi->lf_row_sync);
+        } else {
+          av1_loop_filter_frame(&cm->cur_frame->buf, cm, &pbi->mb,
 #if CONFIG_LPF_MASK
-                              1,
+                                1,
 #endif
-                              0, num_planes, 0);
+                                0, num_planes, 0);
+        }
       }
     }
 
-    const int do_loop_restoration =
-        cm->rst_info[0].frame_restoration_type != RESTORE_NONE ||
-        cm->rst_info[1].frame_restoration_type != RESTORE_NONE ||
-        cm->rst_info[2].frame_restoration_type != RESTORE_NONE;
-    const int do_cdef =
-        !pbi->skip_loop_filter && !cm->features.coded_lossless &&
-        (cm->cdef_info.cdef_bits || cm->cdef_info.cdef_strengths[0] ||
-         cm->cdef_info.cdef_uv_strengths[0]);
-    const int do_superres = av1_superres_scaled(cm);
-    const int optimized_loop_restoration = !do_cdef && !do_superres;
-
     if (!optimized_loop_restoration) {
-      if (do_loop_restoration)
-        av1_loop_restoration_save_boundary_lines(&pbi->common.cur_frame->buf,
-                                                 cm, 0);
-
-      if (do_cdef) av1_cdef_frame(&pbi->common.cur_frame->buf, cm, &pbi->mb);
+      if (!pipeline_lf_cdef) {
+        if (do_loop_restoration)
+          av1_loop_restoration_save_boundary_lines(&pbi->common.cur_frame->buf,
+                                                   cm, 0);
+
+        if (do_cdef) {
+          if (pbi->num_workers > 1) {
+            av1_cdef_frame_mt(&pbi->common.cur_frame->buf, cm, &pbi->mb,
+                              pbi->tile_workers, pbi->num_workers,
+                              &pbi->cdef_sync);
+          } else {
+            av1_cdef_frame(&pbi->common.cur_frame->buf, cm, &pbi->mb);
+          }
+        }
+      }
 
       superres_post_decode(pbi);
 
-      if (do_loop_restoration) {
+      if (do_loop_restoration && !pipeline_lr) {
         av1_loop_restoration_save_boundary_lines(&pbi->common.cur_frame->buf,
                                                  cm, 1);
         if (pbi->num_workers > 1) {
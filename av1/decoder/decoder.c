@@ -154,12 +154,7 @@ AV1Decoder *av1_decoder_create(BufferPool *const pool) {
 
 void av1_dealloc_dec_jobs(struct AV1DecTileMTData *tile_mt_info) {
   if (tile_mt_info != NULL) {
-#if CONFIG_MULTITHREAD
-    if (tile_mt_info->job_mutex != NULL) {
-      pthread_mutex_destroy(tile_mt_info->job_mutex);
-      aom_free(tile_mt_info->job_mutex);
-    }
-#endif
+    aom_job_scheduler_free(&tile_mt_info->job_sched);
     aom_free(tile_mt_info->job_queue);
     // clear the structure as the source of this call may be a resize in which
     // case this call will be followed by an _alloc() which may fail.
@@ -211,12 +206,14 @@ void av1_decoder_remove(AV1Decoder *pbi) {
     TileDataDec *const tile_data = pbi->tile_data + i;
     av1_dec_row_mt_dealloc(&tile_data->dec_row_mt_sync);
   }
+  aom_free(pbi->frame_row_mt_info.sb_row_tiles_decoded);
   aom_free(pbi->tile_data);
   aom_free(pbi->tile_workers);
 
   if (pbi->num_workers > 0) {
     av1_loop_filter_dealloc(&pbi->lf_row_sync);
-    av1_loop_restoration_dealloc(&pbi->lr_row_sync, pbi->num_workers);
+    av1_loop_restoration_dealloc(&pbi->lr_row_sync);
+    av1_cdef_sync_dealloc(&pbi->cdef_sync);
     av1_dealloc_dec_jobs(&pbi->tile_mt_info);
   }
 
@@ -17,6 +17,8 @@
 #include "aom/aom_codec.h"
 #include "aom_dsp/bitreader.h"
 #include "aom_scale/yv12config.h"
+#include "aom_util/aom_job_scheduler.h"
+#include "aom_util/aom_row_sync.h"
 #include "aom_util/aom_thread.h"
 
 #include "av1/common/av1_common_int.h"
@@ -73,12 +75,9 @@ typedef struct AV1DecRowMTJobInfo {
 } AV1DecRowMTJobInfo;
 
 typedef struct AV1DecRowMTSyncData {
-#if CONFIG_MULTITHREAD
-  pthread_mutex_t *mutex_;
-  pthread_cond_t *cond_;
-#endif
   int allocated_sb_rows;
-  int *cur_sb_col;
+  // Index of the last decoded superblock in each row.
+  AVxRowSync cur_sb_col;
   int sync_range;
   int mi_rows;
   int mi_cols;
@@ -115,6 +114,16 @@ typedef struct AV1DecRowMTInfo {
   // Boolean: Initialized to 0 (false). Set to 1 (true) on error to abort
   // decoding.
   int row_mt_exit;
+
+  // Boolean: The in-loop filters run on pbi->lf_row_sync while the frame is
+  // being decoded. The workers join them once there are no decode jobs left.
+  int filter_overlap;
+  // Number of tile columns which have reconstructed each superblock row of
+  // the frame, and the number of leading superblock rows which are completely
+  // reconstructed.
+  int *sb_row_tiles_decoded;
+  int allocated_sb_rows;
+  int sb_rows_decoded;
 } AV1DecRowMTInfo;
 
 typedef struct TileDataDec {
@@ -145,12 +154,10 @@ typedef struct TileJobsDec {
 } TileJobsDec;
 
 typedef struct AV1DecTileMTData {
-#if CONFIG_MULTITHREAD
-  pthread_mutex_t *job_mutex;
-#endif
+  // Hands out the jobs of job_queue to the tile workers.
+  AVxJobScheduler job_sched;
   TileJobsDec *job_queue;
   int jobs_enqueued;
-  int jobs_dequeued;
   int alloc_tile_rows;
   int alloc_tile_cols;
 } AV1DecTileMT;
@@ -164,8 +171,12 @@ typedef struct AV1Decoder {
   AV1LfSync lf_row_sync;
   AV1LrSync lr_row_sync;
   AV1LrStruct lr_ctxt;
+  AV1CdefSync cdef_sync;
   AVxWorker *tile_workers;
   int num_workers;
+  // If not NULL, the tile workers run on this pool instead of their own
+  // threads.
+  aom_thread_pool_t *thread_pool;
   DecWorkerData *thread_data;
   ThreadData td;
   TileDataDec *tile_data;
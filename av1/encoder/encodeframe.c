@@ -5324,12 +5324,11 @@ static INLINE int64_t calc_erroradv_threshold(AV1_COMP *cpi,
 }
 
 static void compute_global_motion_for_ref_frame(
-    AV1_COMP *cpi, YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES], int frame,
-    int *num_frm_corners, int *frm_corners, unsigned char *frm_buffer,
-    MotionModel *params_by_motion, uint8_t *segment_map,
-    const int segment_map_w, const int segment_map_h,
+    AV1_COMP *cpi, ThreadData *td, YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES],
+    int frame, const int num_frm_corners, int *frm_corners,
+    unsigned char *frm_buffer, MotionModel *params_by_motion,
+    uint8_t *segment_map, const int segment_map_w, const int segment_map_h,
     const WarpedMotionParams *ref_params) {
-  ThreadData *const td = &cpi->td;
   MACROBLOCK *const x = &td->mb;
   AV1_COMMON *const cm = &cpi->common;
   MACROBLOCKD *const xd = &x->e_mbd;
@@ -5343,14 +5342,12 @@ static void compute_global_motion_for_ref_frame(
   const double *params_this_motion;
   int inliers_by_motion[RANSAC_NUM_MOTIONS];
   assert(ref_buf[frame] != NULL);
-  if (*num_frm_corners < 0) {
-    // compute interest points using FAST features
-    *num_frm_corners = av1_fast_corner_detect(
-        frm_buffer, cpi->source->y_width, cpi->source->y_height,
-        cpi->source->y_stride, frm_corners, MAX_CORNERS);
-  }
+  RefCntBuffer *const ref = get_ref_frame_buf(cm, frame);
+  assert(&ref->buf == ref_buf[frame]);
   TransformationType model;
 
+  av1_gm_detect_ref_corners(cpi, ref);
+
   aom_clear_system_state();
 
   // TODO(sarahparker, debargha): Explore do_adaptive_gm_estimation = 1
@@ -5375,9 +5372,10 @@ static void compute_global_motion_for_ref_frame(
 
     av1_compute_global_motion(
         model, frm_buffer, cpi->source->y_width, cpi->source->y_height,
-        cpi->source->y_stride, frm_corners, *num_frm_corners, ref_buf[frame],
-        cpi->common.seq_params.bit_depth, gm_estimation_type, inliers_by_motion,
-        params_by_motion, RANSAC_NUM_MOTIONS);
+        cpi->source->y_stride, frm_corners, num_frm_corners, ref_buf[frame],
+        ref->corners, ref->num_corners, cpi->common.seq_params.bit_depth,
+        gm_estimation_type, inliers_by_motion, params_by_motion,
+        RANSAC_NUM_MOTIONS);
     int64_t ref_frame_error = 0;
     for (i = 0; i < RANSAC_NUM_MOTIONS; ++i) {
       if (inliers_by_motion[i] == 0) continue;
@@ -5452,11 +5450,6 @@ static void compute_global_motion_for_ref_frame(
   aom_clear_system_state();
 }
 
-typedef struct {
-  int distance;
-  MV_REFERENCE_FRAME frame;
-} FrameDistPair;
-
 static INLINE void update_valid_ref_frames_for_gm(
     AV1_COMP *cpi, YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES],
     FrameDistPair *past_ref_frame, FrameDistPair *future_ref_frame,
@@ -5505,20 +5498,21 @@ static INLINE void update_valid_ref_frames_for_gm(
   }
 }
 
-static INLINE void compute_gm_for_valid_ref_frames(
-    AV1_COMP *cpi, YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES], int frame,
-    int *num_frm_corners, int *frm_corners, unsigned char *frm_buffer,
-    MotionModel *params_by_motion, uint8_t *segment_map,
-    const int segment_map_w, const int segment_map_h) {
+static INLINE void compute_gm_for_valid_ref_frames(AV1_COMP *cpi,
+                                                   ThreadData *td, int frame) {
   AV1_COMMON *const cm = &cpi->common;
   GlobalMotionInfo *const gm_info = &cpi->gm_info;
+  GlobalMotionJobInfo *const job_info = &cpi->gm_job_info;
+  GlobalMotionThreadData *const gm_data = &td->gm_data;
   const WarpedMotionParams *ref_params =
       cm->prev_frame ? &cm->prev_frame->global_motion[frame]
                      : &default_warp_params;
 
   compute_global_motion_for_ref_frame(
-      cpi, ref_buf, frame, num_frm_corners, frm_corners, frm_buffer,
-      params_by_motion, segment_map, segment_map_w, segment_map_h, ref_params);
+      cpi, td, job_info->ref_buf, frame, job_info->num_frm_corners,
+      job_info->frm_corners, job_info->frm_buffer, gm_data->params_by_motion,
+      gm_data->segment_map, job_info->segment_map_w, job_info->segment_map_h,
+      ref_params);
 
   gm_info->params_cost[frame] =
       gm_get_params_cost(&cm->global_motion[frame], ref_params,
@@ -5537,32 +5531,103 @@ static int compare_distance(const void *a, const void *b) {
   return 0;
 }
 
-static INLINE void compute_global_motion_for_references(
-    AV1_COMP *cpi, YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES],
-    FrameDistPair reference_frame[REF_FRAMES - 1], int num_ref_frames,
-    int *num_frm_corners, int *frm_corners, unsigned char *frm_buffer,
-    MotionModel *params_by_motion, uint8_t *segment_map,
-    const int segment_map_w, const int segment_map_h) {
+// Gets the next reference frame whose global motion is not pruned by a
+// nearer reference frame of the same direction yet.
+static int get_next_gm_job(GlobalMotionJobInfo *job_info, int *dir,
+                           int *index) {
+  int found = 0;
+#if CONFIG_MULTITHREAD
+  if (job_info->mutex_ != NULL) pthread_mutex_lock(job_info->mutex_);
+#endif
+  while (!found && job_info->next_job < GM_NUM_DIRECTIONS * (REF_FRAMES - 1)) {
+    const int job = job_info->next_job++;
+    *dir = job % GM_NUM_DIRECTIONS;
+    *index = job / GM_NUM_DIRECTIONS;
+    found = *index < job_info->num_ref_frames[*dir] &&
+            *index < job_info->early_exit[*dir];
+  }
+#if CONFIG_MULTITHREAD
+  if (job_info->mutex_ != NULL) pthread_mutex_unlock(job_info->mutex_);
+#endif
+  return found;
+}
+
+void av1_compute_global_motion_for_references(AV1_COMP *cpi, ThreadData *td) {
   AV1_COMMON *const cm = &cpi->common;
+  GlobalMotionJobInfo *const job_info = &cpi->gm_job_info;
+  int dir, index;
   // Compute global motion w.r.t. reference frames starting from the nearest ref
   // frame in a given direction
-  for (int frame = 0; frame < num_ref_frames; frame++) {
-    int ref_frame = reference_frame[frame].frame;
-    compute_gm_for_valid_ref_frames(cpi, ref_buf, ref_frame, num_frm_corners,
-                                    frm_corners, frm_buffer, params_by_motion,
-                                    segment_map, segment_map_w, segment_map_h);
+  while (get_next_gm_job(job_info, &dir, &index)) {
+    const FrameDistPair *const reference_frame =
+        &job_info->reference_frame[dir][index];
+    const int ref_frame = reference_frame->frame;
+    compute_gm_for_valid_ref_frames(cpi, td, ref_frame);
     // If global motion w.r.t. current ref frame is
     // INVALID/TRANSLATION/IDENTITY, skip the evaluation of global motion w.r.t
     // the remaining ref frames in that direction. The below exit is disabled
     // when ref frame distance w.r.t. current frame is zero. E.g.:
     // source_alt_ref_frame w.r.t. ARF frames
     if (cpi->sf.gm_sf.prune_ref_frame_for_gm_search &&
-        reference_frame[frame].distance != 0 &&
-        cm->global_motion[ref_frame].wmtype != ROTZOOM)
-      break;
+        reference_frame->distance != 0 &&
+        cm->global_motion[ref_frame].wmtype != ROTZOOM) {
+#if CONFIG_MULTITHREAD
+      if (job_info->mutex_ != NULL) pthread_mutex_lock(job_info->mutex_);
+#endif
+      job_info->early_exit[dir] = AOMMIN(job_info->early_exit[dir], index);
+#if CONFIG_MULTITHREAD
+      if (job_info->mutex_ != NULL) pthread_mutex_unlock(job_info->mutex_);
+#endif
+    }
   }
 }
 
+void av1_gm_detect_ref_corners(AV1_COMP *cpi, RefCntBuffer *ref) {
+  AV1_COMMON *const cm = &cpi->common;
+  YV12_BUFFER_CONFIG *const buf = &ref->buf;
+  if (ref->corners_valid) return;
+
+  unsigned char *buffer = buf->y_buffer;
+  if (buf->flags & YV12_FLAG_HIGHBITDEPTH) {
+    buffer = av1_downconvert_frame(buf, cm->seq_params.bit_depth);
+  }
+  if (ref->corners == NULL) {
+    CHECK_MEM_ERROR(cm, ref->corners,
+                    aom_malloc(sizeof(*ref->corners) * 2 * MAX_CORNERS));
+  }
+  ref->num_corners =
+      av1_fast_corner_detect(buffer, buf->y_width, buf->y_height,
+                             buf->y_stride, ref->corners, MAX_CORNERS);
+  ref->corners_valid = 1;
+}
+
+void av1_gm_alloc_data(AV1_COMP *cpi, GlobalMotionThreadData *gm_data) {
+  AV1_COMMON *const cm = &cpi->common;
+  const GlobalMotionJobInfo *const job_info = &cpi->gm_job_info;
+  for (int m = 0; m < RANSAC_NUM_MOTIONS; m++) {
+    memset(&gm_data->params_by_motion[m], 0,
+           sizeof(gm_data->params_by_motion[m]));
+    CHECK_MEM_ERROR(
+        cm, gm_data->params_by_motion[m].inliers,
+        aom_malloc(sizeof(*(gm_data->params_by_motion[m].inliers)) * 2 *
+                   MAX_CORNERS));
+  }
+  const int segment_map_size =
+      job_info->segment_map_w * job_info->segment_map_h;
+  CHECK_MEM_ERROR(
+      cm, gm_data->segment_map,
+      aom_calloc(segment_map_size, sizeof(*gm_data->segment_map)));
+}
+
+void av1_gm_dealloc_data(GlobalMotionThreadData *gm_data) {
+  for (int m = 0; m < RANSAC_NUM_MOTIONS; m++) {
+    aom_free(gm_data->params_by_motion[m].inliers);
+    gm_data->params_by_motion[m].inliers = NULL;
+  }
+  aom_free(gm_data->segment_map);
+  gm_data->segment_map = NULL;
+}
+
 static AOM_INLINE void setup_prune_ref_frame_mask(AV1_COMP *cpi) {
   if (!cpi->sf.rt_sf.use_nonrd_pick_mode &&
       cpi->sf.inter_sf.selective_ref_frame >= 2) {
@@ -5816,47 +5881,31 @@ static AOM_INLINE void encode_frame_internal(AV1_COMP *cpi) {
   av1_zero(gm_info->params_cost);
   if (cpi->common.current_frame.frame_type == INTER_FRAME && cpi->source &&
       cpi->oxcf.enable_global_motion && !gm_info->search_done) {
-    YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES];
-    MotionModel params_by_motion[RANSAC_NUM_MOTIONS];
-    for (int m = 0; m < RANSAC_NUM_MOTIONS; m++) {
-      memset(&params_by_motion[m], 0, sizeof(params_by_motion[m]));
-      params_by_motion[m].inliers =
-          aom_malloc(sizeof(*(params_by_motion[m].inliers)) * 2 * MAX_CORNERS);
-    }
-
-    int num_frm_corners = -1;
-    int frm_corners[2 * MAX_CORNERS];
-    unsigned char *frm_buffer = cpi->source->y_buffer;
+    GlobalMotionJobInfo *const job_info = &cpi->gm_job_info;
+    job_info->frm_buffer = cpi->source->y_buffer;
     if (cpi->source->flags & YV12_FLAG_HIGHBITDEPTH) {
       // The frame buffer is 16-bit, so we need to convert to 8 bits for the
       // following code. We cache the result until the frame is released.
-      frm_buffer =
+      job_info->frm_buffer =
           av1_downconvert_frame(cpi->source, cpi->common.seq_params.bit_depth);
     }
-    const int segment_map_w =
+    job_info->segment_map_w =
         (cpi->source->y_width + WARP_ERROR_BLOCK) >> WARP_ERROR_BLOCK_LOG;
-    const int segment_map_h =
+    job_info->segment_map_h =
         (cpi->source->y_height + WARP_ERROR_BLOCK) >> WARP_ERROR_BLOCK_LOG;
 
-    uint8_t *segment_map =
-        aom_malloc(sizeof(*segment_map) * segment_map_w * segment_map_h);
-    memset(segment_map, 0,
-           sizeof(*segment_map) * segment_map_w * segment_map_h);
-
-    FrameDistPair future_ref_frame[REF_FRAMES - 1] = {
-      { -1, NONE_FRAME }, { -1, NONE_FRAME }, { -1, NONE_FRAME },
-      { -1, NONE_FRAME }, { -1, NONE_FRAME }, { -1, NONE_FRAME },
-      { -1, NONE_FRAME }
-    };
-    FrameDistPair past_ref_frame[REF_FRAMES - 1] = {
-      { -1, NONE_FRAME }, { -1, NONE_FRAME }, { -1, NONE_FRAME },
-      { -1, NONE_FRAME }, { -1, NONE_FRAME }, { -1, NONE_FRAME },
-      { -1, NONE_FRAME }
-    };
+    FrameDistPair *const past_ref_frame = job_info->reference_frame[0];
+    FrameDistPair *const future_ref_frame = job_info->reference_frame[1];
+    for (i = 0; i < REF_FRAMES - 1; i++) {
+      past_ref_frame[i].distance = -1;
+      past_ref_frame[i].frame = NONE_FRAME;
+      future_ref_frame[i].distance = -1;
+      future_ref_frame[i].frame = NONE_FRAME;
+    }
     int num_past_ref_frames = 0;
     int num_future_ref_frames = 0;
     // Populate ref_buf for valid ref frames in global motion
-    update_valid_ref_frames_for_gm(cpi, ref_buf, past_ref_frame,
+    update_valid_ref_frames_for_gm(cpi, job_info->ref_buf, past_ref_frame,
                                    future_ref_frame, &num_past_ref_frames,
                                    &num_future_ref_frames);
 
@@ -5866,27 +5915,31 @@ static AOM_INLINE void encode_frame_internal(AV1_COMP *cpi) {
           compare_distance);
     qsort(future_ref_frame, num_future_ref_frames, sizeof(future_ref_frame[0]),
           compare_distance);
+    job_info->num_ref_frames[0] = num_past_ref_frames;
+    job_info->num_ref_frames[1] = num_future_ref_frames;
+
+    const int num_ref_frames = num_past_ref_frames + num_future_ref_frames;
+    if (num_ref_frames > 0) {
+      // compute interest points using FAST features
+      job_info->num_frm_corners = av1_fast_corner_detect(
+          job_info->frm_buffer, cpi->source->y_width, cpi->source->y_height,
+          cpi->source->y_stride, job_info->frm_corners, MAX_CORNERS);
+      for (int dir = 0; dir < GM_NUM_DIRECTIONS; dir++) {
+        job_info->early_exit[dir] = REF_FRAMES - 1;
+      }
+      job_info->next_job = 0;
 
-    // Compute global motion w.r.t. past reference frames
-    if (num_past_ref_frames > 0)
-      compute_global_motion_for_references(
-          cpi, ref_buf, past_ref_frame, num_past_ref_frames, &num_frm_corners,
-          frm_corners, frm_buffer, params_by_motion, segment_map, segment_map_w,
-          segment_map_h);
-
-    // Compute global motion w.r.t. future reference frames
-    if (num_future_ref_frames > 0)
-      compute_global_motion_for_references(
-          cpi, ref_buf, future_ref_frame, num_future_ref_frames,
-          &num_frm_corners, frm_corners, frm_buffer, params_by_motion,
-          segment_map, segment_map_w, segment_map_h);
-
-    aom_free(segment_map);
+      // Compute global motion w.r.t. past and future reference frames
+      if (cpi->oxcf.max_threads > 1 && num_ref_frames > 1) {
+        av1_global_motion_estimation_mt(cpi);
+      } else {
+        av1_gm_alloc_data(cpi, &cpi->td.gm_data);
+        av1_compute_global_motion_for_references(cpi, &cpi->td);
+        av1_gm_dealloc_data(&cpi->td.gm_data);
+      }
+    }
 
     gm_info->search_done = 1;
-    for (int m = 0; m < RANSAC_NUM_MOTIONS; m++) {
-      aom_free(params_by_motion[m].inliers);
-    }
   }
   memcpy(cm->cur_frame->global_motion, cm->global_motion,
          REF_FRAMES * sizeof(WarpedMotionParams));
@@ -28,6 +28,8 @@ struct macroblock;
 struct yv12_buffer_config;
 struct AV1_COMP;
 struct ThreadData;
+struct RefCntBuffer;
+struct GlobalMotionThreadData;
 
 void av1_setup_src_planes(struct macroblock *x,
                           const struct yv12_buffer_config *src, int mi_row,
@@ -42,6 +44,18 @@ void av1_encode_tile(struct AV1_COMP *cpi, struct ThreadData *td, int tile_row,
 void av1_encode_sb_row(struct AV1_COMP *cpi, struct ThreadData *td,
                        int tile_row, int tile_col, int mi_row);
 
+// Computes the global motion of the reference frames of cpi->gm_job_info
+// which are left, with the buffers of 'td'.
+void av1_compute_global_motion_for_references(struct AV1_COMP *cpi,
+                                              struct ThreadData *td);
+// Detects the corners of the reference buffer 'ref' unless they are cached
+// in it already. A buffer keeps its corners until it is reassigned, so they
+// are detected once for all the frames which use it as a reference.
+void av1_gm_detect_ref_corners(struct AV1_COMP *cpi, struct RefCntBuffer *ref);
+void av1_gm_alloc_data(struct AV1_COMP *cpi,
+                       struct GlobalMotionThreadData *gm_data);
+void av1_gm_dealloc_data(struct GlobalMotionThreadData *gm_data);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -64,6 +64,7 @@
 #include "av1/encoder/hash_motion.h"
 #include "av1/encoder/mv_prec.h"
 #include "av1/encoder/pass2_strategy.h"
+#include "av1/encoder/pickcdef.h"
 #include "av1/encoder/picklpf.h"
 #include "av1/encoder/pickrst.h"
 #include "av1/encoder/random.h"
@@ -3635,6 +3636,7 @@ void av1_remove_compressor(AV1_COMP *cpi) {
       av1_free_pc_tree(cpi, thread_data->td, num_planes,
                        cm->seq_params.sb_size);
       aom_free(thread_data->td->mbmi_ext);
+      aom_free(thread_data->td->rst_tmpbuf);
       aom_free(thread_data->td);
     }
   }
@@ -3645,12 +3647,20 @@ void av1_remove_compressor(AV1_COMP *cpi) {
   }
 #endif
   av1_row_mt_mem_dealloc(cpi);
+  av1_tpl_mt_mem_dealloc(&cpi->tpl_mt_info);
+  av1_tf_mt_dealloc(&cpi->tf_ctx);
+  av1_free_firstpass_data(&cpi->fp_data);
+  av1_gm_mt_dealloc(&cpi->gm_job_info);
+  av1_pick_rst_mt_dealloc(&cpi->rst_search_mt_info);
+  av1_cdef_search_mt_dealloc(&cpi->cdef_search_mt_info);
+  av1_pick_lpf_mt_dealloc(&cpi->pick_lpf_mt_info);
   aom_free(cpi->tile_thr_data);
   aom_free(cpi->workers);
 
   if (cpi->num_workers > 1) {
     av1_loop_filter_dealloc(&cpi->lf_row_sync);
-    av1_loop_restoration_dealloc(&cpi->lr_row_sync, cpi->num_workers);
+    av1_loop_restoration_dealloc(&cpi->lr_row_sync);
+    av1_cdef_sync_dealloc(&cpi->cdef_sync);
   }
 
   dealloc_compressor_data(cpi);
@@ -3723,6 +3733,9 @@ int av1_set_reference_enc(AV1_COMP *cpi, int idx, YV12_BUFFER_CONFIG *sd) {
   YV12_BUFFER_CONFIG *cfg = get_ref_frame(cm, idx);
   if (cfg) {
     aom_yv12_copy_frame(sd, cfg, num_planes);
+    // The cached data derived from the previous content is stale now.
+    cfg->buf_8bit_valid = 0;
+    cm->ref_frame_map[idx]->corners_valid = 0;
     return 0;
   } else {
     return -1;
@@ -4031,15 +4044,26 @@ void av1_set_screen_content_options(const AV1_COMP *cpi,
   // Counts of blocks with no more than color_thresh colors and variance larger
   // than var_thresh.
   int counts_2 = 0;
+  // The colors of the blocks may have been counted by the lookahead.
+  const struct lookahead_stats *const stats =
+      av1_lookahead_get_stats(cpi->lookahead, cpi->unfiltered_source);
+  const uint16_t *block_colors =
+      stats != NULL && (stats->flags & LOOKAHEAD_STATS_BLOCK_COLORS) &&
+              stats->bit_depth == bd
+          ? stats->block_colors
+          : NULL;
 
   for (int r = 0; r + blk_h <= height; r += blk_h) {
     for (int c = 0; c + blk_w <= width; c += blk_w) {
       int count_buf[1 << 12];  // Maximum (1 << 12) color levels.
       const uint8_t *const this_src = src + r * stride + c;
       const int n_colors =
-          use_hbd ? av1_count_colors_highbd(this_src, stride, blk_w, blk_h, bd,
-                                            count_buf)
-                  : av1_count_colors(this_src, stride, blk_w, blk_h, count_buf);
+          block_colors != NULL
+              ? *block_colors++
+              : use_hbd ? av1_count_colors_highbd(this_src, stride, blk_w,
+                                                  blk_h, bd, count_buf)
+                        : av1_count_colors(this_src, stride, blk_w, blk_h,
+                                           count_buf);
       if (n_colors > 1 && n_colors <= color_thresh) {
         ++counts_1;
         struct buf_2d buf;
@@ -4798,6 +4822,22 @@ static void superres_post_encode(AV1_COMP *cpi) {
   }
 }
 
+// Returns the source frame scaled to the coded frame size. The frames of the
+// lookahead keep their scaled copies, so that they are scaled once for all
+// the recodes and again when they are the last source frame.
+static YV12_BUFFER_CONFIG *scale_source_if_required(
+    AV1_COMP *cpi, YV12_BUFFER_CONFIG *unscaled, YV12_BUFFER_CONFIG *scaled) {
+  AV1_COMMON *const cm = &cpi->common;
+  if (cm->width == unscaled->y_crop_width &&
+      cm->height == unscaled->y_crop_height)
+    return unscaled;
+  YV12_BUFFER_CONFIG *const cached = av1_lookahead_get_scaled(
+      cpi->lookahead, unscaled, cm->width, cm->height,
+      (int)cm->seq_params.bit_depth, av1_num_planes(cm),
+      cpi->oxcf.border_in_pixels, cm->features.byte_alignment);
+  return cached != NULL ? cached : av1_scale_if_required(cm, unscaled, scaled);
+}
+
 static void cdef_restoration_frame(AV1_COMP *cpi, AV1_COMMON *cm,
                                    MACROBLOCKD *xd, int use_restoration,
                                    int use_cdef) {
@@ -4809,11 +4849,15 @@ static void cdef_restoration_frame(AV1_COMP *cpi, AV1_COMMON *cm,
     start_timing(cpi, cdef_time);
 #endif
     // Find CDEF parameters
-    av1_cdef_search(&cm->cur_frame->buf, cpi->source, cm, xd,
+    av1_cdef_search(cpi, &cm->cur_frame->buf, cpi->source, xd,
                     cpi->sf.lpf_sf.cdef_pick_method, cpi->td.mb.rdmult);
 
     // Apply the filter
-    av1_cdef_frame(&cm->cur_frame->buf, cm, xd);
+    if (cpi->num_workers > 1)
+      av1_cdef_frame_mt(&cm->cur_frame->buf, cm, xd, cpi->workers,
+                        cpi->num_workers, &cpi->cdef_sync);
+    else
+      av1_cdef_frame(&cm->cur_frame->buf, cm, xd);
 #if CONFIG_COLLECT_COMPONENT_TIMING
     end_timing(cpi, cdef_time);
 #endif
@@ -5335,10 +5379,10 @@ static void determine_sc_tools_with_encoding(AV1_COMP *cpi, const int q_orig) {
   aom_clear_system_state();
 
   cpi->source =
-      av1_scale_if_required(cm, cpi->unscaled_source, &cpi->scaled_source);
+      scale_source_if_required(cpi, cpi->unscaled_source, &cpi->scaled_source);
   if (cpi->unscaled_last_source != NULL) {
-    cpi->last_source = av1_scale_if_required(cm, cpi->unscaled_last_source,
-                                             &cpi->scaled_last_source);
+    cpi->last_source = scale_source_if_required(
+        cpi, cpi->unscaled_last_source, &cpi->scaled_last_source);
   }
 
   setup_frame(cpi);
@@ -5495,11 +5539,11 @@ static int encode_with_recode_loop(AV1_COMP *cpi, size_t *size, uint8_t *dest) {
         gm_info->search_done = 0;
       }
     }
-    cpi->source =
-        av1_scale_if_required(cm, cpi->unscaled_source, &cpi->scaled_source);
+    cpi->source = scale_source_if_required(cpi, cpi->unscaled_source,
+                                           &cpi->scaled_source);
     if (cpi->unscaled_last_source != NULL) {
-      cpi->last_source = av1_scale_if_required(cm, cpi->unscaled_last_source,
-                                               &cpi->scaled_last_source);
+      cpi->last_source = scale_source_if_required(
+          cpi, cpi->unscaled_last_source, &cpi->scaled_last_source);
     }
 
     if (!frame_is_intra_only(cm)) {
@@ -6634,8 +6678,12 @@ static int apply_denoise_2d(AV1_COMP *cpi, YV12_BUFFER_CONFIG *sd,
     }
     memset(cpi->film_grain_table, 0, sizeof(*cpi->film_grain_table));
   }
-  if (aom_denoise_and_model_run(cpi->denoise_and_model, sd,
-                                &cm->film_grain_params)) {
+  // The encoder workers are idle between frames. They are created by the
+  // first multi-threaded stage of the encoding, so the frames received before
+  // are denoised on the calling thread only.
+  if (aom_denoise_and_model_run_mt(cpi->denoise_and_model, sd,
+                                   &cm->film_grain_params, cpi->workers,
+                                   cpi->num_workers)) {
     if (cm->film_grain_params.apply_grain) {
       aom_film_grain_table_append(cpi->film_grain_table, time_stamp, end_time,
                                   &cm->film_grain_params);
@@ -6645,6 +6693,20 @@ static int apply_denoise_2d(AV1_COMP *cpi, YV12_BUFFER_CONFIG *sd,
 }
 #endif
 
+// Returns the statistics which the lookahead computes on the source frames in
+// the background for the first pass and the screen content detection.
+static int get_lookahead_stats_flags(const AV1_COMP *cpi) {
+  int stats_flags = 0;
+#if !CONFIG_REALTIME_ONLY
+  if (cpi->oxcf.pass == 1 || cpi->lap_enabled)
+    stats_flags |= LOOKAHEAD_STATS_RAW_MOTION_ERR;
+#endif
+  if (cpi->common.seq_params.force_screen_content_tools == 2 &&
+      cpi->oxcf.mode != REALTIME && cpi->oxcf.content != AOM_CONTENT_SCREEN)
+    stats_flags |= LOOKAHEAD_STATS_BLOCK_COLORS;
+  return stats_flags;
+}
+
 int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
                           YV12_BUFFER_CONFIG *sd, int64_t time_stamp,
                           int64_t end_time) {
@@ -6677,6 +6739,8 @@ int av1_receive_raw_frame(AV1_COMP *cpi, aom_enc_frame_flags_t frame_flags,
       res = -1;
 #endif  //  CONFIG_DENOISE
 
+  av1_lookahead_set_stats(cpi->lookahead, get_lookahead_stats_flags(cpi),
+                          seq_params->bit_depth, cpi->oxcf.max_threads > 1);
   if (av1_lookahead_push(cpi->lookahead, sd, time_stamp, end_time,
                          use_highbitdepth, frame_flags))
     res = -1;
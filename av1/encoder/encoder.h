@@ -33,6 +33,7 @@
 #include "av1/encoder/context_tree.h"
 #include "av1/encoder/encodemb.h"
 #include "av1/encoder/firstpass.h"
+#include "av1/encoder/global_motion.h"
 #include "av1/encoder/level.h"
 #include "av1/encoder/lookahead.h"
 #include "av1/encoder/mcomp.h"
@@ -50,6 +51,8 @@
 #include "aom_dsp/noise_model.h"
 #endif
 #include "aom/internal/aom_codec_internal.h"
+#include "aom_util/aom_job_scheduler.h"
+#include "aom_util/aom_row_sync.h"
 #include "aom_util/aom_thread.h"
 
 #ifdef __cplusplus
@@ -605,12 +608,8 @@ typedef struct inter_modes_info {
 
 // Encoder row synchronization
 typedef struct AV1RowMTSyncData {
-#if CONFIG_MULTITHREAD
-  pthread_mutex_t *mutex_;
-  pthread_cond_t *cond_;
-#endif
-  // Allocate memory to store the sb/mb block index in each row.
-  int *cur_col;
+  // Index of the last encoded sb/mb block in each row.
+  AVxRowSync cur_col;
   int sync_range;
   int rows;
 } AV1RowMTSync;
@@ -709,6 +708,156 @@ typedef struct MultiThreadHandle {
   int thread_id_to_tile_id[MAX_NUM_THREADS];  // Mapping of threads to tiles
 } MultiThreadHandle;
 
+// Maximum number of frames of a GF group whose tpl stats are computed at the
+// same time.
+#define MAX_TPL_PARALLEL_FRAMES 4
+
+// A frame whose tpl stats are computed by mc_flow_dispenser().
+typedef struct TplDispenserFrame {
+  int frame_idx;
+  struct scale_factors sf;
+  const YV12_BUFFER_CONFIG *ref_frame[INTER_REFS_PER_FRAME];
+  const YV12_BUFFER_CONFIG *src_frame[INTER_REFS_PER_FRAME];
+  // Mode info written while the frame is processed. Frames processed at the
+  // same time may not share it.
+  CommonModeInfoParams *mi_params;
+  // Index of the last processed block in each block row.
+  AV1RowMTSync row_mt_sync;
+} TplDispenserFrame;
+
+typedef struct TplMultiThreadInfo {
+  // The frames processed at the same time. None of them is a reference of
+  // another one.
+  TplDispenserFrame frames[MAX_TPL_PARALLEL_FRAMES];
+  int num_frames;
+  // Number of block rows of each frame.
+  int num_rows;
+  // Mode info of frames[0] to frames[num_frames - 2]. It only has the mode
+  // info of the top-left corner of each block. The last frame uses the mode
+  // info of cm.
+  CommonModeInfoParams mi_params[MAX_TPL_PARALLEL_FRAMES - 1];
+  // Hands out the block rows of the frames to the workers.
+  AVxJobScheduler job_sched;
+  int allocated_rows;
+  int allocated_mi_rows;
+  int allocated_mi_cols;
+  int allocated_workers;
+  void (*sync_read_ptr)(AV1RowMTSync *const, int, int);
+  void (*sync_write_ptr)(AV1RowMTSync *const, int, int, const int);
+} TplMultiThreadInfo;
+
+typedef struct {
+  int64_t sum;
+  int64_t sse;
+} FRAME_DIFF;
+
+// Parameters of the temporal filtering of one frame, shared by the workers.
+typedef struct TemporalFilterCtx {
+  YV12_BUFFER_CONFIG **frames;
+  int num_frames;
+  int filter_frame_idx;
+  int is_key_frame;
+  int is_second_arf;
+  BLOCK_SIZE block_size;
+  const struct scale_factors *scale;
+  int strength;
+  const double *noise_levels;
+  int mb_rows;
+  int mb_cols;
+  // Hands out the block rows to the workers.
+  AVxJobScheduler job_sched;
+  int allocated_workers;
+} TemporalFilterCtx;
+
+// Buffers of a thread doing temporal filtering. The accumulator and the count
+// only hold one block, which is normalized before the next one is filtered.
+typedef struct TemporalFilterData {
+  MB_MODE_INFO *tmp_mbmi;
+  uint8_t *pred8;
+  uint16_t *pred16;
+  uint32_t *accum;
+  uint16_t *count;
+  // Difference between the filtered and the source blocks of the thread.
+  FRAME_DIFF diff;
+} TemporalFilterData;
+
+// Buffers of a thread computing the global motion of a reference frame.
+typedef struct GlobalMotionThreadData {
+  MotionModel params_by_motion[RANSAC_NUM_MOTIONS];
+  uint8_t *segment_map;
+} GlobalMotionThreadData;
+
+// State of the first pass of a frame, shared by the threads encoding its
+// block rows.
+typedef struct FirstPassData {
+  // Stats of each block. They are merged in raster order, so that the stats
+  // of the frame do not depend on the number of threads.
+  FRAME_STATS *mb_stats;
+  // Motion vector of each block, used to count the new motion vectors.
+  MV *mb_mvs;
+  // Motion error of each block with the last source frame as reference.
+  int *raw_motion_err_list;
+  // Motion errors with the last source frame computed by the lookahead, or
+  // NULL.
+  const int *lookahead_raw_motion_err;
+  int allocated_mbs;
+  const YV12_BUFFER_CONFIG *last_frame;
+  const YV12_BUFFER_CONFIG *golden_frame;
+  const YV12_BUFFER_CONFIG *alt_ref_frame;
+  YV12_BUFFER_CONFIG *this_frame;
+  TileInfo tile;
+  int qindex;
+  AV1RowMTSync row_mt_sync;
+  // Hands out the block rows to the workers.
+  AVxJobScheduler job_sched;
+  int allocated_rows;
+  int allocated_workers;
+  void (*sync_read_ptr)(AV1RowMTSync *const, int, int);
+  void (*sync_write_ptr)(AV1RowMTSync *const, int, int, const int);
+} FirstPassData;
+
+// Loop restoration search of a plane, shared by the workers searching its
+// rows of restoration units.
+typedef struct RestSearchMTInfo {
+  // The RestSearchCtxt of the plane, which is private to pickrst.c.
+  void *rsc;
+  // Searches the restoration type being evaluated for one unit.
+  rest_unit_visitor_t search_unit;
+  // Number of rows of restoration units of the plane.
+  int unit_rows;
+  AV1RowMTSync row_mt_sync;
+  // Hands out the rows of restoration units to the workers.
+  AVxJobScheduler job_sched;
+  int allocated_rows;
+  int allocated_workers;
+} RestSearchMTInfo;
+
+// CDEF strength search of a frame, shared by the workers computing the
+// distortions of its filter blocks.
+typedef struct CdefSearchMTInfo {
+  // The CdefSearchCtx of the frame, which is private to pickcdef.c.
+  void *ctx;
+  // Number of filter blocks to search.
+  int num_fbs;
+  // Hands out the filter blocks to the workers.
+  AVxJobScheduler job_sched;
+  int allocated_workers;
+} CdefSearchMTInfo;
+
+// Error of a loop filter level tried on a plane, shared by the workers
+// measuring it and restoring the unfiltered plane, one band of rows each.
+typedef struct PickLpfMTInfo {
+  const YV12_BUFFER_CONFIG *src;
+  int plane;
+  int num_bands;
+  // Error of each band, summed once all of them are done.
+  int64_t *band_sse;
+  int allocated_bands;
+  // Hands out the bands to the workers.
+  AVxJobScheduler job_sched;
+  int allocated_workers;
+} PickLpfMTInfo;
+
 typedef struct RD_COUNTS {
   int64_t comp_pred_diff[REFERENCE_MODES];
   // Stores number of 4x4 blocks using global motion per reference frame.
@@ -745,6 +894,10 @@ typedef struct ThreadData {
   MB_MODE_INFO_EXT *mbmi_ext;
   VP64x64 *vt64x64;
   int32_t num_64x64_blocks;
+  TemporalFilterData tf_data;
+  GlobalMotionThreadData gm_data;
+  // Scratch buffer of the loop restoration search.
+  int32_t *rst_tmpbuf;
 } ThreadData;
 
 struct EncWorkerData;
@@ -884,6 +1037,40 @@ typedef struct {
   bool search_done;
 } GlobalMotionInfo;
 
+typedef struct {
+  int distance;
+  MV_REFERENCE_FRAME frame;
+} FrameDistPair;
+
+// Number of directions of the reference frames in the global motion search:
+// the past and the future reference frames.
+#define GM_NUM_DIRECTIONS 2
+
+// Global motion search of a frame, shared by the threads computing the global
+// motion of its reference frames.
+typedef struct GlobalMotionJobInfo {
+  YV12_BUFFER_CONFIG *ref_buf[REF_FRAMES];
+  // Reference frames of each direction, from the nearest to the farthest.
+  FrameDistPair reference_frame[GM_NUM_DIRECTIONS][REF_FRAMES - 1];
+  int num_ref_frames[GM_NUM_DIRECTIONS];
+  // Index of the first reference frame of each direction which prunes the
+  // search of the farther ones.
+  int early_exit[GM_NUM_DIRECTIONS];
+  // The jobs are the reference frames of both directions, interleaved from
+  // the nearest to the farthest: job = 2 * index + direction.
+  int next_job;
+  // Corners of the source frame, shared by all the reference frames.
+  unsigned char *frm_buffer;
+  int frm_corners[2 * MAX_CORNERS];
+  int num_frm_corners;
+  int segment_map_w;
+  int segment_map_h;
+#if CONFIG_MULTITHREAD
+  // Protects next_job and early_exit.
+  pthread_mutex_t *mutex_;
+#endif
+} GlobalMotionJobInfo;
+
 typedef struct {
   // Stores the default value of skip flag depending on chroma format
   // Set as 1 for monochrome and 3 for other color formats
@@ -1142,6 +1329,7 @@ typedef struct AV1_COMP {
 
   // Parameters related to global motion search.
   GlobalMotionInfo gm_info;
+  GlobalMotionJobInfo gm_job_info;
 
   // Parameters related to winner mode processing.
   WinnerModeParams winner_mode_params;
@@ -1263,6 +1451,8 @@ typedef struct AV1_COMP {
   // Multi-threading
   int num_workers;
   AVxWorker *workers;
+  // If not NULL, the workers run on this pool instead of their own threads.
+  aom_thread_pool_t *thread_pool;
   struct EncWorkerData *tile_thr_data;
   int existing_fb_idx_to_show;
   int internal_altref_allowed;
@@ -1278,6 +1468,7 @@ typedef struct AV1_COMP {
   AV1LfSync lf_row_sync;
   AV1LrSync lr_row_sync;
   AV1LrStruct lr_ctxt;
+  AV1CdefSync cdef_sync;
 
   aom_film_grain_table_t *film_grain_table;
 #if CONFIG_DENOISE
@@ -1288,6 +1479,12 @@ typedef struct AV1_COMP {
   InterpSearchFlags interp_search_flags;
 
   MultiThreadHandle multi_thread_ctxt;
+  TplMultiThreadInfo tpl_mt_info;
+  TemporalFilterCtx tf_ctx;
+  FirstPassData fp_data;
+  RestSearchMTInfo rst_search_mt_info;
+  CdefSearchMTInfo cdef_search_mt_info;
+  PickLpfMTInfo pick_lpf_mt_info;
   void (*row_mt_sync_read_ptr)(AV1RowMTSync *const, int, int);
   void (*row_mt_sync_write_ptr)(AV1RowMTSync *const, int, int, const int);
 #if CONFIG_MULTITHREAD
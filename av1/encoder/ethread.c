@@ -13,7 +13,12 @@
 #include "av1/encoder/encodeframe.h"
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/ethread.h"
+#include "av1/encoder/pickcdef.h"
+#include "av1/encoder/picklpf.h"
+#include "av1/encoder/pickrst.h"
 #include "av1/encoder/rdopt.h"
+#include "av1/encoder/temporal_filter.h"
+#include "av1/encoder/tpl_model.h"
 #include "aom_dsp/aom_dsp_common.h"
 
 static AOM_INLINE void accumulate_rd_opt(ThreadData *td, ThreadData *td_t) {
@@ -102,15 +107,7 @@ void av1_row_mt_sync_read(AV1RowMTSync *const row_mt_sync, int r, int c) {
 #if CONFIG_MULTITHREAD
   const int nsync = row_mt_sync->sync_range;
 
-  if (r) {
-    pthread_mutex_t *const mutex = &row_mt_sync->mutex_[r - 1];
-    pthread_mutex_lock(mutex);
-
-    while (c > row_mt_sync->cur_col[r - 1] - nsync) {
-      pthread_cond_wait(&row_mt_sync->cond_[r - 1], mutex);
-    }
-    pthread_mutex_unlock(mutex);
-  }
+  if (r) aom_row_sync_wait(&row_mt_sync->cur_col, r - 1, c + nsync);
 #else
   (void)row_mt_sync;
   (void)r;
@@ -133,14 +130,7 @@ void av1_row_mt_sync_write(AV1RowMTSync *const row_mt_sync, int r, int c,
     cur = cols + nsync;
   }
 
-  if (sig) {
-    pthread_mutex_lock(&row_mt_sync->mutex_[r]);
-
-    row_mt_sync->cur_col[r] = cur;
-
-    pthread_cond_signal(&row_mt_sync->cond_[r]);
-    pthread_mutex_unlock(&row_mt_sync->mutex_[r]);
-  }
+  if (sig) aom_row_sync_set(&row_mt_sync->cur_col, r, cur);
 #else
   (void)row_mt_sync;
   (void)r;
@@ -153,30 +143,9 @@ void av1_row_mt_sync_write(AV1RowMTSync *const row_mt_sync, int r, int c,
 void av1_row_mt_sync_mem_alloc(AV1RowMTSync *row_mt_sync, AV1_COMMON *cm,
                                int rows) {
   row_mt_sync->rows = rows;
-#if CONFIG_MULTITHREAD
-  {
-    int i;
-
-    CHECK_MEM_ERROR(cm, row_mt_sync->mutex_,
-                    aom_malloc(sizeof(*row_mt_sync->mutex_) * rows));
-    if (row_mt_sync->mutex_) {
-      for (i = 0; i < rows; ++i) {
-        pthread_mutex_init(&row_mt_sync->mutex_[i], NULL);
-      }
-    }
-
-    CHECK_MEM_ERROR(cm, row_mt_sync->cond_,
-                    aom_malloc(sizeof(*row_mt_sync->cond_) * rows));
-    if (row_mt_sync->cond_) {
-      for (i = 0; i < rows; ++i) {
-        pthread_cond_init(&row_mt_sync->cond_[i], NULL);
-      }
-    }
-  }
-#endif  // CONFIG_MULTITHREAD
-
-  CHECK_MEM_ERROR(cm, row_mt_sync->cur_col,
-                  aom_malloc(sizeof(*row_mt_sync->cur_col) * rows));
+  if (aom_row_sync_alloc(&row_mt_sync->cur_col, rows))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate row synchronization");
 
   // Set up nsync.
   row_mt_sync->sync_range = 1;
@@ -185,23 +154,7 @@ void av1_row_mt_sync_mem_alloc(AV1RowMTSync *row_mt_sync, AV1_COMMON *cm,
 // Deallocate row based multi-threading synchronization related mutex and data
 void av1_row_mt_sync_mem_dealloc(AV1RowMTSync *row_mt_sync) {
   if (row_mt_sync != NULL) {
-#if CONFIG_MULTITHREAD
-    int i;
-
-    if (row_mt_sync->mutex_ != NULL) {
-      for (i = 0; i < row_mt_sync->rows; ++i) {
-        pthread_mutex_destroy(&row_mt_sync->mutex_[i]);
-      }
-      aom_free(row_mt_sync->mutex_);
-    }
-    if (row_mt_sync->cond_ != NULL) {
-      for (i = 0; i < row_mt_sync->rows; ++i) {
-        pthread_cond_destroy(&row_mt_sync->cond_[i]);
-      }
-      aom_free(row_mt_sync->cond_);
-    }
-#endif  // CONFIG_MULTITHREAD
-    aom_free(row_mt_sync->cur_col);
+    aom_row_sync_free(&row_mt_sync->cur_col);
     // clear the structure as the source of this call may be dynamic change
     // in tiles in which case this call will be followed by an _alloc()
     // which may fail.
@@ -414,6 +367,7 @@ static AOM_INLINE void create_enc_workers(AV1_COMP *cpi, int num_workers) {
     ++cpi->num_workers;
     winterface->init(worker);
     worker->thread_name = "aom enc worker";
+    worker->pool = cpi->thread_pool;
 
     thread_data->cpi = cpi;
     thread_data->thread_id = i;
@@ -702,8 +656,7 @@ void av1_encode_tiles_row_mt(AV1_COMP *cpi) {
       TileDataEnc *this_tile = &cpi->tile_data[tile_id];
 
       // Initialize cur_col to -1 for all rows.
-      memset(this_tile->row_mt_sync.cur_col, -1,
-             sizeof(*this_tile->row_mt_sync.cur_col) * max_sb_rows);
+      aom_row_sync_reset(&this_tile->row_mt_sync.cur_col, -1);
       this_tile->row_mt_info.current_mi_row = this_tile->tile_info.mi_row_start;
       this_tile->row_mt_info.num_threads_working = 0;
 
@@ -727,3 +680,479 @@ void av1_encode_tiles_row_mt(AV1_COMP *cpi) {
   if (cm->delta_q_info.delta_lf_present_flag) update_delta_lf_for_row_mt(cpi);
   accumulate_counters_enc_workers(cpi, num_workers);
 }
+
+static AOM_INLINE void tpl_mt_mem_alloc(AV1_COMP *cpi, int num_workers) {
+  AV1_COMMON *const cm = &cpi->common;
+  const CommonModeInfoParams *const mi_params = &cm->mi_params;
+  TplMultiThreadInfo *const tpl_mt_info = &cpi->tpl_mt_info;
+  const BLOCK_SIZE bsize = convert_length_to_bsize(MC_FLOW_BSIZE_1D);
+  const int mi_size_1d = mi_size_wide[bsize];
+
+  for (int i = 0; i < MAX_TPL_PARALLEL_FRAMES; ++i) {
+    av1_row_mt_sync_mem_alloc(&tpl_mt_info->frames[i].row_mt_sync, cm,
+                              tpl_mt_info->num_rows);
+  }
+
+  // The copies of the mode info only have one MB_MODE_INFO per block.
+  for (int i = 0; i < MAX_TPL_PARALLEL_FRAMES - 1; ++i) {
+    CommonModeInfoParams *const mi_copy = &tpl_mt_info->mi_params[i];
+    const int aligned_mi_rows = calc_mi_size(mi_params->mi_rows);
+    mi_copy->mi_rows = mi_params->mi_rows;
+    mi_copy->mi_cols = mi_params->mi_cols;
+    mi_copy->mi_stride = mi_params->mi_stride;
+    mi_copy->mi_alloc_bsize = bsize;
+    mi_copy->mi_alloc_stride =
+        (mi_params->mi_stride + mi_size_1d - 1) / mi_size_1d;
+    mi_copy->mi_alloc_size =
+        mi_copy->mi_alloc_stride * (aligned_mi_rows / mi_size_1d);
+    mi_copy->mi_grid_size = mi_params->mi_stride * aligned_mi_rows;
+    CHECK_MEM_ERROR(cm, mi_copy->mi_alloc,
+                    aom_calloc(mi_copy->mi_alloc_size,
+                               sizeof(*mi_copy->mi_alloc)));
+    CHECK_MEM_ERROR(cm, mi_copy->mi_grid_base,
+                    aom_calloc(mi_copy->mi_grid_size,
+                               sizeof(*mi_copy->mi_grid_base)));
+  }
+
+  if (aom_job_scheduler_alloc(&tpl_mt_info->job_sched, num_workers))
+    aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                       "Failed to allocate tpl job scheduler");
+
+  tpl_mt_info->allocated_rows = tpl_mt_info->num_rows;
+  tpl_mt_info->allocated_mi_rows = mi_params->mi_rows;
+  tpl_mt_info->allocated_mi_cols = mi_params->mi_cols;
+  tpl_mt_info->allocated_workers = num_workers;
+}
+
+void av1_tpl_mt_mem_dealloc(TplMultiThreadInfo *tpl_mt_info) {
+  for (int i = 0; i < MAX_TPL_PARALLEL_FRAMES; ++i) {
+    av1_row_mt_sync_mem_dealloc(&tpl_mt_info->frames[i].row_mt_sync);
+  }
+  for (int i = 0; i < MAX_TPL_PARALLEL_FRAMES - 1; ++i) {
+    aom_free(tpl_mt_info->mi_params[i].mi_alloc);
+    aom_free(tpl_mt_info->mi_params[i].mi_grid_base);
+    av1_zero(tpl_mt_info->mi_params[i]);
+  }
+  aom_job_scheduler_free(&tpl_mt_info->job_sched);
+  tpl_mt_info->allocated_rows = 0;
+  tpl_mt_info->allocated_mi_rows = 0;
+  tpl_mt_info->allocated_mi_cols = 0;
+  tpl_mt_info->allocated_workers = 0;
+}
+
+// Copies the mode info which mode_estimation() reads before it writes it: the
+// mode info of the top-left corner of each block.
+static AOM_INLINE void copy_tpl_mode_info(const CommonModeInfoParams *src,
+                                          CommonModeInfoParams *dst) {
+  const int step = mi_size_wide[dst->mi_alloc_bsize];
+  for (int mi_row = 0; mi_row < src->mi_rows; mi_row += step) {
+    for (int mi_col = 0; mi_col < src->mi_cols; mi_col += step) {
+      dst->mi_alloc[get_alloc_mi_idx(dst, mi_row, mi_col)] =
+          src->mi_alloc[get_alloc_mi_idx(src, mi_row, mi_col)];
+    }
+  }
+  dst->tx_type_map = src->tx_type_map;
+}
+
+static int tpl_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  TplMultiThreadInfo *const tpl_mt_info = &cpi->tpl_mt_info;
+  MACROBLOCK *const x = &thread_data->td->mb;
+  const int mi_height = mi_size_high[convert_length_to_bsize(MC_FLOW_BSIZE_1D)];
+  int job;
+  (void)unused;
+
+  while ((job = aom_job_scheduler_get_job(&tpl_mt_info->job_sched,
+                                          thread_data->thread_id)) >= 0) {
+    // The rows of the frames are interleaved, so that all the frames keep
+    // the workers busy.
+    TplDispenserFrame *const frame =
+        &tpl_mt_info->frames[job % tpl_mt_info->num_frames];
+    const int mi_row = (job / tpl_mt_info->num_frames) * mi_height;
+    av1_mc_flow_dispenser_row(cpi, x, frame, mi_row);
+  }
+  return 1;
+}
+
+void av1_mc_flow_dispenser_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  const CommonModeInfoParams *const mi_params = &cm->mi_params;
+  TplMultiThreadInfo *const tpl_mt_info = &cpi->tpl_mt_info;
+  const int num_frames = tpl_mt_info->num_frames;
+  const int num_jobs = tpl_mt_info->num_rows * num_frames;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads, num_jobs);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+  if (tpl_mt_info->allocated_rows < tpl_mt_info->num_rows ||
+      tpl_mt_info->allocated_mi_rows != mi_params->mi_rows ||
+      tpl_mt_info->allocated_mi_cols != mi_params->mi_cols ||
+      tpl_mt_info->allocated_workers < num_workers) {
+    av1_tpl_mt_mem_dealloc(tpl_mt_info);
+    tpl_mt_mem_alloc(cpi, num_workers);
+  }
+
+  for (int i = 0; i < num_frames; ++i) {
+    aom_row_sync_reset(&tpl_mt_info->frames[i].row_mt_sync.cur_col, -1);
+  }
+  // The frames processed at the same time write their own mode info, except
+  // the last one, so that cm ends up with the same mode info as if the frames
+  // were processed one after the other.
+  for (int i = 0; i < num_frames - 1; ++i) {
+    copy_tpl_mode_info(mi_params, &tpl_mt_info->mi_params[i]);
+    tpl_mt_info->frames[i].mi_params = &tpl_mt_info->mi_params[i];
+  }
+  tpl_mt_info->sync_read_ptr = av1_row_mt_sync_read;
+  tpl_mt_info->sync_write_ptr = av1_row_mt_sync_write;
+  aom_job_scheduler_reset(&tpl_mt_info->job_sched, num_jobs, num_workers);
+
+  prepare_enc_workers(cpi, tpl_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+}
+
+void av1_tf_mt_dealloc(TemporalFilterCtx *tf_ctx) {
+  aom_job_scheduler_free(&tf_ctx->job_sched);
+  tf_ctx->allocated_workers = 0;
+}
+
+static int tf_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  int mb_row;
+  (void)unused;
+
+  while ((mb_row = aom_job_scheduler_get_job(&cpi->tf_ctx.job_sched,
+                                             thread_data->thread_id)) >= 0) {
+    av1_tf_do_filtering_row(cpi, thread_data->td, mb_row);
+  }
+  return 1;
+}
+
+void av1_tf_do_filtering_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  TemporalFilterCtx *const tf_ctx = &cpi->tf_ctx;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads, tf_ctx->mb_rows);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+  if (tf_ctx->allocated_workers < num_workers) {
+    av1_tf_mt_dealloc(tf_ctx);
+    if (aom_job_scheduler_alloc(&tf_ctx->job_sched, num_workers))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate temporal filter job scheduler");
+    tf_ctx->allocated_workers = num_workers;
+  }
+  aom_job_scheduler_reset(&tf_ctx->job_sched, tf_ctx->mb_rows, num_workers);
+
+  // The main thread uses the buffers of cpi->td, which the caller allocates.
+  for (int i = num_workers - 1; i > 0; i--) {
+    av1_tf_alloc_data(cpi, &cpi->tile_thr_data[i].td->tf_data);
+  }
+
+  prepare_enc_workers(cpi, tf_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+
+  // The sums of the block errors do not depend on the order of the blocks.
+  FRAME_DIFF *const diff = &cpi->td.tf_data.diff;
+  for (int i = num_workers - 1; i > 0; i--) {
+    TemporalFilterData *const tf_data = &cpi->tile_thr_data[i].td->tf_data;
+    diff->sum += tf_data->diff.sum;
+    diff->sse += tf_data->diff.sse;
+    av1_tf_dealloc_data(tf_data);
+  }
+}
+
+static int fp_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  int mb_row;
+  (void)unused;
+
+  while ((mb_row = aom_job_scheduler_get_job(&cpi->fp_data.job_sched,
+                                             thread_data->thread_id)) >= 0) {
+    av1_first_pass_row(cpi, thread_data->td, mb_row);
+  }
+  return 1;
+}
+
+void av1_first_pass_row_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  FirstPassData *const fp_data = &cpi->fp_data;
+  const int mb_rows = cm->mi_params.mb_rows;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads, mb_rows);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+  if (fp_data->allocated_rows < mb_rows) {
+    av1_row_mt_sync_mem_dealloc(&fp_data->row_mt_sync);
+    av1_row_mt_sync_mem_alloc(&fp_data->row_mt_sync, cm, mb_rows);
+    fp_data->allocated_rows = mb_rows;
+  }
+  if (fp_data->allocated_workers < num_workers) {
+    aom_job_scheduler_free(&fp_data->job_sched);
+    if (aom_job_scheduler_alloc(&fp_data->job_sched, num_workers))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate first pass job scheduler");
+    fp_data->allocated_workers = num_workers;
+  }
+
+  aom_row_sync_reset(&fp_data->row_mt_sync.cur_col, -1);
+  fp_data->sync_read_ptr = av1_row_mt_sync_read;
+  fp_data->sync_write_ptr = av1_row_mt_sync_write;
+  aom_job_scheduler_reset(&fp_data->job_sched, mb_rows, num_workers);
+
+  prepare_enc_workers(cpi, fp_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+}
+
+void av1_gm_mt_dealloc(GlobalMotionJobInfo *job_info) {
+#if CONFIG_MULTITHREAD
+  if (job_info->mutex_ != NULL) {
+    pthread_mutex_destroy(job_info->mutex_);
+    aom_free(job_info->mutex_);
+    job_info->mutex_ = NULL;
+  }
+#else
+  (void)job_info;
+#endif
+}
+
+static int gm_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  (void)unused;
+  av1_compute_global_motion_for_references(thread_data->cpi, thread_data->td);
+  return 1;
+}
+
+void av1_global_motion_estimation_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  GlobalMotionJobInfo *const job_info = &cpi->gm_job_info;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads,
+                           job_info->num_ref_frames[0] +
+                               job_info->num_ref_frames[1]);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+#if CONFIG_MULTITHREAD
+  if (job_info->mutex_ == NULL) {
+    CHECK_MEM_ERROR(cm, job_info->mutex_,
+                    aom_malloc(sizeof(*job_info->mutex_)));
+    if (job_info->mutex_) pthread_mutex_init(job_info->mutex_, NULL);
+  }
+#endif
+
+  // The 8-bit copies and the corners of the reference frames are cached in
+  // the frames, so make them before two workers can make those of the same
+  // frame.
+  for (int dir = 0; dir < GM_NUM_DIRECTIONS; dir++) {
+    for (int i = 0; i < job_info->num_ref_frames[dir]; i++) {
+      av1_gm_detect_ref_corners(
+          cpi, get_ref_frame_buf(cm, job_info->reference_frame[dir][i].frame));
+    }
+  }
+
+  for (int i = num_workers - 1; i >= 0; i--) {
+    av1_gm_alloc_data(cpi, &cpi->tile_thr_data[i].td->gm_data);
+  }
+
+  prepare_enc_workers(cpi, gm_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+
+  for (int i = num_workers - 1; i >= 0; i--) {
+    av1_gm_dealloc_data(&cpi->tile_thr_data[i].td->gm_data);
+  }
+
+  // A worker may have started a reference frame before a nearer one pruned
+  // it. Drop its global motion, as the search one frame after the other does
+  // not compute it.
+  for (int dir = 0; dir < GM_NUM_DIRECTIONS; dir++) {
+    for (int i = job_info->early_exit[dir] + 1;
+         i < job_info->num_ref_frames[dir]; i++) {
+      const int frame = job_info->reference_frame[dir][i].frame;
+      cm->global_motion[frame] = default_warp_params;
+      cpi->gm_info.params_cost[frame] = 0;
+    }
+  }
+}
+
+void av1_pick_rst_mt_dealloc(RestSearchMTInfo *mt_info) {
+  av1_row_mt_sync_mem_dealloc(&mt_info->row_mt_sync);
+  aom_job_scheduler_free(&mt_info->job_sched);
+  mt_info->allocated_rows = 0;
+  mt_info->allocated_workers = 0;
+}
+
+static int pickrst_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  int job;
+  (void)unused;
+
+  while ((job = aom_job_scheduler_get_job(&cpi->rst_search_mt_info.job_sched,
+                                          thread_data->thread_id)) >= 0) {
+    av1_pick_rst_search_row(cpi, thread_data->td, job);
+  }
+  return 1;
+}
+
+void av1_pick_rst_search_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  RestSearchMTInfo *const mt_info = &cpi->rst_search_mt_info;
+  const int unit_rows = mt_info->unit_rows;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads, unit_rows);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+  if (mt_info->allocated_rows < unit_rows) {
+    av1_row_mt_sync_mem_dealloc(&mt_info->row_mt_sync);
+    av1_row_mt_sync_mem_alloc(&mt_info->row_mt_sync, cm, unit_rows);
+    mt_info->allocated_rows = unit_rows;
+  }
+  if (mt_info->allocated_workers < num_workers) {
+    aom_job_scheduler_free(&mt_info->job_sched);
+    if (aom_job_scheduler_alloc(&mt_info->job_sched, num_workers))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate restoration search scheduler");
+    mt_info->allocated_workers = num_workers;
+  }
+  aom_row_sync_reset(&mt_info->row_mt_sync.cur_col, -1);
+  aom_job_scheduler_reset(&mt_info->job_sched, unit_rows, num_workers);
+
+  // The scratch buffers of the workers are kept until the workers are freed.
+  // The main thread uses the one of the loop restoration.
+  cpi->td.rst_tmpbuf = cm->rst_tmpbuf;
+  for (int i = num_workers - 1; i > 0; i--) {
+    ThreadData *const td = cpi->tile_thr_data[i].td;
+    if (td->rst_tmpbuf == NULL) {
+      CHECK_MEM_ERROR(cm, td->rst_tmpbuf,
+                      (int32_t *)aom_memalign(16, RESTORATION_TMPBUF_SIZE));
+    }
+  }
+
+  prepare_enc_workers(cpi, pickrst_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+}
+
+void av1_cdef_search_mt_dealloc(CdefSearchMTInfo *mt_info) {
+  aom_job_scheduler_free(&mt_info->job_sched);
+  mt_info->allocated_workers = 0;
+}
+
+static int cdef_search_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  int job;
+  (void)unused;
+
+  while ((job = aom_job_scheduler_get_job(&cpi->cdef_search_mt_info.job_sched,
+                                          thread_data->thread_id)) >= 0) {
+    av1_cdef_search_fb(cpi, job);
+  }
+  return 1;
+}
+
+void av1_cdef_search_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  CdefSearchMTInfo *const mt_info = &cpi->cdef_search_mt_info;
+  const int num_fbs = mt_info->num_fbs;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads, num_fbs);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+  if (mt_info->allocated_workers < num_workers) {
+    aom_job_scheduler_free(&mt_info->job_sched);
+    if (aom_job_scheduler_alloc(&mt_info->job_sched, num_workers))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate CDEF search scheduler");
+    mt_info->allocated_workers = num_workers;
+  }
+  aom_job_scheduler_reset(&mt_info->job_sched, num_fbs, num_workers);
+
+  prepare_enc_workers(cpi, cdef_search_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+}
+
+void av1_pick_lpf_mt_dealloc(PickLpfMTInfo *mt_info) {
+  aom_free(mt_info->band_sse);
+  mt_info->band_sse = NULL;
+  mt_info->allocated_bands = 0;
+  aom_job_scheduler_free(&mt_info->job_sched);
+  mt_info->allocated_workers = 0;
+}
+
+static int pick_lpf_worker_hook(void *arg1, void *unused) {
+  EncWorkerData *const thread_data = (EncWorkerData *)arg1;
+  AV1_COMP *const cpi = thread_data->cpi;
+  int job;
+  (void)unused;
+
+  while ((job = aom_job_scheduler_get_job(&cpi->pick_lpf_mt_info.job_sched,
+                                          thread_data->thread_id)) >= 0) {
+    av1_pick_lpf_band_sse(cpi, job);
+  }
+  return 1;
+}
+
+void av1_pick_lpf_sse_mt(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  PickLpfMTInfo *const mt_info = &cpi->pick_lpf_mt_info;
+  const int num_bands = mt_info->num_bands;
+  int num_workers = AOMMIN(cpi->oxcf.max_threads, num_bands);
+
+  // Only run once to create threads and allocate thread data.
+  if (cpi->num_workers == 0) {
+    create_enc_workers(cpi, num_workers);
+  } else {
+    num_workers = AOMMIN(num_workers, cpi->num_workers);
+  }
+
+  if (mt_info->allocated_workers < num_workers) {
+    aom_job_scheduler_free(&mt_info->job_sched);
+    if (aom_job_scheduler_alloc(&mt_info->job_sched, num_workers))
+      aom_internal_error(&cm->error, AOM_CODEC_MEM_ERROR,
+                         "Failed to allocate loop filter search scheduler");
+    mt_info->allocated_workers = num_workers;
+  }
+  aom_job_scheduler_reset(&mt_info->job_sched, num_bands, num_workers);
+
+  prepare_enc_workers(cpi, pick_lpf_worker_hook, num_workers);
+  launch_enc_workers(cpi, num_workers);
+  sync_enc_workers(cpi, num_workers);
+}
@@ -19,6 +19,12 @@ extern "C" {
 struct AV1_COMP;
 struct ThreadData;
 struct AV1RowMTSyncData;
+struct TplMultiThreadInfo;
+struct TemporalFilterCtx;
+struct GlobalMotionJobInfo;
+struct RestSearchMTInfo;
+struct CdefSearchMTInfo;
+struct PickLpfMTInfo;
 
 typedef struct EncWorkerData {
   struct AV1_COMP *cpi;
@@ -44,6 +50,44 @@ void av1_row_mt_sync_mem_alloc(AV1RowMTSync *row_mt_sync, struct AV1Common *cm,
 void av1_encode_tiles_mt(struct AV1_COMP *cpi);
 void av1_encode_tiles_row_mt(struct AV1_COMP *cpi);
 
+// Computes the tpl stats of the frames of cpi->tpl_mt_info with the workers.
+void av1_mc_flow_dispenser_mt(struct AV1_COMP *cpi);
+
+void av1_tpl_mt_mem_dealloc(struct TplMultiThreadInfo *tpl_mt_info);
+
+// Filters the frame of cpi->tf_ctx with the workers.
+void av1_tf_do_filtering_mt(struct AV1_COMP *cpi);
+
+void av1_tf_mt_dealloc(struct TemporalFilterCtx *tf_ctx);
+
+// Encodes the block rows of the first pass frame with the workers.
+void av1_first_pass_row_mt(struct AV1_COMP *cpi);
+
+// Computes the global motion of the reference frames of cpi->gm_job_info with
+// the workers, one reference frame per job.
+void av1_global_motion_estimation_mt(struct AV1_COMP *cpi);
+
+void av1_gm_mt_dealloc(struct GlobalMotionJobInfo *job_info);
+
+// Searches the restoration units of the plane of cpi->rst_search_mt_info with
+// the workers, one row of units per job.
+void av1_pick_rst_search_mt(struct AV1_COMP *cpi);
+
+void av1_pick_rst_mt_dealloc(struct RestSearchMTInfo *mt_info);
+
+// Computes the distortions of the filter blocks of cpi->cdef_search_mt_info
+// with the workers, one filter block per job.
+void av1_cdef_search_mt(struct AV1_COMP *cpi);
+
+void av1_cdef_search_mt_dealloc(struct CdefSearchMTInfo *mt_info);
+
+// Measures the error of the loop filter level tried on the plane of
+// cpi->pick_lpf_mt_info and restores the unfiltered plane with the workers,
+// one band of rows per job.
+void av1_pick_lpf_sse_mt(struct AV1_COMP *cpi);
+
+void av1_pick_lpf_mt_dealloc(struct PickLpfMTInfo *mt_info);
+
 void av1_accumulate_frame_counts(struct FRAME_COUNTS *acc_counts,
                                  const struct FRAME_COUNTS *counts);
 
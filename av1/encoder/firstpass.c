@@ -37,6 +37,7 @@
 #include "av1/encoder/encodemv.h"
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/encode_strategy.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/extend.h"
 #include "av1/encoder/firstpass.h"
 #include "av1/encoder/mcomp.h"
@@ -246,17 +247,15 @@ static AOM_INLINE void first_pass_motion_search(AV1_COMP *cpi, MACROBLOCK *x,
   }
 }
 
-static BLOCK_SIZE get_bsize(const CommonModeInfoParams *const mi_params,
-                            int mb_row, int mb_col) {
-  if (mi_size_wide[BLOCK_16X16] * mb_col + mi_size_wide[BLOCK_8X8] <
-      mi_params->mi_cols) {
+static BLOCK_SIZE get_bsize(int mi_rows, int mi_cols, int mb_row, int mb_col) {
+  if (mi_size_wide[BLOCK_16X16] * mb_col + mi_size_wide[BLOCK_8X8] < mi_cols) {
     return mi_size_wide[BLOCK_16X16] * mb_row + mi_size_wide[BLOCK_8X8] <
-                   mi_params->mi_rows
+                   mi_rows
                ? BLOCK_16X16
                : BLOCK_16X8;
   } else {
     return mi_size_wide[BLOCK_16X16] * mb_row + mi_size_wide[BLOCK_8X8] <
-                   mi_params->mi_rows
+                   mi_rows
                ? BLOCK_8X16
                : BLOCK_8X8;
   }
@@ -289,62 +288,13 @@ static double raw_motion_error_stdev(int *raw_motion_err_list,
   return raw_err_stdev;
 }
 
-// This structure contains several key parameters to be accumulate for this
-// frame.
-typedef struct {
-  // Intra prediction error.
-  int64_t intra_error;
-  // Average wavelet energy computed using Discrete Wavelet Transform (DWT).
-  int64_t frame_avg_wavelet_energy;
-  // Best of intra pred error and inter pred error using last frame as ref.
-  int64_t coded_error;
-  // Best of intra pred error and inter pred error using golden frame as ref.
-  int64_t sr_coded_error;
-  // Best of intra pred error and inter pred error using altref frame as ref.
-  int64_t tr_coded_error;
-  // Count of motion vector.
-  int mv_count;
-  // Count of blocks that pick inter prediction (inter pred error is smaller
-  // than intra pred error).
-  int inter_count;
-  // Count of blocks that pick second ref (golden frame).
-  int second_ref_count;
-  // Count of blocks that pick third ref (altref frame).
-  int third_ref_count;
-  // Count of blocks where the inter and intra are very close and very low.
-  double neutral_count;
-  // Count of blocks where intra error is very small.
-  int intra_skip_count;
-  // Start row.
-  int image_data_start_row;
-  // Count of unique non-zero motion vectors.
-  int new_mv_count;
-  // Sum of inward motion vectors.
-  int sum_in_vectors;
-  // Sum of motion vector row.
-  int sum_mvr;
-  // Sum of motion vector column.
-  int sum_mvc;
-  // Sum of absolute value of motion vector row.
-  int sum_mvr_abs;
-  // Sum of absolute value of motion vector column.
-  int sum_mvc_abs;
-  // Sum of the square of motion vector row.
-  int64_t sum_mvrs;
-  // Sum of the square of motion vector column.
-  int64_t sum_mvcs;
-  // A factor calculated using intra pred error.
-  double intra_factor;
-  // A factor that measures brightness.
-  double brightness_factor;
-} FRAME_STATS;
-
 #define UL_INTRA_THRESH 50
 #define INVALID_ROW -1
 // Computes and returns the intra pred error of a block.
 // intra pred error: sum of squared error of the intra predicted residual.
 // Inputs:
 //   cpi: the encoder setting. Only a few params in it will be used.
+//   x: the macroblock of the thread encoding the block.
 //   this_frame: the current frame buffer.
 //   tile: tile information (not used in first pass, already init to zero)
 //   mb_row: row index in the unit of first pass block size.
@@ -366,19 +316,19 @@ typedef struct {
 // Returns:
 //   this_intra_error.
 static int firstpass_intra_prediction(
-    AV1_COMP *cpi, YV12_BUFFER_CONFIG *const this_frame,
+    AV1_COMP *cpi, MACROBLOCK *const x, YV12_BUFFER_CONFIG *const this_frame,
     const TileInfo *const tile, const int mb_row, const int mb_col,
     const int y_offset, const int uv_offset, const BLOCK_SIZE fp_block_size,
     const int qindex, FRAME_STATS *const stats) {
   const AV1_COMMON *const cm = &cpi->common;
   const CommonModeInfoParams *const mi_params = &cm->mi_params;
   const SequenceHeader *const seq_params = &cm->seq_params;
-  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   const int mb_scale = mi_size_wide[fp_block_size];
   const int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
   const int num_planes = av1_num_planes(cm);
-  const BLOCK_SIZE bsize = get_bsize(mi_params, mb_row, mb_col);
+  const BLOCK_SIZE bsize =
+      get_bsize(mi_params->mi_rows, mi_params->mi_cols, mb_row, mb_col);
 
   aom_clear_system_state();
   set_mi_offsets(mi_params, xd, mb_row * mb_scale, mb_col * mb_scale);
@@ -481,18 +431,59 @@ static int get_prediction_error_bitdepth(const int is_high_bitdepth,
   return get_prediction_error(block_size, src, ref);
 }
 
+void av1_first_pass_raw_motion_err(const YV12_BUFFER_CONFIG *src,
+                                   const YV12_BUFFER_CONFIG *last_src,
+                                   int mi_rows, int mi_cols, int bit_depth,
+                                   int *raw_motion_err) {
+  const int is_high_bitdepth = (src->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
+  const int mb_rows = (mi_rows + 2) >> 2;
+  const int mb_cols = (mi_cols + 2) >> 2;
+  const int fp_block_size = 16;
+  struct buf_2d src_buf, last_src_buf;
+  src_buf.stride = src->y_stride;
+  last_src_buf.stride = last_src->y_stride;
+  for (int mb_row = 0; mb_row < mb_rows; ++mb_row) {
+    for (int mb_col = 0; mb_col < mb_cols; ++mb_col) {
+      const BLOCK_SIZE bsize = get_bsize(mi_rows, mi_cols, mb_row, mb_col);
+      src_buf.buf = src->y_buffer + mb_row * fp_block_size * src->y_stride +
+                    mb_col * fp_block_size;
+      last_src_buf.buf = last_src->y_buffer +
+                         mb_row * fp_block_size * last_src->y_stride +
+                         mb_col * fp_block_size;
+      raw_motion_err[mb_row * mb_cols + mb_col] = get_prediction_error_bitdepth(
+          is_high_bitdepth, bit_depth, bsize, &src_buf, &last_src_buf);
+    }
+  }
+}
+
+// Returns the raw motion errors of the blocks of the source frame which the
+// lookahead computed when the frame was enqueued, or NULL if they were not
+// computed against the last source frame.
+static const int *get_lookahead_raw_motion_err(AV1_COMP *cpi) {
+  const AV1_COMMON *const cm = &cpi->common;
+  if (frame_is_intra_only(cm) || cpi->unscaled_last_source == NULL)
+    return NULL;
+  const struct lookahead_stats *const stats =
+      av1_lookahead_get_stats(cpi->lookahead, cpi->source);
+  if (stats == NULL || !(stats->flags & LOOKAHEAD_STATS_RAW_MOTION_ERR) ||
+      stats->raw_motion_ref != cpi->unscaled_last_source ||
+      stats->bit_depth != (int)cm->seq_params.bit_depth ||
+      stats->mi_rows != cm->mi_params.mi_rows ||
+      stats->mi_cols != cm->mi_params.mi_cols)
+    return NULL;
+  return stats->raw_motion_err;
+}
+
 // Accumulates motion vector stats.
-// Modifies member variables of "stats".
+// Modifies member variables of "stats". The new motion vectors are counted
+// when the stats of the blocks are merged.
 static void accumulate_mv_stats(const MV best_mv, const FULLPEL_MV mv,
                                 const int mb_row, const int mb_col,
                                 const int mb_rows, const int mb_cols,
-                                MV *last_mv, FRAME_STATS *stats) {
+                                FRAME_STATS *stats) {
   if (is_zero_mv(&best_mv)) return;
 
   ++stats->mv_count;
-  // Non-zero vector, was it different from the last non zero vector?
-  if (!is_equal_mv(&best_mv, last_mv)) ++stats->new_mv_count;
-  *last_mv = best_mv;
 
   // Does the row vector point inwards or outwards?
   if (mb_row < mb_rows / 2) {
@@ -531,6 +522,7 @@ static void accumulate_mv_stats(const MV best_mv, const FULLPEL_MV mv,
 // Updates stats accordingly.
 // Inputs:
 //   cpi: the encoder setting. Only a few params in it will be used.
+//   x: the macroblock of the thread encoding the block.
 //   last_frame: the frame buffer of the last frame.
 //   golden_frame: the frame buffer of the golden frame.
 //   alt_ref_frame: the frame buffer of the alt ref frame.
@@ -544,37 +536,36 @@ static void accumulate_mv_stats(const MV best_mv, const FULLPEL_MV mv,
 //   alt_ref_frame_offset: the y offset of the alt ref frame buffer.
 //   fp_block_size: first pass block size.
 //   this_intra_error: the intra prediction error of this block.
-//   raw_motion_err_counts: the count of raw motion vectors.
+//   raw_motion_err_counts: the index of the block in raster order.
 //   raw_motion_err_list: the array that records the raw motion error.
 //   best_ref_mv: best reference mv found so far.
-//   last_mv: last mv.
 //   stats: frame encoding stats.
 //  Modifies:
 //    raw_motion_err_list
 //    best_ref_mv
-//    last_mv
 //    stats: many member params in it.
 //  Returns:
 //    this_inter_error
 static int firstpass_inter_prediction(
-    AV1_COMP *cpi, const YV12_BUFFER_CONFIG *const last_frame,
+    AV1_COMP *cpi, MACROBLOCK *const x,
+    const YV12_BUFFER_CONFIG *const last_frame,
     const YV12_BUFFER_CONFIG *const golden_frame,
     const YV12_BUFFER_CONFIG *const alt_ref_frame, const int mb_row,
     const int mb_col, const int recon_yoffset, const int recon_uvoffset,
     const int src_yoffset, const int alt_ref_frame_yoffset,
     const BLOCK_SIZE fp_block_size, const int this_intra_error,
     const int raw_motion_err_counts, int *raw_motion_err_list, MV *best_ref_mv,
-    MV *last_mv, FRAME_STATS *stats) {
+    FRAME_STATS *stats) {
   int this_inter_error = this_intra_error;
   AV1_COMMON *const cm = &cpi->common;
   const CommonModeInfoParams *const mi_params = &cm->mi_params;
   CurrentFrame *const current_frame = &cm->current_frame;
-  MACROBLOCK *const x = &cpi->td.mb;
   MACROBLOCKD *const xd = &x->e_mbd;
   const int is_high_bitdepth = is_cur_buf_hbd(xd);
   const int bitdepth = xd->bd;
   const int mb_scale = mi_size_wide[fp_block_size];
-  const BLOCK_SIZE bsize = get_bsize(mi_params, mb_row, mb_col);
+  const BLOCK_SIZE bsize =
+      get_bsize(mi_params->mi_rows, mi_params->mi_cols, mb_row, mb_col);
   const int fp_block_size_height = block_size_wide[fp_block_size];
   // Assume 0,0 motion with no mv overhead.
   FULLPEL_MV mv = kZeroFullMv;
@@ -593,13 +584,19 @@ static int firstpass_inter_prediction(
   // Compute the motion error of the 0,0 motion using the last source
   // frame as the reference. Skip the further motion search on
   // reconstructed frame if this error is small.
-  struct buf_2d unscaled_last_source_buf_2d;
-  unscaled_last_source_buf_2d.buf =
-      cpi->unscaled_last_source->y_buffer + src_yoffset;
-  unscaled_last_source_buf_2d.stride = cpi->unscaled_last_source->y_stride;
-  const int raw_motion_error = get_prediction_error_bitdepth(
-      is_high_bitdepth, bitdepth, bsize, &x->plane[0].src,
-      &unscaled_last_source_buf_2d);
+  int raw_motion_error;
+  if (cpi->fp_data.lookahead_raw_motion_err != NULL) {
+    raw_motion_error =
+        cpi->fp_data.lookahead_raw_motion_err[raw_motion_err_counts];
+  } else {
+    struct buf_2d unscaled_last_source_buf_2d;
+    unscaled_last_source_buf_2d.buf =
+        cpi->unscaled_last_source->y_buffer + src_yoffset;
+    unscaled_last_source_buf_2d.stride = cpi->unscaled_last_source->y_stride;
+    raw_motion_error = get_prediction_error_bitdepth(
+        is_high_bitdepth, bitdepth, bsize, &x->plane[0].src,
+        &unscaled_last_source_buf_2d);
+  }
   raw_motion_err_list[raw_motion_err_counts] = raw_motion_error;
 
   // TODO(pengchong): Replace the hard-coded threshold
@@ -722,7 +719,7 @@ static int firstpass_inter_prediction(
 
     *best_ref_mv = best_mv;
     accumulate_mv_stats(best_mv, mv, mb_row, mb_col, mi_params->mb_rows,
-                        mi_params->mb_cols, last_mv, stats);
+                        mi_params->mb_cols, stats);
   }
 
   return this_inter_error;
@@ -845,6 +842,166 @@ static void print_reconstruction_frame(
   fclose(recon_file);
 }
 
+static void alloc_firstpass_data(AV1_COMP *cpi) {
+  AV1_COMMON *const cm = &cpi->common;
+  FirstPassData *const fp_data = &cpi->fp_data;
+  const int num_mbs = cm->mi_params.mb_rows * cm->mi_params.mb_cols;
+  if (fp_data->allocated_mbs >= num_mbs) return;
+
+  aom_free(fp_data->mb_stats);
+  aom_free(fp_data->mb_mvs);
+  aom_free(fp_data->raw_motion_err_list);
+  fp_data->allocated_mbs = 0;
+  CHECK_MEM_ERROR(cm, fp_data->mb_stats,
+                  aom_malloc(num_mbs * sizeof(*fp_data->mb_stats)));
+  CHECK_MEM_ERROR(cm, fp_data->mb_mvs,
+                  aom_malloc(num_mbs * sizeof(*fp_data->mb_mvs)));
+  CHECK_MEM_ERROR(cm, fp_data->raw_motion_err_list,
+                  aom_malloc(num_mbs * sizeof(*fp_data->raw_motion_err_list)));
+  fp_data->allocated_mbs = num_mbs;
+}
+
+void av1_free_firstpass_data(FirstPassData *fp_data) {
+  aom_free(fp_data->mb_stats);
+  aom_free(fp_data->mb_mvs);
+  aom_free(fp_data->raw_motion_err_list);
+  fp_data->mb_stats = NULL;
+  fp_data->mb_mvs = NULL;
+  fp_data->raw_motion_err_list = NULL;
+  fp_data->allocated_mbs = 0;
+  av1_row_mt_sync_mem_dealloc(&fp_data->row_mt_sync);
+  aom_job_scheduler_free(&fp_data->job_sched);
+  fp_data->allocated_rows = 0;
+  fp_data->allocated_workers = 0;
+}
+
+// Merges the stats of the blocks in raster order, so that the floating point
+// sums are the same whatever the order in which the blocks were encoded.
+static void accumulate_frame_stats(const FirstPassData *fp_data,
+                                   const int num_mbs, FRAME_STATS *stats) {
+  MV last_mv = kZeroMv;
+  for (int i = 0; i < num_mbs; ++i) {
+    const FRAME_STATS *const mb_stats = &fp_data->mb_stats[i];
+    stats->intra_error += mb_stats->intra_error;
+    stats->frame_avg_wavelet_energy += mb_stats->frame_avg_wavelet_energy;
+    stats->coded_error += mb_stats->coded_error;
+    stats->sr_coded_error += mb_stats->sr_coded_error;
+    stats->tr_coded_error += mb_stats->tr_coded_error;
+    stats->mv_count += mb_stats->mv_count;
+    stats->inter_count += mb_stats->inter_count;
+    stats->second_ref_count += mb_stats->second_ref_count;
+    stats->third_ref_count += mb_stats->third_ref_count;
+    stats->neutral_count += mb_stats->neutral_count;
+    stats->intra_skip_count += mb_stats->intra_skip_count;
+    if (stats->image_data_start_row == INVALID_ROW) {
+      stats->image_data_start_row = mb_stats->image_data_start_row;
+    }
+    stats->sum_in_vectors += mb_stats->sum_in_vectors;
+    stats->sum_mvr += mb_stats->sum_mvr;
+    stats->sum_mvc += mb_stats->sum_mvc;
+    stats->sum_mvr_abs += mb_stats->sum_mvr_abs;
+    stats->sum_mvc_abs += mb_stats->sum_mvc_abs;
+    stats->sum_mvrs += mb_stats->sum_mvrs;
+    stats->sum_mvcs += mb_stats->sum_mvcs;
+    stats->intra_factor += mb_stats->intra_factor;
+    stats->brightness_factor += mb_stats->brightness_factor;
+
+    // Non-zero vector, was it different from the last non zero vector?
+    if (mb_stats->mv_count) {
+      if (!is_equal_mv(&fp_data->mb_mvs[i], &last_mv)) ++stats->new_mv_count;
+      last_mv = fp_data->mb_mvs[i];
+    }
+  }
+}
+
+void av1_first_pass_row(AV1_COMP *cpi, ThreadData *td, const int mb_row) {
+  AV1_COMMON *const cm = &cpi->common;
+  const CommonModeInfoParams *const mi_params = &cm->mi_params;
+  FirstPassData *const fp_data = &cpi->fp_data;
+  MACROBLOCK *const x = &td->mb;
+  MACROBLOCKD *const xd = &x->e_mbd;
+  const PICK_MODE_CONTEXT *ctx = &td->pc_root->none;
+  const int num_planes = av1_num_planes(cm);
+  const YV12_BUFFER_CONFIG *const last_frame = fp_data->last_frame;
+  const YV12_BUFFER_CONFIG *const alt_ref_frame = fp_data->alt_ref_frame;
+  YV12_BUFFER_CONFIG *const this_frame = fp_data->this_frame;
+  const int mb_cols = mi_params->mb_cols;
+  const BLOCK_SIZE fp_block_size = BLOCK_16X16;
+  const int fp_block_size_width = block_size_high[fp_block_size];
+  const int fp_block_size_height = block_size_wide[fp_block_size];
+  const int src_y_stride = cpi->source->y_stride;
+  const int recon_y_stride = this_frame->y_stride;
+  const int recon_uv_stride = this_frame->uv_stride;
+  const int uv_mb_height =
+      fp_block_size_height >> (this_frame->y_height > this_frame->uv_height);
+  MV best_ref_mv = kZeroMv;
+
+  for (int i = 0; i < num_planes; ++i) {
+    x->plane[i].coeff = ctx->coeff[i];
+    x->plane[i].qcoeff = ctx->qcoeff[i];
+    x->plane[i].eobs = ctx->eobs[i];
+    x->plane[i].txb_entropy_ctx = ctx->txb_entropy_ctx[i];
+    xd->plane[i].dqcoeff = ctx->dqcoeff[i];
+  }
+
+  // Reset above block coeffs.
+  xd->up_available = (mb_row != 0);
+  int recon_yoffset = (mb_row * recon_y_stride * fp_block_size_height);
+  int src_yoffset = (mb_row * src_y_stride * fp_block_size_height);
+  int recon_uvoffset = (mb_row * recon_uv_stride * uv_mb_height);
+  int src_uvoffset = (mb_row * x->plane[1].src.stride * uv_mb_height);
+  int alt_ref_frame_yoffset =
+      (alt_ref_frame != NULL)
+          ? mb_row * alt_ref_frame->y_stride * fp_block_size_height
+          : -1;
+
+  // Set up limit values for motion vectors to prevent them extending
+  // outside the UMV borders.
+  av1_set_mv_row_limits(mi_params, &x->mv_limits, (mb_row << 2),
+                        (fp_block_size_height >> MI_SIZE_LOG2),
+                        cpi->oxcf.border_in_pixels);
+
+  for (int mb_col = 0; mb_col < mb_cols; ++mb_col) {
+    const int mb_idx = mb_row * mb_cols + mb_col;
+    FRAME_STATS *const stats = &fp_data->mb_stats[mb_idx];
+    memset(stats, 0, sizeof(*stats));
+    stats->image_data_start_row = INVALID_ROW;
+    x->plane[0].src.buf = cpi->source->y_buffer + src_yoffset;
+    x->plane[1].src.buf = cpi->source->u_buffer + src_uvoffset;
+    x->plane[2].src.buf = cpi->source->v_buffer + src_uvoffset;
+
+    // Wait for the blocks above, which the intra prediction uses.
+    fp_data->sync_read_ptr(&fp_data->row_mt_sync, mb_row, mb_col);
+
+    int this_intra_error = firstpass_intra_prediction(
+        cpi, x, this_frame, &fp_data->tile, mb_row, mb_col, recon_yoffset,
+        recon_uvoffset, fp_block_size, fp_data->qindex, stats);
+
+    if (!frame_is_intra_only(cm)) {
+      const int this_inter_error = firstpass_inter_prediction(
+          cpi, x, last_frame, fp_data->golden_frame, alt_ref_frame, mb_row,
+          mb_col, recon_yoffset, recon_uvoffset, src_yoffset,
+          alt_ref_frame_yoffset, fp_block_size, this_intra_error, mb_idx,
+          fp_data->raw_motion_err_list, &best_ref_mv, stats);
+      stats->coded_error += this_inter_error;
+      fp_data->mb_mvs[mb_idx] = best_ref_mv;
+    } else {
+      stats->sr_coded_error += this_intra_error;
+      stats->tr_coded_error += this_intra_error;
+      stats->coded_error += this_intra_error;
+    }
+
+    fp_data->sync_write_ptr(&fp_data->row_mt_sync, mb_row, mb_col, mb_cols);
+
+    // Adjust to the next column of MBs.
+    recon_yoffset += fp_block_size_width;
+    src_yoffset += fp_block_size_width;
+    recon_uvoffset += uv_mb_height;
+    src_uvoffset += uv_mb_height;
+    alt_ref_frame_yoffset += fp_block_size_width;
+  }
+}
+
 #define FIRST_PASS_ALT_REF_DISTANCE 16
 void av1_first_pass(AV1_COMP *cpi, const int64_t ts_duration) {
   MACROBLOCK *const x = &cpi->td.mb;
@@ -854,8 +1011,7 @@ void av1_first_pass(AV1_COMP *cpi, const int64_t ts_duration) {
   const SequenceHeader *const seq_params = &cm->seq_params;
   const int num_planes = av1_num_planes(cm);
   MACROBLOCKD *const xd = &x->e_mbd;
-  const PICK_MODE_CONTEXT *ctx = &cpi->td.pc_root->none;
-  MV last_mv = kZeroMv;
+  FirstPassData *const fp_data = &cpi->fp_data;
   const int qindex = find_fp_qindex(seq_params->bit_depth);
   // Detect if the key frame is screen content type.
   if (frame_is_intra_only(cm)) {
@@ -865,16 +1021,9 @@ void av1_first_pass(AV1_COMP *cpi, const int64_t ts_duration) {
   }
   // First pass coding proceeds in raster scan order with unit size of 16x16.
   const BLOCK_SIZE fp_block_size = BLOCK_16X16;
-  const int fp_block_size_width = block_size_high[fp_block_size];
-  const int fp_block_size_height = block_size_wide[fp_block_size];
-  int *raw_motion_err_list;
-  int raw_motion_err_counts = 0;
-  CHECK_MEM_ERROR(cm, raw_motion_err_list,
-                  aom_calloc(mi_params->mb_rows * mi_params->mb_cols,
-                             sizeof(*raw_motion_err_list)));
+  alloc_firstpass_data(cpi);
   // Tiling is ignored in the first pass.
-  TileInfo tile;
-  av1_tile_init(&tile, cm, 0, 0);
+  av1_tile_init(&fp_data->tile, cm, 0, 0);
   FRAME_STATS stats = { 0 };
   stats.image_data_start_row = INVALID_ROW;
 
@@ -898,6 +1047,11 @@ void av1_first_pass(AV1_COMP *cpi, const int64_t ts_duration) {
   // First pass code requires valid last and new frame buffers.
   assert(this_frame != NULL);
   assert(frame_is_intra_only(cm) || (last_frame != NULL));
+  fp_data->last_frame = last_frame;
+  fp_data->golden_frame = golden_frame;
+  fp_data->alt_ref_frame = alt_ref_frame;
+  fp_data->this_frame = this_frame;
+  fp_data->qindex = qindex;
 
   av1_setup_frame_size(cpi);
   aom_clear_system_state();
@@ -927,82 +1081,26 @@ void av1_first_pass(AV1_COMP *cpi, const int64_t ts_duration) {
   xd->cfl.store_y = 0;
   av1_frame_init_quantizer(cpi);
 
-  for (int i = 0; i < num_planes; ++i) {
-    x->plane[i].coeff = ctx->coeff[i];
-    x->plane[i].qcoeff = ctx->qcoeff[i];
-    x->plane[i].eobs = ctx->eobs[i];
-    x->plane[i].txb_entropy_ctx = ctx->txb_entropy_ctx[i];
-    xd->plane[i].dqcoeff = ctx->dqcoeff[i];
-  }
-
   av1_init_mv_probs(cm);
   av1_initialize_rd_consts(cpi);
 
-  const int src_y_stride = cpi->source->y_stride;
-  const int recon_y_stride = this_frame->y_stride;
-  const int recon_uv_stride = this_frame->uv_stride;
-  const int uv_mb_height =
-      fp_block_size_height >> (this_frame->y_height > this_frame->uv_height);
+  fp_data->lookahead_raw_motion_err = get_lookahead_raw_motion_err(cpi);
 
-  for (int mb_row = 0; mb_row < mi_params->mb_rows; ++mb_row) {
-    MV best_ref_mv = kZeroMv;
-
-    // Reset above block coeffs.
-    xd->up_available = (mb_row != 0);
-    int recon_yoffset = (mb_row * recon_y_stride * fp_block_size_height);
-    int src_yoffset = (mb_row * src_y_stride * fp_block_size_height);
-    int recon_uvoffset = (mb_row * recon_uv_stride * uv_mb_height);
-    int alt_ref_frame_yoffset =
-        (alt_ref_frame != NULL)
-            ? mb_row * alt_ref_frame->y_stride * fp_block_size_height
-            : -1;
-
-    // Set up limit values for motion vectors to prevent them extending
-    // outside the UMV borders.
-    av1_set_mv_row_limits(mi_params, &x->mv_limits, (mb_row << 2),
-                          (fp_block_size_height >> MI_SIZE_LOG2),
-                          cpi->oxcf.border_in_pixels);
-
-    for (int mb_col = 0; mb_col < mi_params->mb_cols; ++mb_col) {
-      int this_intra_error = firstpass_intra_prediction(
-          cpi, this_frame, &tile, mb_row, mb_col, recon_yoffset, recon_uvoffset,
-          fp_block_size, qindex, &stats);
-
-      if (!frame_is_intra_only(cm)) {
-        const int this_inter_error = firstpass_inter_prediction(
-            cpi, last_frame, golden_frame, alt_ref_frame, mb_row, mb_col,
-            recon_yoffset, recon_uvoffset, src_yoffset, alt_ref_frame_yoffset,
-            fp_block_size, this_intra_error, raw_motion_err_counts,
-            raw_motion_err_list, &best_ref_mv, &last_mv, &stats);
-        stats.coded_error += this_inter_error;
-        ++raw_motion_err_counts;
-      } else {
-        stats.sr_coded_error += this_intra_error;
-        stats.tr_coded_error += this_intra_error;
-        stats.coded_error += this_intra_error;
-      }
-
-      // Adjust to the next column of MBs.
-      x->plane[0].src.buf += fp_block_size_width;
-      x->plane[1].src.buf += uv_mb_height;
-      x->plane[2].src.buf += uv_mb_height;
-
-      recon_yoffset += fp_block_size_width;
-      src_yoffset += fp_block_size_width;
-      recon_uvoffset += uv_mb_height;
-      alt_ref_frame_yoffset += fp_block_size_width;
+  if (cpi->oxcf.row_mt == 1 && cpi->oxcf.max_threads > 1) {
+    av1_first_pass_row_mt(cpi);
+  } else {
+    fp_data->sync_read_ptr = av1_row_mt_sync_read_dummy;
+    fp_data->sync_write_ptr = av1_row_mt_sync_write_dummy;
+    for (int mb_row = 0; mb_row < mi_params->mb_rows; ++mb_row) {
+      av1_first_pass_row(cpi, &cpi->td, mb_row);
     }
-    // Adjust to the next row of MBs.
-    x->plane[0].src.buf += fp_block_size_height * x->plane[0].src.stride -
-                           fp_block_size_width * mi_params->mb_cols;
-    x->plane[1].src.buf += uv_mb_height * x->plane[1].src.stride -
-                           uv_mb_height * mi_params->mb_cols;
-    x->plane[2].src.buf += uv_mb_height * x->plane[1].src.stride -
-                           uv_mb_height * mi_params->mb_cols;
   }
-  const double raw_err_stdev =
-      raw_motion_error_stdev(raw_motion_err_list, raw_motion_err_counts);
-  aom_free(raw_motion_err_list);
+
+  const int num_mbs_in_frame = mi_params->mb_rows * mi_params->mb_cols;
+  accumulate_frame_stats(fp_data, num_mbs_in_frame, &stats);
+  const double raw_err_stdev = raw_motion_error_stdev(
+      fp_data->raw_motion_err_list,
+      frame_is_intra_only(cm) ? 0 : num_mbs_in_frame);
 
   // Clamp the image start to rows/2. This number of rows is discarded top
   // and bottom as dead data so rows / 2 means the frame is blank.
@@ -423,13 +423,12 @@ void av1_compute_feature_segmentation_map(uint8_t *segment_map, int width,
 static int compute_global_motion_feature_based(
     TransformationType type, unsigned char *frm_buffer, int frm_width,
     int frm_height, int frm_stride, int *frm_corners, int num_frm_corners,
-    YV12_BUFFER_CONFIG *ref, int bit_depth, int *num_inliers_by_motion,
-    MotionModel *params_by_motion, int num_motions) {
+    YV12_BUFFER_CONFIG *ref, int *ref_corners, int num_ref_corners,
+    int bit_depth, int *num_inliers_by_motion, MotionModel *params_by_motion,
+    int num_motions) {
   int i;
-  int num_ref_corners;
   int num_correspondences;
   int *correspondences;
-  int ref_corners[2 * MAX_CORNERS];
   unsigned char *ref_buffer = ref->y_buffer;
   RansacFunc ransac = av1_get_ransac_type(type);
 
@@ -437,10 +436,6 @@ static int compute_global_motion_feature_based(
     ref_buffer = av1_downconvert_frame(ref, bit_depth);
   }
 
-  num_ref_corners =
-      av1_fast_corner_detect(ref_buffer, ref->y_width, ref->y_height,
-                             ref->y_stride, ref_corners, MAX_CORNERS);
-
   // find correspondences between the two images
   correspondences =
       (int *)malloc(num_frm_corners * 4 * sizeof(*correspondences));
@@ -993,6 +988,7 @@ int av1_compute_global_motion(TransformationType type,
                               unsigned char *frm_buffer, int frm_width,
                               int frm_height, int frm_stride, int *frm_corners,
                               int num_frm_corners, YV12_BUFFER_CONFIG *ref,
+                              int *ref_corners, int num_ref_corners,
                               int bit_depth,
                               GlobalMotionEstimationType gm_estimation_type,
                               int *num_inliers_by_motion,
@@ -1001,8 +997,8 @@ int av1_compute_global_motion(TransformationType type,
     case GLOBAL_MOTION_FEATURE_BASED:
       return compute_global_motion_feature_based(
           type, frm_buffer, frm_width, frm_height, frm_stride, frm_corners,
-          num_frm_corners, ref, bit_depth, num_inliers_by_motion,
-          params_by_motion, num_motions);
+          num_frm_corners, ref, ref_corners, num_ref_corners, bit_depth,
+          num_inliers_by_motion, params_by_motion, num_motions);
     case GLOBAL_MOTION_DISFLOW_BASED:
       return compute_global_motion_disflow_based(
           type, frm_buffer, frm_width, frm_height, frm_stride, frm_corners,
@@ -86,11 +86,17 @@ int64_t av1_refine_integerized_param(
   "num_inliers" should be length "num_motions", and will be populated with the
   number of inlier feature points for each motion. Params for which the
   num_inliers entry is 0 should be ignored by the caller.
+
+  "ref_corners" holds the "num_ref_corners" feature points of "ref", as found
+  by av1_fast_corner_detect() on its 8-bit luma plane, so that they can be
+  shared by all the frames which use "ref". Only the feature based estimation
+  uses them.
 */
 int av1_compute_global_motion(TransformationType type,
                               unsigned char *frm_buffer, int frm_width,
                               int frm_height, int frm_stride, int *frm_corners,
                               int num_frm_corners, YV12_BUFFER_CONFIG *ref,
+                              int *ref_corners, int num_ref_corners,
                               int bit_depth,
                               GlobalMotionEstimationType gm_estimation_type,
                               int *num_inliers_by_motion,
@@ -14,10 +14,14 @@
 #include "config/aom_config.h"
 
 #include "aom_scale/yv12config.h"
+#include "aom_util/aom_thread.h"
 #include "av1/common/common.h"
+#include "av1/common/resize.h"
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/extend.h"
+#include "av1/encoder/firstpass.h"
 #include "av1/encoder/lookahead.h"
+#include "av1/encoder/rdopt.h"
 
 /* Return the buffer at the given absolute index and increment the index */
 static struct lookahead_entry *pop(struct lookahead_ctx *ctx, int *idx) {
@@ -30,12 +34,54 @@ static struct lookahead_entry *pop(struct lookahead_ctx *ctx, int *idx) {
   return buf;
 }
 
+// Waits for the statistics being computed by the worker.
+static void sync_stats(struct lookahead_ctx *ctx) {
+  if (ctx->worker != NULL) aom_get_worker_interface()->sync(ctx->worker);
+}
+
+static void free_stats(struct lookahead_stats *stats) {
+  free(stats->raw_motion_err);
+  free(stats->block_colors);
+  memset(stats, 0, sizeof(*stats));
+}
+
+static void free_scaled_copies(struct lookahead_entry *buf) {
+  for (int i = 0; i < LOOKAHEAD_SCALED_COPIES; i++)
+    aom_free_frame_buffer(&buf->scaled_img[i]);
+  av1_zero(buf->scaled_valid);
+  buf->next_scaled = 0;
+}
+
+// The scaled copies of a frame are read while it is the source frame, and
+// then while it is one of the MAX_PRE_FRAMES previous source frames. Frees
+// them once the frame leaves that window, i.e. when the encode stage pops the
+// next frame, so that only the frames around the one being coded hold them.
+static void free_stale_scaled_copies(struct lookahead_ctx *ctx,
+                                     const struct read_ctx *read_ctx) {
+  int index = read_ctx->read_idx - 1 - MAX_PRE_FRAMES;
+  if (index < 0) index += ctx->max_sz;
+  // With a full queue the entry may hold a new frame already. It is kept, as
+  // a queued frame can be scaled as the source of an alt-ref before its pop.
+  int queued_pos = index - read_ctx->read_idx;
+  if (queued_pos < 0) queued_pos += ctx->max_sz;
+  if (queued_pos < read_ctx->sz) return;
+  free_scaled_copies(&ctx->buf[index]);
+}
+
 void av1_lookahead_destroy(struct lookahead_ctx *ctx) {
   if (ctx) {
+    if (ctx->worker) {
+      aom_get_worker_interface()->end(ctx->worker);
+      free(ctx->worker);
+    }
     if (ctx->buf) {
       int i;
 
-      for (i = 0; i < ctx->max_sz; i++) aom_free_frame_buffer(&ctx->buf[i].img);
+      for (i = 0; i < ctx->max_sz; i++) {
+        aom_free_frame_buffer(&ctx->buf[i].img);
+        free_stats(&ctx->buf[i].stats);
+        free_scaled_copies(&ctx->buf[i]);
+      }
       free(ctx->buf);
     }
     free(ctx);
@@ -84,6 +130,104 @@ fail:
   return NULL;
 }
 
+void av1_lookahead_set_stats(struct lookahead_ctx *ctx, int stats_flags,
+                             int bit_depth, int use_worker) {
+  ctx->stats_flags = stats_flags;
+  ctx->bit_depth = bit_depth;
+#if CONFIG_MULTITHREAD
+  if (use_worker && stats_flags && ctx->worker == NULL) {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    ctx->worker = calloc(1, sizeof(*ctx->worker));
+    if (ctx->worker == NULL) return;
+    winterface->init(ctx->worker);
+    ctx->worker->thread_name = "aom lookahead";
+    // Compute the statistics synchronously if the thread cannot be created.
+    if (!winterface->reset(ctx->worker)) {
+      winterface->end(ctx->worker);
+      free(ctx->worker);
+      ctx->worker = NULL;
+    }
+  }
+#else
+  (void)use_worker;
+#endif
+}
+
+static void count_block_colors(const YV12_BUFFER_CONFIG *img, int bit_depth,
+                               uint16_t *block_colors) {
+  const int use_hbd = (img->flags & YV12_FLAG_HIGHBITDEPTH) != 0;
+  const int stride = img->y_stride;
+  const int blk_w = 16;
+  const int blk_h = 16;
+  int count_buf[1 << 12];  // Maximum (1 << 12) color levels.
+  for (int r = 0; r + blk_h <= img->y_height; r += blk_h) {
+    for (int c = 0; c + blk_w <= img->y_width; c += blk_w) {
+      const uint8_t *const this_src = img->y_buffer + r * stride + c;
+      *block_colors++ =
+          use_hbd ? av1_count_colors_highbd(this_src, stride, blk_w, blk_h,
+                                            bit_depth, count_buf)
+                  : av1_count_colors(this_src, stride, blk_w, blk_h, count_buf);
+    }
+  }
+}
+
+// Computes the statistics of the buffer in data1.
+static int compute_stats(void *arg1, void *unused) {
+  struct lookahead_entry *const buf = (struct lookahead_entry *)arg1;
+  struct lookahead_stats *const stats = &buf->stats;
+  (void)unused;
+#if !CONFIG_REALTIME_ONLY
+  if (stats->flags & LOOKAHEAD_STATS_RAW_MOTION_ERR) {
+    av1_first_pass_raw_motion_err(&buf->img, stats->raw_motion_ref,
+                                  stats->mi_rows, stats->mi_cols,
+                                  stats->bit_depth, stats->raw_motion_err);
+  }
+#endif
+  if (stats->flags & LOOKAHEAD_STATS_BLOCK_COLORS)
+    count_block_colors(&buf->img, stats->bit_depth, stats->block_colors);
+  return 1;
+}
+
+// Allocates the statistics of buf which are computed on it.
+static int alloc_stats(struct lookahead_ctx *ctx,
+                       struct lookahead_entry *buf) {
+  struct lookahead_stats *const stats = &buf->stats;
+  const struct lookahead_entry *const last = ctx->last_entry;
+  stats->flags = 0;
+  stats->bit_depth = ctx->bit_depth;
+  stats->mi_rows = ALIGN_POWER_OF_TWO(buf->img.y_crop_height, 3) >> 2;
+  stats->mi_cols = ALIGN_POWER_OF_TWO(buf->img.y_crop_width, 3) >> 2;
+  stats->raw_motion_ref = NULL;
+  if ((ctx->stats_flags & LOOKAHEAD_STATS_RAW_MOTION_ERR) && last != NULL &&
+      last->img.y_crop_width == buf->img.y_crop_width &&
+      last->img.y_crop_height == buf->img.y_crop_height &&
+      last->img.flags == buf->img.flags) {
+    const int mbs = ((stats->mi_rows + 2) >> 2) * ((stats->mi_cols + 2) >> 2);
+    if (stats->allocated_mbs < mbs) {
+      free(stats->raw_motion_err);
+      stats->allocated_mbs = 0;
+      stats->raw_motion_err = malloc(mbs * sizeof(*stats->raw_motion_err));
+      if (stats->raw_motion_err == NULL) return 1;
+      stats->allocated_mbs = mbs;
+    }
+    stats->raw_motion_ref = &last->img;
+    stats->flags |= LOOKAHEAD_STATS_RAW_MOTION_ERR;
+  }
+  if ((ctx->stats_flags & LOOKAHEAD_STATS_BLOCK_COLORS) &&
+      (last == NULL || (buf->flags & AOM_EFLAG_FORCE_KF))) {
+    const int blocks = (buf->img.y_height / 16) * (buf->img.y_width / 16);
+    if (stats->allocated_blocks < blocks) {
+      free(stats->block_colors);
+      stats->allocated_blocks = 0;
+      stats->block_colors = malloc(blocks * sizeof(*stats->block_colors));
+      if (stats->block_colors == NULL) return 1;
+      stats->allocated_blocks = blocks;
+    }
+    stats->flags |= LOOKAHEAD_STATS_BLOCK_COLORS;
+  }
+  return 0;
+}
+
 int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
                        int64_t ts_start, int64_t ts_end, int use_highbitdepth,
                        aom_enc_frame_flags_t flags) {
@@ -103,7 +247,12 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
   if (ctx->read_ctxs[LAP_STAGE].valid) {
     ctx->read_ctxs[LAP_STAGE].sz++;
   }
+  // The worker may still read the buffers of the last enqueued frame.
+  sync_stats(ctx);
   buf = pop(ctx, &ctx->write_idx);
+  buf->stats.flags = 0;
+  av1_zero(buf->scaled_valid);
+  buf->next_scaled = 0;
 
   new_dimensions = width != buf->img.y_crop_width ||
                    height != buf->img.y_crop_height ||
@@ -139,6 +288,22 @@ int av1_lookahead_push(struct lookahead_ctx *ctx, YV12_BUFFER_CONFIG *src,
   buf->flags = flags;
   aom_remove_metadata_from_frame_buffer(&buf->img);
   aom_copy_metadata_to_frame_buffer(&buf->img, src->metadata);
+
+  if (alloc_stats(ctx, buf)) {
+    buf->stats.flags = 0;
+    return 1;
+  }
+  ctx->last_entry = buf;
+  if (buf->stats.flags) {
+    if (ctx->worker != NULL) {
+      ctx->worker->hook = compute_stats;
+      ctx->worker->data1 = buf;
+      ctx->worker->data2 = NULL;
+      aom_get_worker_interface()->launch(ctx->worker);
+    } else {
+      compute_stats(buf, NULL);
+    }
+  }
   return 0;
 }
 
@@ -149,6 +314,7 @@ struct lookahead_entry *av1_lookahead_pop(struct lookahead_ctx *ctx, int drain,
     struct read_ctx *read_ctx = &ctx->read_ctxs[stage];
     assert(read_ctx->valid == 1);
     if (read_ctx->sz && (drain || read_ctx->sz == read_ctx->pop_sz)) {
+      if (stage == ENCODE_STAGE) free_stale_scaled_copies(ctx, read_ctx);
       buf = pop(ctx, &read_ctx->read_idx);
       read_ctx->sz--;
     }
@@ -203,3 +369,49 @@ int av1_lookahead_pop_sz(struct lookahead_ctx *ctx, COMPRESSOR_STAGE stage) {
   assert(read_ctx->valid == 1);
   return read_ctx->pop_sz;
 }
+
+// Returns the enqueued buffer of img, or NULL.
+static struct lookahead_entry *find_entry(struct lookahead_ctx *ctx,
+                                          const YV12_BUFFER_CONFIG *img) {
+  if (ctx == NULL) return NULL;
+  for (int i = 0; i < ctx->max_sz; ++i) {
+    if (&ctx->buf[i].img == img) return &ctx->buf[i];
+  }
+  return NULL;
+}
+
+YV12_BUFFER_CONFIG *av1_lookahead_get_scaled(struct lookahead_ctx *ctx,
+                                             const YV12_BUFFER_CONFIG *img,
+                                             int width, int height,
+                                             int bit_depth, int num_planes,
+                                             int border, int byte_alignment) {
+  struct lookahead_entry *const buf = find_entry(ctx, img);
+  if (buf == NULL) return NULL;
+  for (int i = 0; i < LOOKAHEAD_SCALED_COPIES; ++i) {
+    YV12_BUFFER_CONFIG *const scaled = &buf->scaled_img[i];
+    if (buf->scaled_valid[i] && scaled->y_crop_width == width &&
+        scaled->y_crop_height == height && scaled->border == border)
+      return scaled;
+  }
+
+  const int idx = buf->next_scaled;
+  YV12_BUFFER_CONFIG *const scaled = &buf->scaled_img[idx];
+  buf->scaled_valid[idx] = 0;
+  if (aom_realloc_frame_buffer(scaled, width, height, img->subsampling_x,
+                               img->subsampling_y,
+                               (img->flags & YV12_FLAG_HIGHBITDEPTH) != 0,
+                               border, byte_alignment, NULL, NULL, NULL))
+    return NULL;
+  av1_resize_and_extend_frame(img, scaled, bit_depth, num_planes);
+  buf->scaled_valid[idx] = 1;
+  buf->next_scaled = (idx + 1) % LOOKAHEAD_SCALED_COPIES;
+  return scaled;
+}
+
+const struct lookahead_stats *av1_lookahead_get_stats(
+    struct lookahead_ctx *ctx, const YV12_BUFFER_CONFIG *img) {
+  struct lookahead_entry *const buf = find_entry(ctx, img);
+  if (buf == NULL) return NULL;
+  sync_stats(ctx);
+  return &buf->stats;
+}
@@ -13,6 +13,7 @@
 #define AOM_AV1_ENCODER_LOOKAHEAD_H_
 
 #include "aom_scale/yv12config.h"
+#include "aom_util/aom_thread.h"
 #include "aom/aom_integer.h"
 
 #ifdef __cplusplus
@@ -24,11 +25,44 @@ extern "C" {
 #define MAX_TOTAL_BUFFERS (MAX_LAG_BUFFERS + MAX_LAP_BUFFERS)
 #define LAP_LAG_IN_FRAMES 17
 
+// Statistics which the lookahead computes on a frame when it is enqueued.
+#define LOOKAHEAD_STATS_RAW_MOTION_ERR (1 << 0)
+#define LOOKAHEAD_STATS_BLOCK_COLORS (1 << 1)
+
+// Statistics of the luma plane of an enqueued frame. They are computed in the
+// background while the earlier frames are encoded, and must be read through
+// av1_lookahead_get_stats().
+struct lookahead_stats {
+  int flags;  // LOOKAHEAD_STATS_* computed for the frame
+  int bit_depth;
+  // Size of the frame in 4x4 units, from which the first pass sizes its blocks.
+  int mi_rows;
+  int mi_cols;
+  // Sum of squared error at zero motion of each block of the first pass, with
+  // raw_motion_ref, the previously enqueued frame, as reference.
+  int *raw_motion_err;
+  const YV12_BUFFER_CONFIG *raw_motion_ref;
+  int allocated_mbs;
+  // Number of luma colors of each 16x16 block inside the frame, in raster
+  // order, as counted by the screen content detection.
+  uint16_t *block_colors;
+  int allocated_blocks;
+};
+
+// Number of scaled copies of a frame kept in its lookahead entry.
+#define LOOKAHEAD_SCALED_COPIES 2
+
 struct lookahead_entry {
   YV12_BUFFER_CONFIG img;
   int64_t ts_start;
   int64_t ts_end;
   aom_enc_frame_flags_t flags;
+  struct lookahead_stats stats;
+  // Copies of img scaled to the sizes the frame is coded at, built the first
+  // time each size is needed. See av1_lookahead_get_scaled().
+  YV12_BUFFER_CONFIG scaled_img[LOOKAHEAD_SCALED_COPIES];
+  int scaled_valid[LOOKAHEAD_SCALED_COPIES];
+  int next_scaled;  // Index of the scaled copy to replace next
 };
 
 // The max of past frames we want to keep in the queue.
@@ -48,6 +82,10 @@ struct lookahead_ctx {
   int write_idx;                         /* Write index */
   struct read_ctx read_ctxs[MAX_STAGES]; /* Read context */
   struct lookahead_entry *buf;           /* Buffer list */
+  struct lookahead_entry *last_entry;    /* Last enqueued buffer */
+  int stats_flags;                       /* LOOKAHEAD_STATS_* to compute */
+  int bit_depth;                         /* Bit depth of the stats */
+  AVxWorker *worker;                     /* Stats worker, or NULL */
 };
 
 /**\brief Initializes the lookahead stage
@@ -64,6 +102,21 @@ struct lookahead_ctx *av1_lookahead_init(
  */
 void av1_lookahead_destroy(struct lookahead_ctx *ctx);
 
+/**\brief Sets the statistics computed on the next enqueued buffers
+ *
+ * The statistics are computed on a background thread if use_worker is set and
+ * one can be created, and otherwise when the buffer is enqueued.
+ *
+ * \param[in] ctx         Pointer to the lookahead context
+ * \param[in] stats_flags LOOKAHEAD_STATS_* to compute. The block colors are
+ *                        only computed for the first frame and the forced key
+ *                        frames, the key frames known when they are enqueued.
+ * \param[in] bit_depth   Bit depth of the frames
+ * \param[in] use_worker  Whether to compute the statistics in the background
+ */
+void av1_lookahead_set_stats(struct lookahead_ctx *ctx, int stats_flags,
+                             int bit_depth, int use_worker);
+
 /**\brief Enqueue a source buffer
  *
  * This function will copy the source image into a new framebuffer with
@@ -115,6 +168,44 @@ unsigned int av1_lookahead_depth(struct lookahead_ctx *ctx,
 
 int av1_lookahead_pop_sz(struct lookahead_ctx *ctx, COMPRESSOR_STAGE stage);
 
+/**\brief Get the statistics of an enqueued buffer
+ *
+ * Waits for the statistics being computed in the background.
+ *
+ * \param[in] ctx       Pointer to the lookahead context
+ * \param[in] img       Image of the buffer
+ *
+ * \retval NULL, if img is not the image of an enqueued buffer
+ */
+const struct lookahead_stats *av1_lookahead_get_stats(
+    struct lookahead_ctx *ctx, const YV12_BUFFER_CONFIG *img);
+
+/**\brief Get an enqueued buffer scaled to a frame size
+ *
+ * The scaled copy is built the first time it is requested, and kept until it
+ * is replaced by a copy at another size or the buffer is no longer one of the
+ * MAX_PRE_FRAMES previous source frames. So at most
+ * (MAX_PRE_FRAMES + 1) * LOOKAHEAD_SCALED_COPIES scaled frames are allocated
+ * outside of the queued frames, which are scaled as alt-ref sources.
+ *
+ * \param[in] ctx            Pointer to the lookahead context
+ * \param[in] img            Image of the buffer
+ * \param[in] width          Width to scale to
+ * \param[in] height         Height to scale to
+ * \param[in] bit_depth      Bit depth of the image
+ * \param[in] num_planes     Number of planes to scale
+ * \param[in] border         Border of the scaled copy
+ * \param[in] byte_alignment Alignment of the rows of the scaled copy
+ *
+ * \retval NULL, if img is not the image of an enqueued buffer or the scaled
+ *               copy cannot be allocated
+ */
+YV12_BUFFER_CONFIG *av1_lookahead_get_scaled(struct lookahead_ctx *ctx,
+                                             const YV12_BUFFER_CONFIG *img,
+                                             int width, int height,
+                                             int bit_depth, int num_planes,
+                                             int border, int byte_alignment);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -12,6 +12,7 @@
 #include <math.h>
 #include <string.h>
 
+#include "config/aom_dsp_rtcd.h"
 #include "config/aom_scale_rtcd.h"
 
 #include "aom/aom_integer.h"
@@ -20,6 +21,8 @@
 #include "av1/common/cdef.h"
 #include "av1/common/reconinter.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
+#include "av1/encoder/pickcdef.h"
 
 #define REDUCED_PRI_STRENGTHS_LVL1 8
 #define REDUCED_PRI_STRENGTHS_LVL2 5
@@ -198,6 +201,7 @@ typedef uint64_t (*compute_cdef_dist_t)(void *dst, int dstride, uint16_t *src,
                                         BLOCK_SIZE bsize, int coeff_shift,
                                         int row, int col);
 
+#if CONFIG_AV1_HIGHBITDEPTH
 static void copy_sb16_16_highbd(uint16_t *dst, int dstride, const void *src,
                                 int src_voffset, int src_hoffset, int sstride,
                                 int vsize, int hsize) {
@@ -207,6 +211,7 @@ static void copy_sb16_16_highbd(uint16_t *dst, int dstride, const void *src,
   for (r = 0; r < vsize; r++)
     memcpy(dst + r * dstride, base + r * sstride, hsize * sizeof(*base));
 }
+#endif  // CONFIG_AV1_HIGHBITDEPTH
 
 static void copy_sb16_16(uint16_t *dst, int dstride, const void *src,
                          int src_voffset, int src_hoffset, int sstride,
@@ -219,33 +224,6 @@ static void copy_sb16_16(uint16_t *dst, int dstride, const void *src,
       dst[r * dstride + c] = (uint16_t)base[r * sstride + c];
 }
 
-static INLINE uint64_t mse_wxh_16bit_highbd(uint16_t *dst, int dstride,
-                                            uint16_t *src, int sstride, int w,
-                                            int h) {
-  uint64_t sum = 0;
-  int i, j;
-  for (i = 0; i < h; i++) {
-    for (j = 0; j < w; j++) {
-      int e = dst[i * dstride + j] - src[i * sstride + j];
-      sum += e * e;
-    }
-  }
-  return sum;
-}
-
-static INLINE uint64_t mse_wxh_16bit(uint8_t *dst, int dstride, uint16_t *src,
-                                     int sstride, int w, int h) {
-  uint64_t sum = 0;
-  int i, j;
-  for (i = 0; i < h; i++) {
-    for (j = 0; j < w; j++) {
-      int e = (uint16_t)dst[i * dstride + j] - src[i * sstride + j];
-      sum += e * e;
-    }
-  }
-  return sum;
-}
-
 static INLINE void init_src_params(int *src_stride, int *width, int *height,
                                    int *width_log2, int *height_log2,
                                    BLOCK_SIZE bsize) {
@@ -256,6 +234,7 @@ static INLINE void init_src_params(int *src_stride, int *width, int *height,
   *height_log2 = MI_SIZE_LOG2 + mi_size_wide_log2[bsize];
 }
 
+#if CONFIG_AV1_HIGHBITDEPTH
 /* Compute MSE only on the blocks we filtered. */
 static uint64_t compute_cdef_dist_highbd(void *dst, int dstride, uint16_t *src,
                                          cdef_list *dlist, int cdef_count,
@@ -273,13 +252,15 @@ static uint64_t compute_cdef_dist_highbd(void *dst, int dstride, uint16_t *src,
   for (bi = 0; bi < cdef_count; bi++) {
     by = dlist[bi].by;
     bx = dlist[bi].bx;
-    sum += mse_wxh_16bit_highbd(
+    sum += aom_mse_wxh_16bit_highbd(
         &dst_buff[(by << height_log2) * dstride + (bx << width_log2)], dstride,
         &src[bi << (height_log2 + width_log2)], src_stride, width, height);
   }
   return sum >> 2 * coeff_shift;
 }
+#endif  // CONFIG_AV1_HIGHBITDEPTH
 
+/* Compute MSE only on the blocks we filtered. */
 static uint64_t compute_cdef_dist(void *dst, int dstride, uint16_t *src,
                                   cdef_list *dlist, int cdef_count,
                                   BLOCK_SIZE bsize, int coeff_shift, int row,
@@ -296,7 +277,7 @@ static uint64_t compute_cdef_dist(void *dst, int dstride, uint16_t *src,
   for (bi = 0; bi < cdef_count; bi++) {
     by = dlist[bi].by;
     bx = dlist[bi].bx;
-    sum += mse_wxh_16bit(
+    sum += aom_mse_wxh_16bit(
         &dst_buff[(by << height_log2) * dstride + (bx << width_log2)], dstride,
         &src[bi << (height_log2 + width_log2)], src_stride, width, height);
   }
@@ -375,144 +356,229 @@ static void pick_cdef_from_qp(AV1_COMMON *const cm) {
   }
 }
 
-void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
-                     AV1_COMMON *cm, MACROBLOCKD *xd, int pick_method,
-                     int rdmult) {
+// State of the strength search of a frame, shared by the jobs computing the
+// distortions of its filter blocks.
+typedef struct CdefSearchCtx {
+  const CommonModeInfoParams *mi_params;
+  const MACROBLOCKD *xd;
+  CDEF_PICK_METHOD pick_method;
+  int fast;
+  int total_strengths;
+  int num_planes;
+  int nvfb;
+  int nhfb;
+  int damping;
+  int coeff_shift;
+  int bsize[3];
+  int mi_wide_l2[3];
+  int mi_high_l2[3];
+  int xdec[3];
+  int ydec[3];
+  uint8_t *ref_buffer[3];
+  int ref_stride[3];
+  copy_fn_t copy_fn;
+  compute_cdef_dist_t compute_cdef_dist_fn;
+  // Position of each filter block to search, in raster order.
+  int *fb_rows;
+  int *fb_cols;
+  // Distortion of each filter block for each strength, for luma and for the
+  // sum of both chroma planes.
+  uint64_t (*mse[2])[TOTAL_STRENGTHS];
+} CdefSearchCtx;
+
+// Returns the size of the filter block at (fbr, fbc) in 'bs', or 0 if it is
+// not searched: if it is entirely skipped or part of a 128x128 superblock
+// covered by an earlier filter block.
+static int get_fb_size(const CommonModeInfoParams *const mi_params, int fbr,
+                       int fbc, BLOCK_SIZE *bs) {
+  // No filtering if the entire filter block is skipped
+  if (sb_all_skip(mi_params, fbr * MI_SIZE_64X64, fbc * MI_SIZE_64X64))
+    return 0;
+
+  const MB_MODE_INFO *const mbmi =
+      mi_params->mi_grid_base[MI_SIZE_64X64 * fbr * mi_params->mi_stride +
+                              MI_SIZE_64X64 * fbc];
+  if (((fbc & 1) &&
+       (mbmi->sb_type == BLOCK_128X128 || mbmi->sb_type == BLOCK_128X64)) ||
+      ((fbr & 1) &&
+       (mbmi->sb_type == BLOCK_128X128 || mbmi->sb_type == BLOCK_64X128)))
+    return 0;
+
+  if (mbmi->sb_type == BLOCK_128X128 || mbmi->sb_type == BLOCK_128X64 ||
+      mbmi->sb_type == BLOCK_64X128)
+    *bs = mbmi->sb_type;
+  else
+    *bs = BLOCK_64X64;
+  return 1;
+}
+
+void av1_cdef_search_fb(AV1_COMP *cpi, int job) {
+  const CdefSearchCtx *const ctx =
+      (const CdefSearchCtx *)cpi->cdef_search_mt_info.ctx;
+  const CommonModeInfoParams *const mi_params = ctx->mi_params;
+  const MACROBLOCKD *const xd = ctx->xd;
+  const int fbr = ctx->fb_rows[job];
+  const int fbc = ctx->fb_cols[job];
+  const int nvfb = ctx->nvfb;
+  const int nhfb = ctx->nhfb;
+  cdef_list dlist[MI_SIZE_128X128 * MI_SIZE_128X128];
+  int dir[CDEF_NBLOCKS][CDEF_NBLOCKS] = { { 0 } };
+  int var[CDEF_NBLOCKS][CDEF_NBLOCKS] = { { 0 } };
+  DECLARE_ALIGNED(32, uint16_t, tmp_dst[1 << (MAX_SB_SIZE_LOG2 * 2)]);
+  DECLARE_ALIGNED(32, uint16_t, inbuf[CDEF_INBUF_SIZE]);
+  uint16_t *const in = inbuf + CDEF_VBORDER * CDEF_BSTRIDE + CDEF_HBORDER;
+
+  BLOCK_SIZE bs = BLOCK_64X64;
+  get_fb_size(mi_params, fbr, fbc, &bs);
+  int nhb = AOMMIN(MI_SIZE_64X64, mi_params->mi_cols - MI_SIZE_64X64 * fbc);
+  int nvb = AOMMIN(MI_SIZE_64X64, mi_params->mi_rows - MI_SIZE_64X64 * fbr);
+  int hb_step = 1;
+  int vb_step = 1;
+  if (bs == BLOCK_128X128 || bs == BLOCK_128X64) {
+    nhb = AOMMIN(MI_SIZE_128X128, mi_params->mi_cols - MI_SIZE_64X64 * fbc);
+    hb_step = 2;
+  }
+  if (bs == BLOCK_128X128 || bs == BLOCK_64X128) {
+    nvb = AOMMIN(MI_SIZE_128X128, mi_params->mi_rows - MI_SIZE_64X64 * fbr);
+    vb_step = 2;
+  }
+
+  const int cdef_count = av1_cdef_compute_sb_list(
+      mi_params, fbr * MI_SIZE_64X64, fbc * MI_SIZE_64X64, dlist, bs);
+
+  const int yoff = CDEF_VBORDER * (fbr != 0);
+  const int xoff = CDEF_HBORDER * (fbc != 0);
+  int dirinit = 0;
+  for (int pli = 0; pli < ctx->num_planes; pli++) {
+    for (int i = 0; i < CDEF_INBUF_SIZE; i++) inbuf[i] = CDEF_VERY_LARGE;
+    /* We avoid filtering the pixels for which some of the pixels to
+       average are outside the frame. We could change the filter instead,
+       but it would add special cases for any future vectorization. */
+    const int ysize = (nvb << ctx->mi_high_l2[pli]) +
+                      CDEF_VBORDER * (fbr + vb_step < nvfb) + yoff;
+    const int xsize = (nhb << ctx->mi_wide_l2[pli]) +
+                      CDEF_HBORDER * (fbc + hb_step < nhfb) + xoff;
+    const int row = fbr * MI_SIZE_64X64 << ctx->mi_high_l2[pli];
+    const int col = fbc * MI_SIZE_64X64 << ctx->mi_wide_l2[pli];
+    for (int gi = 0; gi < ctx->total_strengths; gi++) {
+      int pri_strength = gi / CDEF_SEC_STRENGTHS;
+      if (ctx->fast)
+        pri_strength = get_pri_strength(ctx->pick_method, pri_strength);
+      const int sec_strength = gi % CDEF_SEC_STRENGTHS;
+      ctx->copy_fn(&in[(-yoff * CDEF_BSTRIDE - xoff)], CDEF_BSTRIDE,
+                   xd->plane[pli].dst.buf, row - yoff, col - xoff,
+                   xd->plane[pli].dst.stride, ysize, xsize);
+      av1_cdef_filter_fb(NULL, tmp_dst, CDEF_BSTRIDE, in, ctx->xdec[pli],
+                         ctx->ydec[pli], dir, &dirinit, var, pli, dlist,
+                         cdef_count, pri_strength,
+                         sec_strength + (sec_strength == 3), ctx->damping,
+                         ctx->coeff_shift);
+      const uint64_t curr_mse = ctx->compute_cdef_dist_fn(
+          ctx->ref_buffer[pli], ctx->ref_stride[pli], tmp_dst, dlist,
+          cdef_count, ctx->bsize[pli], ctx->coeff_shift, row, col);
+      if (pli < 2)
+        ctx->mse[pli][job][gi] = curr_mse;
+      else
+        ctx->mse[1][job][gi] += curr_mse;
+    }
+  }
+}
+
+void av1_cdef_search(AV1_COMP *cpi, YV12_BUFFER_CONFIG *frame,
+                     const YV12_BUFFER_CONFIG *ref, MACROBLOCKD *xd,
+                     int pick_method, int rdmult) {
+  AV1_COMMON *const cm = &cpi->common;
   if (pick_method == CDEF_PICK_FROM_Q) {
     pick_cdef_from_qp(cm);
     return;
   }
 
-  cdef_list dlist[MI_SIZE_128X128 * MI_SIZE_128X128];
-  int dir[CDEF_NBLOCKS][CDEF_NBLOCKS] = { { 0 } };
-  int var[CDEF_NBLOCKS][CDEF_NBLOCKS] = { { 0 } };
   const CommonModeInfoParams *const mi_params = &cm->mi_params;
   const int nvfb = (mi_params->mi_rows + MI_SIZE_64X64 - 1) / MI_SIZE_64X64;
   const int nhfb = (mi_params->mi_cols + MI_SIZE_64X64 - 1) / MI_SIZE_64X64;
-  int *sb_index = aom_malloc(nvfb * nhfb * sizeof(*sb_index));
   const int damping = 3 + (cm->quant_params.base_qindex >> 6);
   const int fast = (pick_method == CDEF_FAST_SEARCH_LVL1 ||
                     pick_method == CDEF_FAST_SEARCH_LVL2);
-  const int total_strengths = nb_cdef_strengths[pick_method];
-  DECLARE_ALIGNED(32, uint16_t, tmp_dst[1 << (MAX_SB_SIZE_LOG2 * 2)]);
   const int num_planes = av1_num_planes(cm);
   av1_setup_dst_planes(xd->plane, cm->seq_params.sb_size, frame, 0, 0, 0,
                        num_planes);
-  uint64_t(*mse[2])[TOTAL_STRENGTHS];
-  mse[0] = aom_malloc(sizeof(**mse) * nvfb * nhfb);
-  mse[1] = aom_malloc(sizeof(**mse) * nvfb * nhfb);
-
-  int bsize[3];
-  int mi_wide_l2[3];
-  int mi_high_l2[3];
-  int xdec[3];
-  int ydec[3];
-  uint8_t *ref_buffer[3] = { ref->y_buffer, ref->u_buffer, ref->v_buffer };
-  int ref_stride[3] = { ref->y_stride, ref->uv_stride, ref->uv_stride };
 
+  CdefSearchCtx ctx;
+  ctx.mi_params = mi_params;
+  ctx.xd = xd;
+  ctx.pick_method = pick_method;
+  ctx.fast = fast;
+  ctx.total_strengths = nb_cdef_strengths[pick_method];
+  ctx.num_planes = num_planes;
+  ctx.nvfb = nvfb;
+  ctx.nhfb = nhfb;
+  ctx.damping = damping;
+  ctx.coeff_shift = AOMMAX(cm->seq_params.bit_depth - 8, 0);
+  ctx.ref_buffer[0] = ref->y_buffer;
+  ctx.ref_buffer[1] = ref->u_buffer;
+  ctx.ref_buffer[2] = ref->v_buffer;
+  ctx.ref_stride[0] = ref->y_stride;
+  ctx.ref_stride[1] = ref->uv_stride;
+  ctx.ref_stride[2] = ref->uv_stride;
   for (int pli = 0; pli < num_planes; pli++) {
-    xdec[pli] = xd->plane[pli].subsampling_x;
-    ydec[pli] = xd->plane[pli].subsampling_y;
-    bsize[pli] = ydec[pli] ? (xdec[pli] ? BLOCK_4X4 : BLOCK_8X4)
-                           : (xdec[pli] ? BLOCK_4X8 : BLOCK_8X8);
-    mi_wide_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_x;
-    mi_high_l2[pli] = MI_SIZE_LOG2 - xd->plane[pli].subsampling_y;
+    const int xdec = xd->plane[pli].subsampling_x;
+    const int ydec = xd->plane[pli].subsampling_y;
+    ctx.xdec[pli] = xdec;
+    ctx.ydec[pli] = ydec;
+    ctx.bsize[pli] = ydec ? (xdec ? BLOCK_4X4 : BLOCK_8X4)
+                          : (xdec ? BLOCK_4X8 : BLOCK_8X8);
+    ctx.mi_wide_l2[pli] = MI_SIZE_LOG2 - xdec;
+    ctx.mi_high_l2[pli] = MI_SIZE_LOG2 - ydec;
   }
-
-  copy_fn_t copy_fn;
-  compute_cdef_dist_t compute_cdef_dist_fn;
-
+#if CONFIG_AV1_HIGHBITDEPTH
   if (cm->seq_params.use_highbitdepth) {
-    copy_fn = copy_sb16_16_highbd;
-    compute_cdef_dist_fn = compute_cdef_dist_highbd;
+    ctx.copy_fn = copy_sb16_16_highbd;
+    ctx.compute_cdef_dist_fn = compute_cdef_dist_highbd;
   } else {
-    copy_fn = copy_sb16_16;
-    compute_cdef_dist_fn = compute_cdef_dist;
+    ctx.copy_fn = copy_sb16_16;
+    ctx.compute_cdef_dist_fn = compute_cdef_dist;
   }
-
-  DECLARE_ALIGNED(32, uint16_t, inbuf[CDEF_INBUF_SIZE]);
-  uint16_t *const in = inbuf + CDEF_VBORDER * CDEF_BSTRIDE + CDEF_HBORDER;
-  const int coeff_shift = AOMMAX(cm->seq_params.bit_depth - 8, 0);
+#else
+  ctx.copy_fn = copy_sb16_16;
+  ctx.compute_cdef_dist_fn = compute_cdef_dist;
+#endif
+
+  int *sb_index;
+  CHECK_MEM_ERROR(cm, sb_index, aom_malloc(nvfb * nhfb * sizeof(*sb_index)));
+  CHECK_MEM_ERROR(cm, ctx.fb_rows,
+                  aom_malloc(nvfb * nhfb * sizeof(*ctx.fb_rows)));
+  CHECK_MEM_ERROR(cm, ctx.fb_cols,
+                  aom_malloc(nvfb * nhfb * sizeof(*ctx.fb_cols)));
+  CHECK_MEM_ERROR(cm, ctx.mse[0],
+                  aom_malloc(sizeof(**ctx.mse) * nvfb * nhfb));
+  CHECK_MEM_ERROR(cm, ctx.mse[1],
+                  aom_malloc(sizeof(**ctx.mse) * nvfb * nhfb));
+  uint64_t(**mse)[TOTAL_STRENGTHS] = ctx.mse;
+
+  // List the filter blocks to search, whose distortions are then computed
+  // independently of each other.
   int sb_count = 0;
   for (int fbr = 0; fbr < nvfb; ++fbr) {
     for (int fbc = 0; fbc < nhfb; ++fbc) {
-      // No filtering if the entire filter block is skipped
-      if (sb_all_skip(mi_params, fbr * MI_SIZE_64X64, fbc * MI_SIZE_64X64))
-        continue;
-
-      const MB_MODE_INFO *const mbmi =
-          mi_params->mi_grid_base[MI_SIZE_64X64 * fbr * mi_params->mi_stride +
-                                  MI_SIZE_64X64 * fbc];
-      if (((fbc & 1) &&
-           (mbmi->sb_type == BLOCK_128X128 || mbmi->sb_type == BLOCK_128X64)) ||
-          ((fbr & 1) &&
-           (mbmi->sb_type == BLOCK_128X128 || mbmi->sb_type == BLOCK_64X128)))
-        continue;
-
-      int nhb = AOMMIN(MI_SIZE_64X64, mi_params->mi_cols - MI_SIZE_64X64 * fbc);
-      int nvb = AOMMIN(MI_SIZE_64X64, mi_params->mi_rows - MI_SIZE_64X64 * fbr);
-      int hb_step = 1;
-      int vb_step = 1;
       BLOCK_SIZE bs;
-      if (mbmi->sb_type == BLOCK_128X128 || mbmi->sb_type == BLOCK_128X64 ||
-          mbmi->sb_type == BLOCK_64X128) {
-        bs = mbmi->sb_type;
-        if (bs == BLOCK_128X128 || bs == BLOCK_128X64) {
-          nhb =
-              AOMMIN(MI_SIZE_128X128, mi_params->mi_cols - MI_SIZE_64X64 * fbc);
-          hb_step = 2;
-        }
-        if (bs == BLOCK_128X128 || bs == BLOCK_64X128) {
-          nvb =
-              AOMMIN(MI_SIZE_128X128, mi_params->mi_rows - MI_SIZE_64X64 * fbr);
-          vb_step = 2;
-        }
-      } else {
-        bs = BLOCK_64X64;
-      }
-
-      const int cdef_count = av1_cdef_compute_sb_list(
-          mi_params, fbr * MI_SIZE_64X64, fbc * MI_SIZE_64X64, dlist, bs);
-
-      const int yoff = CDEF_VBORDER * (fbr != 0);
-      const int xoff = CDEF_HBORDER * (fbc != 0);
-      int dirinit = 0;
-      for (int pli = 0; pli < num_planes; pli++) {
-        for (int i = 0; i < CDEF_INBUF_SIZE; i++) inbuf[i] = CDEF_VERY_LARGE;
-        /* We avoid filtering the pixels for which some of the pixels to
-           average are outside the frame. We could change the filter instead,
-           but it would add special cases for any future vectorization. */
-        const int ysize = (nvb << mi_high_l2[pli]) +
-                          CDEF_VBORDER * (fbr + vb_step < nvfb) + yoff;
-        const int xsize = (nhb << mi_wide_l2[pli]) +
-                          CDEF_HBORDER * (fbc + hb_step < nhfb) + xoff;
-        const int row = fbr * MI_SIZE_64X64 << mi_high_l2[pli];
-        const int col = fbc * MI_SIZE_64X64 << mi_wide_l2[pli];
-        for (int gi = 0; gi < total_strengths; gi++) {
-          int pri_strength = gi / CDEF_SEC_STRENGTHS;
-          if (fast) pri_strength = get_pri_strength(pick_method, pri_strength);
-          const int sec_strength = gi % CDEF_SEC_STRENGTHS;
-          copy_fn(&in[(-yoff * CDEF_BSTRIDE - xoff)], CDEF_BSTRIDE,
-                  xd->plane[pli].dst.buf, row - yoff, col - xoff,
-                  xd->plane[pli].dst.stride, ysize, xsize);
-          av1_cdef_filter_fb(
-              NULL, tmp_dst, CDEF_BSTRIDE, in, xdec[pli], ydec[pli], dir,
-              &dirinit, var, pli, dlist, cdef_count, pri_strength,
-              sec_strength + (sec_strength == 3), damping, coeff_shift);
-          const uint64_t curr_mse = compute_cdef_dist_fn(
-              ref_buffer[pli], ref_stride[pli], tmp_dst, dlist, cdef_count,
-              bsize[pli], coeff_shift, row, col);
-          if (pli < 2)
-            mse[pli][sb_count][gi] = curr_mse;
-          else
-            mse[1][sb_count][gi] += curr_mse;
-        }
-      }
+      if (!get_fb_size(mi_params, fbr, fbc, &bs)) continue;
+      ctx.fb_rows[sb_count] = fbr;
+      ctx.fb_cols[sb_count] = fbc;
       sb_index[sb_count++] =
           MI_SIZE_64X64 * fbr * mi_params->mi_stride + MI_SIZE_64X64 * fbc;
     }
   }
 
+  CdefSearchMTInfo *const mt_info = &cpi->cdef_search_mt_info;
+  mt_info->ctx = &ctx;
+  mt_info->num_fbs = sb_count;
+  if (cpi->oxcf.max_threads > 1 && sb_count > 1) {
+    av1_cdef_search_mt(cpi);
+  } else {
+    for (int i = 0; i < sb_count; i++) av1_cdef_search_fb(cpi, i);
+  }
+  mt_info->ctx = NULL;
+
   /* Search for different number of signalling bits. */
   int nb_strength_bits = 0;
   uint64_t best_rd = UINT64_MAX;
@@ -581,7 +647,9 @@ void av1_cdef_search(YV12_BUFFER_CONFIG *frame, const YV12_BUFFER_CONFIG *ref,
 
   cdef_info->cdef_damping = damping;
 
-  aom_free(mse[0]);
-  aom_free(mse[1]);
+  aom_free(ctx.mse[0]);
+  aom_free(ctx.mse[1]);
+  aom_free(ctx.fb_rows);
+  aom_free(ctx.fb_cols);
   aom_free(sb_index);
 }
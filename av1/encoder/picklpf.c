@@ -25,8 +25,13 @@
 
 #include "av1/encoder/av1_quantize.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/picklpf.h"
 
+// Height in luma rows of the bands of a plane measured and restored by the
+// workers after each filter level tried.
+#define LPF_SSE_BAND_HEIGHT 64
+
 static void yv12_copy_plane(const YV12_BUFFER_CONFIG *src_bc,
                             YV12_BUFFER_CONFIG *dst_bc, int plane) {
   switch (plane) {
@@ -37,6 +42,75 @@ static void yv12_copy_plane(const YV12_BUFFER_CONFIG *src_bc,
   }
 }
 
+// Copies the rows [vstart, vend) of the plane, over the width copied by
+// yv12_copy_plane().
+static void yv12_partial_copy_plane(const YV12_BUFFER_CONFIG *src_bc,
+                                    YV12_BUFFER_CONFIG *dst_bc, int plane,
+                                    int vstart, int vend) {
+  const int width = src_bc->widths[plane > 0];
+  switch (plane) {
+    case 0:
+      aom_yv12_partial_copy_y(src_bc, 0, width, vstart, vend, dst_bc, 0,
+                              vstart);
+      break;
+    case 1:
+      aom_yv12_partial_copy_u(src_bc, 0, width, vstart, vend, dst_bc, 0,
+                              vstart);
+      break;
+    case 2:
+      aom_yv12_partial_copy_v(src_bc, 0, width, vstart, vend, dst_bc, 0,
+                              vstart);
+      break;
+    default: assert(plane >= 0 && plane <= 2); break;
+  }
+}
+
+static int64_t get_sse_plane_part(const YV12_BUFFER_CONFIG *a,
+                                  const YV12_BUFFER_CONFIG *b, int plane,
+                                  int vstart, int height, int highbd) {
+  const int width = a->crop_widths[plane > 0];
+#if CONFIG_AV1_HIGHBITDEPTH
+  if (highbd) {
+    switch (plane) {
+      case 0: return aom_highbd_get_y_sse_part(a, b, 0, width, vstart, height);
+      case 1: return aom_highbd_get_u_sse_part(a, b, 0, width, vstart, height);
+      case 2: return aom_highbd_get_v_sse_part(a, b, 0, width, vstart, height);
+      default: assert(plane >= 0 && plane <= 2); return 0;
+    }
+  }
+#else
+  (void)highbd;
+#endif
+  switch (plane) {
+    case 0: return aom_get_y_sse_part(a, b, 0, width, vstart, height);
+    case 1: return aom_get_u_sse_part(a, b, 0, width, vstart, height);
+    case 2: return aom_get_v_sse_part(a, b, 0, width, vstart, height);
+    default: assert(plane >= 0 && plane <= 2); return 0;
+  }
+}
+
+void av1_pick_lpf_band_sse(AV1_COMP *cpi, int band) {
+  AV1_COMMON *const cm = &cpi->common;
+  PickLpfMTInfo *const mt_info = &cpi->pick_lpf_mt_info;
+  const int plane = mt_info->plane;
+  const int is_uv = plane > 0;
+  YV12_BUFFER_CONFIG *const frame = &cm->cur_frame->buf;
+  const int band_height =
+      LPF_SSE_BAND_HEIGHT >> (is_uv ? cm->seq_params.subsampling_y : 0);
+  const int vstart = band * band_height;
+  const int sse_end = AOMMIN(vstart + band_height, frame->crop_heights[is_uv]);
+  const int copy_end = AOMMIN(vstart + band_height, frame->heights[is_uv]);
+
+  mt_info->band_sse[band] =
+      sse_end > vstart
+          ? get_sse_plane_part(mt_info->src, frame, plane, vstart,
+                               sse_end - vstart,
+                               cm->seq_params.use_highbitdepth)
+          : 0;
+  yv12_partial_copy_plane(&cpi->last_frame_uf, frame, plane, vstart,
+                          copy_end);
+}
+
 int av1_get_max_filter_level(const AV1_COMP *cpi) {
   if (is_stat_consumption_stage_twopass(cpi)) {
     return cpi->twopass.section_intra_rating > 8 ? MAX_LOOP_FILTER * 3 / 4
@@ -83,11 +157,35 @@ static int64_t try_filter_frame(const YV12_BUFFER_CONFIG *sd,
 #endif
                           plane, plane + 1, partial_frame);
 
-  filt_err = aom_get_sse_plane(sd, &cm->cur_frame->buf, plane,
-                               cm->seq_params.use_highbitdepth);
+  if (cpi->num_workers > 1) {
+    // Measure the error and re-instate the unfiltered frame by bands of rows,
+    // the workers being available anyway to filter the frame.
+    PickLpfMTInfo *const mt_info = &cpi->pick_lpf_mt_info;
+    const int is_uv = plane > 0;
+    const int band_height =
+        LPF_SSE_BAND_HEIGHT >> (is_uv ? cm->seq_params.subsampling_y : 0);
+    const int num_bands =
+        (cm->cur_frame->buf.heights[is_uv] + band_height - 1) / band_height;
+    if (mt_info->allocated_bands < num_bands) {
+      aom_free(mt_info->band_sse);
+      mt_info->allocated_bands = 0;
+      CHECK_MEM_ERROR(cm, mt_info->band_sse,
+                      aom_malloc(num_bands * sizeof(*mt_info->band_sse)));
+      mt_info->allocated_bands = num_bands;
+    }
+    mt_info->src = sd;
+    mt_info->plane = plane;
+    mt_info->num_bands = num_bands;
+    av1_pick_lpf_sse_mt(cpi);
+    filt_err = 0;
+    for (int i = 0; i < num_bands; i++) filt_err += mt_info->band_sse[i];
+  } else {
+    filt_err = aom_get_sse_plane(sd, &cm->cur_frame->buf, plane,
+                                 cm->seq_params.use_highbitdepth);
 
-  // Re-instate the unfiltered frame
-  yv12_copy_plane(&cpi->last_frame_uf, &cm->cur_frame->buf, plane);
+    // Re-instate the unfiltered frame
+    yv12_copy_plane(&cpi->last_frame_uf, &cm->cur_frame->buf, plane);
+  }
 
   return filt_err;
 }
@@ -23,6 +23,10 @@ struct AV1_COMP;
 int av1_get_max_filter_level(const AV1_COMP *cpi);
 void av1_pick_filter_level(const struct yv12_buffer_config *sd,
                            struct AV1_COMP *cpi, LPF_PICK_METHOD method);
+
+// Measures the error of the given job, a band of rows of the plane of
+// cpi->pick_lpf_mt_info, and restores it from the unfiltered frame.
+void av1_pick_lpf_band_sse(struct AV1_COMP *cpi, int band);
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -29,6 +29,7 @@
 
 #include "av1/encoder/av1_quantize.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/mathutils.h"
 #include "av1/encoder/picklpf.h"
 #include "av1/encoder/pickrst.h"
@@ -193,7 +194,8 @@ static AOM_INLINE void init_rsc(const YV12_BUFFER_CONFIG *src,
 static int64_t try_restoration_unit(const RestSearchCtxt *rsc,
                                     const RestorationTileLimits *limits,
                                     const AV1PixelRect *tile_rect,
-                                    const RestorationUnitInfo *rui) {
+                                    const RestorationUnitInfo *rui,
+                                    int32_t *tmpbuf) {
   const AV1_COMMON *const cm = rsc->cm;
   const int plane = rsc->plane;
   const int is_uv = plane > 0;
@@ -212,7 +214,7 @@ static int64_t try_restoration_unit(const RestSearchCtxt *rsc,
       is_uv && cm->seq_params.subsampling_x,
       is_uv && cm->seq_params.subsampling_y, highbd, bit_depth,
       fts->buffers[plane], fts->strides[is_uv], rsc->dst->buffers[plane],
-      rsc->dst->strides[is_uv], cm->rst_tmpbuf, optimized_lr);
+      rsc->dst->strides[is_uv], tmpbuf, optimized_lr);
 
   return sse_restoration_unit(limits, rsc->src, rsc->dst, plane, highbd);
 }
@@ -870,23 +872,15 @@ static AOM_INLINE void search_sgrproj(const RestorationTileLimits *limits,
                                       int32_t *tmpbuf,
                                       RestorationLineBuffers *rlbs) {
   (void)rlbs;
-  RestSearchCtxt *rsc = (RestSearchCtxt *)priv;
+  const RestSearchCtxt *rsc = (const RestSearchCtxt *)priv;
   RestUnitSearchInfo *rusi = &rsc->rusi[rest_unit_idx];
 
-  const MACROBLOCK *const x = rsc->x;
   const AV1_COMMON *const cm = rsc->cm;
   const int highbd = cm->seq_params.use_highbitdepth;
   const int bit_depth = cm->seq_params.bit_depth;
 
-  const int64_t bits_none = x->sgrproj_restore_cost[0];
   // Prune evaluation of RESTORE_SGRPROJ if 'skip_sgr_eval' is set
-  if (rusi->skip_sgr_eval) {
-    rsc->bits += bits_none;
-    rsc->sse += rusi->sse[RESTORE_NONE];
-    rusi->best_rtype[RESTORE_SGRPROJ - 1] = RESTORE_NONE;
-    rusi->sse[RESTORE_SGRPROJ] = INT64_MAX;
-    return;
-  }
+  if (rusi->skip_sgr_eval) return;
 
   uint8_t *dgd_start =
       rsc->dgd_buffer + limits->v_start * rsc->dgd_stride + limits->h_start;
@@ -909,7 +903,32 @@ static AOM_INLINE void search_sgrproj(const RestorationTileLimits *limits,
   rui.restoration_type = RESTORE_SGRPROJ;
   rui.sgrproj_info = rusi->sgrproj;
 
-  rusi->sse[RESTORE_SGRPROJ] = try_restoration_unit(rsc, limits, tile, &rui);
+  rusi->sse[RESTORE_SGRPROJ] =
+      try_restoration_unit(rsc, limits, tile, &rui, tmpbuf);
+}
+
+static AOM_INLINE void select_sgrproj(const RestorationTileLimits *limits,
+                                      const AV1PixelRect *tile,
+                                      int rest_unit_idx, void *priv,
+                                      int32_t *tmpbuf,
+                                      RestorationLineBuffers *rlbs) {
+  (void)limits;
+  (void)tile;
+  (void)tmpbuf;
+  (void)rlbs;
+  RestSearchCtxt *rsc = (RestSearchCtxt *)priv;
+  RestUnitSearchInfo *rusi = &rsc->rusi[rest_unit_idx];
+
+  const MACROBLOCK *const x = rsc->x;
+
+  const int64_t bits_none = x->sgrproj_restore_cost[0];
+  if (rusi->skip_sgr_eval) {
+    rsc->bits += bits_none;
+    rsc->sse += rusi->sse[RESTORE_NONE];
+    rusi->best_rtype[RESTORE_SGRPROJ - 1] = RESTORE_NONE;
+    rusi->sse[RESTORE_SGRPROJ] = INT64_MAX;
+    return;
+  }
 
   const int64_t bits_sgr = x->sgrproj_restore_cost[1] +
                            (count_sgrproj_bits(&rusi->sgrproj, &rsc->sgrproj)
@@ -1344,9 +1363,9 @@ static int64_t finer_tile_search_wiener(const RestSearchCtxt *rsc,
                                         const RestorationTileLimits *limits,
                                         const AV1PixelRect *tile,
                                         RestorationUnitInfo *rui,
-                                        int wiener_win) {
+                                        int wiener_win, int32_t *tmpbuf) {
   const int plane_off = (WIENER_WIN - wiener_win) >> 1;
-  int64_t err = try_restoration_unit(rsc, limits, tile, rui);
+  int64_t err = try_restoration_unit(rsc, limits, tile, rui, tmpbuf);
 #if USE_WIENER_REFINEMENT_SEARCH
   int64_t err2;
   int tap_min[] = { WIENER_FILT_TAP0_MINV, WIENER_FILT_TAP1_MINV,
@@ -1366,7 +1385,7 @@ static int64_t finer_tile_search_wiener(const RestSearchCtxt *rsc,
           plane_wiener->hfilter[p] -= s;
           plane_wiener->hfilter[WIENER_WIN - p - 1] -= s;
           plane_wiener->hfilter[WIENER_HALFWIN] += 2 * s;
-          err2 = try_restoration_unit(rsc, limits, tile, rui);
+          err2 = try_restoration_unit(rsc, limits, tile, rui, tmpbuf);
           if (err2 > err) {
             plane_wiener->hfilter[p] += s;
             plane_wiener->hfilter[WIENER_WIN - p - 1] += s;
@@ -1386,7 +1405,7 @@ static int64_t finer_tile_search_wiener(const RestSearchCtxt *rsc,
           plane_wiener->hfilter[p] += s;
           plane_wiener->hfilter[WIENER_WIN - p - 1] += s;
           plane_wiener->hfilter[WIENER_HALFWIN] -= 2 * s;
-          err2 = try_restoration_unit(rsc, limits, tile, rui);
+          err2 = try_restoration_unit(rsc, limits, tile, rui, tmpbuf);
           if (err2 > err) {
             plane_wiener->hfilter[p] -= s;
             plane_wiener->hfilter[WIENER_WIN - p - 1] -= s;
@@ -1407,7 +1426,7 @@ static int64_t finer_tile_search_wiener(const RestSearchCtxt *rsc,
           plane_wiener->vfilter[p] -= s;
           plane_wiener->vfilter[WIENER_WIN - p - 1] -= s;
           plane_wiener->vfilter[WIENER_HALFWIN] += 2 * s;
-          err2 = try_restoration_unit(rsc, limits, tile, rui);
+          err2 = try_restoration_unit(rsc, limits, tile, rui, tmpbuf);
           if (err2 > err) {
             plane_wiener->vfilter[p] += s;
             plane_wiener->vfilter[WIENER_WIN - p - 1] += s;
@@ -1427,7 +1446,7 @@ static int64_t finer_tile_search_wiener(const RestSearchCtxt *rsc,
           plane_wiener->vfilter[p] += s;
           plane_wiener->vfilter[WIENER_WIN - p - 1] += s;
           plane_wiener->vfilter[WIENER_HALFWIN] -= 2 * s;
-          err2 = try_restoration_unit(rsc, limits, tile, rui);
+          err2 = try_restoration_unit(rsc, limits, tile, rui, tmpbuf);
           if (err2 > err) {
             plane_wiener->vfilter[p] -= s;
             plane_wiener->vfilter[WIENER_WIN - p - 1] -= s;
@@ -1452,13 +1471,12 @@ static AOM_INLINE void search_wiener(const RestorationTileLimits *limits,
                                      int rest_unit_idx, void *priv,
                                      int32_t *tmpbuf,
                                      RestorationLineBuffers *rlbs) {
-  (void)tmpbuf;
   (void)rlbs;
-  RestSearchCtxt *rsc = (RestSearchCtxt *)priv;
+  const RestSearchCtxt *rsc = (const RestSearchCtxt *)priv;
   RestUnitSearchInfo *rusi = &rsc->rusi[rest_unit_idx];
 
-  const MACROBLOCK *const x = rsc->x;
-  const int64_t bits_none = x->wiener_restore_cost[0];
+  // A Wiener sse of INT64_MAX means that no Wiener filter is tried.
+  rusi->sse[RESTORE_WIENER] = INT64_MAX;
 
   // Skip Wiener search for low variance contents
   if (rsc->sf->lpf_sf.prune_wiener_based_on_src_var) {
@@ -1476,15 +1494,7 @@ static AOM_INLINE void search_wiener(const RestorationTileLimits *limits,
     // Do not perform Wiener search if source variance is lower than threshold
     // or if the reconstruction error is zero
     int prune_wiener = (src_var < thresh) || (rusi->sse[RESTORE_NONE] == 0);
-    if (prune_wiener) {
-      rsc->bits += bits_none;
-      rsc->sse += rusi->sse[RESTORE_NONE];
-      rusi->best_rtype[RESTORE_WIENER - 1] = RESTORE_NONE;
-      rusi->sse[RESTORE_WIENER] = INT64_MAX;
-      if (rsc->sf->lpf_sf.prune_sgr_based_on_wiener == 2)
-        rusi->skip_sgr_eval = 1;
-      return;
-    }
+    if (prune_wiener) return;
   }
 
   const int wiener_win =
@@ -1519,11 +1529,6 @@ static AOM_INLINE void search_wiener(const RestorationTileLimits *limits,
 #endif
 
   if (!wiener_decompose_sep_sym(reduced_wiener_win, M, H, vfilter, hfilter)) {
-    rsc->bits += bits_none;
-    rsc->sse += rusi->sse[RESTORE_NONE];
-    rusi->best_rtype[RESTORE_WIENER - 1] = RESTORE_NONE;
-    rusi->sse[RESTORE_WIENER] = INT64_MAX;
-    if (rsc->sf->lpf_sf.prune_sgr_based_on_wiener == 2) rusi->skip_sgr_eval = 1;
     return;
   }
 
@@ -1538,18 +1543,13 @@ static AOM_INLINE void search_wiener(const RestorationTileLimits *limits,
   // reduction in the function, the filter is reverted back to identity
   if (compute_score(reduced_wiener_win, M, H, rui.wiener_info.vfilter,
                     rui.wiener_info.hfilter) > 0) {
-    rsc->bits += bits_none;
-    rsc->sse += rusi->sse[RESTORE_NONE];
-    rusi->best_rtype[RESTORE_WIENER - 1] = RESTORE_NONE;
-    rusi->sse[RESTORE_WIENER] = INT64_MAX;
-    if (rsc->sf->lpf_sf.prune_sgr_based_on_wiener == 2) rusi->skip_sgr_eval = 1;
     return;
   }
 
   aom_clear_system_state();
 
   rusi->sse[RESTORE_WIENER] = finer_tile_search_wiener(
-      rsc, limits, tile_rect, &rui, reduced_wiener_win);
+      rsc, limits, tile_rect, &rui, reduced_wiener_win, tmpbuf);
   rusi->wiener = rui.wiener_info;
 
   if (reduced_wiener_win != WIENER_WIN) {
@@ -1558,7 +1558,33 @@ static AOM_INLINE void search_wiener(const RestorationTileLimits *limits,
     assert(rui.wiener_info.hfilter[0] == 0 &&
            rui.wiener_info.hfilter[WIENER_WIN - 1] == 0);
   }
+}
 
+static AOM_INLINE void select_wiener(const RestorationTileLimits *limits,
+                                     const AV1PixelRect *tile_rect,
+                                     int rest_unit_idx, void *priv,
+                                     int32_t *tmpbuf,
+                                     RestorationLineBuffers *rlbs) {
+  (void)limits;
+  (void)tile_rect;
+  (void)tmpbuf;
+  (void)rlbs;
+  RestSearchCtxt *rsc = (RestSearchCtxt *)priv;
+  RestUnitSearchInfo *rusi = &rsc->rusi[rest_unit_idx];
+
+  const MACROBLOCK *const x = rsc->x;
+  const int64_t bits_none = x->wiener_restore_cost[0];
+
+  if (rusi->sse[RESTORE_WIENER] == INT64_MAX) {
+    rsc->bits += bits_none;
+    rsc->sse += rusi->sse[RESTORE_NONE];
+    rusi->best_rtype[RESTORE_WIENER - 1] = RESTORE_NONE;
+    if (rsc->sf->lpf_sf.prune_sgr_based_on_wiener == 2) rusi->skip_sgr_eval = 1;
+    return;
+  }
+
+  const int wiener_win =
+      (rsc->plane == AOM_PLANE_Y) ? WIENER_WIN : WIENER_WIN_CHROMA;
   const int64_t bits_wiener =
       x->wiener_restore_cost[1] +
       (count_wiener_bits(wiener_win, &rusi->wiener, &rsc->wiener)
@@ -1595,17 +1621,29 @@ static AOM_INLINE void search_norestore(const RestorationTileLimits *limits,
   (void)tmpbuf;
   (void)rlbs;
 
-  RestSearchCtxt *rsc = (RestSearchCtxt *)priv;
+  const RestSearchCtxt *rsc = (const RestSearchCtxt *)priv;
   RestUnitSearchInfo *rusi = &rsc->rusi[rest_unit_idx];
 
   const int highbd = rsc->cm->seq_params.use_highbitdepth;
   rusi->sse[RESTORE_NONE] = sse_restoration_unit(
       limits, rsc->src, &rsc->cm->cur_frame->buf, rsc->plane, highbd);
+}
 
-  rsc->sse += rusi->sse[RESTORE_NONE];
+static AOM_INLINE void select_norestore(const RestorationTileLimits *limits,
+                                        const AV1PixelRect *tile_rect,
+                                        int rest_unit_idx, void *priv,
+                                        int32_t *tmpbuf,
+                                        RestorationLineBuffers *rlbs) {
+  (void)limits;
+  (void)tile_rect;
+  (void)tmpbuf;
+  (void)rlbs;
+
+  RestSearchCtxt *rsc = (RestSearchCtxt *)priv;
+  rsc->sse += rsc->rusi[rest_unit_idx].sse[RESTORE_NONE];
 }
 
-static AOM_INLINE void search_switchable(const RestorationTileLimits *limits,
+static AOM_INLINE void select_switchable(const RestorationTileLimits *limits,
                                          const AV1PixelRect *tile_rect,
                                          int rest_unit_idx, void *priv,
                                          int32_t *tmpbuf,
@@ -1680,16 +1718,89 @@ static AOM_INLINE void copy_unit_info(RestorationType frame_rtype,
     rui->sgrproj_info = rusi->sgrproj;
 }
 
-static double search_rest_type(RestSearchCtxt *rsc, RestorationType rtype) {
-  static const rest_unit_visitor_t funs[RESTORE_TYPES] = {
-    search_norestore, search_wiener, search_sgrproj, search_switchable
+static void rst_search_sync_read(void *const sync, int r, int c, int plane) {
+  (void)plane;
+  av1_row_mt_sync_read((AV1RowMTSync *)sync, r, c);
+}
+
+static void rst_search_sync_write(void *const sync, int r, int c,
+                                  const int cols, int plane) {
+  (void)plane;
+  av1_row_mt_sync_write((AV1RowMTSync *)sync, r, c, cols);
+}
+
+void av1_pick_rst_search_row(AV1_COMP *cpi, ThreadData *td, int job) {
+  RestSearchMTInfo *const mt_info = &cpi->rst_search_mt_info;
+  const RestSearchCtxt *const rsc = (const RestSearchCtxt *)mt_info->rsc;
+  const RestorationInfo *const rsi = &rsc->cm->rst_info[rsc->plane];
+  const AV1PixelRect *const tile_rect = &rsc->tile_rect;
+  const int unit_size = rsi->restoration_unit_size;
+  const int unit_rows = mt_info->unit_rows;
+  const int tile_idx = LR_TILE_COL + LR_TILE_ROW * LR_TILE_COLS;
+  const int unit_idx0 = tile_idx * rsi->units_per_tile;
+  const int is_uv = rsc->plane > 0;
+  const int ss_y = is_uv && rsc->cm->seq_params.subsampling_y;
+
+  // Filtering a unit overwrites the rows around its stripes for a while, so
+  // the units next to each other must not be searched at the same time. The
+  // even rows are queued first and do not wait for any row, then the units of
+  // an odd row wait for the units above and below them, as in the loop
+  // restoration of the decoder.
+  const int num_even_rows = (unit_rows + 1) >> 1;
+  const int row =
+      job < num_even_rows ? 2 * job : 2 * (job - num_even_rows) + 1;
+
+  RestorationTileLimits limits;
+  limits.v_start = tile_rect->top + row * unit_size;
+  limits.v_end = row < unit_rows - 1 ? limits.v_start + unit_size
+                                     : tile_rect->bottom;
+  // Offset the tile upwards to align with the restoration processing stripe
+  const int voffset = RESTORATION_UNIT_OFFSET >> ss_y;
+  limits.v_start = AOMMAX(tile_rect->top, limits.v_start - voffset);
+  if (limits.v_end < tile_rect->bottom) limits.v_end -= voffset;
+
+  av1_foreach_rest_unit_in_row(
+      &limits, tile_rect, mt_info->search_unit, row, unit_size, unit_idx0,
+      rsi->horz_units_per_tile, unit_rows, rsc->plane, (void *)rsc,
+      td->rst_tmpbuf, NULL,
+      (row & 1) ? rst_search_sync_read : av1_lr_sync_read_dummy,
+      (row & 1) ? av1_lr_sync_write_dummy : rst_search_sync_write,
+      &mt_info->row_mt_sync);
+}
+
+static double search_rest_type(AV1_COMP *cpi, RestSearchCtxt *rsc,
+                               RestorationType rtype) {
+  // Each unit is searched on its own, and then the type of each unit is
+  // selected in raster order, as the cost of the coefficients of a unit
+  // depends on those selected for the unit before it.
+  static const rest_unit_visitor_t search_funs[RESTORE_TYPES] = {
+    search_norestore, search_wiener, search_sgrproj, NULL
+  };
+  static const rest_unit_visitor_t select_funs[RESTORE_TYPES] = {
+    select_norestore, select_wiener, select_sgrproj, select_switchable
   };
+  const AV1_COMMON *const cm = rsc->cm;
+
+  const int unit_rows = cm->rst_info[rsc->plane].vert_units_per_tile;
+
+  if (search_funs[rtype] != NULL) {
+    if (cpi->oxcf.max_threads > 1 && unit_rows > 1) {
+      RestSearchMTInfo *const mt_info = &cpi->rst_search_mt_info;
+      mt_info->rsc = rsc;
+      mt_info->search_unit = search_funs[rtype];
+      mt_info->unit_rows = unit_rows;
+      av1_pick_rst_search_mt(cpi);
+    } else {
+      av1_foreach_rest_unit_in_plane(cm, rsc->plane, search_funs[rtype], rsc,
+                                     &rsc->tile_rect, cm->rst_tmpbuf, NULL);
+    }
+  }
 
   reset_rsc(rsc);
   rsc_on_tile(rsc);
 
-  av1_foreach_rest_unit_in_plane(rsc->cm, rsc->plane, funs[rtype], rsc,
-                                 &rsc->tile_rect, rsc->cm->rst_tmpbuf, NULL);
+  av1_foreach_rest_unit_in_plane(cm, rsc->plane, select_funs[rtype], rsc,
+                                 &rsc->tile_rect, cm->rst_tmpbuf, NULL);
   return RDCOST_DBL(rsc->x->rdmult, rsc->bits >> 4, rsc->sse);
 }
 
@@ -1744,7 +1855,7 @@ void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *src, AV1_COMP *cpi) {
             (r != force_restore_type))
           continue;
 
-        double cost = search_rest_type(&rsc, r);
+        double cost = search_rest_type(cpi, &rsc, r);
 
         if (r == 0 || cost < best_cost) {
           best_cost = cost;
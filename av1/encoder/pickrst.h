@@ -59,6 +59,10 @@ static INLINE uint16_t find_average_highbd(const uint16_t *src, int h_start,
 
 void av1_pick_filter_restoration(const YV12_BUFFER_CONFIG *sd, AV1_COMP *cpi);
 
+// Searches the restoration units of the given job, a row of units of the plane
+// of cpi->rst_search_mt_info, with the scratch buffer of 'td'.
+void av1_pick_rst_search_row(AV1_COMP *cpi, ThreadData *td, int job);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -21,6 +21,7 @@
 #include "av1/common/reconinter.h"
 #include "av1/encoder/av1_quantize.h"
 #include "av1/encoder/encoder.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/extend.h"
 #include "av1/encoder/firstpass.h"
 #include "av1/encoder/mcomp.h"
@@ -46,6 +47,7 @@
 // also do motion search for each 1/4 sub-block to get more precise prediction.
 // Inputs:
 //   cpi: Pointer to the composed information of input video.
+//   mb: Pointer to the macroblock of the thread doing the search.
 //   frame_to_filter: Pointer to the frame to be filtered.
 //   ref_frame: Pointer to the reference frame.
 //   block_size: Block size used for motion search.
@@ -57,7 +59,7 @@
 //   subblock_mses: Pointer to the search errors (MSE) for 4 sub-blocks.
 // Returns:
 //   Search error (MSE) of the entire block.
-static int tf_motion_search(AV1_COMP *cpi,
+static int tf_motion_search(AV1_COMP *cpi, MACROBLOCK *mb,
                             const YV12_BUFFER_CONFIG *frame_to_filter,
                             const YV12_BUFFER_CONFIG *ref_frame,
                             const BLOCK_SIZE block_size, const int mb_row,
@@ -75,7 +77,6 @@ static int tf_motion_search(AV1_COMP *cpi,
   const int y_offset = mb_row * mb_height * y_stride + mb_col * mb_width;
 
   // Save input state.
-  MACROBLOCK *const mb = &cpi->td.mb;
   MACROBLOCKD *const mbd = &mb->e_mbd;
   const struct buf_2d ori_src_buf = mb->plane[0].src;
   const struct buf_2d ori_pre_buf = mbd->plane[0].pre[0];
@@ -905,10 +906,159 @@ static INLINE int get_num_blocks(const int frame_length, const int mb_length) {
   return (frame_length + mb_length - 1) / mb_length;
 }
 
-typedef struct {
-  int64_t sum;
-  int64_t sse;
-} FRAME_DIFF;
+void av1_tf_alloc_data(AV1_COMP *cpi, TemporalFilterData *tf_data) {
+  AV1_COMMON *const cm = &cpi->common;
+  const BLOCK_SIZE block_size = cpi->tf_ctx.block_size;
+  const int num_planes = av1_num_planes(cm);
+  const int mb_pels = block_size_high[block_size] * block_size_wide[block_size];
+
+  // A temporary block info used to store state in temporal filtering process.
+  CHECK_MEM_ERROR(cm, tf_data->tmp_mbmi,
+                  (MB_MODE_INFO *)aom_calloc(1, sizeof(*tf_data->tmp_mbmi)));
+  tf_data->tmp_mbmi->motion_mode = SIMPLE_TRANSLATION;
+  // Allocate memory for predictor, accumulator and count.
+  CHECK_MEM_ERROR(cm, tf_data->pred8,
+                  aom_memalign(32, num_planes * mb_pels * sizeof(uint8_t)));
+  CHECK_MEM_ERROR(cm, tf_data->pred16,
+                  aom_memalign(32, num_planes * mb_pels * sizeof(uint16_t)));
+  CHECK_MEM_ERROR(cm, tf_data->accum,
+                  aom_memalign(16, num_planes * mb_pels * sizeof(uint32_t)));
+  CHECK_MEM_ERROR(cm, tf_data->count,
+                  aom_memalign(16, num_planes * mb_pels * sizeof(uint16_t)));
+  memset(tf_data->pred8, 0, num_planes * mb_pels * sizeof(uint8_t));
+  memset(tf_data->pred16, 0, num_planes * mb_pels * sizeof(uint16_t));
+  tf_data->diff.sum = 0;
+  tf_data->diff.sse = 0;
+}
+
+void av1_tf_dealloc_data(TemporalFilterData *tf_data) {
+  aom_free(tf_data->tmp_mbmi);
+  aom_free(tf_data->pred8);
+  aom_free(tf_data->pred16);
+  aom_free(tf_data->accum);
+  aom_free(tf_data->count);
+  tf_data->tmp_mbmi = NULL;
+  tf_data->pred8 = NULL;
+  tf_data->pred16 = NULL;
+  tf_data->accum = NULL;
+  tf_data->count = NULL;
+}
+
+void av1_tf_do_filtering_row(AV1_COMP *cpi, ThreadData *td, int mb_row) {
+  // Basic information.
+  const TemporalFilterCtx *const tf_ctx = &cpi->tf_ctx;
+  YV12_BUFFER_CONFIG **const frames = tf_ctx->frames;
+  const int num_frames = tf_ctx->num_frames;
+  const int filter_frame_idx = tf_ctx->filter_frame_idx;
+  const BLOCK_SIZE block_size = tf_ctx->block_size;
+  const struct scale_factors *const scale = tf_ctx->scale;
+  const YV12_BUFFER_CONFIG *const frame_to_filter = frames[filter_frame_idx];
+  const int frame_height = frame_to_filter->y_crop_height;
+  const int frame_width = frame_to_filter->y_crop_width;
+  const int mb_height = block_size_high[block_size];
+  const int mb_width = block_size_wide[block_size];
+  const int mb_pels = mb_height * mb_width;
+  const int num_planes = av1_num_planes(&cpi->common);
+  const int mi_h = mi_size_high_log2[block_size];
+  const int mi_w = mi_size_wide_log2[block_size];
+  assert(num_planes >= 1 && num_planes <= MAX_MB_PLANE);
+  const int is_high_bitdepth = is_frame_high_bitdepth(frame_to_filter);
+
+  MACROBLOCK *const mb = &td->mb;
+  MACROBLOCKD *const mbd = &mb->e_mbd;
+  TemporalFilterData *const tf_data = &td->tf_data;
+  uint32_t *const accum = tf_data->accum;
+  uint16_t *const count = tf_data->count;
+  uint8_t *const pred = is_high_bitdepth ? CONVERT_TO_BYTEPTR(tf_data->pred16)
+                                         : tf_data->pred8;
+  mbd->mi = &tf_data->tmp_mbmi;
+
+  av1_set_mv_row_limits(&cpi->common.mi_params, &mb->mv_limits,
+                        (mb_row << mi_h), (mb_height >> MI_SIZE_LOG2),
+                        cpi->oxcf.border_in_pixels);
+  for (int mb_col = 0; mb_col < tf_ctx->mb_cols; mb_col++) {
+    av1_set_mv_col_limits(&cpi->common.mi_params, &mb->mv_limits,
+                          (mb_col << mi_w), (mb_width >> MI_SIZE_LOG2),
+                          cpi->oxcf.border_in_pixels);
+    memset(accum, 0, num_planes * mb_pels * sizeof(accum[0]));
+    memset(count, 0, num_planes * mb_pels * sizeof(count[0]));
+    MV ref_mv = kZeroMv;  // Reference motion vector passed down along frames.
+    // Perform temporal filtering frame by frame.
+    for (int frame = 0; frame < num_frames; frame++) {
+      if (frames[frame] == NULL) continue;
+
+      // Motion search.
+      MV subblock_mvs[4] = { kZeroMv, kZeroMv, kZeroMv, kZeroMv };
+      int subblock_filter_weights[4] = { 0, 0, 0, 0 };
+      int block_mse = INT_MAX;
+      int subblock_mses[4] = { INT_MAX, INT_MAX, INT_MAX, INT_MAX };
+
+      if (frame == filter_frame_idx) {  // Frame to be filtered.
+        // Set motion vector as 0 for the frame to be filtered.
+        mbd->mi[0]->mv[0].as_mv = kZeroMv;
+        // Change ref_mv sign for following frames.
+        ref_mv.row *= -1;
+        ref_mv.col *= -1;
+      } else {  // Other reference frames.
+        block_mse = tf_motion_search(cpi, mb, frame_to_filter, frames[frame],
+                                     block_size, mb_row, mb_col, &ref_mv,
+                                     subblock_mvs, subblock_mses);
+        // Do not pass down the reference motion vector if error is too large.
+        const int thresh = AOMMIN(frame_height, frame_width) >= 720 ? 12 : 3;
+        if (block_mse > (thresh << (mbd->bd - 8))) {
+          ref_mv = kZeroMv;
+        }
+      }
+
+      // Build predictor.
+      int use_subblock = tf_get_filter_weight(block_mse, subblock_mses,
+                                              tf_ctx->is_second_arf,
+                                              subblock_filter_weights);
+      tf_build_predictor(frames[frame], mbd, block_size, mb_row, mb_col,
+                         num_planes, scale, use_subblock, subblock_mvs, pred);
+
+      // Perform weighted averaging.
+      if (frame == filter_frame_idx) {  // Frame to be filtered.
+        av1_apply_temporal_filter_self(mbd, block_size, num_planes,
+                                       subblock_filter_weights[0], pred, accum,
+                                       count);
+      } else {  // Other reference frames.
+        const FRAME_TYPE frame_type =
+            (cpi->common.current_frame.frame_number > 1) ? INTER_FRAME
+                                                         : KEY_FRAME;
+        const int q_factor =
+            (int)av1_convert_qindex_to_q(cpi->rc.avg_frame_qindex[frame_type],
+                                         cpi->common.seq_params.bit_depth);
+        av1_apply_temporal_filter_others(
+            frame_to_filter, mbd, block_size, mb_row, mb_col, num_planes,
+            tf_ctx->strength, use_subblock, subblock_filter_weights,
+            tf_ctx->noise_levels, block_mse, subblock_mses, q_factor, pred,
+            accum, count);
+      }
+    }
+
+    tf_normalize_filtered_frame(mbd, block_size, mb_row, mb_col, num_planes,
+                                accum, count, &cpi->alt_ref_buffer);
+
+    if (!tf_ctx->is_key_frame && cpi->sf.hl_sf.adaptive_overlay_encoding) {
+      const int y_height = mb_height >> mbd->plane[0].subsampling_y;
+      const int y_width = mb_width >> mbd->plane[0].subsampling_x;
+      const int source_y_stride = frame_to_filter->y_stride;
+      const int filter_y_stride = cpi->alt_ref_buffer.y_stride;
+      const int source_offset =
+          mb_row * y_height * source_y_stride + mb_col * y_width;
+      const int filter_offset =
+          mb_row * y_height * filter_y_stride + mb_col * y_width;
+      unsigned int sse = 0;
+      cpi->fn_ptr[block_size].vf(frame_to_filter->y_buffer + source_offset,
+                                 source_y_stride,
+                                 cpi->alt_ref_buffer.y_buffer + filter_offset,
+                                 filter_y_stride, &sse);
+      tf_data->diff.sum += sse;
+      tf_data->diff.sse += sse * sse;
+    }
+  }
+}
 
 // Does temporal filter for a particular frame.
 // Inputs:
@@ -931,20 +1081,22 @@ static FRAME_DIFF tf_do_filtering(
     const int filter_frame_idx, const int is_key_frame, const int is_second_arf,
     const BLOCK_SIZE block_size, const struct scale_factors *scale,
     const int strength, const double *noise_levels) {
-  // Basic information.
   const YV12_BUFFER_CONFIG *const frame_to_filter = frames[filter_frame_idx];
-  const int frame_height = frame_to_filter->y_crop_height;
-  const int frame_width = frame_to_filter->y_crop_width;
-  const int mb_height = block_size_high[block_size];
-  const int mb_width = block_size_wide[block_size];
-  const int mb_pels = mb_height * mb_width;
-  const int mb_rows = get_num_blocks(frame_height, mb_height);
-  const int mb_cols = get_num_blocks(frame_width, mb_width);
   const int num_planes = av1_num_planes(&cpi->common);
-  const int mi_h = mi_size_high_log2[block_size];
-  const int mi_w = mi_size_wide_log2[block_size];
-  assert(num_planes >= 1 && num_planes <= MAX_MB_PLANE);
-  const int is_high_bitdepth = is_frame_high_bitdepth(frame_to_filter);
+  TemporalFilterCtx *const tf_ctx = &cpi->tf_ctx;
+  tf_ctx->frames = frames;
+  tf_ctx->num_frames = num_frames;
+  tf_ctx->filter_frame_idx = filter_frame_idx;
+  tf_ctx->is_key_frame = is_key_frame;
+  tf_ctx->is_second_arf = is_second_arf;
+  tf_ctx->block_size = block_size;
+  tf_ctx->scale = scale;
+  tf_ctx->strength = strength;
+  tf_ctx->noise_levels = noise_levels;
+  tf_ctx->mb_rows = get_num_blocks(frame_to_filter->y_crop_height,
+                                   block_size_high[block_size]);
+  tf_ctx->mb_cols = get_num_blocks(frame_to_filter->y_crop_width,
+                                   block_size_wide[block_size]);
 
   // Save input state.
   MACROBLOCK *const mb = &cpi->td.mb;
@@ -958,108 +1110,17 @@ static FRAME_DIFF tf_do_filtering(
   // Setup.
   mbd->block_ref_scale_factors[0] = scale;
   mbd->block_ref_scale_factors[1] = scale;
-  // A temporary block info used to store state in temporal filtering process.
-  MB_MODE_INFO *tmp_mb_mode_info = (MB_MODE_INFO *)malloc(sizeof(MB_MODE_INFO));
-  memset(tmp_mb_mode_info, 0, sizeof(MB_MODE_INFO));
-  mbd->mi = &tmp_mb_mode_info;
-  mbd->mi[0]->motion_mode = SIMPLE_TRANSLATION;
-  // Allocate memory for predictor, accumulator and count.
-  uint8_t *pred8 = aom_memalign(32, num_planes * mb_pels * sizeof(uint8_t));
-  uint16_t *pred16 = aom_memalign(32, num_planes * mb_pels * sizeof(uint16_t));
-  uint32_t *accum = aom_memalign(16, num_planes * mb_pels * sizeof(uint32_t));
-  uint16_t *count = aom_memalign(16, num_planes * mb_pels * sizeof(uint16_t));
-  memset(pred8, 0, num_planes * mb_pels * sizeof(pred8[0]));
-  memset(pred16, 0, num_planes * mb_pels * sizeof(pred16[0]));
-  uint8_t *const pred = is_high_bitdepth ? CONVERT_TO_BYTEPTR(pred16) : pred8;
+  av1_tf_alloc_data(cpi, &cpi->td.tf_data);
 
-  // Do filtering.
-  FRAME_DIFF diff = { 0, 0 };
   // Perform temporal filtering block by block.
-  for (int mb_row = 0; mb_row < mb_rows; mb_row++) {
-    av1_set_mv_row_limits(&cpi->common.mi_params, &mb->mv_limits,
-                          (mb_row << mi_h), (mb_height >> MI_SIZE_LOG2),
-                          cpi->oxcf.border_in_pixels);
-    for (int mb_col = 0; mb_col < mb_cols; mb_col++) {
-      av1_set_mv_col_limits(&cpi->common.mi_params, &mb->mv_limits,
-                            (mb_col << mi_w), (mb_width >> MI_SIZE_LOG2),
-                            cpi->oxcf.border_in_pixels);
-      memset(accum, 0, num_planes * mb_pels * sizeof(accum[0]));
-      memset(count, 0, num_planes * mb_pels * sizeof(count[0]));
-      MV ref_mv = kZeroMv;  // Reference motion vector passed down along frames.
-      // Perform temporal filtering frame by frame.
-      for (int frame = 0; frame < num_frames; frame++) {
-        if (frames[frame] == NULL) continue;
-
-        // Motion search.
-        MV subblock_mvs[4] = { kZeroMv, kZeroMv, kZeroMv, kZeroMv };
-        int subblock_filter_weights[4] = { 0, 0, 0, 0 };
-        int block_mse = INT_MAX;
-        int subblock_mses[4] = { INT_MAX, INT_MAX, INT_MAX, INT_MAX };
-
-        if (frame == filter_frame_idx) {  // Frame to be filtered.
-          // Set motion vector as 0 for the frame to be filtered.
-          mbd->mi[0]->mv[0].as_mv = kZeroMv;
-          // Change ref_mv sign for following frames.
-          ref_mv.row *= -1;
-          ref_mv.col *= -1;
-        } else {  // Other reference frames.
-          block_mse = tf_motion_search(cpi, frame_to_filter, frames[frame],
-                                       block_size, mb_row, mb_col, &ref_mv,
-                                       subblock_mvs, subblock_mses);
-          // Do not pass down the reference motion vector if error is too large.
-          const int thresh = AOMMIN(frame_height, frame_width) >= 720 ? 12 : 3;
-          if (block_mse > (thresh << (mbd->bd - 8))) {
-            ref_mv = kZeroMv;
-          }
-        }
-
-        // Build predictor.
-        int use_subblock = tf_get_filter_weight(
-            block_mse, subblock_mses, is_second_arf, subblock_filter_weights);
-        tf_build_predictor(frames[frame], mbd, block_size, mb_row, mb_col,
-                           num_planes, scale, use_subblock, subblock_mvs, pred);
-
-        // Perform weighted averaging.
-        if (frame == filter_frame_idx) {  // Frame to be filtered.
-          av1_apply_temporal_filter_self(mbd, block_size, num_planes,
-                                         subblock_filter_weights[0], pred,
-                                         accum, count);
-        } else {  // Other reference frames.
-          const FRAME_TYPE frame_type =
-              (cpi->common.current_frame.frame_number > 1) ? INTER_FRAME
-                                                           : KEY_FRAME;
-          const int q_factor =
-              (int)av1_convert_qindex_to_q(cpi->rc.avg_frame_qindex[frame_type],
-                                           cpi->common.seq_params.bit_depth);
-          av1_apply_temporal_filter_others(
-              frame_to_filter, mbd, block_size, mb_row, mb_col, num_planes,
-              strength, use_subblock, subblock_filter_weights, noise_levels,
-              block_mse, subblock_mses, q_factor, pred, accum, count);
-        }
-      }
-
-      tf_normalize_filtered_frame(mbd, block_size, mb_row, mb_col, num_planes,
-                                  accum, count, &cpi->alt_ref_buffer);
-
-      if (!is_key_frame && cpi->sf.hl_sf.adaptive_overlay_encoding) {
-        const int y_height = mb_height >> mbd->plane[0].subsampling_y;
-        const int y_width = mb_width >> mbd->plane[0].subsampling_x;
-        const int source_y_stride = frame_to_filter->y_stride;
-        const int filter_y_stride = cpi->alt_ref_buffer.y_stride;
-        const int source_offset =
-            mb_row * y_height * source_y_stride + mb_col * y_width;
-        const int filter_offset =
-            mb_row * y_height * filter_y_stride + mb_col * y_width;
-        unsigned int sse = 0;
-        cpi->fn_ptr[block_size].vf(frame_to_filter->y_buffer + source_offset,
-                                   source_y_stride,
-                                   cpi->alt_ref_buffer.y_buffer + filter_offset,
-                                   filter_y_stride, &sse);
-        diff.sum += sse;
-        diff.sse += sse * sse;
-      }
+  if (cpi->oxcf.max_threads > 1) {
+    av1_tf_do_filtering_mt(cpi);
+  } else {
+    for (int mb_row = 0; mb_row < tf_ctx->mb_rows; mb_row++) {
+      av1_tf_do_filtering_row(cpi, &cpi->td, mb_row);
     }
   }
+  const FRAME_DIFF diff = cpi->td.tf_data.diff;
 
   // Restore input state
   for (int i = 0; i < num_planes; i++) {
@@ -1067,11 +1128,7 @@ static FRAME_DIFF tf_do_filtering(
   }
   mbd->mi = input_mb_mode_info;
 
-  free(tmp_mb_mode_info);
-  aom_free(pred8);
-  aom_free(pred16);
-  aom_free(accum);
-  aom_free(count);
+  av1_tf_dealloc_data(&cpi->td.tf_data);
 
   return diff;
 }
@@ -80,6 +80,15 @@ double av1_estimate_noise_from_single_plane(const YV12_BUFFER_CONFIG *frame,
 int av1_temporal_filter(AV1_COMP *cpi, const int filter_frame_lookahead_idx,
                         int *show_existing_arf);
 
+// Allocates the buffers of a thread filtering the frame of cpi->tf_ctx.
+void av1_tf_alloc_data(AV1_COMP *cpi, TemporalFilterData *tf_data);
+
+void av1_tf_dealloc_data(TemporalFilterData *tf_data);
+
+// Filters one block row of the frame of cpi->tf_ctx with the macroblock and
+// the buffers of 'td'. The rows are independent of each other.
+void av1_tf_do_filtering_row(AV1_COMP *cpi, ThreadData *td, int mb_row);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -26,6 +26,7 @@
 
 #include "av1/encoder/encoder.h"
 #include "av1/encoder/encode_strategy.h"
+#include "av1/encoder/ethread.h"
 #include "av1/encoder/hybrid_fwd_txfm.h"
 #include "av1/encoder/rdopt.h"
 #include "av1/encoder/reconinter_enc.h"
@@ -186,16 +187,22 @@ static int is_alike_mv(int_mv candidate_mv, int_mv *center_mvs,
   return 0;
 }
 
-static AOM_INLINE void mode_estimation(
-    AV1_COMP *cpi, MACROBLOCK *x, MACROBLOCKD *xd, struct scale_factors *sf,
-    int frame_idx, int mi_row, int mi_col, BLOCK_SIZE bsize, TX_SIZE tx_size,
-    const YV12_BUFFER_CONFIG *ref_frame[],
-    const YV12_BUFFER_CONFIG *src_ref_frame[], TplDepStats *tpl_stats) {
+static AOM_INLINE void mode_estimation(AV1_COMP *cpi, MACROBLOCK *x,
+                                       MACROBLOCKD *xd,
+                                       const TplDispenserFrame *frame,
+                                       int mi_row, int mi_col, BLOCK_SIZE bsize,
+                                       TX_SIZE tx_size,
+                                       TplDepStats *tpl_stats) {
   AV1_COMMON *cm = &cpi->common;
   const GF_GROUP *gf_group = &cpi->gf_group;
 
   (void)gf_group;
 
+  const int frame_idx = frame->frame_idx;
+  const struct scale_factors *sf = &frame->sf;
+  const YV12_BUFFER_CONFIG *const *ref_frame = frame->ref_frame;
+  const YV12_BUFFER_CONFIG *const *src_ref_frame = frame->src_frame;
+  CommonModeInfoParams *const mi_params = frame->mi_params;
   TplParams *tpl_data = &cpi->tpl_data;
   TplDepFrame *tpl_frame = &tpl_data->tpl_frame[frame_idx];
   const uint8_t block_mis_log2 = tpl_data->tpl_stats_block_mis_log2;
@@ -233,10 +240,9 @@ static AOM_INLINE void mode_estimation(
 
   const int mi_width = mi_size_wide[bsize];
   const int mi_height = mi_size_high[bsize];
-  set_mode_info_offsets(&cpi->common.mi_params, &cpi->mbmi_ext_info, x, xd,
-                        mi_row, mi_col);
+  set_mode_info_offsets(mi_params, &cpi->mbmi_ext_info, x, xd, mi_row, mi_col);
   set_mi_row_col(xd, &xd->tile, mi_row, mi_height, mi_col, mi_width,
-                 cm->mi_params.mi_rows, cm->mi_params.mi_cols);
+                 mi_params->mi_rows, mi_params->mi_cols);
   set_plane_n4(xd, mi_size_wide[bsize], mi_size_high[bsize],
                av1_num_planes(cm));
   xd->mi[0]->sb_type = bsize;
@@ -456,7 +462,7 @@ static AOM_INLINE void mode_estimation(
     for (int idx = 0; idx < mi_width; ++idx) {
       if ((xd->mb_to_right_edge >> (3 + MI_SIZE_LOG2)) + mi_width > idx &&
           (xd->mb_to_bottom_edge >> (3 + MI_SIZE_LOG2)) + mi_height > idy) {
-        xd->mi[idx + idy * cm->mi_params.mi_stride] = xd->mi[0];
+        xd->mi[idx + idy * mi_params->mi_stride] = xd->mi[0];
       }
     }
   }
@@ -665,52 +671,34 @@ static AOM_INLINE void tpl_model_store(TplDepStats *tpl_stats_ptr, int mi_row,
   }
 }
 
-static AOM_INLINE void mc_flow_dispenser(AV1_COMP *cpi, int frame_idx,
-                                         int pframe_qindex) {
-  const GF_GROUP *gf_group = &cpi->gf_group;
-  if (frame_idx == gf_group->size) return;
+// Sets up the scale factors and the reference frames of a frame to process.
+static AOM_INLINE void init_dispenser_frame(AV1_COMP *cpi, int frame_idx,
+                                            TplDispenserFrame *frame) {
   TplParams *const tpl_data = &cpi->tpl_data;
   TplDepFrame *tpl_frame = &tpl_data->tpl_frame[frame_idx];
   const YV12_BUFFER_CONFIG *this_frame = tpl_frame->gf_picture;
-  const YV12_BUFFER_CONFIG *ref_frame[7] = { NULL, NULL, NULL, NULL,
-                                             NULL, NULL, NULL };
   const YV12_BUFFER_CONFIG *ref_frames_ordered[INTER_REFS_PER_FRAME];
   int ref_frame_flags;
-  const YV12_BUFFER_CONFIG *src_frame[7] = { NULL, NULL, NULL, NULL,
-                                             NULL, NULL, NULL };
-
-  AV1_COMMON *cm = &cpi->common;
-  const CommonModeInfoParams *const mi_params = &cm->mi_params;
-  struct scale_factors sf;
-  int rdmult, idx;
-  ThreadData *td = &cpi->td;
-  MACROBLOCK *x = &td->mb;
-  MACROBLOCKD *xd = &x->e_mbd;
-  int mi_row, mi_col;
-  const BLOCK_SIZE bsize = convert_length_to_bsize(MC_FLOW_BSIZE_1D);
-  av1_tile_init(&xd->tile, cm, 0, 0);
+  int idx;
 
-  const TX_SIZE tx_size = max_txsize_lookup[bsize];
-  const int mi_height = mi_size_high[bsize];
-  const int mi_width = mi_size_wide[bsize];
+  frame->frame_idx = frame_idx;
+  frame->mi_params = &cpi->common.mi_params;
 
   // Setup scaling factor
   av1_setup_scale_factors_for_frame(
-      &sf, this_frame->y_crop_width, this_frame->y_crop_height,
+      &frame->sf, this_frame->y_crop_width, this_frame->y_crop_height,
       this_frame->y_crop_width, this_frame->y_crop_height);
 
-  xd->cur_buf = this_frame;
-
   for (idx = 0; idx < INTER_REFS_PER_FRAME; ++idx) {
-    ref_frame[idx] =
+    frame->ref_frame[idx] =
         tpl_data->tpl_frame[tpl_frame->ref_map_index[idx]].rec_picture;
-    src_frame[idx] =
+    frame->src_frame[idx] =
         tpl_data->tpl_frame[tpl_frame->ref_map_index[idx]].gf_picture;
   }
 
   // Store the reference frames based on priority order
   for (int i = 0; i < INTER_REFS_PER_FRAME; ++i) {
-    ref_frames_ordered[i] = ref_frame[ref_frame_priority_order[i] - 1];
+    ref_frames_ordered[i] = frame->ref_frame[ref_frame_priority_order[i] - 1];
   }
 
   // Work out which reference frame slots may be used.
@@ -722,9 +710,95 @@ static AOM_INLINE void mc_flow_dispenser(AV1_COMP *cpi, int frame_idx,
   // Prune reference frames
   for (idx = 0; idx < INTER_REFS_PER_FRAME; ++idx) {
     if ((ref_frame_flags & (1 << idx)) == 0) {
-      ref_frame[idx] = NULL;
+      frame->ref_frame[idx] = NULL;
     }
   }
+}
+
+// Returns 1 if 'frame' may be processed at the same time as the given frames,
+// i.e. if none of the frames uses the reconstruction of another one.
+static int is_independent_frame(const TplParams *const tpl_data,
+                                const TplDispenserFrame *frames, int num_frames,
+                                const TplDispenserFrame *frame) {
+  const YV12_BUFFER_CONFIG *const rec =
+      tpl_data->tpl_frame[frame->frame_idx].rec_picture;
+  for (int i = 0; i < num_frames; ++i) {
+    const YV12_BUFFER_CONFIG *const other_rec =
+        tpl_data->tpl_frame[frames[i].frame_idx].rec_picture;
+    if (rec == other_rec) return 0;
+    for (int idx = 0; idx < INTER_REFS_PER_FRAME; ++idx) {
+      if (frame->ref_frame[idx] == other_rec || frames[i].ref_frame[idx] == rec)
+        return 0;
+    }
+  }
+  return 1;
+}
+
+void av1_mc_flow_dispenser_row(AV1_COMP *cpi, MACROBLOCK *x,
+                               TplDispenserFrame *frame, int mi_row) {
+  AV1_COMMON *cm = &cpi->common;
+  const CommonModeInfoParams *const mi_params = &cm->mi_params;
+  TplMultiThreadInfo *const tpl_mt_info = &cpi->tpl_mt_info;
+  TplParams *const tpl_data = &cpi->tpl_data;
+  TplDepFrame *tpl_frame = &tpl_data->tpl_frame[frame->frame_idx];
+  MACROBLOCKD *xd = &x->e_mbd;
+  const BLOCK_SIZE bsize = convert_length_to_bsize(MC_FLOW_BSIZE_1D);
+  const TX_SIZE tx_size = max_txsize_lookup[bsize];
+  const int mi_height = mi_size_high[bsize];
+  const int mi_width = mi_size_wide[bsize];
+  const int block_row = mi_row / mi_height;
+  const int num_block_cols = (mi_params->mi_cols + mi_width - 1) / mi_width;
+
+  xd->cur_buf = tpl_frame->gf_picture;
+  xd->block_ref_scale_factors[0] = &frame->sf;
+
+  // Motion estimation row boundary
+  av1_set_mv_row_limits(mi_params, &x->mv_limits, mi_row, mi_height,
+                        cpi->oxcf.border_in_pixels);
+  xd->mb_to_top_edge = -GET_MV_SUBPEL(mi_row * MI_SIZE);
+  xd->mb_to_bottom_edge =
+      GET_MV_SUBPEL((mi_params->mi_rows - mi_height - mi_row) * MI_SIZE);
+  for (int mi_col = 0; mi_col < mi_params->mi_cols; mi_col += mi_width) {
+    const int block_col = mi_col / mi_width;
+    TplDepStats tpl_stats;
+
+    // The search of the block uses the stats and the reconstruction of the
+    // blocks above and above-right.
+    (*tpl_mt_info->sync_read_ptr)(&frame->row_mt_sync, block_row, block_col);
+
+    // Motion estimation column boundary
+    av1_set_mv_col_limits(mi_params, &x->mv_limits, mi_col, mi_width,
+                          cpi->oxcf.border_in_pixels);
+    xd->mb_to_left_edge = -GET_MV_SUBPEL(mi_col * MI_SIZE);
+    xd->mb_to_right_edge =
+        GET_MV_SUBPEL(mi_params->mi_cols - mi_width - mi_col);
+    mode_estimation(cpi, x, xd, frame, mi_row, mi_col, bsize, tx_size,
+                    &tpl_stats);
+
+    // Motion flow dependency dispenser.
+    tpl_model_store(tpl_frame->tpl_stats_ptr, mi_row, mi_col, bsize,
+                    tpl_frame->stride, &tpl_stats,
+                    tpl_data->tpl_stats_block_mis_log2);
+
+    (*tpl_mt_info->sync_write_ptr)(&frame->row_mt_sync, block_row, block_col,
+                                   num_block_cols);
+  }
+}
+
+// Computes the tpl stats of the frames of cpi->tpl_mt_info.
+static AOM_INLINE void mc_flow_dispenser(AV1_COMP *cpi, int pframe_qindex) {
+  TplParams *const tpl_data = &cpi->tpl_data;
+  TplMultiThreadInfo *const tpl_mt_info = &cpi->tpl_mt_info;
+  AV1_COMMON *cm = &cpi->common;
+  const CommonModeInfoParams *const mi_params = &cm->mi_params;
+  int rdmult;
+  ThreadData *td = &cpi->td;
+  MACROBLOCK *x = &td->mb;
+  MACROBLOCKD *xd = &x->e_mbd;
+  const BLOCK_SIZE bsize = convert_length_to_bsize(MC_FLOW_BSIZE_1D);
+  av1_tile_init(&xd->tile, cm, 0, 0);
+
+  const int mi_height = mi_size_high[bsize];
 
   // Make a temporary mbmi for tpl model
   MB_MODE_INFO mbmi;
@@ -732,8 +806,6 @@ static AOM_INLINE void mc_flow_dispenser(AV1_COMP *cpi, int frame_idx,
   MB_MODE_INFO *mbmi_ptr = &mbmi;
   xd->mi = &mbmi_ptr;
 
-  xd->block_ref_scale_factors[0] = &sf;
-
   const int base_qindex = pframe_qindex;
   // Get rd multiplier set up.
   rdmult = (int)av1_compute_rd_mult(cpi, base_qindex);
@@ -741,37 +813,26 @@ static AOM_INLINE void mc_flow_dispenser(AV1_COMP *cpi, int frame_idx,
   set_error_per_bit(x, rdmult);
   av1_initialize_me_consts(cpi, x, base_qindex);
 
-  tpl_frame->is_valid = 1;
-
   cm->quant_params.base_qindex = base_qindex;
   av1_frame_init_quantizer(cpi);
 
-  tpl_frame->base_rdmult =
-      av1_compute_rd_mult_based_on_qindex(cpi, pframe_qindex) / 6;
+  for (int i = 0; i < tpl_mt_info->num_frames; ++i) {
+    TplDepFrame *tpl_frame =
+        &tpl_data->tpl_frame[tpl_mt_info->frames[i].frame_idx];
+    tpl_frame->is_valid = 1;
+    tpl_frame->base_rdmult =
+        av1_compute_rd_mult_based_on_qindex(cpi, pframe_qindex) / 6;
+  }
 
-  for (mi_row = 0; mi_row < mi_params->mi_rows; mi_row += mi_height) {
-    // Motion estimation row boundary
-    av1_set_mv_row_limits(mi_params, &x->mv_limits, mi_row, mi_height,
-                          cpi->oxcf.border_in_pixels);
-    xd->mb_to_top_edge = -GET_MV_SUBPEL(mi_row * MI_SIZE);
-    xd->mb_to_bottom_edge =
-        GET_MV_SUBPEL((mi_params->mi_rows - mi_height - mi_row) * MI_SIZE);
-    for (mi_col = 0; mi_col < mi_params->mi_cols; mi_col += mi_width) {
-      TplDepStats tpl_stats;
-
-      // Motion estimation column boundary
-      av1_set_mv_col_limits(mi_params, &x->mv_limits, mi_col, mi_width,
-                            cpi->oxcf.border_in_pixels);
-      xd->mb_to_left_edge = -GET_MV_SUBPEL(mi_col * MI_SIZE);
-      xd->mb_to_right_edge =
-          GET_MV_SUBPEL(mi_params->mi_cols - mi_width - mi_col);
-      mode_estimation(cpi, x, xd, &sf, frame_idx, mi_row, mi_col, bsize,
-                      tx_size, ref_frame, src_frame, &tpl_stats);
-
-      // Motion flow dependency dispenser.
-      tpl_model_store(tpl_frame->tpl_stats_ptr, mi_row, mi_col, bsize,
-                      tpl_frame->stride, &tpl_stats,
-                      tpl_data->tpl_stats_block_mis_log2);
+  tpl_mt_info->num_rows = (mi_params->mi_rows + mi_height - 1) / mi_height;
+  if (cpi->oxcf.max_threads > 1) {
+    av1_mc_flow_dispenser_mt(cpi);
+  } else {
+    assert(tpl_mt_info->num_frames == 1);
+    tpl_mt_info->sync_read_ptr = av1_row_mt_sync_read_dummy;
+    tpl_mt_info->sync_write_ptr = av1_row_mt_sync_write_dummy;
+    for (int mi_row = 0; mi_row < mi_params->mi_rows; mi_row += mi_height) {
+      av1_mc_flow_dispenser_row(cpi, x, &tpl_mt_info->frames[0], mi_row);
     }
   }
 }
@@ -1011,16 +1072,45 @@ int av1_tpl_setup_stats(AV1_COMP *cpi, int gop_eval,
   init_tpl_stats(tpl_data);
 
   // Backward propagation from tpl_group_frames to 1.
-  for (int frame_idx = gf_group->index; frame_idx < tpl_gf_group_frames;
-       ++frame_idx) {
-    if (gf_group->update_type[frame_idx] == INTNL_OVERLAY_UPDATE ||
-        gf_group->update_type[frame_idx] == OVERLAY_UPDATE)
-      continue;
+  TplMultiThreadInfo *const tpl_mt_info = &cpi->tpl_mt_info;
+  const int max_parallel_frames =
+      cpi->oxcf.max_threads > 1 ? MAX_TPL_PARALLEL_FRAMES : 1;
+  for (int frame_idx = gf_group->index; frame_idx < tpl_gf_group_frames;) {
+    // Gather the next frames which do not depend on each other, so that they
+    // may be processed at the same time.
+    tpl_mt_info->num_frames = 0;
+    for (; frame_idx < tpl_gf_group_frames &&
+           tpl_mt_info->num_frames < max_parallel_frames;
+         ++frame_idx) {
+      if (gf_group->update_type[frame_idx] == INTNL_OVERLAY_UPDATE ||
+          gf_group->update_type[frame_idx] == OVERLAY_UPDATE)
+        continue;
+
+      if (frame_idx == gf_group->size) {
+        // This frame is not processed.
+        if (tpl_mt_info->num_frames > 0) break;
+        aom_extend_frame_borders(tpl_data->tpl_frame[frame_idx].rec_picture,
+                                 av1_num_planes(cm));
+        continue;
+      }
 
-    mc_flow_dispenser(cpi, frame_idx, pframe_qindex);
+      TplDispenserFrame *const frame =
+          &tpl_mt_info->frames[tpl_mt_info->num_frames];
+      init_dispenser_frame(cpi, frame_idx, frame);
+      if (!is_independent_frame(tpl_data, tpl_mt_info->frames,
+                                tpl_mt_info->num_frames, frame))
+        break;
+      ++tpl_mt_info->num_frames;
+    }
+    if (tpl_mt_info->num_frames == 0) continue;
+
+    mc_flow_dispenser(cpi, pframe_qindex);
 
-    aom_extend_frame_borders(tpl_data->tpl_frame[frame_idx].rec_picture,
-                             av1_num_planes(cm));
+    for (int i = 0; i < tpl_mt_info->num_frames; ++i) {
+      aom_extend_frame_borders(
+          tpl_data->tpl_frame[tpl_mt_info->frames[i].frame_idx].rec_picture,
+          av1_num_planes(cm));
+    }
   }
 
   for (int frame_idx = tpl_gf_group_frames - 1; frame_idx >= gf_group->index;
@@ -33,6 +33,11 @@ int av1_tpl_setup_stats(AV1_COMP *cpi, int gop_eval,
                         const EncodeFrameParams *const frame_params,
                         const EncodeFrameInput *const frame_input);
 
+// Computes the tpl stats of a row of blocks of the frame. The blocks wait for
+// the blocks above them with tpl_mt_info.sync_read_ptr.
+void av1_mc_flow_dispenser_row(AV1_COMP *cpi, MACROBLOCK *x,
+                               TplDispenserFrame *frame, int mi_row);
+
 int av1_tpl_ptr_pos(int mi_row, int mi_col, int stride, uint8_t right_shift);
 
 void av1_tpl_rdmult_setup(AV1_COMP *cpi);
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <assert.h>
+#include <immintrin.h>
+#include <math.h>
+
+#include "config/av1_rtcd.h"
+
+#include "aom_dsp/aom_dsp_common.h"
+#include "av1/encoder/cnn.h"
+
+// The weights of a layer are stored with the output channels innermost, so
+// the weights of 8 consecutive output channels for one tap are one vector.
+// The convolution computes 8 output channels of CONV_PIXELS pixels of a row at
+// a time, keeping the sums in registers and loading each weight vector once
+// for all the pixels. The products are accumulated in the order of the C
+// version, without fused multiply-adds, so the outputs are bit-exact.
+#define CONV_PIXELS 4
+
+static const int32_t channel_mask[16] = { -1, -1, -1, -1, -1, -1, -1, -1,
+                                          0,  0,  0,  0,  0,  0,  0,  0 };
+
+// Loads the values of the n <= 8 channels at p, the others being 0.
+static INLINE __m256 load_channels(const float *p, int n, __m256i mask) {
+  return n == 8 ? _mm256_loadu_ps(p) : _mm256_maskload_ps(p, mask);
+}
+
+// Stores the 8 channels of 4 pixels of sum to the first n channels of output,
+// at 4 consecutive positions from index.
+static INLINE void store_channels_x4(const __m256 *sum, int n, float **output,
+                                     int index) {
+  __m128 lo0 = _mm256_castps256_ps128(sum[0]);
+  __m128 lo1 = _mm256_castps256_ps128(sum[1]);
+  __m128 lo2 = _mm256_castps256_ps128(sum[2]);
+  __m128 lo3 = _mm256_castps256_ps128(sum[3]);
+  __m128 hi0 = _mm256_extractf128_ps(sum[0], 1);
+  __m128 hi1 = _mm256_extractf128_ps(sum[1], 1);
+  __m128 hi2 = _mm256_extractf128_ps(sum[2], 1);
+  __m128 hi3 = _mm256_extractf128_ps(sum[3], 1);
+  _MM_TRANSPOSE4_PS(lo0, lo1, lo2, lo3);
+  _MM_TRANSPOSE4_PS(hi0, hi1, hi2, hi3);
+  const __m128 rows[8] = { lo0, lo1, lo2, lo3, hi0, hi1, hi2, hi3 };
+  for (int c = 0; c < n; ++c) _mm_storeu_ps(output[c] + index, rows[c]);
+}
+
+static INLINE void store_channels_x1(__m256 sum, int n, float **output,
+                                     int index) {
+  float values[8];
+  _mm256_storeu_ps(values, sum);
+  for (int c = 0; c < n; ++c) output[c][index] = values[c];
+}
+
+// Convolves the n <= 8 output channels of output with PADDING_VALID, the
+// filter being applied at the input columns w, w + skip_width, ...
+static void convolve_valid_channels(const float **input, int in_width,
+                                    int in_height, int in_stride,
+                                    const CNN_LAYER_CONFIG *layer_config,
+                                    const float *weights, const float *bias,
+                                    int n, float **output, int out_stride) {
+  const int in_channels = layer_config->in_channels;
+  const int filter_width = layer_config->filter_width;
+  const int filter_height = layer_config->filter_height;
+  const int skip_width = layer_config->skip_width;
+  const int cstep = in_channels * layer_config->out_channels;
+  const __m256i mask =
+      _mm256_loadu_si256((const __m256i *)(channel_mask + 8 - n));
+  const __m256 bias_vec = load_channels(bias, n, mask);
+  const int end_w = in_width - filter_width + 1;
+
+  for (int h = 0, u = 0; h < in_height - filter_height + 1;
+       h += layer_config->skip_height, ++u) {
+    int w = 0;
+    int out_index = u * out_stride;
+    for (; w + (CONV_PIXELS - 1) * skip_width < end_w;
+         w += CONV_PIXELS * skip_width, out_index += CONV_PIXELS) {
+      __m256 sum[CONV_PIXELS];
+      for (int p = 0; p < CONV_PIXELS; ++p) sum[p] = bias_vec;
+      for (int k = 0; k < in_channels; ++k) {
+        const float *wt = weights + k * layer_config->out_channels;
+        const float *in_row = input[k] + h * in_stride + w;
+        for (int l = 0; l < filter_height; ++l, in_row += in_stride) {
+          for (int m = 0; m < filter_width; ++m, wt += cstep) {
+            const __m256 weight = load_channels(wt, n, mask);
+            const float *in = in_row + m;
+            for (int p = 0; p < CONV_PIXELS; ++p, in += skip_width) {
+              sum[p] = _mm256_add_ps(
+                  sum[p], _mm256_mul_ps(weight, _mm256_broadcast_ss(in)));
+            }
+          }
+        }
+      }
+      store_channels_x4(sum, n, output, out_index);
+    }
+    for (; w < end_w; w += skip_width, ++out_index) {
+      __m256 sum = bias_vec;
+      for (int k = 0; k < in_channels; ++k) {
+        const float *wt = weights + k * layer_config->out_channels;
+        const float *in_row = input[k] + h * in_stride + w;
+        for (int l = 0; l < filter_height; ++l, in_row += in_stride) {
+          for (int m = 0; m < filter_width; ++m, wt += cstep) {
+            const __m256 weight = load_channels(wt, n, mask);
+            sum = _mm256_add_ps(
+                sum, _mm256_mul_ps(weight, _mm256_broadcast_ss(in_row + m)));
+          }
+        }
+      }
+      store_channels_x1(sum, n, output, out_index);
+    }
+  }
+}
+
+void av1_cnn_convolve_avx2(const float **input, int in_width, int in_height,
+                           int in_stride, const CNN_LAYER_CONFIG *layer_config,
+                           float **output, int out_stride, int start_idx,
+                           int step) {
+  assert(!layer_config->deconvolve);
+  // Only the padding used by the partition CNN is vectorized. The threads
+  // split the output channels one by one, which does not fit the vectors.
+  if (layer_config->pad != PADDING_VALID || start_idx > 0 || step > 1 ||
+      (layer_config->filter_width == 1 && layer_config->filter_height == 1) ||
+      (layer_config->maxpool &&
+       (layer_config->skip_height > 1 || layer_config->skip_width > 1))) {
+    av1_cnn_convolve_c(input, in_width, in_height, in_stride, layer_config,
+                       output, out_stride, start_idx, step);
+    return;
+  }
+  for (int i = 0; i < layer_config->out_channels; i += 8) {
+    const int n = AOMMIN(8, layer_config->out_channels - i);
+    convolve_valid_channels(input, in_width, in_height, in_stride, layer_config,
+                            layer_config->weights + i, layer_config->bias + i,
+                            n, output + i, out_stride);
+  }
+}
+
+void av1_cnn_activate_avx2(float **output, int channels, int width, int height,
+                           int stride, ACTIVATION layer_activation) {
+  if (layer_activation == NONE) return;
+  if (layer_activation != RELU && layer_activation != SOFTSIGN) {
+    av1_cnn_activate_c(output, channels, width, height, stride,
+                       layer_activation);
+    return;
+  }
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < height; ++i) {
+      float *row = output[c] + i * stride;
+      int j = 0;
+      if (layer_activation == RELU) {
+        // The operands are ordered so that -0 and NaN are kept as in C.
+        for (; j + 8 <= width; j += 8) {
+          _mm256_storeu_ps(row + j,
+                           _mm256_max_ps(zero, _mm256_loadu_ps(row + j)));
+        }
+        for (; j < width; ++j) row[j] = row[j] < 0 ? 0 : row[j];
+      } else {
+        for (; j + 8 <= width; j += 8) {
+          const __m256 x = _mm256_loadu_ps(row + j);
+          const __m256 denom = _mm256_add_ps(_mm256_and_ps(x, abs_mask), one);
+          _mm256_storeu_ps(row + j, _mm256_div_ps(x, denom));
+        }
+        for (; j < width; ++j) row[j] = row[j] / (float)(fabsf(row[j]) + 1.0);
+      }
+    }
+  }
+}
+
+void av1_cnn_add_avx2(float **output, int channels, int width, int height,
+                      int stride, const float **add) {
+  for (int c = 0; c < channels; ++c) {
+    for (int i = 0; i < height; ++i) {
+      float *row = output[c] + i * stride;
+      const float *add_row = add[c] + i * stride;
+      int j = 0;
+      for (; j + 8 <= width; j += 8) {
+        _mm256_storeu_ps(row + j, _mm256_add_ps(_mm256_loadu_ps(row + j),
+                                                _mm256_loadu_ps(add_row + j)));
+      }
+      for (; j < width; ++j) row[j] += add_row[j];
+    }
+  }
+}
+
+void av1_cnn_batchnorm_avx2(float **image, int channels, int width, int height,
+                            int stride, const float *gamma, const float *beta,
+                            const float *mean, const float *std) {
+  assert(gamma && beta && beta && std && "batchnorm has null parameter!");
+  for (int ch = 0; ch < channels; ch++) {
+    const __m256 ch_gamma = _mm256_set1_ps(gamma[ch]);
+    const __m256 ch_beta = _mm256_set1_ps(beta[ch]);
+    const __m256 ch_mean = _mm256_set1_ps(mean[ch]);
+    const __m256 ch_std = _mm256_set1_ps(std[ch]);
+    float *image_row = image[ch];
+
+    for (int row = 0; row < height; row++) {
+      int col = 0;
+      // Same order of operations as in C.
+      for (; col + 8 <= width; col += 8) {
+        const __m256 x =
+            _mm256_sub_ps(_mm256_loadu_ps(image_row + col), ch_mean);
+        const __m256 y = _mm256_div_ps(_mm256_mul_ps(ch_gamma, x), ch_std);
+        _mm256_storeu_ps(image_row + col, _mm256_add_ps(y, ch_beta));
+      }
+      for (; col < width; col++) {
+        image_row[col] =
+            gamma[ch] * (image_row[col] - mean[ch]) / std[ch] + beta[ch];
+      }
+      image_row += stride;
+    }
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <immintrin.h>  // AVX-512
+
+#include "config/av1_rtcd.h"
+
+#include "aom/aom_integer.h"
+
+static INLINE int64_t reduce_epi64(const __m512i val) {
+  const __m256i sum_256 = _mm256_add_epi64(_mm512_castsi512_si256(val),
+                                           _mm512_extracti64x4_epi64(val, 1));
+  const __m128i sum_128 = _mm_add_epi64(_mm256_castsi256_si128(sum_256),
+                                        _mm256_extracti128_si256(sum_256, 1));
+  int64_t sum;
+  _mm_storel_epi64((__m128i *)&sum,
+                   _mm_add_epi64(sum_128, _mm_srli_si128(sum_128, 8)));
+  return sum;
+}
+
+// The squares are computed on the 32 bit coefficients as 64 bit products of
+// the even and odd elements, so unlike the avx2 version the coefficients are
+// not saturated to 16 bits.
+int64_t av1_block_error_avx512(const tran_low_t *coeff,
+                               const tran_low_t *dqcoeff, intptr_t block_size,
+                               int64_t *ssz) {
+  __m512i sse_reg = _mm512_setzero_si512();
+  __m512i ssz_reg = _mm512_setzero_si512();
+
+  for (intptr_t i = 0; i < block_size; i += 16) {
+    const __m512i coeff_reg = _mm512_loadu_si512(coeff + i);
+    const __m512i dqcoeff_reg = _mm512_loadu_si512(dqcoeff + i);
+    const __m512i diff = _mm512_sub_epi32(coeff_reg, dqcoeff_reg);
+    const __m512i diff_odd = _mm512_srli_epi64(diff, 32);
+    const __m512i coeff_odd = _mm512_srli_epi64(coeff_reg, 32);
+    sse_reg = _mm512_add_epi64(sse_reg, _mm512_mul_epi32(diff, diff));
+    sse_reg = _mm512_add_epi64(sse_reg, _mm512_mul_epi32(diff_odd, diff_odd));
+    ssz_reg = _mm512_add_epi64(ssz_reg, _mm512_mul_epi32(coeff_reg, coeff_reg));
+    ssz_reg = _mm512_add_epi64(ssz_reg, _mm512_mul_epi32(coeff_odd, coeff_odd));
+  }
+
+  *ssz = reduce_epi64(ssz_reg);
+  return reduce_epi64(sse_reg);
+}
@@ -44,6 +44,7 @@ set_aom_detect_var(HAVE_VSX 0 "Enables VSX optimizations.")
 # x86/x86_64 feature flags.
 set_aom_detect_var(HAVE_AVX 0 "Enables AVX optimizations.")
 set_aom_detect_var(HAVE_AVX2 0 "Enables AVX2 optimizations.")
+set_aom_detect_var(HAVE_AVX512 0 "Enables AVX-512 optimizations.")
 set_aom_detect_var(HAVE_MMX 0 "Enables MMX optimizations. ")
 set_aom_detect_var(HAVE_SSE 0 "Enables SSE optimizations.")
 set_aom_detect_var(HAVE_SSE2 0 "Enables SSE2 optimizations.")
@@ -191,3 +192,5 @@ set_aom_option_var(ENABLE_AVX "Enables AVX optimizations on x86/x86_64 targets."
                    ON)
 set_aom_option_var(ENABLE_AVX2
                    "Enables AVX2 optimizations on x86/x86_64 targets." ON)
+set_aom_option_var(ENABLE_AVX512
+                   "Enables AVX-512 optimizations on x86/x86_64 targets." ON)
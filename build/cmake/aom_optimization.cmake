@@ -15,6 +15,10 @@ set(AOM_BUILD_CMAKE_AOM_OPTIMIZATION_CMAKE_ 1)
 
 include("${AOM_ROOT}/build/cmake/util.cmake")
 
+# The AVX-512 subsets which the avx512 sources may use: the ones of the Skylake
+# server and later processors which x86_simd_caps() requires for HAS_AVX512.
+set(AOM_AVX512_FLAGS "-mavx512f -mavx512bw -mavx512dq -mavx512vl -mavx512cd")
+
 # Translate $flag to one which MSVC understands, and write the new flag to the
 # variable named by $translated_flag (or unset it, when MSVC needs no flag).
 function(get_msvc_intrinsic_flag flag translated_flag)
@@ -22,9 +26,12 @@ function(get_msvc_intrinsic_flag flag translated_flag)
     set(${translated_flag} "/arch:AVX" PARENT_SCOPE)
   elseif("${flag}" STREQUAL "-mavx2")
     set(${translated_flag} "/arch:AVX2" PARENT_SCOPE)
+  elseif("${flag}" STREQUAL "${AOM_AVX512_FLAGS}")
+    set(${translated_flag} "/arch:AVX512" PARENT_SCOPE)
   else()
 
-    # MSVC does not need flags for intrinsics flavors other than AVX/AVX2.
+    # MSVC does not need flags for intrinsics flavors other than
+    # AVX/AVX2/AVX-512.
     unset(${translated_flag} PARENT_SCOPE)
   endif()
 endfunction()
@@ -49,7 +56,7 @@ function(add_intrinsics_object_library flag opt_name target_to_update sources)
     get_msvc_intrinsic_flag(${flag} "flag")
   endif()
 
-  if("${flag}" STREQUAL "-mavx2")
+  if("${flag}" STREQUAL "-mavx2" OR "${flag}" STREQUAL "${AOM_AVX512_FLAGS}")
     unset(FLAG_SUPPORTED)
     check_c_compiler_flag("-mno-avx256-split-unaligned-load" FLAG_SUPPORTED)
     if(${FLAG_SUPPORTED})
@@ -26,6 +26,7 @@ set(AOM_DOXYGEN_SOURCES "${AOM_ROOT}/aom/aom.h" "${AOM_ROOT}/aom/aom_codec.h"
                         "${AOM_ROOT}/aom/aom_frame_buffer.h"
                         "${AOM_ROOT}/aom/aom_image.h"
                         "${AOM_ROOT}/aom/aom_integer.h"
+                        "${AOM_ROOT}/aom/aom_thread_pool.h"
                         "${AOM_ROOT}/keywords.dox" "${AOM_ROOT}/mainpage.dox"
                         "${AOM_ROOT}/usage.dox")
 
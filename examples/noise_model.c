@@ -43,6 +43,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config/aom_dsp_rtcd.h"
+
 #include "aom/aom_encoder.h"
 #include "aom_dsp/aom_dsp_common.h"
 
@@ -296,6 +298,8 @@ int main(int argc, char *argv[]) {
 
   exec_name = argv[0];
   parse_args(&args, &argc, argv + 1);
+  // The flat block finder and the denoiser use the dsp functions directly.
+  aom_dsp_rtcd();
 
   info.frame_width = args.width;
   info.frame_height = args.height;
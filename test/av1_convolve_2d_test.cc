@@ -71,6 +71,11 @@ INSTANTIATE_TEST_SUITE_P(
     AVX2, AV1Convolve2DSrTest,
     libaom_test::AV1Convolve2D::BuildParams(av1_convolve_2d_sr_avx2, 1, 1));
 #endif  // HAVE_AVX2
+#if HAVE_AVX512
+INSTANTIATE_TEST_SUITE_P(
+    AVX512, AV1Convolve2DSrTest,
+    libaom_test::AV1Convolve2D::BuildParams(av1_convolve_2d_sr_avx512, 1, 1));
+#endif  // HAVE_AVX512
 #endif  // HAVE_SSE2
 
 #if HAVE_NEON
@@ -580,4 +580,22 @@ INSTANTIATE_TEST_SUITE_P(AVX2, AV1HighbdFwdTxfm2dTest,
                          Combine(ValuesIn(Highbd_fwd_txfm_for_avx2),
                                  Values(av1_highbd_fwd_txfm)));
 #endif  // HAVE_AVX2
+#if HAVE_AVX512
+// av1_highbd_fwd_txfm() picks the best version the cpu has, so the avx512
+// transforms are called directly.
+template <FwdTxfm2dFunc fwd_txfm2d>
+void HighbdFwdTxfm2dWrapper(const int16_t *src_diff, tran_low_t *coeff,
+                            int diff_stride, TxfmParam *txfm_param) {
+  fwd_txfm2d(src_diff, coeff, diff_stride, txfm_param->tx_type,
+             txfm_param->bd);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    AVX512, AV1HighbdFwdTxfm2dTest,
+    Values(
+        std::make_tuple(TX_32X32,
+                        HighbdFwdTxfm2dWrapper<av1_fwd_txfm2d_32x32_avx512>),
+        std::make_tuple(TX_64X64,
+                        HighbdFwdTxfm2dWrapper<av1_fwd_txfm2d_64x64_avx512>)));
+#endif  // HAVE_AVX512
 }  // namespace
@@ -12,12 +12,18 @@
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
+#include <tuple>
+#include <vector>
 
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "config/av1_rtcd.h"
 
+#include "aom_ports/aom_timer.h"
 #include "av1/encoder/cnn.h"
+#include "av1/encoder/partition_cnn_weights.h"
+#include "test/acm_random.h"
+#include "test/util.h"
 
 #define SQR(x) ((x) * (x))
 
@@ -2494,3 +2500,224 @@ TEST_F(CNNTest, TestMultiOutput) {
 
   aom_free(output_);
 }
+
+namespace {
+
+typedef void (*CNNConvolveFunc)(const float **input, int in_width,
+                                int in_height, int in_stride,
+                                const CNN_LAYER_CONFIG *layer_config,
+                                float **output, int out_stride, int start_idx,
+                                int step);
+typedef void (*CNNActivateFunc)(float **input, int channels, int width,
+                                int height, int stride,
+                                ACTIVATION layer_activation);
+typedef void (*CNNAddFunc)(float **input, int channels, int width, int height,
+                           int stride, const float **add);
+typedef void (*CNNBatchnormFunc)(float **image, int channels, int width,
+                                 int height, int stride, const float *gamma,
+                                 const float *beta, const float *mean,
+                                 const float *std);
+
+typedef std::tuple<CNNConvolveFunc, CNNActivateFunc, CNNAddFunc,
+                   CNNBatchnormFunc>
+    CNNFuncs;
+
+// A tensor of channels planes of width x height floats, with a stride.
+struct Tensor {
+  Tensor(int channels, int width, int height, int stride)
+      : width(width), height(height), stride(stride),
+        data(channels * stride * height), planes(channels) {
+    for (int c = 0; c < channels; ++c) planes[c] = &data[c * stride * height];
+  }
+  Tensor(const Tensor &other)
+      : Tensor((int)other.planes.size(), other.width, other.height,
+               other.stride) {
+    data = other.data;
+  }
+  int width, height, stride;
+  std::vector<float> data;
+  std::vector<float *> planes;
+};
+
+// Compares the SIMD versions of the CNN functions to the C ones, within a
+// float tolerance relative to the magnitude of the reference.
+class CNNSimdTest : public ::testing::TestWithParam<CNNFuncs> {
+ protected:
+  CNNSimdTest() : rnd_(libaom_test::ACMRandom::DeterministicSeed()) {}
+
+  virtual void SetUp() {
+    convolve_ = GET_PARAM(0);
+    activate_ = GET_PARAM(1);
+    add_ = GET_PARAM(2);
+    batchnorm_ = GET_PARAM(3);
+  }
+
+  float RandFloat() { return (rnd_.Rand16() - 32768) / 16384.0f; }
+
+  void FillRandom(std::vector<float> *values) {
+    for (float &v : *values) v = RandFloat();
+  }
+
+  static void ExpectNear(const Tensor &ref, const Tensor &test) {
+    for (size_t c = 0; c < ref.planes.size(); ++c) {
+      for (int i = 0; i < ref.height; ++i) {
+        for (int j = 0; j < ref.width; ++j) {
+          const float r = ref.planes[c][i * ref.stride + j];
+          const float t = test.planes[c][i * test.stride + j];
+          ASSERT_NEAR(r, t, 1e-4f * AOMMAX(1.0f, fabsf(r)))
+              << "channel " << c << " row " << i << " column " << j;
+        }
+      }
+    }
+  }
+
+  void RunConvolve(const CNN_LAYER_CONFIG &layer_config, int in_width,
+                   int in_height) {
+    Tensor input(layer_config.in_channels, in_width, in_height, in_width + 3);
+    FillRandom(&input.data);
+    // PADDING_VALID without maxpool, as in the partition CNN.
+    const int out_width =
+        (in_width - layer_config.filter_width) / layer_config.skip_width + 1;
+    const int out_height =
+        (in_height - layer_config.filter_height) / layer_config.skip_height + 1;
+    Tensor ref(layer_config.out_channels, out_width, out_height, out_width + 1);
+    Tensor test(layer_config.out_channels, out_width, out_height,
+                out_width + 1);
+    av1_cnn_convolve_c((const float **)input.planes.data(), in_width,
+                       in_height, input.stride, &layer_config,
+                       ref.planes.data(), ref.stride, 0, 1);
+    convolve_((const float **)input.planes.data(), in_width, in_height,
+              input.stride, &layer_config, test.planes.data(), test.stride, 0,
+              1);
+    ExpectNear(ref, test);
+  }
+
+  libaom_test::ACMRandom rnd_;
+  CNNConvolveFunc convolve_;
+  CNNActivateFunc activate_;
+  CNNAddFunc add_;
+  CNNBatchnormFunc batchnorm_;
+};
+
+TEST_P(CNNSimdTest, ConvolveRandomLayers) {
+  for (int iter = 0; iter < 200; ++iter) {
+    CNN_LAYER_CONFIG layer_config = {};
+    layer_config.in_channels = 1 + rnd_(24);
+    layer_config.out_channels = 1 + rnd_(24);
+    layer_config.filter_width = 1 + rnd_(6);
+    layer_config.filter_height = 1 + rnd_(6);
+    layer_config.skip_width = 1 + rnd_(5);
+    layer_config.skip_height = 1 + rnd_(5);
+    layer_config.pad = PADDING_VALID;
+    const int num_weights =
+        layer_config.filter_width * layer_config.filter_height *
+        layer_config.in_channels * layer_config.out_channels;
+    std::vector<float> weights(num_weights);
+    std::vector<float> bias(layer_config.out_channels);
+    FillRandom(&weights);
+    FillRandom(&bias);
+    layer_config.weights = weights.data();
+    layer_config.bias = bias.data();
+    RunConvolve(layer_config, layer_config.filter_width + rnd_(70),
+                layer_config.filter_height + rnd_(40));
+    if (HasFatalFailure()) return;
+  }
+}
+
+TEST_P(CNNSimdTest, ConvolvePartitionCNN) {
+  const CNN_CONFIG *const cnn_config = &av1_intra_mode_cnn_partition_cnn_config;
+  int width = 65;
+  int height = 65;
+  for (int layer = 0; layer < cnn_config->num_layers; ++layer) {
+    const CNN_LAYER_CONFIG &layer_config = cnn_config->layer_config[layer];
+    RunConvolve(layer_config, width, height);
+    if (HasFatalFailure()) return;
+    width = (width - layer_config.filter_width) / layer_config.skip_width + 1;
+    height =
+        (height - layer_config.filter_height) / layer_config.skip_height + 1;
+  }
+}
+
+TEST_P(CNNSimdTest, ActivateAddBatchnorm) {
+  const int kChannels = 5;
+  const int kWidth = 21;
+  const int kHeight = 9;
+  const int kStride = 24;
+  std::vector<float> gamma(kChannels), beta(kChannels), mean(kChannels),
+      std(kChannels);
+  FillRandom(&gamma);
+  FillRandom(&beta);
+  FillRandom(&mean);
+  for (float &s : std) s = 0.5f + rnd_(100) / 10.0f;
+  for (ACTIVATION activation : { NONE, RELU, SOFTSIGN }) {
+    Tensor ref(kChannels, kWidth, kHeight, kStride);
+    Tensor add(kChannels, kWidth, kHeight, kStride);
+    FillRandom(&ref.data);
+    FillRandom(&add.data);
+    Tensor test(ref);
+
+    av1_cnn_activate_c(ref.planes.data(), kChannels, kWidth, kHeight, kStride,
+                       activation);
+    activate_(test.planes.data(), kChannels, kWidth, kHeight, kStride,
+              activation);
+    ExpectNear(ref, test);
+
+    av1_cnn_add_c(ref.planes.data(), kChannels, kWidth, kHeight, kStride,
+                  (const float **)add.planes.data());
+    add_(test.planes.data(), kChannels, kWidth, kHeight, kStride,
+         (const float **)add.planes.data());
+    ExpectNear(ref, test);
+
+    av1_cnn_batchnorm_c(ref.planes.data(), kChannels, kWidth, kHeight,
+                        kStride, gamma.data(), beta.data(), mean.data(),
+                        std.data());
+    batchnorm_(test.planes.data(), kChannels, kWidth, kHeight, kStride,
+               gamma.data(), beta.data(), mean.data(), std.data());
+    ExpectNear(ref, test);
+  }
+}
+
+TEST_P(CNNSimdTest, DISABLED_SpeedPartitionCNN) {
+  const CNN_CONFIG *const cnn_config = &av1_intra_mode_cnn_partition_cnn_config;
+  const int kRuns = 2000;
+  int width = 65;
+  int height = 65;
+  for (int layer = 0; layer < cnn_config->num_layers; ++layer) {
+    const CNN_LAYER_CONFIG &layer_config = cnn_config->layer_config[layer];
+    const int out_width =
+        (width - layer_config.filter_width) / layer_config.skip_width + 1;
+    const int out_height =
+        (height - layer_config.filter_height) / layer_config.skip_height + 1;
+    Tensor input(layer_config.in_channels, width, height, width);
+    Tensor output(layer_config.out_channels, out_width, out_height, out_width);
+    FillRandom(&input.data);
+    const CNNConvolveFunc funcs[2] = { av1_cnn_convolve_c, convolve_ };
+    int64_t elapsed[2];
+    for (int f = 0; f < 2; ++f) {
+      aom_usec_timer timer;
+      aom_usec_timer_start(&timer);
+      for (int i = 0; i < kRuns; ++i) {
+        funcs[f]((const float **)input.planes.data(), width, height,
+                 input.stride, &layer_config, output.planes.data(),
+                 output.stride, 0, 1);
+      }
+      aom_usec_timer_mark(&timer);
+      elapsed[f] = aom_usec_timer_elapsed(&timer);
+    }
+    printf("layer %d %2dx%2d: c %6.2f us, simd %6.2f us (x%.1f)\n", layer,
+           width, height, (double)elapsed[0] / kRuns,
+           (double)elapsed[1] / kRuns,
+           (double)elapsed[0] / AOMMAX(elapsed[1], 1));
+    width = out_width;
+    height = out_height;
+  }
+}
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, CNNSimdTest,
+                         ::testing::Values(std::make_tuple(
+                             av1_cnn_convolve_avx2, av1_cnn_activate_avx2,
+                             av1_cnn_add_avx2, av1_cnn_batchnorm_avx2)));
+#endif
+
+}  // namespace
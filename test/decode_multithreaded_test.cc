@@ -12,6 +12,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 #include "aom_mem/aom_mem.h"
 #include "test/codec_factory.h"
@@ -182,4 +183,85 @@ AV1_INSTANTIATE_TEST_CASE(AV1DecodeMultiThreadedLSTestLarge,
                           ::testing::Values(1), ::testing::Values(0, 3),
                           ::testing::Values(0, 1));
 
+// Corrupts the tile data of the frames after the first few ones, and decodes
+// them with row-MT, so that a decode worker fails while the others are
+// deblocking the rows decoded so far. The decoders must report the error
+// instead of waiting for the rows which are never filtered.
+class AV1DecodeMultiThreadedCorruptTest
+    : public ::libaom_test::CodecTestWithParam<int>,
+      public ::libaom_test::EncoderTest {
+ protected:
+  AV1DecodeMultiThreadedCorruptTest()
+      : EncoderTest(GET_PARAM(0)), num_threads_(GET_PARAM(1)),
+        num_frames_(0), num_errors_(0) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.w = 352;
+    cfg.h = 288;
+    cfg.threads = num_threads_;
+    cfg.allow_lowbitdepth = 1;
+    decoder_ = codec_->CreateDecoder(cfg, 0);
+    decoder_->Control(AV1D_SET_ROW_MT, 1);
+  }
+
+  virtual ~AV1DecodeMultiThreadedCorruptTest() { delete decoder_; }
+
+  virtual void SetUp() {
+    InitializeConfig();
+    SetMode(libaom_test::kOnePassGood);
+  }
+
+  virtual void PreEncodeFrameHook(libaom_test::VideoSource *video,
+                                  libaom_test::Encoder *encoder) {
+    if (video->frame() == 0) {
+      encoder->Control(AV1E_SET_TILE_COLUMNS, 1);
+      encoder->Control(AV1E_SET_TILE_ROWS, 1);
+      encoder->Control(AOME_SET_CPUUSED, 5);
+    }
+  }
+
+  virtual void FramePktHook(const aom_codec_cx_pkt_t *pkt) {
+    const uint8_t *const buf =
+        reinterpret_cast<const uint8_t *>(pkt->data.frame.buf);
+    std::vector<uint8_t> data(buf, buf + pkt->data.frame.sz);
+    if (num_frames_++ >= kNumCleanFrames) {
+      // Somewhere in the middle of the tiles, past the frame header.
+      const size_t size = data.size();
+      for (size_t i = size / 2; i < size / 2 + size / 16; ++i) {
+        data[i] ^= static_cast<uint8_t>(i * 31 + 17);
+      }
+    }
+    if (decoder_->DecodeFrame(data.data(), data.size()) != AOM_CODEC_OK) {
+      ++num_errors_;
+    }
+    // Drain the output of the frames which did decode.
+    libaom_test::DxDataIterator dec_iter = decoder_->GetDxData();
+    while (dec_iter.Next() != NULL) {
+    }
+  }
+
+  static const int kNumCleanFrames = 2;
+  int num_threads_;
+  int num_frames_;
+  int num_errors_;
+  ::libaom_test::Decoder *decoder_;
+};
+
+TEST_P(AV1DecodeMultiThreadedCorruptTest, NoHang) {
+  const aom_rational timebase = { 33333333, 1000000000 };
+  cfg_.g_timebase = timebase;
+  cfg_.rc_target_bitrate = 1000;
+  cfg_.g_lag_in_frames = 0;
+  cfg_.rc_end_usage = AOM_VBR;
+
+  libaom_test::I420VideoSource video("hantro_collage_w352h288.yuv", 352, 288,
+                                     timebase.den, timebase.num, 0, 6);
+  ASSERT_NO_FATAL_FAILURE(RunLoop(&video));
+  // A sixteenth of the data of each frame is corrupted, which the decoding
+  // does not survive.
+  EXPECT_GT(num_errors_, 0);
+}
+
+AV1_INSTANTIATE_TEST_CASE(AV1DecodeMultiThreadedCorruptTest,
+                          ::testing::Values(4, 8));
+
 }  // namespace
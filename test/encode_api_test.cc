@@ -9,10 +9,13 @@
  * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
  */
 
+#include <vector>
+
 #include "third_party/googletest/src/googletest/include/gtest/gtest.h"
 
 #include "config/aom_config.h"
 
+#include "test/acm_random.h"
 #include "test/util.h"
 #include "aom/aomcx.h"
 #include "aom/aom_encoder.h"
@@ -70,4 +73,149 @@ TEST(EncodeAPI, InvalidParams) {
   }
 }
 
+#if CONFIG_AV1_ENCODER && CONFIG_MULTITHREAD
+struct EncodedFrame {
+  std::vector<uint8_t> data;
+  aom_codec_pts_t pts;
+  aom_codec_frame_flags_t flags;
+};
+
+int GetEncodedFrames(aom_codec_ctx_t *enc, std::vector<EncodedFrame> *frames) {
+  int num_frames = 0;
+  aom_codec_iter_t iter = NULL;
+  const aom_codec_cx_pkt_t *pkt;
+  while ((pkt = aom_codec_get_cx_data(enc, &iter)) != NULL) {
+    if (pkt->kind != AOM_CODEC_CX_FRAME_PKT) continue;
+    const uint8_t *const buf = (const uint8_t *)pkt->data.frame.buf;
+    frames->push_back({ std::vector<uint8_t>(buf, buf + pkt->data.frame.sz),
+                        pkt->data.frame.pts, pkt->data.frame.flags });
+    ++num_frames;
+  }
+  return num_frames;
+}
+
+// Encodes frames of noise with a lag, forcing a key frame in the middle. The
+// image is overwritten as soon as aom_codec_encode() returns.
+void EncodeNoise(bool async, std::vector<EncodedFrame> *frames) {
+  const int kWidth = 96;
+  const int kHeight = 64;
+  const int kNumFrames = 12;
+  aom_codec_iface_t *const iface = aom_codec_av1_cx();
+  aom_codec_enc_cfg_t cfg;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = kWidth;
+  cfg.g_h = kHeight;
+  cfg.g_lag_in_frames = 6;
+  cfg.rc_target_bitrate = 200;
+  aom_codec_ctx_t enc;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&enc, iface, &cfg, 0));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 6));
+  ASSERT_EQ(AOM_CODEC_OK,
+            aom_codec_control(&enc, AV1E_SET_ASYNC_ENCODE, async ? 1 : 0));
+
+  aom_image_t img;
+  ASSERT_EQ(&img, aom_img_alloc(&img, AOM_IMG_FMT_I420, kWidth, kHeight, 1));
+  libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+  for (int i = 0; i < kNumFrames; ++i) {
+    const size_t size = kWidth * kHeight * 3 / 2;
+    for (size_t j = 0; j < size; ++j) img.img_data[j] = rnd.Rand8();
+    const aom_enc_frame_flags_t flags =
+        i == kNumFrames / 2 ? AOM_EFLAG_FORCE_KF : 0;
+    ASSERT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, &img, i, 1, flags));
+    GetEncodedFrames(&enc, frames);
+  }
+  aom_img_free(&img);
+  do {
+    ASSERT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, NULL, 0, 0, 0));
+  } while (GetEncodedFrames(&enc, frames) > 0);
+
+  // Back to the synchronous mode, the encoder is idle.
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AV1E_SET_ASYNC_ENCODE, 0));
+  EXPECT_EQ(0, GetEncodedFrames(&enc, frames));
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+}
+
+TEST(EncodeAPI, AsyncEncodeMatchesSync) {
+  std::vector<EncodedFrame> sync_frames;
+  std::vector<EncodedFrame> async_frames;
+  EncodeNoise(false, &sync_frames);
+  EncodeNoise(true, &async_frames);
+  ASSERT_FALSE(sync_frames.empty());
+  ASSERT_EQ(sync_frames.size(), async_frames.size());
+  for (size_t i = 0; i < sync_frames.size(); ++i) {
+    EXPECT_EQ(sync_frames[i].pts, async_frames[i].pts) << "frame " << i;
+    EXPECT_EQ(sync_frames[i].flags, async_frames[i].flags) << "frame " << i;
+    EXPECT_EQ(sync_frames[i].data, async_frames[i].data) << "frame " << i;
+  }
+}
+
+// Destroying the encoder drops the frames it has not encoded yet.
+TEST(EncodeAPI, AsyncEncodeDestroyWithQueuedFrames) {
+  aom_codec_iface_t *const iface = aom_codec_av1_cx();
+  aom_codec_enc_cfg_t cfg;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = 96;
+  cfg.g_h = 64;
+  aom_codec_ctx_t enc;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&enc, iface, &cfg, 0));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 6));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AV1E_SET_ASYNC_ENCODE, 1));
+  aom_image_t img;
+  ASSERT_EQ(&img, aom_img_alloc(&img, AOM_IMG_FMT_I420, cfg.g_w, cfg.g_h, 1));
+  memset(img.img_data, 128, cfg.g_w * cfg.g_h * 3 / 2);
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, &img, i, 1, 0));
+  }
+  aom_img_free(&img);
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+}
+
+// The controls wait for the queued frames to be encoded, and apply to the
+// frames queued after them.
+TEST(EncodeAPI, AsyncEncodeControlWithQueuedFrames) {
+  aom_codec_iface_t *const iface = aom_codec_av1_cx();
+  aom_codec_enc_cfg_t cfg;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = 96;
+  cfg.g_h = 64;
+  cfg.g_lag_in_frames = 0;
+  aom_codec_ctx_t enc;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&enc, iface, &cfg, 0));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 6));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AV1E_SET_ASYNC_ENCODE, 1));
+  aom_image_t img;
+  ASSERT_EQ(&img, aom_img_alloc(&img, AOM_IMG_FMT_I420, cfg.g_w, cfg.g_h, 1));
+  memset(img.img_data, 128, cfg.g_w * cfg.g_h * 3 / 2);
+  const int kNumFrames = 12;
+  int num_frames = 0;
+  for (int i = 0; i < kNumFrames; ++i) {
+    ASSERT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, &img, i, 1, 0));
+    if (i % 4 == 3) {
+      int q = -1;
+      EXPECT_EQ(AOM_CODEC_OK,
+                aom_codec_control(&enc, AOME_GET_LAST_QUANTIZER, &q));
+      EXPECT_GE(q, 0);
+      EXPECT_EQ(AOM_CODEC_OK,
+                aom_codec_control(&enc, AOME_SET_CPUUSED, 5 + (i / 4) % 2));
+      cfg.rc_target_bitrate += 100;
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_enc_config_set(&enc, &cfg));
+    }
+    aom_codec_iter_t iter = NULL;
+    const aom_codec_cx_pkt_t *pkt;
+    while ((pkt = aom_codec_get_cx_data(&enc, &iter)) != NULL) {
+      if (pkt->kind == AOM_CODEC_CX_FRAME_PKT) ++num_frames;
+    }
+  }
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_encode(&enc, NULL, 0, 0, 0));
+  aom_codec_iter_t iter = NULL;
+  const aom_codec_cx_pkt_t *pkt;
+  while ((pkt = aom_codec_get_cx_data(&enc, &iter)) != NULL) {
+    if (pkt->kind == AOM_CODEC_CX_FRAME_PKT) ++num_frames;
+  }
+  EXPECT_EQ(kNumFrames, num_frames);
+  aom_img_free(&img);
+  EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+}
+#endif  // CONFIG_AV1_ENCODER && CONFIG_MULTITHREAD
+
 }  // namespace
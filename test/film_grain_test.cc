@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom/aom_decoder.h"
+#include "aom/aomdx.h"
+#include "aom_dsp/grain_synthesis.h"
+#include "aom_util/aom_thread.h"
+#include "av1/encoder/grain_test_vectors.h"
+#if CONFIG_AV1_ENCODER
+#include "aom/aom_encoder.h"
+#include "aom/aomcx.h"
+#endif
+#include "test/acm_random.h"
+#include "test/function_equivalence_test.h"
+#include "test/md5_helper.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+using libaom_test::ACMRandom;
+using libaom_test::FunctionEquivalenceTest;
+
+namespace {
+
+const int kNumIterations = 1000;
+// Largest block passed to the kernels by the grain synthesis, in samples.
+const int kMaxBlockSize = 32;
+const int kStride = 2 * kMaxBlockSize + 8;
+
+// Fills the buffers shared by the luma and chroma tests with random data.
+struct NoiseInput {
+  void Generate(ACMRandom *rnd, int bd) {
+    for (int i = 0; i < 256; ++i) scaling_lut[i] = rnd->Rand8();
+    const int grain_center = 128 << (bd - 8);
+    for (int i = 0; i < kStride * kStride; ++i) {
+      grain[i] = static_cast<int>(rnd->Rand16() % (2 * grain_center)) -
+                 grain_center;
+      pix[i] = rnd->Rand16() & ((1 << bd) - 1);
+      luma[i] = rnd->Rand16() & ((1 << bd) - 1);
+    }
+    width = 1 + rnd->PseudoUniform(kMaxBlockSize);
+    height = 1 + rnd->PseudoUniform(kMaxBlockSize);
+    scaling_shift = 8 + rnd->PseudoUniform(4);
+    subsamp_x = rnd->PseudoUniform(2);
+    subsamp_y = subsamp_x ? rnd->PseudoUniform(2) : 0;
+    luma_mult = rnd->PseudoUniform(256) - 128;
+    chroma_mult = rnd->PseudoUniform(256) - 128;
+    offset = (static_cast<int>(rnd->PseudoUniform(512)) << (bd - 8)) -
+             (1 << bd);
+    if (rnd->PseudoUniform(2)) {
+      min_val = 16 << (bd - 8);
+      max_val = 235 << (bd - 8);
+    } else {
+      min_val = 0;
+      max_val = (1 << bd) - 1;
+    }
+  }
+
+  int scaling_lut[256];
+  int grain[kStride * kStride];
+  uint16_t pix[kStride * kStride];
+  uint16_t luma[kStride * kStride];
+  int width;
+  int height;
+  int scaling_shift;
+  int subsamp_x;
+  int subsamp_y;
+  int luma_mult;
+  int chroma_mult;
+  int offset;
+  int min_val;
+  int max_val;
+};
+
+typedef void (*AddNoiseLumaFunc)(uint8_t *luma, int luma_stride,
+                                 const int *grain, int grain_stride,
+                                 const int *scaling_lut, int width, int height,
+                                 int scaling_shift, int min_val, int max_val);
+typedef libaom_test::FuncParam<AddNoiseLumaFunc> AddNoiseLumaParam;
+
+class AddNoiseLumaTest : public FunctionEquivalenceTest<AddNoiseLumaFunc> {
+ protected:
+  NoiseInput in_;
+};
+
+TEST_P(AddNoiseLumaTest, RandomValues) {
+  uint8_t ref[kStride * kStride];
+  uint8_t tst[kStride * kStride];
+  for (int iter = 0; iter < kNumIterations; ++iter) {
+    in_.Generate(&rng_, 8);
+    for (int i = 0; i < kStride * kStride; ++i) ref[i] = tst[i] = in_.pix[i];
+    params_.ref_func(ref, kStride, in_.grain, kStride, in_.scaling_lut,
+                     in_.width, in_.height, in_.scaling_shift, in_.min_val,
+                     in_.max_val);
+    ASM_REGISTER_STATE_CHECK(params_.tst_func(
+        tst, kStride, in_.grain, kStride, in_.scaling_lut, in_.width,
+        in_.height, in_.scaling_shift, in_.min_val, in_.max_val));
+    ASSERT_EQ(0, memcmp(ref, tst, sizeof(ref)))
+        << "Block " << in_.width << "x" << in_.height;
+  }
+}
+
+typedef void (*AddNoiseChromaFunc)(
+    uint8_t *chroma, int chroma_stride, const uint8_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val);
+typedef libaom_test::FuncParam<AddNoiseChromaFunc> AddNoiseChromaParam;
+
+class AddNoiseChromaTest : public FunctionEquivalenceTest<AddNoiseChromaFunc> {
+ protected:
+  NoiseInput in_;
+};
+
+TEST_P(AddNoiseChromaTest, RandomValues) {
+  uint8_t ref[kStride * kStride];
+  uint8_t tst[kStride * kStride];
+  uint8_t luma[kStride * kStride];
+  for (int iter = 0; iter < kNumIterations; ++iter) {
+    in_.Generate(&rng_, 8);
+    for (int i = 0; i < kStride * kStride; ++i) {
+      ref[i] = tst[i] = in_.pix[i];
+      luma[i] = in_.luma[i];
+    }
+    params_.ref_func(ref, kStride, luma, kStride, in_.grain, kStride,
+                     in_.scaling_lut, in_.width, in_.height, in_.subsamp_x,
+                     in_.subsamp_y, in_.luma_mult, in_.chroma_mult, in_.offset,
+                     in_.scaling_shift, in_.min_val, in_.max_val);
+    ASM_REGISTER_STATE_CHECK(params_.tst_func(
+        tst, kStride, luma, kStride, in_.grain, kStride, in_.scaling_lut,
+        in_.width, in_.height, in_.subsamp_x, in_.subsamp_y, in_.luma_mult,
+        in_.chroma_mult, in_.offset, in_.scaling_shift, in_.min_val,
+        in_.max_val));
+    ASSERT_EQ(0, memcmp(ref, tst, sizeof(ref)))
+        << "Block " << in_.width << "x" << in_.height;
+  }
+}
+
+typedef void (*HighbdAddNoiseLumaFunc)(uint16_t *luma, int luma_stride,
+                                       const int *grain, int grain_stride,
+                                       const int *scaling_lut, int width,
+                                       int height, int scaling_shift,
+                                       int min_val, int max_val, int bd);
+typedef libaom_test::FuncParam<HighbdAddNoiseLumaFunc> HighbdAddNoiseLumaParam;
+
+class HighbdAddNoiseLumaTest
+    : public FunctionEquivalenceTest<HighbdAddNoiseLumaFunc> {
+ protected:
+  NoiseInput in_;
+};
+
+TEST_P(HighbdAddNoiseLumaTest, RandomValues) {
+  const int bd = params_.bit_depth;
+  uint16_t ref[kStride * kStride];
+  uint16_t tst[kStride * kStride];
+  for (int iter = 0; iter < kNumIterations; ++iter) {
+    in_.Generate(&rng_, bd);
+    memcpy(ref, in_.pix, sizeof(ref));
+    memcpy(tst, in_.pix, sizeof(tst));
+    params_.ref_func(ref, kStride, in_.grain, kStride, in_.scaling_lut,
+                     in_.width, in_.height, in_.scaling_shift, in_.min_val,
+                     in_.max_val, bd);
+    ASM_REGISTER_STATE_CHECK(params_.tst_func(
+        tst, kStride, in_.grain, kStride, in_.scaling_lut, in_.width,
+        in_.height, in_.scaling_shift, in_.min_val, in_.max_val, bd));
+    ASSERT_EQ(0, memcmp(ref, tst, sizeof(ref)))
+        << "Block " << in_.width << "x" << in_.height;
+  }
+}
+
+typedef void (*HighbdAddNoiseChromaFunc)(
+    uint16_t *chroma, int chroma_stride, const uint16_t *luma, int luma_stride,
+    const int *grain, int grain_stride, const int *scaling_lut, int width,
+    int height, int subsamp_x, int subsamp_y, int luma_mult, int chroma_mult,
+    int offset, int scaling_shift, int min_val, int max_val, int bd);
+typedef libaom_test::FuncParam<HighbdAddNoiseChromaFunc>
+    HighbdAddNoiseChromaParam;
+
+class HighbdAddNoiseChromaTest
+    : public FunctionEquivalenceTest<HighbdAddNoiseChromaFunc> {
+ protected:
+  NoiseInput in_;
+};
+
+TEST_P(HighbdAddNoiseChromaTest, RandomValues) {
+  const int bd = params_.bit_depth;
+  uint16_t ref[kStride * kStride];
+  uint16_t tst[kStride * kStride];
+  for (int iter = 0; iter < kNumIterations; ++iter) {
+    in_.Generate(&rng_, bd);
+    memcpy(ref, in_.pix, sizeof(ref));
+    memcpy(tst, in_.pix, sizeof(tst));
+    params_.ref_func(ref, kStride, in_.luma, kStride, in_.grain, kStride,
+                     in_.scaling_lut, in_.width, in_.height, in_.subsamp_x,
+                     in_.subsamp_y, in_.luma_mult, in_.chroma_mult, in_.offset,
+                     in_.scaling_shift, in_.min_val, in_.max_val, bd);
+    ASM_REGISTER_STATE_CHECK(params_.tst_func(
+        tst, kStride, in_.luma, kStride, in_.grain, kStride, in_.scaling_lut,
+        in_.width, in_.height, in_.subsamp_x, in_.subsamp_y, in_.luma_mult,
+        in_.chroma_mult, in_.offset, in_.scaling_shift, in_.min_val,
+        in_.max_val, bd));
+    ASSERT_EQ(0, memcmp(ref, tst, sizeof(ref)))
+        << "Block " << in_.width << "x" << in_.height;
+  }
+}
+
+#if HAVE_SSE4_1
+INSTANTIATE_TEST_SUITE_P(
+    SSE4_1, AddNoiseLumaTest,
+    ::testing::Values(AddNoiseLumaParam(&aom_film_grain_add_noise_luma_c,
+                                        &aom_film_grain_add_noise_luma_sse4_1)));
+INSTANTIATE_TEST_SUITE_P(
+    SSE4_1, AddNoiseChromaTest,
+    ::testing::Values(
+        AddNoiseChromaParam(&aom_film_grain_add_noise_chroma_c,
+                            &aom_film_grain_add_noise_chroma_sse4_1)));
+#endif  // HAVE_SSE4_1
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, AddNoiseLumaTest,
+    ::testing::Values(AddNoiseLumaParam(&aom_film_grain_add_noise_luma_c,
+                                        &aom_film_grain_add_noise_luma_avx2)));
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, AddNoiseChromaTest,
+    ::testing::Values(
+        AddNoiseChromaParam(&aom_film_grain_add_noise_chroma_c,
+                            &aom_film_grain_add_noise_chroma_avx2)));
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, HighbdAddNoiseLumaTest,
+    ::testing::Values(
+        HighbdAddNoiseLumaParam(&aom_highbd_film_grain_add_noise_luma_c,
+                                &aom_highbd_film_grain_add_noise_luma_avx2, 8),
+        HighbdAddNoiseLumaParam(&aom_highbd_film_grain_add_noise_luma_c,
+                                &aom_highbd_film_grain_add_noise_luma_avx2, 10),
+        HighbdAddNoiseLumaParam(&aom_highbd_film_grain_add_noise_luma_c,
+                                &aom_highbd_film_grain_add_noise_luma_avx2,
+                                12)));
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, HighbdAddNoiseChromaTest,
+    ::testing::Values(
+        HighbdAddNoiseChromaParam(&aom_highbd_film_grain_add_noise_chroma_c,
+                                  &aom_highbd_film_grain_add_noise_chroma_avx2,
+                                  8),
+        HighbdAddNoiseChromaParam(&aom_highbd_film_grain_add_noise_chroma_c,
+                                  &aom_highbd_film_grain_add_noise_chroma_avx2,
+                                  10),
+        HighbdAddNoiseChromaParam(&aom_highbd_film_grain_add_noise_chroma_c,
+                                  &aom_highbd_film_grain_add_noise_chroma_avx2,
+                                  12)));
+#endif  // HAVE_AVX2
+
+// Checks that splitting the frame in stripes processed by several workers
+// gives the same output as av1_add_film_grain().
+// Parameters: image format, number of workers.
+class AddFilmGrainMTTest
+    : public ::testing::TestWithParam<std::tuple<aom_img_fmt_t, int> > {
+ protected:
+  virtual void SetUp() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    num_workers_ = std::get<1>(GetParam());
+    for (int i = 0; i < num_workers_; ++i) {
+      winterface->init(&workers_[i]);
+      // The last worker is run on the calling thread.
+      if (i < num_workers_ - 1) {
+        ASSERT_TRUE(winterface->reset(&workers_[i]));
+      }
+    }
+  }
+
+  virtual void TearDown() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) winterface->end(&workers_[i]);
+  }
+
+  AVxWorker workers_[8];
+  int num_workers_;
+};
+
+TEST_P(AddFilmGrainMTTest, MatchesSingleThread) {
+  const aom_img_fmt_t fmt = std::get<0>(GetParam());
+  const int hbd = (fmt & AOM_IMG_FMT_HIGHBITDEPTH) ? 1 : 0;
+  const int sizes[][2] = { { 352, 288 }, { 349, 283 }, { 2, 97 } };
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+
+  for (const auto &size : sizes) {
+    for (int i = 0; i < 16; ++i) {
+      aom_film_grain_t params = film_grain_test_vectors[i];
+      params.bit_depth = hbd ? 10 : 8;
+      params.random_seed = rnd.Rand16();
+
+      // Like the decoder output, the source buffer is aligned to an even size.
+      const int w_even = (size[0] + 1) & ~1;
+      const int h_even = (size[1] + 1) & ~1;
+      aom_image_t src, ref, tst;
+      ASSERT_TRUE(aom_img_alloc(&src, fmt, w_even, h_even, 32) != NULL);
+      src.bit_depth = params.bit_depth;
+      for (int plane = 0; plane < 3; ++plane) {
+        const int h = h_even >> (plane ? src.y_chroma_shift : 0);
+        for (int r = 0; r < h; ++r) {
+          uint8_t *const row = src.planes[plane] + r * src.stride[plane];
+          for (int c = 0; c < (src.stride[plane] >> hbd); ++c) {
+            if (hbd) {
+              reinterpret_cast<uint16_t *>(row)[c] = rnd.Rand16() & 1023;
+            } else {
+              row[c] = rnd.Rand8();
+            }
+          }
+        }
+      }
+      src.d_w = size[0];
+      src.d_h = size[1];
+      ASSERT_TRUE(aom_img_alloc(&ref, fmt, w_even, h_even, 32) != NULL);
+      ASSERT_TRUE(aom_img_alloc(&tst, fmt, w_even, h_even, 32) != NULL);
+      memset(ref.img_data, 0, ref.sz);
+      memset(tst.img_data, 0, tst.sz);
+
+      ASSERT_EQ(0, av1_add_film_grain(&params, &src, &ref));
+      ASSERT_EQ(0, av1_add_film_grain_mt(&params, &src, &tst, workers_,
+                                         num_workers_));
+      for (int plane = 0; plane < 3; ++plane) {
+        const int ss_x = plane ? ref.x_chroma_shift : 0;
+        const int ss_y = plane ? ref.y_chroma_shift : 0;
+        for (int r = 0; r < (h_even >> ss_y); ++r) {
+          ASSERT_EQ(0, memcmp(ref.planes[plane] + r * ref.stride[plane],
+                              tst.planes[plane] + r * tst.stride[plane],
+                              (w_even >> ss_x) << hbd))
+              << "Test vector " << i + 1 << " plane " << plane << " row " << r
+              << " size " << size[0] << "x" << size[1];
+        }
+      }
+
+      aom_img_free(&src);
+      aom_img_free(&ref);
+      aom_img_free(&tst);
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    C, AddFilmGrainMTTest,
+    ::testing::Combine(::testing::Values(AOM_IMG_FMT_I420, AOM_IMG_FMT_I422,
+                                         AOM_IMG_FMT_I444, AOM_IMG_FMT_I42016),
+                       ::testing::Values(1, 2, 3, 8)));
+
+#if CONFIG_AV1_ENCODER
+// Encodes random frames with a film grain test vector. The first frames are
+// coded at half the size, so that the images with grain grow in the middle of
+// the stream.
+void EncodeWithGrain(int num_frames, std::vector<std::vector<uint8_t> > *out) {
+  aom_codec_iface_t *const iface = aom_codec_av1_cx();
+  aom_codec_enc_cfg_t cfg;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+  cfg.g_w = 128;
+  cfg.g_h = 96;
+  cfg.g_lag_in_frames = 0;
+  aom_codec_ctx_t enc;
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&enc, iface, &cfg, 0));
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_control(&enc, AOME_SET_CPUUSED, 6));
+  ASSERT_EQ(AOM_CODEC_OK,
+            aom_codec_control(&enc, AV1E_SET_FILM_GRAIN_TEST_VECTOR, 1));
+  aom_image_t img;
+  ASSERT_EQ(&img, aom_img_alloc(&img, AOM_IMG_FMT_I420, cfg.g_w, cfg.g_h, 1));
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  for (int i = 0; i <= num_frames; ++i) {
+    if (i == 0 || i == num_frames / 2) {
+      aom_scaling_mode_t mode = { AOME_NORMAL, AOME_NORMAL };
+      if (i == 0) mode.h_scaling_mode = mode.v_scaling_mode = AOME_ONETWO;
+      ASSERT_EQ(AOM_CODEC_OK,
+                aom_codec_control(&enc, AOME_SET_SCALEMODE, &mode));
+    }
+    for (size_t j = 0; j < cfg.g_w * cfg.g_h * 3 / 2; ++j) {
+      img.img_data[j] = rnd.Rand8();
+    }
+    // The last call flushes the encoder.
+    ASSERT_EQ(AOM_CODEC_OK,
+              aom_codec_encode(&enc, i < num_frames ? &img : NULL, i, 1, 0));
+    aom_codec_iter_t iter = NULL;
+    const aom_codec_cx_pkt_t *pkt;
+    while ((pkt = aom_codec_get_cx_data(&enc, &iter)) != NULL) {
+      if (pkt->kind != AOM_CODEC_CX_FRAME_PKT) continue;
+      const uint8_t *const buf =
+          static_cast<const uint8_t *>(pkt->data.frame.buf);
+      out->push_back(std::vector<uint8_t>(buf, buf + pkt->data.frame.sz));
+    }
+  }
+  aom_img_free(&img);
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_destroy(&enc));
+}
+
+// Frame buffers handed out by the application.
+struct AppFrameBuffers {
+  static int Get(void *priv, size_t min_size, aom_codec_frame_buffer_t *fb) {
+    AppFrameBuffers *const fbs = static_cast<AppFrameBuffers *>(priv);
+    std::vector<uint8_t> *const buf = new std::vector<uint8_t>(min_size);
+    fbs->buffers.push_back(buf);
+    ++fbs->num_in_use;
+    fb->data = buf->data();
+    fb->size = min_size;
+    fb->priv = buf;
+    return 0;
+  }
+
+  static int Release(void *priv, aom_codec_frame_buffer_t *fb) {
+    AppFrameBuffers *const fbs = static_cast<AppFrameBuffers *>(priv);
+    for (size_t i = 0; i < fbs->buffers.size(); ++i) {
+      if (fbs->buffers[i] == fb->priv) {
+        delete fbs->buffers[i];
+        fbs->buffers.erase(fbs->buffers.begin() + i);
+        --fbs->num_in_use;
+        return 0;
+      }
+    }
+    ADD_FAILURE() << "Released an unknown frame buffer";
+    return -1;
+  }
+
+  std::vector<std::vector<uint8_t> *> buffers;
+  int num_in_use = 0;
+};
+
+struct DecodedFrame {
+  std::string md5;
+  int width;
+  const uint8_t *data;
+  // Whether the image is in a frame buffer of the application.
+  bool in_app_buffer;
+};
+
+void DecodeWithGrain(const std::vector<std::vector<uint8_t> > &frames,
+                     int skip_grain, AppFrameBuffers *app_fbs,
+                     std::vector<DecodedFrame> *out) {
+  aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+  cfg.threads = 2;
+  cfg.allow_lowbitdepth = 1;
+  aom_codec_ctx_t dec;
+  ASSERT_EQ(AOM_CODEC_OK,
+            aom_codec_dec_init(&dec, aom_codec_av1_dx(), &cfg, 0));
+  ASSERT_EQ(AOM_CODEC_OK,
+            aom_codec_control(&dec, AV1D_SET_SKIP_FILM_GRAIN, skip_grain));
+  if (app_fbs != NULL) {
+    ASSERT_EQ(AOM_CODEC_OK, aom_codec_set_frame_buffer_functions(
+                                &dec, AppFrameBuffers::Get,
+                                AppFrameBuffers::Release, app_fbs));
+  }
+  for (const std::vector<uint8_t> &frame : frames) {
+    ASSERT_EQ(AOM_CODEC_OK,
+              aom_codec_decode(&dec, frame.data(), frame.size(), NULL));
+    aom_codec_iter_t iter = NULL;
+    const aom_image_t *img;
+    while ((img = aom_codec_get_frame(&dec, &iter)) != NULL) {
+      libaom_test::MD5 md5;
+      md5.Add(img);
+      bool in_app_buffer = false;
+      if (app_fbs != NULL) {
+        for (const std::vector<uint8_t> *buf : app_fbs->buffers) {
+          in_app_buffer |= img->fb_priv == buf &&
+                           img->planes[0] >= buf->data() &&
+                           img->planes[0] < buf->data() + buf->size();
+        }
+      }
+      DecodedFrame decoded = { md5.Get(), static_cast<int>(img->d_w),
+                               img->planes[0], in_app_buffer };
+      out->push_back(decoded);
+    }
+  }
+  ASSERT_EQ(AOM_CODEC_OK, aom_codec_destroy(&dec));
+}
+
+// The images with grain come from a pool which is reused across the frames,
+// and from the application's frame buffers if it provides them.
+TEST(FilmGrainDecodeTest, GrainImagePool) {
+  const int kNumFrames = 6;
+  std::vector<std::vector<uint8_t> > frames;
+  ASSERT_NO_FATAL_FAILURE(EncodeWithGrain(kNumFrames, &frames));
+
+  std::vector<DecodedFrame> no_grain, pooled, app;
+  ASSERT_NO_FATAL_FAILURE(DecodeWithGrain(frames, 1, NULL, &no_grain));
+  ASSERT_NO_FATAL_FAILURE(DecodeWithGrain(frames, 0, NULL, &pooled));
+  AppFrameBuffers app_fbs;
+  ASSERT_NO_FATAL_FAILURE(DecodeWithGrain(frames, 0, &app_fbs, &app));
+  EXPECT_EQ(0, app_fbs.num_in_use);
+
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), pooled.size());
+  ASSERT_EQ(pooled.size(), no_grain.size());
+  ASSERT_EQ(pooled.size(), app.size());
+  EXPECT_EQ(64, pooled[0].width);
+  EXPECT_EQ(128, pooled[kNumFrames - 1].width);
+  for (int i = 0; i < kNumFrames; ++i) {
+    EXPECT_NE(no_grain[i].md5, pooled[i].md5) << "frame " << i;
+    EXPECT_EQ(pooled[i].md5, app[i].md5) << "frame " << i;
+    // The buffer is sized for the largest frame from the start, so it is not
+    // reallocated when the frames grow.
+    EXPECT_EQ(pooled[0].data, pooled[i].data) << "frame " << i;
+    EXPECT_TRUE(app[i].in_app_buffer) << "frame " << i;
+  }
+}
+#endif  // CONFIG_AV1_ENCODER
+
+}  // namespace
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/av1_rtcd.h"
+
+#include "aom_ports/aom_timer.h"
+#include "av1/common/resize.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+namespace {
+
+using libaom_test::ACMRandom;
+
+const int kTestIters = 100;
+const int kPerfIters = 200;
+const int kMaxLength = 1000;
+
+// The filters of the 2:1 downscaling of av1_resize_plane().
+const int16_t kDown2SymevenFilter[SUBPEL_TAPS] = { -1, -3, 12, 56,
+                                                   56, 12, -3, -1 };
+const int16_t kDown2SymoddFilter[SUBPEL_TAPS] = { -3, 0, 35, 64, 35, 0, -3, 0 };
+
+const int16_t *RandomFilter(ACMRandom *rnd) {
+  switch (rnd->PseudoUniform(3)) {
+    case 0: return kDown2SymevenFilter;
+    case 1: return kDown2SymoddFilter;
+    default: {
+      const int sub_pel = rnd->PseudoUniform(1 << RS_SUBPEL_BITS);
+      return av1_resize_filter_normative[sub_pel];
+    }
+  }
+}
+
+// Fills data with random pixels, a third of which are 0 or 255 to exercise the
+// clipping of the results.
+void FillRandom(ACMRandom *rnd, std::vector<uint8_t> *data) {
+  for (size_t i = 0; i < data->size(); ++i) {
+    (*data)[i] = rnd->PseudoUniform(3) == 0 ? 255 * (rnd->Rand8() & 1)
+                                            : rnd->Rand8();
+  }
+}
+
+typedef void (*ResizeVertFunc)(const uint8_t *const *rows, uint8_t *dst,
+                               int width, const int16_t *filter);
+
+class AV1ResizeVertTest : public ::testing::TestWithParam<ResizeVertFunc> {
+ public:
+  virtual ~AV1ResizeVertTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCheckOutput() {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    std::vector<uint8_t> src(SUBPEL_TAPS * kMaxLength);
+    std::vector<uint8_t> ref_dst(kMaxLength), tst_dst(kMaxLength);
+    for (int iter = 0; iter < kTestIters; ++iter) {
+      FillRandom(&rnd, &src);
+      const int width = 1 + rnd.PseudoUniform(kMaxLength);
+      const int16_t *const filter = RandomFilter(&rnd);
+      // The rows are repeated at the edges of the planes.
+      const uint8_t *rows[SUBPEL_TAPS];
+      for (int k = 0; k < SUBPEL_TAPS; ++k) {
+        rows[k] = &src[rnd.PseudoUniform(SUBPEL_TAPS) * kMaxLength];
+      }
+      av1_resize_vert_8tap_c(rows, &ref_dst[0], width, filter);
+      ASM_REGISTER_STATE_CHECK(tst_fun_(rows, &tst_dst[0], width, filter));
+      for (int j = 0; j < width; ++j) {
+        ASSERT_EQ(ref_dst[j], tst_dst[j])
+            << "Mismatch at " << j << " of width " << width;
+      }
+    }
+  }
+
+  void RunSpeedTest() {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    std::vector<uint8_t> src(SUBPEL_TAPS * kMaxLength);
+    std::vector<uint8_t> dst(kMaxLength);
+    FillRandom(&rnd, &src);
+    const uint8_t *rows[SUBPEL_TAPS];
+    for (int k = 0; k < SUBPEL_TAPS; ++k) rows[k] = &src[k * kMaxLength];
+    const int16_t *const filter = av1_resize_filter_normative[17];
+
+    aom_usec_timer ref_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kPerfIters * 100; ++i) {
+      av1_resize_vert_8tap_c(rows, &dst[0], kMaxLength, filter);
+    }
+    aom_usec_timer_mark(&ref_timer);
+    const int64_t ref_time = aom_usec_timer_elapsed(&ref_timer);
+
+    aom_usec_timer tst_timer;
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kPerfIters * 100; ++i) {
+      tst_fun_(rows, &dst[0], kMaxLength, filter);
+    }
+    aom_usec_timer_mark(&tst_timer);
+    const int64_t tst_time = aom_usec_timer_elapsed(&tst_timer);
+
+    printf("[          ] C time = %d us, SIMD time = %d us, gain = %4.2f\n",
+           static_cast<int>(ref_time), static_cast<int>(tst_time),
+           static_cast<double>(ref_time) / tst_time);
+  }
+
+  ResizeVertFunc tst_fun_;
+};
+
+TEST_P(AV1ResizeVertTest, CheckOutput) { RunCheckOutput(); }
+TEST_P(AV1ResizeVertTest, DISABLED_Speed) { RunSpeedTest(); }
+
+typedef void (*ResizeDown2Func)(const uint8_t *input, uint8_t *output,
+                                int out_length, const int16_t *filter);
+
+class AV1ResizeDown2Test : public ::testing::TestWithParam<ResizeDown2Func> {
+ public:
+  virtual ~AV1ResizeDown2Test() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCheckOutput() {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    std::vector<uint8_t> src(2 * kMaxLength + 2 * RESIZE_HORZ_BORDER);
+    std::vector<uint8_t> ref_dst(kMaxLength), tst_dst(kMaxLength);
+    for (int iter = 0; iter < kTestIters; ++iter) {
+      FillRandom(&rnd, &src);
+      const int out_length = 1 + rnd.PseudoUniform(kMaxLength);
+      const int16_t *const filter =
+          (rnd.Rand8() & 1) ? kDown2SymoddFilter : kDown2SymevenFilter;
+      const uint8_t *const input = &src[RESIZE_HORZ_BORDER];
+      av1_resize_down2_horz_c(input, &ref_dst[0], out_length, filter);
+      ASM_REGISTER_STATE_CHECK(
+          tst_fun_(input, &tst_dst[0], out_length, filter));
+      for (int i = 0; i < out_length; ++i) {
+        ASSERT_EQ(ref_dst[i], tst_dst[i])
+            << "Mismatch at " << i << " of length " << out_length;
+      }
+    }
+  }
+
+  void RunSpeedTest() {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    std::vector<uint8_t> src(2 * kMaxLength + 2 * RESIZE_HORZ_BORDER);
+    std::vector<uint8_t> dst(kMaxLength);
+    FillRandom(&rnd, &src);
+    const uint8_t *const input = &src[RESIZE_HORZ_BORDER];
+
+    aom_usec_timer ref_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kPerfIters * 100; ++i) {
+      av1_resize_down2_horz_c(input, &dst[0], kMaxLength, kDown2SymevenFilter);
+    }
+    aom_usec_timer_mark(&ref_timer);
+    const int64_t ref_time = aom_usec_timer_elapsed(&ref_timer);
+
+    aom_usec_timer tst_timer;
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kPerfIters * 100; ++i) {
+      tst_fun_(input, &dst[0], kMaxLength, kDown2SymevenFilter);
+    }
+    aom_usec_timer_mark(&tst_timer);
+    const int64_t tst_time = aom_usec_timer_elapsed(&tst_timer);
+
+    printf("[          ] C time = %d us, SIMD time = %d us, gain = %4.2f\n",
+           static_cast<int>(ref_time), static_cast<int>(tst_time),
+           static_cast<double>(ref_time) / tst_time);
+  }
+
+  ResizeDown2Func tst_fun_;
+};
+
+TEST_P(AV1ResizeDown2Test, CheckOutput) { RunCheckOutput(); }
+TEST_P(AV1ResizeDown2Test, DISABLED_Speed) { RunSpeedTest(); }
+
+typedef void (*ResizeInterpFunc)(const uint8_t *input, uint8_t *output,
+                                 int out_length, int32_t y0, int32_t delta,
+                                 const int16_t *filters);
+
+class AV1ResizeInterpTest : public ::testing::TestWithParam<ResizeInterpFunc> {
+ public:
+  virtual ~AV1ResizeInterpTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  void RunCheckOutput() {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    // The steps are at most 2 pixels, as av1_resize_plane() downscales by 2
+    // before it interpolates.
+    std::vector<uint8_t> src(2 * kMaxLength + 2 * RESIZE_HORZ_BORDER);
+    std::vector<uint8_t> ref_dst(kMaxLength), tst_dst(kMaxLength);
+    const int16_t *const filters = &av1_resize_filter_normative[0][0];
+    for (int iter = 0; iter < kTestIters; ++iter) {
+      FillRandom(&rnd, &src);
+      const int out_length = 1 + rnd.PseudoUniform(kMaxLength);
+      const int32_t delta = 1 + rnd.PseudoUniform(2 << RS_SCALE_SUBPEL_BITS);
+      const int32_t y0 = rnd.PseudoUniform(1 << RS_SCALE_SUBPEL_BITS) -
+                         (1 << (RS_SCALE_SUBPEL_BITS - 1)) + RS_SCALE_EXTRA_OFF;
+      const uint8_t *const input = &src[RESIZE_HORZ_BORDER];
+      av1_resize_interp_horz_c(input, &ref_dst[0], out_length, y0, delta,
+                               filters);
+      ASM_REGISTER_STATE_CHECK(
+          tst_fun_(input, &tst_dst[0], out_length, y0, delta, filters));
+      for (int x = 0; x < out_length; ++x) {
+        ASSERT_EQ(ref_dst[x], tst_dst[x])
+            << "Mismatch at " << x << " of length " << out_length;
+      }
+    }
+  }
+
+  void RunSpeedTest() {
+    ACMRandom rnd(ACMRandom::DeterministicSeed());
+    std::vector<uint8_t> src(2 * kMaxLength + 2 * RESIZE_HORZ_BORDER);
+    std::vector<uint8_t> dst(kMaxLength);
+    FillRandom(&rnd, &src);
+    const uint8_t *const input = &src[RESIZE_HORZ_BORDER];
+    const int16_t *const filters = &av1_resize_filter_normative[0][0];
+    // A 4:3 downscaling.
+    const int32_t delta = (4 << RS_SCALE_SUBPEL_BITS) / 3;
+
+    aom_usec_timer ref_timer;
+    aom_usec_timer_start(&ref_timer);
+    for (int i = 0; i < kPerfIters * 100; ++i) {
+      av1_resize_interp_horz_c(input, &dst[0], kMaxLength, RS_SCALE_EXTRA_OFF,
+                               delta, filters);
+    }
+    aom_usec_timer_mark(&ref_timer);
+    const int64_t ref_time = aom_usec_timer_elapsed(&ref_timer);
+
+    aom_usec_timer tst_timer;
+    aom_usec_timer_start(&tst_timer);
+    for (int i = 0; i < kPerfIters * 100; ++i) {
+      tst_fun_(input, &dst[0], kMaxLength, RS_SCALE_EXTRA_OFF, delta, filters);
+    }
+    aom_usec_timer_mark(&tst_timer);
+    const int64_t tst_time = aom_usec_timer_elapsed(&tst_timer);
+
+    printf("[          ] C time = %d us, SIMD time = %d us, gain = %4.2f\n",
+           static_cast<int>(ref_time), static_cast<int>(tst_time),
+           static_cast<double>(ref_time) / tst_time);
+  }
+
+  ResizeInterpFunc tst_fun_;
+};
+
+TEST_P(AV1ResizeInterpTest, CheckOutput) { RunCheckOutput(); }
+TEST_P(AV1ResizeInterpTest, DISABLED_Speed) { RunSpeedTest(); }
+
+#if HAVE_SSSE3
+INSTANTIATE_TEST_SUITE_P(SSSE3, AV1ResizeVertTest,
+                         ::testing::Values(av1_resize_vert_8tap_ssse3));
+INSTANTIATE_TEST_SUITE_P(SSSE3, AV1ResizeDown2Test,
+                         ::testing::Values(av1_resize_down2_horz_ssse3));
+INSTANTIATE_TEST_SUITE_P(SSSE3, AV1ResizeInterpTest,
+                         ::testing::Values(av1_resize_interp_horz_ssse3));
+#endif
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, AV1ResizeVertTest,
+                         ::testing::Values(av1_resize_vert_8tap_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, AV1ResizeDown2Test,
+                         ::testing::Values(av1_resize_down2_horz_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, AV1ResizeInterpTest,
+                         ::testing::Values(av1_resize_interp_horz_avx2));
+#endif
+
+}  // namespace
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+
+#include "aom_ports/aom_timer.h"
+#include "aom_util/aom_job_scheduler.h"
+#include "aom_util/aom_thread.h"
+
+namespace {
+
+const int kMaxWorkers = 32;
+
+class JobSchedulerTest : public ::testing::TestWithParam<int> {
+ protected:
+  struct WorkerData {
+    JobSchedulerTest *test;
+    int queue;
+  };
+
+  virtual void SetUp() {
+    num_workers_ = GetParam();
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) {
+      winterface->init(&workers_[i]);
+      // The last worker is run on the calling thread.
+      if (i < num_workers_ - 1) {
+        ASSERT_TRUE(winterface->reset(&workers_[i]));
+      }
+      worker_data_[i].test = this;
+      worker_data_[i].queue = i;
+    }
+    ASSERT_EQ(0, aom_job_scheduler_alloc(&sched_, num_workers_));
+#if CONFIG_MULTITHREAD
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&cond_, NULL);
+#endif
+  }
+
+  virtual void TearDown() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) winterface->end(&workers_[i]);
+    aom_job_scheduler_free(&sched_);
+#if CONFIG_MULTITHREAD
+    pthread_mutex_destroy(&mutex_);
+    pthread_cond_destroy(&cond_);
+#endif
+  }
+
+  // Runs hook on all the workers, with a WorkerData as first argument.
+  void RunWorkers(AVxWorkerHook hook) {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) {
+      workers_[i].hook = hook;
+      workers_[i].data1 = &worker_data_[i];
+      workers_[i].data2 = NULL;
+      if (i == num_workers_ - 1) {
+        winterface->execute(&workers_[i]);
+      } else {
+        winterface->launch(&workers_[i]);
+      }
+    }
+    for (int i = 0; i < num_workers_; ++i) {
+      EXPECT_TRUE(winterface->sync(&workers_[i]));
+    }
+  }
+
+  static int CountJobs(void *arg1, void *) {
+    WorkerData *const data = (WorkerData *)arg1;
+    JobSchedulerTest *const test = data->test;
+    int job;
+    while ((job = aom_job_scheduler_get_job(&test->sched_, data->queue)) >= 0) {
+      // Each job is only handed out once, so there is no race.
+      test->counts_[job]++;
+      if (job == test->cancel_job_) aom_job_scheduler_cancel(&test->sched_);
+    }
+    return 1;
+  }
+
+  // Each job waits for the previous one, as the row-synchronized stages do.
+  static int ChainJobs(void *arg1, void *) {
+    WorkerData *const data = (WorkerData *)arg1;
+    JobSchedulerTest *const test = data->test;
+    int job;
+    while ((job = aom_job_scheduler_get_job(&test->sched_, data->queue)) >= 0) {
+#if CONFIG_MULTITHREAD
+      pthread_mutex_lock(&test->mutex_);
+      while (test->jobs_done_ < job) {
+        pthread_cond_wait(&test->cond_, &test->mutex_);
+      }
+#endif
+      test->counts_[job]++;
+      test->jobs_done_ = job + 1;
+#if CONFIG_MULTITHREAD
+      pthread_cond_broadcast(&test->cond_);
+      pthread_mutex_unlock(&test->mutex_);
+#endif
+    }
+    return 1;
+  }
+
+  static int EmptyJobs(void *arg1, void *) {
+    WorkerData *const data = (WorkerData *)arg1;
+    while (aom_job_scheduler_get_job(&data->test->sched_, data->queue) >= 0) {
+    }
+    return 1;
+  }
+
+  // The single mutex-protected queue the scheduler replaces.
+  static int EmptyJobsSingleQueue(void *arg1, void *) {
+    WorkerData *const data = (WorkerData *)arg1;
+    JobSchedulerTest *const test = data->test;
+    while (1) {
+      int job = -1;
+#if CONFIG_MULTITHREAD
+      pthread_mutex_lock(&test->mutex_);
+#endif
+      if (test->jobs_done_ < test->num_jobs_) job = test->jobs_done_++;
+#if CONFIG_MULTITHREAD
+      pthread_mutex_unlock(&test->mutex_);
+#endif
+      if (job < 0) break;
+    }
+    return 1;
+  }
+
+  void ResetJobs(int num_jobs) {
+    num_jobs_ = num_jobs;
+    jobs_done_ = 0;
+    cancel_job_ = -1;
+    counts_.assign(num_jobs, 0);
+    aom_job_scheduler_reset(&sched_, num_jobs, num_workers_);
+  }
+
+  int num_workers_;
+  AVxWorker workers_[kMaxWorkers];
+  WorkerData worker_data_[kMaxWorkers];
+  AVxJobScheduler sched_;
+#if CONFIG_MULTITHREAD
+  pthread_mutex_t mutex_;
+  pthread_cond_t cond_;
+#endif
+  int num_jobs_;
+  int jobs_done_;
+  int cancel_job_;
+  std::vector<int> counts_;
+};
+
+TEST_P(JobSchedulerTest, RunsEachJobOnce) {
+  const int kNumJobs[] = { 0, 1, 7, 64, 1000 };
+  for (int num_jobs : kNumJobs) {
+    ResetJobs(num_jobs);
+    RunWorkers(CountJobs);
+    for (int i = 0; i < num_jobs; ++i) {
+      ASSERT_EQ(1, counts_[i]) << "job " << i << " of " << num_jobs;
+    }
+  }
+}
+
+TEST_P(JobSchedulerTest, DependentJobs) {
+  const int kNumJobs[] = { 1, 7, 64, 1000 };
+  for (int num_jobs : kNumJobs) {
+    ResetJobs(num_jobs);
+    RunWorkers(ChainJobs);
+    ASSERT_EQ(num_jobs, jobs_done_);
+    for (int i = 0; i < num_jobs; ++i) {
+      ASSERT_EQ(1, counts_[i]) << "job " << i << " of " << num_jobs;
+    }
+  }
+}
+
+TEST_P(JobSchedulerTest, Cancel) {
+  ResetJobs(1000);
+  cancel_job_ = 10;
+  RunWorkers(CountJobs);
+  EXPECT_EQ(1, counts_[cancel_job_]);
+  for (int i = 0; i < num_jobs_; ++i) ASSERT_LE(counts_[i], 1);
+
+  // The scheduler is usable again after a reset.
+  ResetJobs(100);
+  RunWorkers(CountJobs);
+  for (int i = 0; i < num_jobs_; ++i) ASSERT_EQ(1, counts_[i]);
+}
+
+// Scheduling overhead per job, compared to a single mutex-protected queue.
+TEST_P(JobSchedulerTest, DISABLED_Speed) {
+  const int kNumJobs = 1000000;
+  aom_usec_timer timer;
+
+  ResetJobs(kNumJobs);
+  aom_usec_timer_start(&timer);
+  RunWorkers(EmptyJobsSingleQueue);
+  aom_usec_timer_mark(&timer);
+  const int64_t single_time = aom_usec_timer_elapsed(&timer);
+
+  ResetJobs(kNumJobs);
+  aom_usec_timer_start(&timer);
+  RunWorkers(EmptyJobs);
+  aom_usec_timer_mark(&timer);
+  const int64_t sched_time = aom_usec_timer_elapsed(&timer);
+
+  printf("%2d workers: single queue %.1f ns/job, scheduler %.1f ns/job\n",
+         num_workers_, 1000.0 * single_time / kNumJobs,
+         1000.0 * sched_time / kNumJobs);
+}
+
+INSTANTIATE_TEST_SUITE_P(AomUtil, JobSchedulerTest,
+                         ::testing::Values(1, 2, 3, 8, kMaxWorkers));
+
+}  // namespace
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+#include "config/aom_dsp_rtcd.h"
+
+#include "aom_ports/aom_timer.h"
+#include "test/acm_random.h"
+#include "test/clear_system_state.h"
+#include "test/register_state_check.h"
+#include "test/util.h"
+
+namespace {
+
+using libaom_test::ACMRandom;
+
+const int kTestIters = 1000;
+const int kPerfIters = 100000;
+
+// Returns a random pixel of bd bits, a third of which are 0 or the maximum.
+int RandomPixel(ACMRandom *rnd, int bd) {
+  const int pix_max = (1 << bd) - 1;
+  if (rnd->PseudoUniform(3) == 0) return pix_max * (rnd->Rand8() & 1);
+  return rnd->Rand16() & pix_max;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SSIM window sums
+/////////////////////////////////////////////////////////////////////////////
+
+typedef void (*SsimParmsFunc)(const uint8_t *s, int sp, const uint8_t *r,
+                              int rp, uint32_t *sum_s, uint32_t *sum_r,
+                              uint32_t *sum_sq_s, uint32_t *sum_sq_r,
+                              uint32_t *sum_sxr);
+
+class SsimParmsTest : public ::testing::TestWithParam<SsimParmsFunc> {
+ public:
+  virtual ~SsimParmsTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  static const int kStride = 24;
+  SsimParmsFunc tst_fun_;
+};
+
+TEST_P(SsimParmsTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  uint8_t s[8 * kStride], r[8 * kStride];
+  for (int iter = 0; iter < kTestIters; ++iter) {
+    for (int i = 0; i < 8 * kStride; ++i) {
+      s[i] = RandomPixel(&rnd, 8);
+      r[i] = RandomPixel(&rnd, 8);
+    }
+    const int sp = 8 + rnd.PseudoUniform(kStride - 7);
+    const int rp = 8 + rnd.PseudoUniform(kStride - 7);
+    // The sums are accumulated to the outputs.
+    uint32_t ref[5], tst[5];
+    for (int k = 0; k < 5; ++k) ref[k] = tst[k] = rnd.Rand16();
+    aom_ssim_parms_8x8_c(s, sp, r, rp, &ref[0], &ref[1], &ref[2], &ref[3],
+                         &ref[4]);
+    ASM_REGISTER_STATE_CHECK(
+        tst_fun_(s, sp, r, rp, &tst[0], &tst[1], &tst[2], &tst[3], &tst[4]));
+    for (int k = 0; k < 5; ++k) ASSERT_EQ(ref[k], tst[k]) << "sum " << k;
+  }
+}
+
+TEST_P(SsimParmsTest, DISABLED_Speed) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  uint8_t s[8 * kStride], r[8 * kStride];
+  for (int i = 0; i < 8 * kStride; ++i) {
+    s[i] = rnd.Rand8();
+    r[i] = rnd.Rand8();
+  }
+  uint32_t sums[5] = { 0 };
+  aom_usec_timer timer;
+  aom_usec_timer_start(&timer);
+  for (int i = 0; i < kPerfIters; ++i) {
+    tst_fun_(s, kStride, r, kStride, &sums[0], &sums[1], &sums[2], &sums[3],
+             &sums[4]);
+  }
+  aom_usec_timer_mark(&timer);
+  printf("[          ] SIMD time = %d us\n",
+         static_cast<int>(aom_usec_timer_elapsed(&timer)));
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+typedef void (*HighbdSsimParmsFunc)(const uint16_t *s, int sp,
+                                    const uint16_t *r, int rp, uint32_t *sum_s,
+                                    uint32_t *sum_r, uint32_t *sum_sq_s,
+                                    uint32_t *sum_sq_r, uint32_t *sum_sxr);
+
+class HighbdSsimParmsTest
+    : public ::testing::TestWithParam<std::tuple<HighbdSsimParmsFunc, int>> {
+ public:
+  virtual ~HighbdSsimParmsTest() {}
+  virtual void SetUp() {
+    tst_fun_ = std::get<0>(GetParam());
+    bd_ = std::get<1>(GetParam());
+  }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  static const int kStride = 24;
+  HighbdSsimParmsFunc tst_fun_;
+  int bd_;
+};
+
+TEST_P(HighbdSsimParmsTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  uint16_t s[8 * kStride], r[8 * kStride];
+  for (int iter = 0; iter < kTestIters; ++iter) {
+    for (int i = 0; i < 8 * kStride; ++i) {
+      s[i] = RandomPixel(&rnd, bd_);
+      r[i] = RandomPixel(&rnd, bd_);
+    }
+    const int sp = 8 + rnd.PseudoUniform(kStride - 7);
+    const int rp = 8 + rnd.PseudoUniform(kStride - 7);
+    uint32_t ref[5], tst[5];
+    for (int k = 0; k < 5; ++k) ref[k] = tst[k] = rnd.Rand16();
+    aom_highbd_ssim_parms_8x8_c(s, sp, r, rp, &ref[0], &ref[1], &ref[2],
+                                &ref[3], &ref[4]);
+    ASM_REGISTER_STATE_CHECK(
+        tst_fun_(s, sp, r, rp, &tst[0], &tst[1], &tst[2], &tst[3], &tst[4]));
+    for (int k = 0; k < 5; ++k) ASSERT_EQ(ref[k], tst[k]) << "sum " << k;
+  }
+}
+#endif  // CONFIG_AV1_HIGHBITDEPTH
+
+/////////////////////////////////////////////////////////////////////////////
+// FastSSIM pyramid
+/////////////////////////////////////////////////////////////////////////////
+
+const int kMaxFastSsimSize = 100;
+
+typedef void (*FastSsimDownsampleFunc)(const uint8_t *src, int stride,
+                                       uint32_t *dst, int w, int h);
+
+class FastSsimDownsampleTest
+    : public ::testing::TestWithParam<FastSsimDownsampleFunc> {
+ public:
+  virtual ~FastSsimDownsampleTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  FastSsimDownsampleFunc tst_fun_;
+};
+
+TEST_P(FastSsimDownsampleTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int stride = 2 * kMaxFastSsimSize + 8;
+  std::vector<uint8_t> src(stride * (2 * kMaxFastSsimSize + 1));
+  std::vector<uint32_t> ref(kMaxFastSsimSize * kMaxFastSsimSize);
+  std::vector<uint32_t> tst(kMaxFastSsimSize * kMaxFastSsimSize);
+  for (int iter = 0; iter < kTestIters / 10; ++iter) {
+    for (size_t i = 0; i < src.size(); ++i) src[i] = RandomPixel(&rnd, 8);
+    const int w = 1 + rnd.PseudoUniform(kMaxFastSsimSize);
+    const int h = 1 + rnd.PseudoUniform(kMaxFastSsimSize);
+    aom_fastssim_downsample_c(&src[0], stride, &ref[0], w, h);
+    ASM_REGISTER_STATE_CHECK(tst_fun_(&src[0], stride, &tst[0], w, h));
+    for (int i = 0; i < w * h; ++i) {
+      ASSERT_EQ(ref[i], tst[i]) << "Mismatch at " << i << " of " << w << "x"
+                                << h;
+    }
+  }
+}
+
+#if CONFIG_AV1_HIGHBITDEPTH
+typedef void (*HighbdFastSsimDownsampleFunc)(const uint16_t *src, int stride,
+                                             uint32_t *dst, int w, int h,
+                                             int shift);
+
+class HighbdFastSsimDownsampleTest
+    : public ::testing::TestWithParam<HighbdFastSsimDownsampleFunc> {
+ public:
+  virtual ~HighbdFastSsimDownsampleTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  HighbdFastSsimDownsampleFunc tst_fun_;
+};
+
+TEST_P(HighbdFastSsimDownsampleTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int stride = 2 * kMaxFastSsimSize + 8;
+  std::vector<uint16_t> src(stride * (2 * kMaxFastSsimSize + 1));
+  std::vector<uint32_t> ref(kMaxFastSsimSize * kMaxFastSsimSize);
+  std::vector<uint32_t> tst(kMaxFastSsimSize * kMaxFastSsimSize);
+  for (int iter = 0; iter < kTestIters / 10; ++iter) {
+    const int bd = rnd.PseudoUniform(2) ? 10 : 12;
+    const int shift = rnd.PseudoUniform(bd - 8 + 1);
+    for (size_t i = 0; i < src.size(); ++i) src[i] = RandomPixel(&rnd, bd);
+    const int w = 1 + rnd.PseudoUniform(kMaxFastSsimSize);
+    const int h = 1 + rnd.PseudoUniform(kMaxFastSsimSize);
+    aom_highbd_fastssim_downsample_c(&src[0], stride, &ref[0], w, h, shift);
+    ASM_REGISTER_STATE_CHECK(tst_fun_(&src[0], stride, &tst[0], w, h, shift));
+    for (int i = 0; i < w * h; ++i) {
+      ASSERT_EQ(ref[i], tst[i]) << "Mismatch at " << i << " of " << w << "x"
+                                << h << " with shift " << shift;
+    }
+  }
+}
+#endif  // CONFIG_AV1_HIGHBITDEPTH
+
+typedef void (*FastSsimDownsampleLevelFunc)(const uint32_t *src, int src_w,
+                                            uint32_t *dst, int w, int h);
+
+class FastSsimDownsampleLevelTest
+    : public ::testing::TestWithParam<FastSsimDownsampleLevelFunc> {
+ public:
+  virtual ~FastSsimDownsampleLevelTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  FastSsimDownsampleLevelFunc tst_fun_;
+};
+
+TEST_P(FastSsimDownsampleLevelTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  // An odd level reads one column and one row past its end.
+  std::vector<uint32_t> src(2 * kMaxFastSsimSize * (2 * kMaxFastSsimSize + 1) +
+                            1);
+  std::vector<uint32_t> ref(kMaxFastSsimSize * kMaxFastSsimSize);
+  std::vector<uint32_t> tst(kMaxFastSsimSize * kMaxFastSsimSize);
+  for (int iter = 0; iter < kTestIters / 10; ++iter) {
+    for (size_t i = 0; i < src.size(); ++i) src[i] = rnd.Rand31();
+    const int src_w = 1 + rnd.PseudoUniform(2 * kMaxFastSsimSize);
+    const int src_h = 1 + rnd.PseudoUniform(2 * kMaxFastSsimSize);
+    const int w = (src_w + 1) >> 1;
+    const int h = (src_h + 1) >> 1;
+    aom_fastssim_downsample_level_c(&src[0], src_w, &ref[0], w, h);
+    ASM_REGISTER_STATE_CHECK(tst_fun_(&src[0], src_w, &tst[0], w, h));
+    for (int i = 0; i < w * h; ++i) {
+      ASSERT_EQ(ref[i], tst[i]) << "Mismatch at " << i << " of " << w << "x"
+                                << h;
+    }
+  }
+}
+
+typedef void (*FastSsimGradientFunc)(const uint32_t *im, int w, uint32_t *g);
+
+class FastSsimGradientTest
+    : public ::testing::TestWithParam<FastSsimGradientFunc> {
+ public:
+  virtual ~FastSsimGradientTest() {}
+  virtual void SetUp() { tst_fun_ = GetParam(); }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  FastSsimGradientFunc tst_fun_;
+};
+
+TEST_P(FastSsimGradientTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  std::vector<uint32_t> im(2 * kMaxFastSsimSize);
+  std::vector<uint32_t> ref(kMaxFastSsimSize), tst(kMaxFastSsimSize);
+  for (int iter = 0; iter < kTestIters; ++iter) {
+    // The sums of the coarsest level of 12-bit pixels have 22 bits.
+    for (size_t i = 0; i < im.size(); ++i) im[i] = rnd.Rand31() >> 9;
+    const int w = 1 + rnd.PseudoUniform(kMaxFastSsimSize);
+    aom_fastssim_gradient_c(&im[0], w, &ref[0]);
+    ASM_REGISTER_STATE_CHECK(tst_fun_(&im[0], w, &tst[0]));
+    for (int i = 0; i < w - 1; ++i) {
+      ASSERT_EQ(ref[i], tst[i]) << "Mismatch at " << i << " of width " << w;
+    }
+  }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// PSNR-HVS blocks
+/////////////////////////////////////////////////////////////////////////////
+
+typedef double (*PsnrhvsFunc)(const int16_t *src, const int16_t *dst,
+                              const double *csf, const double *mask,
+                              int pix_max);
+typedef std::tuple<PsnrhvsFunc, PsnrhvsFunc, int> PsnrhvsParam;
+
+class PsnrhvsTest : public ::testing::TestWithParam<PsnrhvsParam> {
+ public:
+  virtual ~PsnrhvsTest() {}
+  virtual void SetUp() {
+    ref_fun_ = std::get<0>(GetParam());
+    tst_fun_ = std::get<1>(GetParam());
+    bd_ = std::get<2>(GetParam());
+  }
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  // Fills the weights like calc_psnrhvs(), from a random contrast sensitivity
+  // table.
+  void RandomWeights(ACMRandom *rnd) {
+    for (int i = 0; i < 64; ++i) csf_[i] = 0.1 + rnd->Rand16() / 20000.0;
+    for (int i = 0; i < 64; ++i) {
+      mask_[i] = (csf_[i] / csf_[8]) * (csf_[i] / csf_[8]);
+    }
+  }
+
+  // Fills the blocks with pixels of bd bits, the distorted block offset by
+  // the difference of the means of the planes, and with a random amount of
+  // texture in the source block.
+  void RandomBlocks(ACMRandom *rnd) {
+    const int pix_max = (1 << bd_) - 1;
+    const int delt = rnd->PseudoUniform(2 * pix_max / 4) - pix_max / 4;
+    const int range = 1 + rnd->PseudoUniform(pix_max);
+    const int base = rnd->PseudoUniform(pix_max - range + 1);
+    for (int i = 0; i < 64; ++i) {
+      src_[i] = rnd->PseudoUniform(3) == 0
+                    ? RandomPixel(rnd, bd_)
+                    : base + rnd->PseudoUniform(range);
+      dst_[i] = RandomPixel(rnd, bd_) + delt;
+    }
+  }
+
+  PsnrhvsFunc ref_fun_;
+  PsnrhvsFunc tst_fun_;
+  int bd_;
+  int16_t src_[64];
+  int16_t dst_[64];
+  double csf_[64];
+  double mask_[64];
+};
+
+TEST_P(PsnrhvsTest, CheckOutput) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int pix_max = (1 << bd_) - 1;
+  for (int iter = 0; iter < kTestIters; ++iter) {
+    RandomWeights(&rnd);
+    RandomBlocks(&rnd);
+    const double ref = ref_fun_(src_, dst_, csf_, mask_, pix_max);
+    double tst;
+    ASM_REGISTER_STATE_CHECK(tst = tst_fun_(src_, dst_, csf_, mask_, pix_max));
+    // Only the order of the floating point sums differs.
+    ASSERT_NEAR(ref, tst, 1e-9 * std::fabs(ref) + 1e-9) << "iter " << iter;
+  }
+}
+
+TEST_P(PsnrhvsTest, DISABLED_Speed) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int pix_max = (1 << bd_) - 1;
+  RandomWeights(&rnd);
+  RandomBlocks(&rnd);
+  double sum = 0;
+
+  aom_usec_timer ref_timer;
+  aom_usec_timer_start(&ref_timer);
+  for (int i = 0; i < kPerfIters; ++i) {
+    sum += ref_fun_(src_, dst_, csf_, mask_, pix_max);
+  }
+  aom_usec_timer_mark(&ref_timer);
+  const int64_t ref_time = aom_usec_timer_elapsed(&ref_timer);
+
+  aom_usec_timer tst_timer;
+  aom_usec_timer_start(&tst_timer);
+  for (int i = 0; i < kPerfIters; ++i) {
+    sum += tst_fun_(src_, dst_, csf_, mask_, pix_max);
+  }
+  aom_usec_timer_mark(&tst_timer);
+  const int64_t tst_time = aom_usec_timer_elapsed(&tst_timer);
+
+  printf("[          ] C time = %d us, SIMD time = %d us, gain = %4.2f (%g)\n",
+         static_cast<int>(ref_time), static_cast<int>(tst_time),
+         static_cast<double>(ref_time) / tst_time, sum);
+}
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, SsimParmsTest,
+                         ::testing::Values(aom_ssim_parms_8x8_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, FastSsimDownsampleTest,
+                         ::testing::Values(aom_fastssim_downsample_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, FastSsimDownsampleLevelTest,
+                         ::testing::Values(aom_fastssim_downsample_level_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, FastSsimGradientTest,
+                         ::testing::Values(aom_fastssim_gradient_avx2));
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, PsnrhvsTest,
+    ::testing::Values(
+        PsnrhvsParam(aom_psnrhvs_8x8_c, aom_psnrhvs_8x8_avx2, 8)
+#if CONFIG_AV1_HIGHBITDEPTH
+            ,
+        PsnrhvsParam(aom_highbd_psnrhvs_8x8_c, aom_highbd_psnrhvs_8x8_avx2, 10),
+        PsnrhvsParam(aom_highbd_psnrhvs_8x8_c, aom_highbd_psnrhvs_8x8_avx2, 12)
+#endif
+            ));
+
+#if CONFIG_AV1_HIGHBITDEPTH
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, HighbdSsimParmsTest,
+    ::testing::Combine(::testing::Values(aom_highbd_ssim_parms_8x8_avx2),
+                       ::testing::Values(8, 10, 12)));
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, HighbdFastSsimDownsampleTest,
+    ::testing::Values(aom_highbd_fastssim_downsample_avx2));
+#endif  // CONFIG_AV1_HIGHBITDEPTH
+#endif  // HAVE_AVX2
+
+}  // namespace
@@ -1336,8 +1336,190 @@ TYPED_TEST_P(WienerDenoiseTest, GradientTest) {
   }
 }
 
+// Checks that splitting the block rows between several workers gives the same
+// flat blocks and denoised planes as a single thread.
+TYPED_TEST_P(WienerDenoiseTest, MatchesSingleThread) {
+  const int kWidth = this->kWidth;
+  const int kHeight = this->kHeight;
+  const int kBlockSize = this->kBlockSize;
+  const uint8_t *const data_ptrs[3] = {
+    reinterpret_cast<uint8_t *>(&this->data_[0][0]),
+    reinterpret_cast<uint8_t *>(&this->data_[1][0]),
+    reinterpret_cast<uint8_t *>(&this->data_[2][0]),
+  };
+  uint8_t *denoised_ptrs[3] = {
+    reinterpret_cast<uint8_t *>(&this->denoised_[0][0]),
+    reinterpret_cast<uint8_t *>(&this->denoised_[1][0]),
+    reinterpret_cast<uint8_t *>(&this->denoised_[2][0]),
+  };
+  ASSERT_EQ(1, aom_wiener_denoise_2d(data_ptrs, denoised_ptrs, kWidth, kHeight,
+                                     this->stride_, this->chroma_sub_,
+                                     this->noise_psd_ptrs_, kBlockSize,
+                                     this->kBitDepth, this->kUseHighBD));
+
+  aom_flat_block_finder_t flat_block_finder;
+  ASSERT_EQ(1, aom_flat_block_finder_init(&flat_block_finder, kBlockSize,
+                                          this->kBitDepth, this->kUseHighBD));
+  const int num_blocks = (kWidth / kBlockSize) * (kHeight / kBlockSize);
+  std::vector<uint8_t> flat_blocks(num_blocks);
+  const int num_flat =
+      aom_flat_block_finder_run(&flat_block_finder, data_ptrs[0], kWidth,
+                                kHeight, this->stride_[0], &flat_blocks[0]);
+
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  AVxWorker workers[8];
+  for (int i = 0; i < 8; ++i) {
+    winterface->init(&workers[i]);
+    // The first worker is run on the calling thread.
+    if (i > 0) {
+      ASSERT_TRUE(winterface->reset(&workers[i]));
+    }
+  }
+
+  const int kNumWorkers[] = { 2, 3, 8 };
+  for (const int num_workers : kNumWorkers) {
+    std::vector<typename TypeParam::data_type_t> denoised_mt[3];
+    uint8_t *denoised_mt_ptrs[3];
+    for (int c = 0; c < 3; ++c) {
+      denoised_mt[c].resize(kWidth * kHeight);
+      denoised_mt_ptrs[c] = reinterpret_cast<uint8_t *>(&denoised_mt[c][0]);
+    }
+    EXPECT_EQ(1, aom_wiener_denoise_2d_mt(
+                     data_ptrs, denoised_mt_ptrs, kWidth, kHeight,
+                     this->stride_, this->chroma_sub_, this->noise_psd_ptrs_,
+                     kBlockSize, this->kBitDepth, this->kUseHighBD, workers,
+                     num_workers));
+    for (int c = 0; c < 3; ++c) {
+      const int shift = (c > 0);
+      for (int y = 0; y < (kHeight >> shift); ++y) {
+        for (int x = 0; x < (kWidth >> shift); ++x) {
+          ASSERT_EQ(this->denoised_[c][y * this->stride_[c] + x],
+                    denoised_mt[c][y * this->stride_[c] + x])
+              << "plane " << c << " x " << x << " y " << y << " workers "
+              << num_workers;
+        }
+      }
+    }
+
+    std::vector<uint8_t> flat_blocks_mt(num_blocks);
+    EXPECT_EQ(num_flat,
+              aom_flat_block_finder_run_mt(
+                  &flat_block_finder, data_ptrs[0], kWidth, kHeight,
+                  this->stride_[0], &flat_blocks_mt[0], workers, num_workers));
+    EXPECT_EQ(flat_blocks, flat_blocks_mt) << "workers " << num_workers;
+  }
+
+  for (int i = 0; i < 8; ++i) winterface->end(&workers[i]);
+  aom_flat_block_finder_free(&flat_block_finder);
+}
+
 REGISTER_TYPED_TEST_SUITE_P(WienerDenoiseTest, InvalidBlockSize,
-                            InvalidChromaSubsampling, GradientTest);
+                            InvalidChromaSubsampling, GradientTest,
+                            MatchesSingleThread);
 
 INSTANTIATE_TYPED_TEST_SUITE_P(WienerDenoiseTestInstatiation, WienerDenoiseTest,
                                AllBitDepthParams);
+
+namespace {
+
+using libaom_test::ACMRandom;
+
+typedef void (*NoiseTxFilterCoeffsFunc)(float *coeffs, const float *psd,
+                                        int n);
+
+// Compares the Wiener gain applied to the transform coefficients by an
+// optimized version with the C version.
+class NoiseTxFilterCoeffsTest
+    : public ::testing::TestWithParam<NoiseTxFilterCoeffsFunc> {};
+
+TEST_P(NoiseTxFilterCoeffsTest, MatchesC) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int kSizes[] = { 1, 4, 5, 16, 64, 256, 1024 };
+  for (const int n : kSizes) {
+    std::vector<float> ref(2 * n), tst(2 * n), psd(n);
+    for (int iter = 0; iter < 10; ++iter) {
+      for (int i = 0; i < n; ++i) {
+        // Powers around the PSD, and some below the minimum power.
+        const float scale = (rnd.Rand8() & 3) ? 1.f : 1e-4f;
+        ref[2 * i] = (float)randn(&rnd, scale);
+        ref[2 * i + 1] = (rnd.Rand8() & 7) ? (float)randn(&rnd, scale) : 0.f;
+        psd[i] = (float)rnd.Rand16() / 65535.f * (rnd.Rand8() & 1 ? 2 : 1e-6f);
+      }
+      tst = ref;
+      aom_noise_tx_filter_coeffs_c(&ref[0], &psd[0], n);
+      GetParam()(&tst[0], &psd[0], n);
+      for (int i = 0; i < 2 * n; ++i) {
+        ASSERT_EQ(ref[i], tst[i]) << "n " << n << " i " << i;
+      }
+    }
+  }
+}
+
+typedef void (*NoiseOverlapAddFunc)(float *dst, int dst_stride,
+                                    const float *block, const float *plane,
+                                    const float *window, int w, int h);
+
+class NoiseOverlapAddTest
+    : public ::testing::TestWithParam<NoiseOverlapAddFunc> {};
+
+TEST_P(NoiseOverlapAddTest, MatchesC) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  const int kStride = 70;
+  for (int size = 2; size <= 32; size *= 2) {
+    std::vector<float> block(size * size), plane(size * size),
+        window(size * size);
+    std::vector<float> ref(kStride * size), tst(kStride * size);
+    for (int i = 0; i < size * size; ++i) {
+      block[i] = (float)randn(&rnd, 0.1);
+      plane[i] = (float)rnd.Rand16() / 65535.f;
+      window[i] = (float)rnd.Rand16() / 65535.f;
+    }
+    for (int i = 0; i < kStride * size; ++i) {
+      ref[i] = (float)rnd.Rand16() / 65535.f;
+    }
+    tst = ref;
+    aom_noise_overlap_add_c(&ref[3], kStride, &block[0], &plane[0], &window[0],
+                            size, size);
+    GetParam()(&tst[3], kStride, &block[0], &plane[0], &window[0], size, size);
+    for (int i = 0; i < kStride * size; ++i) {
+      ASSERT_EQ(ref[i], tst[i]) << "size " << size << " i " << i;
+    }
+  }
+}
+
+typedef void (*FlatBlockGradientStatsFunc)(const double *block, int block_size,
+                                           double *sum_gxx, double *sum_gxy,
+                                           double *sum_gyy, double *sum,
+                                           double *sum_sq);
+
+class FlatBlockGradientStatsTest
+    : public ::testing::TestWithParam<FlatBlockGradientStatsFunc> {};
+
+TEST_P(FlatBlockGradientStatsTest, MatchesC) {
+  ACMRandom rnd(ACMRandom::DeterministicSeed());
+  for (int block_size = 2; block_size <= 40; ++block_size) {
+    std::vector<double> block(block_size * block_size);
+    for (int iter = 0; iter < 10; ++iter) {
+      for (auto &v : block) v = randn(&rnd, 0.05);
+      double ref[5], tst[5];
+      aom_flat_block_gradient_stats_c(&block[0], block_size, &ref[0], &ref[1],
+                                      &ref[2], &ref[3], &ref[4]);
+      GetParam()(&block[0], block_size, &tst[0], &tst[1], &tst[2], &tst[3],
+                 &tst[4]);
+      for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(ref[i], tst[i]) << "block_size " << block_size << " i " << i;
+      }
+    }
+  }
+}
+
+#if HAVE_AVX2
+INSTANTIATE_TEST_SUITE_P(AVX2, NoiseTxFilterCoeffsTest,
+                         ::testing::Values(aom_noise_tx_filter_coeffs_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, NoiseOverlapAddTest,
+                         ::testing::Values(aom_noise_overlap_add_avx2));
+INSTANTIATE_TEST_SUITE_P(AVX2, FlatBlockGradientStatsTest,
+                         ::testing::Values(aom_flat_block_gradient_stats_avx2));
+#endif  // HAVE_AVX2
+
+}  // namespace
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <stdio.h>
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+
+#include "aom_dsp/aom_dsp_common.h"
+#include "aom_ports/aom_timer.h"
+#include "aom_util/aom_row_sync.h"
+#include "aom_util/aom_thread.h"
+
+namespace {
+
+const int kMaxWorkers = 32;
+
+// Runs a wavefront over a grid of blocks: each worker processes the rows
+// worker, worker + num_workers, ..., and a block may only be processed once
+// the block above and to the right of it is done.
+class RowSyncTest : public ::testing::TestWithParam<int> {
+ protected:
+  struct WorkerData {
+    RowSyncTest *test;
+    int worker;
+    int64_t stall_time;
+  };
+
+  virtual void SetUp() {
+    num_workers_ = GetParam();
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) {
+      winterface->init(&workers_[i]);
+      // The last worker is run on the calling thread.
+      if (i < num_workers_ - 1) {
+        ASSERT_TRUE(winterface->reset(&workers_[i]));
+      }
+      worker_data_[i].test = this;
+      worker_data_[i].worker = i;
+    }
+  }
+
+  virtual void TearDown() {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) winterface->end(&workers_[i]);
+    aom_row_sync_free(&sync_);
+#if CONFIG_MULTITHREAD
+    for (size_t i = 0; i < mutexes_.size(); ++i) {
+      pthread_mutex_destroy(&mutexes_[i]);
+      pthread_cond_destroy(&conds_[i]);
+    }
+#endif
+  }
+
+  void Init(int rows, int cols, int work) {
+    rows_ = rows;
+    cols_ = cols;
+    work_ = work;
+    done_.assign(rows * cols, 0);
+    errors_ = 0;
+    aom_row_sync_free(&sync_);
+    ASSERT_EQ(0, aom_row_sync_alloc(&sync_, rows));
+    aom_row_sync_reset(&sync_, -1);
+    cur_col_.assign(rows, -1);
+#if CONFIG_MULTITHREAD
+    for (size_t i = 0; i < mutexes_.size(); ++i) {
+      pthread_mutex_destroy(&mutexes_[i]);
+      pthread_cond_destroy(&conds_[i]);
+    }
+    mutexes_.resize(rows);
+    conds_.resize(rows);
+    for (int i = 0; i < rows; ++i) {
+      pthread_mutex_init(&mutexes_[i], NULL);
+      pthread_cond_init(&conds_[i], NULL);
+    }
+#endif
+  }
+
+  // Returns the total time the workers spent waiting, in microseconds.
+  int64_t RunWorkers(AVxWorkerHook hook) {
+    const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+    for (int i = 0; i < num_workers_; ++i) {
+      worker_data_[i].stall_time = 0;
+      workers_[i].hook = hook;
+      workers_[i].data1 = &worker_data_[i];
+      workers_[i].data2 = NULL;
+      if (i == num_workers_ - 1) {
+        winterface->execute(&workers_[i]);
+      } else {
+        winterface->launch(&workers_[i]);
+      }
+    }
+    int64_t stall_time = 0;
+    for (int i = 0; i < num_workers_; ++i) {
+      EXPECT_TRUE(winterface->sync(&workers_[i]));
+      stall_time += worker_data_[i].stall_time;
+    }
+    return stall_time;
+  }
+
+  void ProcessBlock(int r, int c) {
+    // The block above and to the right must be done, and this one not yet.
+    if (r > 0 && !done_[(r - 1) * cols_ + AOMMIN(c + 1, cols_ - 1)]) {
+      ++errors_;
+    }
+    if (done_[r * cols_ + c]) ++errors_;
+    volatile int sum = 0;
+    for (int i = 0; i < work_; ++i) sum += i;
+    done_[r * cols_ + c] = 1;
+  }
+
+  static int RowSyncHook(void *arg1, void *) {
+    WorkerData *const data = (WorkerData *)arg1;
+    RowSyncTest *const test = data->test;
+    aom_usec_timer timer;
+    for (int r = data->worker; r < test->rows_; r += test->num_workers_) {
+      for (int c = 0; c < test->cols_; ++c) {
+        if (r > 0) {
+          aom_usec_timer_start(&timer);
+          aom_row_sync_wait(&test->sync_, r - 1, c + 1);
+          aom_usec_timer_mark(&timer);
+          data->stall_time += aom_usec_timer_elapsed(&timer);
+        }
+        test->ProcessBlock(r, c);
+        aom_row_sync_set(&test->sync_, r,
+                         c < test->cols_ - 1 ? c : test->cols_ + 1);
+      }
+    }
+    return 1;
+  }
+
+  // The mutex and condition variable per row which AVxRowSync replaces.
+  static int MutexHook(void *arg1, void *) {
+    WorkerData *const data = (WorkerData *)arg1;
+    RowSyncTest *const test = data->test;
+    aom_usec_timer timer;
+    for (int r = data->worker; r < test->rows_; r += test->num_workers_) {
+      for (int c = 0; c < test->cols_; ++c) {
+#if CONFIG_MULTITHREAD
+        if (r > 0) {
+          aom_usec_timer_start(&timer);
+          pthread_mutex_lock(&test->mutexes_[r - 1]);
+          while (c + 1 > test->cur_col_[r - 1]) {
+            pthread_cond_wait(&test->conds_[r - 1], &test->mutexes_[r - 1]);
+          }
+          pthread_mutex_unlock(&test->mutexes_[r - 1]);
+          aom_usec_timer_mark(&timer);
+          data->stall_time += aom_usec_timer_elapsed(&timer);
+        }
+#endif
+        test->ProcessBlock(r, c);
+#if CONFIG_MULTITHREAD
+        pthread_mutex_lock(&test->mutexes_[r]);
+#endif
+        test->cur_col_[r] = c < test->cols_ - 1 ? c : test->cols_ + 1;
+#if CONFIG_MULTITHREAD
+        pthread_cond_signal(&test->conds_[r]);
+        pthread_mutex_unlock(&test->mutexes_[r]);
+#endif
+      }
+    }
+    (void)timer;
+    return 1;
+  }
+
+  int num_workers_;
+  AVxWorker workers_[kMaxWorkers];
+  WorkerData worker_data_[kMaxWorkers];
+  AVxRowSync sync_ = AVxRowSync();
+  std::vector<int> cur_col_;
+#if CONFIG_MULTITHREAD
+  std::vector<pthread_mutex_t> mutexes_;
+  std::vector<pthread_cond_t> conds_;
+#endif
+  int rows_;
+  int cols_;
+  int work_;
+  std::vector<int> done_;
+  int errors_;
+};
+
+TEST_P(RowSyncTest, Wavefront) {
+  const int kSizes[][2] = { { 1, 1 }, { 1, 10 }, { 10, 1 }, { 68, 120 } };
+  for (const auto &size : kSizes) {
+    Init(size[0], size[1], 0);
+    RunWorkers(RowSyncHook);
+    EXPECT_EQ(0, errors_) << size[0] << "x" << size[1];
+    for (int i = 0; i < size[0] * size[1]; ++i) ASSERT_EQ(1, done_[i]);
+  }
+}
+
+// Total and stall time of a 4K frame of 64x64 superblocks, compared to a
+// mutex and a condition variable per row.
+TEST_P(RowSyncTest, DISABLED_Speed) {
+  const int kRows = 34;
+  const int kCols = 60;
+  const int kWork = 2000;
+  const int kRuns = 20;
+  aom_usec_timer timer;
+  int64_t mutex_stall = 0, sync_stall = 0;
+
+  aom_usec_timer_start(&timer);
+  for (int i = 0; i < kRuns; ++i) {
+    Init(kRows, kCols, kWork);
+    mutex_stall += RunWorkers(MutexHook);
+  }
+  aom_usec_timer_mark(&timer);
+  const int64_t mutex_time = aom_usec_timer_elapsed(&timer);
+  EXPECT_EQ(0, errors_);
+
+  aom_usec_timer_start(&timer);
+  for (int i = 0; i < kRuns; ++i) {
+    Init(kRows, kCols, kWork);
+    sync_stall += RunWorkers(RowSyncHook);
+  }
+  aom_usec_timer_mark(&timer);
+  const int64_t sync_time = aom_usec_timer_elapsed(&timer);
+  EXPECT_EQ(0, errors_);
+
+  printf("%2d workers: mutex %6d us (stall %7d us), row sync %6d us (stall "
+         "%7d us)\n",
+         num_workers_, (int)(mutex_time / kRuns), (int)(mutex_stall / kRuns),
+         (int)(sync_time / kRuns), (int)(sync_stall / kRuns));
+}
+
+INSTANTIATE_TEST_SUITE_P(AomUtil, RowSyncTest,
+                         ::testing::Values(1, 2, 3, 8, 16, kMaxWorkers));
+
+}  // namespace
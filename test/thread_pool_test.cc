@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2020, Alliance for Open Media. All rights reserved
+ *
+ * This source code is subject to the terms of the BSD 2 Clause License and
+ * the Alliance for Open Media Patent License 1.0. If the BSD 2 Clause License
+ * was not distributed with this source code in the LICENSE file, you can
+ * obtain it at www.aomedia.org/license/software. If the Alliance for Open
+ * Media Patent License 1.0 was not distributed with this source code in the
+ * PATENTS file, you can obtain it at www.aomedia.org/license/patent.
+ */
+
+#include <string>
+#include <vector>
+
+#include "third_party/googletest/src/googletest/include/gtest/gtest.h"
+
+#include "config/aom_config.h"
+
+#include "aom/aom_decoder.h"
+#include "aom/aom_encoder.h"
+#include "aom/aom_thread_pool.h"
+#include "aom/aomcx.h"
+#include "aom/aomdx.h"
+#include "aom_util/aom_thread.h"
+#include "test/acm_random.h"
+#include "test/md5_helper.h"
+
+namespace {
+
+const int kWidth = 352;
+const int kHeight = 288;
+const int kNumFrames = 4;
+const int kNumThreads = 4;
+const int kNumEncoders = 2;
+
+typedef std::vector<std::vector<uint8_t> > FrameList;
+
+int AddOne(void *arg1, void *) {
+  ++*(int *)arg1;
+  return 1;
+}
+
+TEST(ThreadPoolTest, InvalidParams) {
+  EXPECT_EQ(NULL, aom_thread_pool_create(0));
+  EXPECT_EQ(NULL, aom_thread_pool_create(-1));
+  aom_thread_pool_destroy(NULL);
+}
+
+// More workers than pool threads, each launched many times.
+TEST(ThreadPoolTest, Workers) {
+  const int kNumWorkers = 8;
+  const int kNumRuns = 100;
+  const AVxWorkerInterface *const winterface = aom_get_worker_interface();
+  aom_thread_pool_t *const pool = aom_thread_pool_create(2);
+  ASSERT_NE(pool, nullptr);
+
+  AVxWorker workers[kNumWorkers];
+  int counts[kNumWorkers] = { 0 };
+  for (int i = 0; i < kNumWorkers; ++i) {
+    winterface->init(&workers[i]);
+    workers[i].pool = pool;
+    ASSERT_TRUE(winterface->reset(&workers[i]));
+    workers[i].hook = AddOne;
+    workers[i].data1 = &counts[i];
+    workers[i].data2 = NULL;
+  }
+  for (int run = 0; run < kNumRuns; ++run) {
+    for (int i = 0; i < kNumWorkers - 1; ++i) winterface->launch(&workers[i]);
+    winterface->execute(&workers[kNumWorkers - 1]);
+    for (int i = 0; i < kNumWorkers; ++i) {
+      EXPECT_TRUE(winterface->sync(&workers[i]));
+    }
+  }
+  // A worker may also be ended while its hook is queued or running.
+  for (int i = 0; i < kNumWorkers; ++i) winterface->launch(&workers[i]);
+  for (int i = 0; i < kNumWorkers; ++i) winterface->end(&workers[i]);
+  aom_thread_pool_destroy(pool);
+
+  for (int i = 0; i < kNumWorkers; ++i) EXPECT_EQ(kNumRuns + 1, counts[i]);
+}
+
+// Moving gradient with some noise, so that the encoder finds some motion.
+void FillFrame(aom_image_t *img, int frame, libaom_test::ACMRandom *rnd) {
+  for (int plane = 0; plane < 3; ++plane) {
+    const int w = plane ? (kWidth + 1) >> 1 : kWidth;
+    const int h = plane ? (kHeight + 1) >> 1 : kHeight;
+    for (int y = 0; y < h; ++y) {
+      uint8_t *const row = img->planes[plane] + y * img->stride[plane];
+      for (int x = 0; x < w; ++x) {
+        row[x] = (uint8_t)(((x + y + 2 * frame) & 0xff) >> (plane ? 1 : 0));
+        row[x] += rnd->Rand8() & 7;
+      }
+    }
+  }
+}
+
+class ThreadPoolEncodeTest : public ::testing::Test {
+ protected:
+  // Encodes the same frames with all the encoders at the same time, each
+  // frame with all the encoders before the next one. Returns the md5 of the
+  // output of the first encoder, and checks that the other encoders give the
+  // same output.
+  std::string Encode(aom_thread_pool_t *pool, int num_encoders,
+                     FrameList *frames) {
+    aom_codec_iface_t *const iface = aom_codec_av1_cx();
+    aom_codec_enc_cfg_t cfg;
+    EXPECT_EQ(AOM_CODEC_OK, aom_codec_enc_config_default(iface, &cfg, 0));
+    cfg.g_w = kWidth;
+    cfg.g_h = kHeight;
+    cfg.g_threads = kNumThreads;
+    cfg.g_lag_in_frames = 0;
+    cfg.rc_target_bitrate = 500;
+
+    std::vector<aom_codec_ctx_t> enc(num_encoders);
+    for (aom_codec_ctx_t &ctx : enc) {
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_enc_init(&ctx, iface, &cfg, 0));
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_control(&ctx, AOME_SET_CPUUSED, 6));
+      EXPECT_EQ(AOM_CODEC_OK,
+                aom_codec_control(&ctx, AV1E_SET_TILE_COLUMNS, 1));
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_control(&ctx, AV1E_SET_ROW_MT, 1));
+      if (pool != NULL) {
+        EXPECT_EQ(AOM_CODEC_OK,
+                  aom_codec_control(&ctx, AV1_SET_THREAD_POOL, pool));
+      }
+    }
+
+    aom_image_t img;
+    EXPECT_NE(aom_img_alloc(&img, AOM_IMG_FMT_I420, kWidth, kHeight, 32),
+              nullptr);
+    libaom_test::ACMRandom rnd(libaom_test::ACMRandom::DeterministicSeed());
+    std::vector<libaom_test::MD5> md5(num_encoders);
+    frames->clear();
+    for (int frame = 0; frame <= kNumFrames; ++frame) {
+      if (frame < kNumFrames) FillFrame(&img, frame, &rnd);
+      for (int i = 0; i < num_encoders; ++i) {
+        EXPECT_EQ(AOM_CODEC_OK,
+                  aom_codec_encode(&enc[i], frame < kNumFrames ? &img : NULL,
+                                   frame, 1, 0));
+        aom_codec_iter_t iter = NULL;
+        const aom_codec_cx_pkt_t *pkt;
+        while ((pkt = aom_codec_get_cx_data(&enc[i], &iter)) != NULL) {
+          if (pkt->kind != AOM_CODEC_CX_FRAME_PKT) continue;
+          const uint8_t *const buf = (const uint8_t *)pkt->data.frame.buf;
+          md5[i].Add(buf, pkt->data.frame.sz);
+          if (i == 0) frames->emplace_back(buf, buf + pkt->data.frame.sz);
+        }
+      }
+    }
+    aom_img_free(&img);
+
+    if (pool != NULL) {
+      // The workers are already created.
+      EXPECT_EQ(AOM_CODEC_ERROR,
+                aom_codec_control(&enc[0], AV1_SET_THREAD_POOL, pool));
+    }
+    for (aom_codec_ctx_t &ctx : enc) {
+      EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&ctx));
+    }
+    const std::string result = md5[0].Get();
+    for (int i = 1; i < num_encoders; ++i) EXPECT_EQ(result, md5[i].Get());
+    return result;
+  }
+
+  std::string Decode(aom_thread_pool_t *pool, int threads,
+                     const FrameList &frames) {
+    aom_codec_dec_cfg_t cfg = aom_codec_dec_cfg_t();
+    cfg.threads = threads;
+    cfg.allow_lowbitdepth = 1;
+    aom_codec_ctx_t dec;
+    EXPECT_EQ(AOM_CODEC_OK,
+              aom_codec_dec_init(&dec, aom_codec_av1_dx(), &cfg, 0));
+    if (pool != NULL) {
+      EXPECT_EQ(AOM_CODEC_OK,
+                aom_codec_control(&dec, AV1_SET_THREAD_POOL, pool));
+    }
+    libaom_test::MD5 md5;
+    for (const std::vector<uint8_t> &frame : frames) {
+      EXPECT_EQ(AOM_CODEC_OK,
+                aom_codec_decode(&dec, frame.data(), frame.size(), NULL));
+      aom_codec_iter_t iter = NULL;
+      const aom_image_t *img;
+      while ((img = aom_codec_get_frame(&dec, &iter)) != NULL) md5.Add(img);
+    }
+    EXPECT_EQ(AOM_CODEC_OK, aom_codec_destroy(&dec));
+    return md5.Get();
+  }
+};
+
+TEST_F(ThreadPoolEncodeTest, MD5Match) {
+  FrameList frames;
+  const std::string enc_md5 = Encode(NULL, 1, &frames);
+  const std::string dec_md5 = Decode(NULL, 1, frames);
+  ASSERT_FALSE(frames.empty());
+
+  // A pool with fewer threads than each encoder and decoder uses.
+  for (int pool_threads : { 1, kNumThreads - 1 }) {
+    SCOPED_TRACE(pool_threads);
+    aom_thread_pool_t *const pool = aom_thread_pool_create(pool_threads);
+    ASSERT_NE(pool, nullptr);
+    FrameList pool_frames;
+    EXPECT_EQ(enc_md5, Encode(pool, kNumEncoders, &pool_frames));
+    EXPECT_EQ(dec_md5, Decode(pool, kNumThreads, frames));
+    aom_thread_pool_destroy(pool);
+  }
+}
+
+}  // namespace
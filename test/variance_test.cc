@@ -53,6 +53,11 @@ typedef uint32_t (*ObmcSubpelVarFunc)(const uint8_t *pre, int pre_stride,
                                       int xoffset, int yoffset,
                                       const int32_t *wsrc, const int32_t *mask,
                                       unsigned int *sse);
+typedef uint64_t (*MseWxH16bitFunc)(uint8_t *dst, int dstride, uint16_t *src,
+                                    int sstride, int w, int h);
+typedef uint64_t (*MseWxH16bitHBDFunc)(uint16_t *dst, int dstride,
+                                       uint16_t *src, int sstride, int w,
+                                       int h);
 
 using libaom_test::ACMRandom;
 
@@ -656,6 +661,74 @@ void MainTestClass<FunctionType>::MaxTestSse() {
   EXPECT_EQ(expected, var);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Tests of the distortion of the CDEF search, between the blocks of a frame
+// and the 16-bit blocks filtered from them.
+
+template <typename Pixel, typename FunctionType>
+class MseWxHTestClass
+    : public ::testing::TestWithParam<TestParams<FunctionType> > {
+ public:
+  virtual void SetUp() {
+    params_ = this->GetParam();
+    rnd_.Reset(ACMRandom::DeterministicSeed());
+  }
+
+  virtual void TearDown() { libaom_test::ClearSystemState(); }
+
+ protected:
+  // The blocks of the frame are read with the stride of a frame and the
+  // filtered blocks with their width.
+  static const int kDstStride = 72;
+
+  void RefMatchTest();
+  void MaxTest();
+
+  ACMRandom rnd_;
+  TestParams<FunctionType> params_;
+  Pixel dst_[kDstStride * 8];
+  uint16_t src_[8 * 8];
+};
+
+template <typename Pixel, typename FunctionType>
+void MseWxHTestClass<Pixel, FunctionType>::RefMatchTest() {
+  const int w = params_.width;
+  const int h = params_.height;
+  for (int i = 0; i < 100; ++i) {
+    for (int j = 0; j < kDstStride * h; ++j) {
+      dst_[j] = static_cast<Pixel>(rnd_.Rand16() & params_.mask);
+    }
+    for (int j = 0; j < w * h; ++j) {
+      src_[j] = static_cast<uint16_t>(rnd_.Rand16() & params_.mask);
+    }
+    uint64_t expected = 0;
+    for (int r = 0; r < h; ++r) {
+      for (int c = 0; c < w; ++c) {
+        const int64_t e = dst_[r * kDstStride + c] - src_[r * w + c];
+        expected += e * e;
+      }
+    }
+    uint64_t mse;
+    ASM_REGISTER_STATE_CHECK(
+        mse = params_.func(dst_, kDstStride, src_, w, w, h));
+    EXPECT_EQ(expected, mse) << "iteration " << i;
+  }
+}
+
+template <typename Pixel, typename FunctionType>
+void MseWxHTestClass<Pixel, FunctionType>::MaxTest() {
+  const int w = params_.width;
+  const int h = params_.height;
+  for (int j = 0; j < kDstStride * h; ++j) {
+    dst_[j] = static_cast<Pixel>(params_.mask);
+  }
+  for (int j = 0; j < w * h; ++j) src_[j] = 0;
+  uint64_t mse;
+  ASM_REGISTER_STATE_CHECK(mse =
+                               params_.func(dst_, kDstStride, src_, w, w, h));
+  EXPECT_EQ((uint64_t)params_.block_size * params_.mask * params_.mask, mse);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 using std::get;
@@ -1078,6 +1151,7 @@ typedef SubpelVarianceTest<SubpixAvgVarMxNFunc> AvxSubpelAvgVarianceTest;
 typedef SubpelVarianceTest<DistWtdSubpixAvgVarMxNFunc>
     AvxDistWtdSubpelAvgVarianceTest;
 typedef ObmcVarianceTest<ObmcSubpelVarFunc> AvxObmcSubpelVarianceTest;
+typedef MseWxHTestClass<uint8_t, MseWxH16bitFunc> AvxMseWxHTest;
 
 TEST_P(AvxSseTest, RefSse) { RefTestSse(); }
 TEST_P(AvxSseTest, MaxSse) { MaxTestSse(); }
@@ -1098,6 +1172,8 @@ TEST_P(AvxDistWtdSubpelAvgVarianceTest, Ref) { RefTest(); }
 TEST_P(AvxObmcSubpelVarianceTest, Ref) { RefTest(); }
 TEST_P(AvxObmcSubpelVarianceTest, ExtremeRef) { ExtremeRefTest(); }
 TEST_P(AvxObmcSubpelVarianceTest, DISABLED_Speed) { SpeedTest(); }
+TEST_P(AvxMseWxHTest, RefMatch) { RefMatchTest(); }
+TEST_P(AvxMseWxHTest, Max) { MaxTest(); }
 
 INSTANTIATE_TEST_SUITE_P(C, SumOfSquaresTest,
                          ::testing::Values(aom_get_mb_ss_c));
@@ -1114,6 +1190,14 @@ INSTANTIATE_TEST_SUITE_P(C, AvxMseTest,
                                            MseParams(3, 4, &aom_mse8x16_c),
                                            MseParams(3, 3, &aom_mse8x8_c)));
 
+typedef TestParams<MseWxH16bitFunc> MseWxHParams;
+INSTANTIATE_TEST_SUITE_P(
+    C, AvxMseWxHTest,
+    ::testing::Values(MseWxHParams(3, 3, &aom_mse_wxh_16bit_c),
+                      MseWxHParams(3, 2, &aom_mse_wxh_16bit_c),
+                      MseWxHParams(2, 3, &aom_mse_wxh_16bit_c),
+                      MseWxHParams(2, 2, &aom_mse_wxh_16bit_c)));
+
 typedef TestParams<VarianceMxNFunc> VarianceParams;
 INSTANTIATE_TEST_SUITE_P(
     C, AvxVarianceTest,
@@ -1275,9 +1359,12 @@ typedef MainTestClass<VarianceMxNFunc> AvxHBDVarianceTest;
 typedef SubpelVarianceTest<SubpixVarMxNFunc> AvxHBDSubpelVarianceTest;
 typedef SubpelVarianceTest<SubpixAvgVarMxNFunc> AvxHBDSubpelAvgVarianceTest;
 typedef ObmcVarianceTest<ObmcSubpelVarFunc> AvxHBDObmcSubpelVarianceTest;
+typedef MseWxHTestClass<uint16_t, MseWxH16bitHBDFunc> AvxHBDMseWxHTest;
 
 TEST_P(AvxHBDMseTest, RefMse) { RefTestMse(); }
 TEST_P(AvxHBDMseTest, MaxMse) { MaxTestMse(); }
+TEST_P(AvxHBDMseWxHTest, RefMatch) { RefMatchTest(); }
+TEST_P(AvxHBDMseWxHTest, Max) { MaxTest(); }
 TEST_P(AvxHBDVarianceTest, Zero) { ZeroTest(); }
 TEST_P(AvxHBDVarianceTest, Ref) { RefTest(); }
 TEST_P(AvxHBDVarianceTest, RefStride) { RefStrideTest(); }
@@ -1377,6 +1464,14 @@ const VarianceParams kArrayHBDVariance_c[] = {
 INSTANTIATE_TEST_SUITE_P(C, AvxHBDVarianceTest,
                          ::testing::ValuesIn(kArrayHBDVariance_c));
 
+typedef TestParams<MseWxH16bitHBDFunc> MseWxHHBDParams;
+INSTANTIATE_TEST_SUITE_P(
+    C, AvxHBDMseWxHTest,
+    ::testing::Values(MseWxHHBDParams(3, 3, &aom_mse_wxh_16bit_highbd_c, 12),
+                      MseWxHHBDParams(3, 2, &aom_mse_wxh_16bit_highbd_c, 12),
+                      MseWxHHBDParams(2, 3, &aom_mse_wxh_16bit_highbd_c, 12),
+                      MseWxHHBDParams(2, 2, &aom_mse_wxh_16bit_highbd_c, 12)));
+
 #if HAVE_SSE4_1
 INSTANTIATE_TEST_SUITE_P(
     SSE4_1, AvxHBDVarianceTest,
@@ -1699,6 +1794,13 @@ INSTANTIATE_TEST_SUITE_P(SSE2, AvxMseTest,
                                            MseParams(3, 4, &aom_mse8x16_sse2),
                                            MseParams(3, 3, &aom_mse8x8_sse2)));
 
+INSTANTIATE_TEST_SUITE_P(
+    SSE2, AvxMseWxHTest,
+    ::testing::Values(MseWxHParams(3, 3, &aom_mse_wxh_16bit_sse2),
+                      MseWxHParams(3, 2, &aom_mse_wxh_16bit_sse2),
+                      MseWxHParams(2, 3, &aom_mse_wxh_16bit_sse2),
+                      MseWxHParams(2, 2, &aom_mse_wxh_16bit_sse2)));
+
 INSTANTIATE_TEST_SUITE_P(
     SSE2, AvxVarianceTest,
     ::testing::Values(VarianceParams(7, 7, &aom_variance128x128_sse2),
@@ -1825,6 +1927,16 @@ INSTANTIATE_TEST_SUITE_P(
                       MseParams(3, 3, &aom_highbd_8_mse8x8_sse2)));
 */
 
+INSTANTIATE_TEST_SUITE_P(
+    SSE2, AvxHBDMseWxHTest,
+    ::testing::Values(
+        MseWxHHBDParams(3, 3, &aom_mse_wxh_16bit_highbd_sse2, 12),
+        MseWxHHBDParams(3, 2, &aom_mse_wxh_16bit_highbd_sse2, 12),
+        MseWxHHBDParams(2, 3, &aom_mse_wxh_16bit_highbd_sse2, 12),
+        MseWxHHBDParams(2, 2, &aom_mse_wxh_16bit_highbd_sse2, 12),
+        MseWxHHBDParams(3, 3, &aom_mse_wxh_16bit_highbd_sse2, 10),
+        MseWxHHBDParams(2, 2, &aom_mse_wxh_16bit_highbd_sse2, 10)));
+
 const VarianceParams kArrayHBDVariance_sse2[] = {
   VarianceParams(7, 7, &aom_highbd_12_variance128x128_sse2, 12),
   VarianceParams(7, 6, &aom_highbd_12_variance128x64_sse2, 12),
@@ -1908,6 +2020,16 @@ const VarianceParams kArrayHBDVariance_avx2[] = {
 
 INSTANTIATE_TEST_SUITE_P(AVX2, AvxHBDVarianceTest,
                          ::testing::ValuesIn(kArrayHBDVariance_avx2));
+
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, AvxHBDMseWxHTest,
+    ::testing::Values(
+        MseWxHHBDParams(3, 3, &aom_mse_wxh_16bit_highbd_avx2, 12),
+        MseWxHHBDParams(3, 2, &aom_mse_wxh_16bit_highbd_avx2, 12),
+        MseWxHHBDParams(2, 3, &aom_mse_wxh_16bit_highbd_avx2, 12),
+        MseWxHHBDParams(2, 2, &aom_mse_wxh_16bit_highbd_avx2, 12),
+        MseWxHHBDParams(3, 3, &aom_mse_wxh_16bit_highbd_avx2, 10),
+        MseWxHHBDParams(2, 2, &aom_mse_wxh_16bit_highbd_avx2, 10)));
 #endif  // HAVE_AVX2
 
 const SubpelVarianceParams kArrayHBDSubpelVariance_sse2[] = {
@@ -2261,6 +2383,13 @@ INSTANTIATE_TEST_SUITE_P(AVX2, AvxMseTest,
                          ::testing::Values(MseParams(4, 4,
                                                      &aom_mse16x16_avx2)));
 
+INSTANTIATE_TEST_SUITE_P(
+    AVX2, AvxMseWxHTest,
+    ::testing::Values(MseWxHParams(3, 3, &aom_mse_wxh_16bit_avx2),
+                      MseWxHParams(3, 2, &aom_mse_wxh_16bit_avx2),
+                      MseWxHParams(2, 3, &aom_mse_wxh_16bit_avx2),
+                      MseWxHParams(2, 2, &aom_mse_wxh_16bit_avx2)));
+
 INSTANTIATE_TEST_SUITE_P(
     AVX2, AvxVarianceTest,
     ::testing::Values(VarianceParams(7, 7, &aom_variance128x128_avx2),
@@ -2313,6 +2442,21 @@ INSTANTIATE_TEST_SUITE_P(
                                 0)));
 #endif  // HAVE_AVX2
 
+#if HAVE_AVX512
+INSTANTIATE_TEST_SUITE_P(
+    AVX512, AvxVarianceTest,
+    ::testing::Values(VarianceParams(7, 7, &aom_variance128x128_avx512),
+                      VarianceParams(7, 6, &aom_variance128x64_avx512),
+                      VarianceParams(6, 7, &aom_variance64x128_avx512),
+                      VarianceParams(6, 6, &aom_variance64x64_avx512),
+                      VarianceParams(6, 5, &aom_variance64x32_avx512),
+                      VarianceParams(6, 4, &aom_variance64x16_avx512),
+                      VarianceParams(5, 6, &aom_variance32x64_avx512),
+                      VarianceParams(5, 5, &aom_variance32x32_avx512),
+                      VarianceParams(5, 4, &aom_variance32x16_avx512),
+                      VarianceParams(5, 3, &aom_variance32x8_avx512)));
+#endif  // HAVE_AVX512
+
 #if HAVE_NEON
 INSTANTIATE_TEST_SUITE_P(NEON, AvxSseTest,
                          ::testing::Values(SseParams(2, 2,